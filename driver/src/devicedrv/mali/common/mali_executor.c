@@ -22,6 +22,7 @@
 #include "mali_osk_profiling.h"
 #include "mali_session.h"
 #include "mali_osk_mali.h"
+#include "mali_memory_defer_bind.h"
 
 /*
  * If dma_buf with map on demand is used, we defer job deletion and job queue
@@ -52,8 +53,17 @@ enum mali_executor_state_t {
 /* Lock for this module (protecting all HW access except L2 caches) */
 _mali_osk_spinlock_irq_t *mali_executor_lock_obj = NULL;
 
+/* Contention statistics of the executor lock, protected by the lock itself */
+struct mali_scheduler_lock_stats mali_executor_lock_stats;
+
 mali_bool mali_executor_hints[MALI_EXECUTOR_HINT_MAX];
 
+/*
+ * Start jobs released by a dependency callback from the callback itself
+ * when powered cores can take them, see mali_executor_schedule_dependents().
+ */
+int mali_dependent_start_direct = 1;
+
 /*
  * ---------- static variables ----------
  */
@@ -61,6 +71,17 @@ mali_bool mali_executor_hints[MALI_EXECUTOR_HINT_MAX];
 /* Used to defer job scheduling */
 static _mali_osk_wq_work_t *executor_wq_high_pri = NULL;
 
+/*
+ * Number of schedule requests posted by submitting threads which found the
+ * executor lock busy, see mali_executor_submit_from_mask(). The
+ * executor_wq_high_pri worker runs one schedule for all of them.
+ */
+static _mali_osk_atomic_t executor_schedule_pending;
+
+/* How dependency callbacks started their jobs, protected by the executor lock */
+static u64 dependent_starts_direct = 0;
+static u64 dependent_starts_deferred = 0;
+
 /* Store version from GP and PP (user space wants to know this) */
 static u32 pp_version = 0;
 static u32 gp_version = 0;
@@ -125,6 +146,7 @@ static void mali_executor_disable_empty_virtual(void);
 static mali_bool mali_executor_physical_rejoin_virtual(struct mali_group *group);
 static mali_bool mali_executor_has_virtual_group(void);
 static mali_bool mali_executor_virtual_group_is_usable(void);
+static mali_bool mali_executor_dependents_powered(mali_scheduler_mask mask);
 static void mali_executor_schedule(void);
 static void mali_executor_wq_schedule(void *arg);
 static void mali_executor_send_gp_oom_to_user(struct mali_gp_job *job);
@@ -164,6 +186,8 @@ _mali_osk_errcode_t mali_executor_initialize(void)
 		return _MALI_OSK_ERR_NOMEM;
 	}
 
+	_mali_osk_atomic_init(&executor_schedule_pending, 0);
+
 	executor_wq_high_pri = _mali_osk_wq_create_work_high_pri(mali_executor_wq_schedule, NULL);
 	if (NULL == executor_wq_high_pri) {
 		mali_executor_terminate();
@@ -213,6 +237,8 @@ void mali_executor_terminate(void)
 		executor_wq_high_pri = NULL;
 	}
 
+	_mali_osk_atomic_term(&executor_schedule_pending);
+
 	if (NULL != mali_executor_lock_obj) {
 		_mali_osk_spinlock_irq_term(mali_executor_lock_obj);
 		mali_executor_lock_obj = NULL;
@@ -421,7 +447,7 @@ struct mali_group *mali_executor_get_virtual_group(void)
 	return virtual_group;
 }
 
-void mali_executor_zap_all_active(struct mali_session_data *session)
+void mali_executor_zap_all_active(struct mali_session_data *session, struct mali_mmu_invalidate_batch *batch)
 {
 	struct mali_group *group;
 	struct mali_group *temp;
@@ -440,7 +466,7 @@ void mali_executor_zap_all_active(struct mali_session_data *session)
 	 */
 
 	MALI_DEBUG_ASSERT(NULL != gp_group);
-	ret = mali_group_zap_session(gp_group, session);
+	ret = mali_group_zap_session(gp_group, session, batch);
 	if (MALI_FALSE == ret) {
 		struct mali_gp_job *gp_job = NULL;
 
@@ -454,7 +480,7 @@ void mali_executor_zap_all_active(struct mali_session_data *session)
 	}
 
 	if (mali_executor_has_virtual_group()) {
-		ret = mali_group_zap_session(virtual_group, session);
+		ret = mali_group_zap_session(virtual_group, session, batch);
 		if (MALI_FALSE == ret) {
 			struct mali_pp_job *pp_job = NULL;
 
@@ -470,9 +496,9 @@ void mali_executor_zap_all_active(struct mali_session_data *session)
 
 	_MALI_OSK_LIST_FOREACHENTRY(group, temp, &group_list_working,
 				    struct mali_group, executor_list) {
-		ret = mali_group_zap_session(group, session);
+		ret = mali_group_zap_session(group, session, batch);
 		if (MALI_FALSE == ret) {
-			ret = mali_group_zap_session(group, session);
+			ret = mali_group_zap_session(group, session, batch);
 			if (MALI_FALSE == ret) {
 				struct mali_pp_job *pp_job = NULL;
 
@@ -505,6 +531,72 @@ void mali_executor_schedule_from_mask(mali_scheduler_mask mask, mali_bool deferr
 	}
 }
 
+void mali_executor_submit_from_mask(mali_scheduler_mask mask)
+{
+	if (MALI_SCHEDULER_MASK_EMPTY == mask) {
+		return;
+	}
+
+	if (MALI_TRUE == _mali_osk_spinlock_irq_trylock(mali_executor_lock_obj)) {
+		mali_executor_lock_stats.acquired++;
+		mali_executor_schedule();
+		mali_executor_unlock();
+	} else {
+		/*
+		 * The lock is busy, typically with IRQ completion work. Rather
+		 * than spinning behind it, post the request to the worker.
+		 */
+		_mali_osk_atomic_inc(&executor_schedule_pending);
+		_mali_osk_wq_schedule_work_high_pri(executor_wq_high_pri);
+	}
+}
+
+void mali_executor_schedule_dependents(mali_scheduler_mask mask)
+{
+	mali_bool direct;
+
+	if (MALI_SCHEDULER_MASK_EMPTY == mask) {
+		return;
+	}
+
+	mali_executor_lock();
+
+	direct = (0 != mali_dependent_start_direct) &&
+		 mali_executor_dependents_powered(mask);
+	if (MALI_TRUE == direct) {
+		dependent_starts_direct++;
+		mali_executor_schedule();
+	} else {
+		dependent_starts_deferred++;
+	}
+
+	mali_executor_unlock();
+
+	if (MALI_FALSE == direct) {
+		/* Cores must be powered up first, leave that to the workqueue */
+		mali_executor_schedule_from_mask(mask, MALI_TRUE);
+	}
+}
+
+void mali_executor_dependent_start_stats(u64 *direct, u64 *deferred)
+{
+	MALI_DEBUG_ASSERT_POINTER(direct);
+	MALI_DEBUG_ASSERT_POINTER(deferred);
+
+	mali_executor_lock();
+	*direct = dependent_starts_direct;
+	*deferred = dependent_starts_deferred;
+	mali_executor_unlock();
+}
+
+void mali_executor_dependent_start_stats_reset(void)
+{
+	mali_executor_lock();
+	dependent_starts_direct = 0;
+	dependent_starts_deferred = 0;
+	mali_executor_unlock();
+}
+
 _mali_osk_errcode_t mali_executor_interrupt_gp(struct mali_group *group,
 		mali_bool in_upper_half)
 {
@@ -573,6 +665,7 @@ _mali_osk_errcode_t mali_executor_interrupt_gp(struct mali_group *group,
 		}
 	} else if (MALI_INTERRUPT_RESULT_OOM == int_result) {
 		struct mali_gp_job *job = mali_group_get_running_gp_job(group);
+		u32 heap_start, heap_end;
 
 		/* PLBU out of mem */
 		MALI_DEBUG_PRINT(3, ("Executor: PLBU needs more heap memory\n"));
@@ -582,11 +675,21 @@ _mali_osk_errcode_t mali_executor_interrupt_gp(struct mali_group *group,
 		mali_group_oom(group);
 #endif
 
-		/*
-		 * no need to hold interrupt raised while
-		 * waiting for more memory.
-		 */
-		mali_executor_send_gp_oom_to_user(job);
+		if (MALI_TRUE == mali_mem_defer_heap_grow(job, &heap_start, &heap_end)) {
+			/* Grown in the kernel, no round trip to user space needed */
+			MALI_DEBUG_PRINT(3, ("Executor: Resuming job %u with grown heap; 0x%08X - 0x%08X\n",
+					     mali_gp_job_get_id(job), heap_start, heap_end));
+
+			/* This will also re-enable interrupts */
+			mali_group_resume_gp_with_new_heap(group, mali_gp_job_get_id(job),
+							   heap_start, heap_end);
+		} else {
+			/*
+			 * no need to hold interrupt raised while
+			 * waiting for more memory.
+			 */
+			mali_executor_send_gp_oom_to_user(job);
+		}
 
 		mali_executor_unlock();
 
@@ -1343,7 +1446,7 @@ _mali_osk_errcode_t _mali_ukk_gp_suspend_response(_mali_uk_gp_suspend_response_s
 
 void mali_executor_lock(void)
 {
-	_mali_osk_spinlock_irq_lock(mali_executor_lock_obj);
+	mali_scheduler_lock_with_stats(mali_executor_lock_obj, &mali_executor_lock_stats);
 	MALI_DEBUG_PRINT(5, ("Executor: lock taken\n"));
 }
 
@@ -1454,6 +1557,38 @@ static mali_bool mali_executor_has_virtual_group(void)
 #endif /* (defined(CONFIG_MALI450) || defined(CONFIG_MALI470)) */
 }
 
+/*
+ * Check if a job in \a mask can go straight onto an already powered core.
+ * A PP job is satisfied by any powered PP core, busy cores pick it up on
+ * completion.
+ */
+static mali_bool mali_executor_dependents_powered(mali_scheduler_mask mask)
+{
+	MALI_DEBUG_ASSERT_EXECUTOR_LOCK_HELD();
+
+	if (0 < pause_count) {
+		return MALI_FALSE;
+	}
+
+	if (MALI_SCHEDULER_MASK_GP & mask) {
+		if (EXEC_STATE_IDLE != gp_group_state &&
+		    EXEC_STATE_WORKING != gp_group_state) {
+			return MALI_FALSE;
+		}
+	}
+
+	if (MALI_SCHEDULER_MASK_PP & mask) {
+		if (0 == group_list_idle_count &&
+		    0 == group_list_working_count &&
+		    EXEC_STATE_IDLE != virtual_group_state &&
+		    EXEC_STATE_WORKING != virtual_group_state) {
+			return MALI_FALSE;
+		}
+	}
+
+	return MALI_TRUE;
+}
+
 static mali_bool mali_executor_virtual_group_is_usable(void)
 {
 #if (defined(CONFIG_MALI450) || defined(CONFIG_MALI470))
@@ -1879,6 +2014,7 @@ static void mali_executor_wq_schedule(void *arg)
 {
 	MALI_IGNORE(arg);
 	mali_executor_lock();
+	mali_executor_lock_stats.handoffs += _mali_osk_atomic_xchg(&executor_schedule_pending, 0);
 	mali_executor_schedule();
 	mali_executor_unlock();
 }
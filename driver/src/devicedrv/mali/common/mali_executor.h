@@ -26,9 +26,13 @@ extern mali_bool mali_executor_hints[MALI_EXECUTOR_HINT_MAX];
 struct mali_session_data;
 struct mali_group;
 struct mali_pp_core;
+struct mali_mmu_invalidate_batch;
 
 extern _mali_osk_spinlock_irq_t *mali_executor_lock_obj;
 
+/* Contention statistics of the executor lock */
+extern struct mali_scheduler_lock_stats mali_executor_lock_stats;
+
 #define MALI_DEBUG_ASSERT_EXECUTOR_LOCK_HELD() MALI_DEBUG_ASSERT_LOCK_HELD(mali_executor_lock_obj);
 
 _mali_osk_errcode_t mali_executor_initialize(void);
@@ -45,7 +49,8 @@ u32 mali_executor_get_num_cores_enabled(void);
 struct mali_pp_core *mali_executor_get_virtual_pp(void);
 struct mali_group *mali_executor_get_virtual_group(void);
 
-void mali_executor_zap_all_active(struct mali_session_data *session);
+/* Invalidate the TLB of all groups running \a session, for the ranges in \a batch (NULL for everything) */
+void mali_executor_zap_all_active(struct mali_session_data *session, struct mali_mmu_invalidate_batch *batch);
 
 /**
  * Schedule GP and PP according to bitmask.
@@ -55,6 +60,31 @@ void mali_executor_zap_all_active(struct mali_session_data *session);
  */
 void mali_executor_schedule_from_mask(mali_scheduler_mask mask, mali_bool deferred_schedule);
 
+/**
+ * Schedule GP and PP according to bitmask, after submitting jobs.
+ *
+ * Schedules from this thread if the executor lock is free. Otherwise leaves
+ * the schedule to the high priority worker, so that submitters don't spin
+ * behind job completion. The jobs may not have been started on return.
+ *
+ * @param mask A scheduling bitmask.
+ */
+void mali_executor_submit_from_mask(mali_scheduler_mask mask);
+
+/**
+ * Schedule jobs released by a dependency callback.
+ *
+ * Starts the jobs from the calling thread when powered cores can take them,
+ * saving the hop through the deferred schedule workqueue, and defers
+ * otherwise. Must be called from process context without timeline or
+ * executor locks held.
+ *
+ * @param mask A scheduling bitmask.
+ */
+void mali_executor_schedule_dependents(mali_scheduler_mask mask);
+void mali_executor_dependent_start_stats(u64 *direct, u64 *deferred);
+void mali_executor_dependent_start_stats_reset(void);
+
 _mali_osk_errcode_t mali_executor_interrupt_gp(struct mali_group *group, mali_bool in_upper_half);
 _mali_osk_errcode_t mali_executor_interrupt_pp(struct mali_group *group, mali_bool in_upper_half);
 _mali_osk_errcode_t mali_executor_interrupt_mmu(struct mali_group *group, mali_bool in_upper_half);
@@ -19,6 +19,29 @@ static u32 gp_counter_src0 = MALI_HW_CORE_NO_COUNTER;      /**< Performance coun
 static u32 gp_counter_src1 = MALI_HW_CORE_NO_COUNTER;           /**< Performance counter 1, MALI_HW_CORE_NO_COUNTER for disabled */
 static void _mali_gp_del_varying_allocations(struct mali_gp_job *job);
 
+#define MALI_GP_JOB_POOL_MAX_CACHED 32
+
+static _mali_osk_object_pool_t *gp_job_pool = NULL; /**< Recycled GP job objects */
+
+_mali_osk_errcode_t mali_gp_job_initialize(void)
+{
+	gp_job_pool = _mali_osk_object_pool_create("mali_gp_job", sizeof(struct mali_gp_job),
+			MALI_GP_JOB_POOL_MAX_CACHED);
+	if (NULL == gp_job_pool) {
+		return _MALI_OSK_ERR_NOMEM;
+	}
+
+	return _MALI_OSK_ERR_OK;
+}
+
+void mali_gp_job_terminate(void)
+{
+	if (NULL != gp_job_pool) {
+		_mali_osk_object_pool_destroy(gp_job_pool);
+		gp_job_pool = NULL;
+	}
+}
+
 
 static int _mali_gp_add_varying_allocations(struct mali_session_data *session,
 		struct mali_gp_job *job,
@@ -72,14 +95,16 @@ static void _mali_gp_del_varying_allocations(struct mali_gp_job *job)
 	INIT_LIST_HEAD(&job->varying_alloc);
 }
 
-struct mali_gp_job *mali_gp_job_create(struct mali_session_data *session, _mali_uk_gp_start_job_s *uargs, u32 id, struct mali_timeline_tracker *pp_tracker)
+static struct mali_gp_job *mali_gp_job_create_internal(struct mali_session_data *session,
+		_mali_uk_gp_start_job_s *uargs, const _mali_uk_gp_start_job_s *kargs,
+		u32 id, struct mali_timeline_tracker *pp_tracker)
 {
 	struct mali_gp_job *job;
 	u32 perf_counter_flag;
 	u32 __user *memory_list = NULL;
 	struct mali_gp_allocation_node *alloc_node, *tmp_node;
 
-	job = _mali_osk_calloc(1, sizeof(struct mali_gp_job));
+	job = _mali_osk_object_pool_alloc(gp_job_pool);
 	if (NULL != job) {
 		job->finished_notification = _mali_osk_notification_create(_MALI_NOTIFICATION_GP_FINISHED, sizeof(_mali_uk_gp_job_finished_s));
 		if (NULL == job->finished_notification) {
@@ -91,7 +116,9 @@ struct mali_gp_job *mali_gp_job_create(struct mali_session_data *session, _mali_
 			goto fail2;
 		}
 
-		if (0 != _mali_osk_copy_from_user(&job->uargs, uargs, sizeof(_mali_uk_gp_start_job_s))) {
+		if (NULL != kargs) {
+			_mali_osk_memcpy(&job->uargs, kargs, sizeof(_mali_uk_gp_start_job_s));
+		} else if (0 != _mali_osk_copy_from_user(&job->uargs, uargs, sizeof(_mali_uk_gp_start_job_s))) {
 			goto fail1;
 		}
 
@@ -177,6 +204,12 @@ struct mali_gp_job *mali_gp_job_create(struct mali_session_data *session, _mali_
 				job->big_job = 1;
 			}
 		}
+
+		/* If the heap can't be grown for it, user space is asked for more on out of memory */
+		if (_MALI_OSK_ERR_OK != mali_mem_defer_heap_prepare(job)) {
+			MALI_DEBUG_PRINT(2, ("Mali GP job: failed to prepare growing the heap\n"));
+		}
+
 		job->pp_tracker = pp_tracker;
 		if (NULL != job->pp_tracker) {
 			/* Take a reference on PP job's tracker that will be released when the GP
@@ -187,9 +220,11 @@ struct mali_gp_job *mali_gp_job_create(struct mali_session_data *session, _mali_
 		mali_timeline_tracker_init(&job->tracker, MALI_TIMELINE_TRACKER_GP, NULL, job);
 		mali_timeline_fence_copy_uk_fence(&(job->tracker.fence), &(job->uargs.fence));
 
+		_mali_osk_atomic_inc(&session->number_of_gp_jobs);
+
 		return job;
 	} else {
-		MALI_PRINT_ERROR(("Mali GP job: _mali_osk_calloc failed!\n"));
+		MALI_PRINT_ERROR(("Mali GP job: failed to allocate job object!\n"));
 		return NULL;
 	}
 
@@ -209,10 +244,21 @@ fail1:
 fail2:
 	_mali_osk_notification_delete(job->finished_notification);
 fail3:
-	_mali_osk_free(job);
+	_mali_osk_object_pool_free(gp_job_pool, job);
 	return NULL;
 }
 
+struct mali_gp_job *mali_gp_job_create(struct mali_session_data *session, _mali_uk_gp_start_job_s *uargs, u32 id, struct mali_timeline_tracker *pp_tracker)
+{
+	return mali_gp_job_create_internal(session, uargs, NULL, id, pp_tracker);
+}
+
+struct mali_gp_job *mali_gp_job_create_from_kargs(struct mali_session_data *session, const _mali_uk_gp_start_job_s *kargs, u32 id, struct mali_timeline_tracker *pp_tracker)
+{
+	MALI_DEBUG_ASSERT_POINTER(kargs);
+	return mali_gp_job_create_internal(session, NULL, kargs, id, pp_tracker);
+}
+
 void mali_gp_job_delete(struct mali_gp_job *job)
 {
 	struct mali_backend_bind_list *bkn, *bkn_tmp;
@@ -228,6 +274,7 @@ void mali_gp_job_delete(struct mali_gp_job *job)
 	}
 
 	mali_mem_defer_dmem_free(job);
+	mali_mem_defer_heap_release(job);
 
 	/* de-allocate the pre-allocated oom notifications */
 	if (NULL != job->oom_notification) {
@@ -239,7 +286,8 @@ void mali_gp_job_delete(struct mali_gp_job *job)
 		job->finished_notification = NULL;
 	}
 
-	_mali_osk_free(job);
+	_mali_osk_atomic_dec(&job->session->number_of_gp_jobs);
+	_mali_osk_object_pool_free(gp_job_pool, job);
 }
 
 void mali_gp_job_list_add(struct mali_gp_job *job, _mali_osk_list_t *list)
@@ -294,6 +342,7 @@ mali_scheduler_mask mali_gp_job_signal_pp_tracker(struct mali_gp_job *job, mali_
 	MALI_DEBUG_ASSERT_POINTER(job);
 
 	if (NULL != job->pp_tracker) {
+		job->pp_tracker->gp_end_time = _mali_osk_time_get_ns();
 		schedule_mask |= mali_timeline_system_tracker_put(job->session->timeline_system, job->pp_tracker, MALI_FALSE == success);
 		job->pp_tracker = NULL;
 	}
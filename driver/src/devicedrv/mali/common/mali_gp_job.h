@@ -22,6 +22,7 @@
 #include "mali_timeline.h"
 
 struct mali_defer_mem;
+struct mali_mem_heap_grow;
 /**
  * This structure represents a GP job
  *
@@ -75,6 +76,7 @@ struct mali_gp_job {
 	struct list_head vary_todo;                        /**< list of backend list need to do defer bind*/
 	u32 required_varying_memsize;                      /** < size of varying memory to reallocate*/
 	u32 big_job;                                       /** < if the gp job have large varying output and may take long time*/
+	struct mali_mem_heap_grow *heap;                   /**< Growable heap grown on PLBU out of memory, protected by executor lock */
 };
 
 #define MALI_DEFER_BIND_MEMORY_PREPARED (0x1 << 0)
@@ -85,7 +87,12 @@ struct mali_gp_allocation_node {
 	mali_mem_allocation *alloc;
 };
 
+_mali_osk_errcode_t mali_gp_job_initialize(void);
+void mali_gp_job_terminate(void);
+
 struct mali_gp_job *mali_gp_job_create(struct mali_session_data *session, _mali_uk_gp_start_job_s *uargs, u32 id, struct mali_timeline_tracker *pp_tracker);
+/* Same as mali_gp_job_create(), but with the job arguments already copied from user space */
+struct mali_gp_job *mali_gp_job_create_from_kargs(struct mali_session_data *session, const _mali_uk_gp_start_job_s *kargs, u32 id, struct mali_timeline_tracker *pp_tracker);
 void mali_gp_job_delete(struct mali_gp_job *job);
 
 u32 mali_gp_job_get_gp_counter_src0(void);
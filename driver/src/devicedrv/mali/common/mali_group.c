@@ -1786,7 +1786,8 @@ static void mali_group_timeout(void *data)
 }
 
 mali_bool mali_group_zap_session(struct mali_group *group,
-				 struct mali_session_data *session)
+				 struct mali_session_data *session,
+				 struct mali_mmu_invalidate_batch *batch)
 {
 	MALI_DEBUG_ASSERT_POINTER(group);
 	MALI_DEBUG_ASSERT_POINTER(session);
@@ -1798,8 +1799,8 @@ mali_bool mali_group_zap_session(struct mali_group *group,
 	}
 
 	if (group->is_working) {
-		/* The Zap also does the stall and disable_stall */
-		mali_bool zap_success = mali_mmu_zap_tlb(group->mmu);
+		/* The invalidation also does the stall and disable_stall */
+		mali_bool zap_success = mali_mmu_invalidate(group->mmu, batch);
 		return zap_success;
 	} else {
 		/* Just remove the session instead of zapping */
@@ -262,10 +262,13 @@ MALI_STATIC_INLINE struct mali_gp_job *mali_group_get_running_gp_job(struct mali
 
 /** @brief Zap MMU TLB on all groups
  *
- * Zap TLB on group if \a session is active.
+ * Zap TLB on group if \a session is active. If the group is working, only the
+ * ranges in \a batch are invalidated when that is cheaper, a NULL batch zaps
+ * the whole TLB.
  */
 mali_bool mali_group_zap_session(struct mali_group *group,
-				 struct mali_session_data *session);
+				 struct mali_session_data *session,
+				 struct mali_mmu_invalidate_batch *batch);
 
 /** @brief Get pointer to GP core object
  */
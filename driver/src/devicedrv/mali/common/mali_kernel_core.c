@@ -754,7 +754,29 @@ _mali_osk_errcode_t mali_initialize_subsystems(void)
 	}
 #endif
 
-	mali_pp_job_initialize();
+	err = _mali_osk_notification_initialize();
+	if (_MALI_OSK_ERR_OK != err) {
+		mali_terminate_subsystems();
+		return err;
+	}
+
+	err = mali_pp_job_initialize();
+	if (_MALI_OSK_ERR_OK != err) {
+		mali_terminate_subsystems();
+		return err;
+	}
+
+	err = mali_gp_job_initialize();
+	if (_MALI_OSK_ERR_OK != err) {
+		mali_terminate_subsystems();
+		return err;
+	}
+
+	err = mali_soft_job_initialize();
+	if (_MALI_OSK_ERR_OK != err) {
+		mali_terminate_subsystems();
+		return err;
+	}
 
 	err = mali_timeline_initialize();
 	if (_MALI_OSK_ERR_OK != err) {
@@ -936,6 +958,8 @@ void mali_terminate_subsystems(void)
 	mali_executor_terminate();
 
 	mali_scheduler_terminate();
+	mali_soft_job_terminate();
+	mali_gp_job_terminate();
 	mali_pp_job_terminate();
 	mali_delete_l2_cache_cores();
 	mali_mmu_terminate();
@@ -962,6 +986,8 @@ void mali_terminate_subsystems(void)
 
 	mali_timeline_terminate();
 
+	_mali_osk_notification_terminate();
+
 	global_gpu_base_address = 0;
 }
 
@@ -1191,8 +1217,10 @@ _mali_osk_errcode_t _mali_ukk_open(void **context)
 #endif
 
 	_mali_osk_atomic_init(&session->number_of_pp_jobs, 0);
+	_mali_osk_atomic_init(&session->number_of_gp_jobs, 0);
 
 	session->use_high_priority_job_queue = MALI_FALSE;
+	session->pp_sched.weight = MALI_SCHEDULER_PP_WEIGHT_DEFAULT;
 
 	/* Initialize list of PP jobs on this session. */
 	_MALI_OSK_INIT_LIST_HEAD(&session->pp_job_list);
@@ -1294,6 +1322,12 @@ _mali_osk_errcode_t _mali_ukk_close(void **context)
 	mali_timeline_system_destroy(session->timeline_system);
 	session->timeline_system = NULL;
 
+	/* Nothing publishes points any more. */
+	if (NULL != session->timeline_seqno_page) {
+		mali_timeline_seqno_destroy(session->timeline_seqno_page);
+		session->timeline_seqno_page = NULL;
+	}
+
 	/* Destroy soft system. */
 	mali_soft_job_system_destroy(session->soft_job_system);
 	session->soft_job_system = NULL;
@@ -1301,6 +1335,12 @@ _mali_osk_errcode_t _mali_ukk_close(void **context)
 	/*Wait for the session job lists become empty.*/
 	_mali_osk_wait_queue_wait_event(session->wait_queue, mali_session_pp_job_is_empty, (void *) session);
 
+	/* No more job completions can be posted at this point. */
+	if (NULL != session->completion_ring) {
+		mali_completion_ring_destroy(session->completion_ring);
+		session->completion_ring = NULL;
+	}
+
 	/* Free remaining memory allocated to this session */
 	mali_memory_session_end(session);
 
@@ -52,6 +52,19 @@ static mali_io_address mali_page_fault_flush_page_table_mapping = NULL;
 static mali_dma_addr mali_page_fault_flush_data_page = MALI_INVALID_PAGE;
 static mali_io_address mali_page_fault_flush_data_page_mapping = NULL;
 
+/*
+ * ZAP_ONE_LINE drops the TLB entry of a single 4KB page. Invalidating more
+ * pages than this costs more than refilling the whole TLB, so the TLB is
+ * zapped instead.
+ */
+#define MALI_MMU_INVALIDATE_MAX_LINES 64
+
+/* Invalidation statistics, updated with the executor lock held */
+static u32 mali_mmu_stat_full_zaps = 0;        /* Whole TLB zapped under a running job */
+static u32 mali_mmu_stat_ranged = 0;           /* Ranged invalidations under a running job */
+static u32 mali_mmu_stat_lines = 0;            /* Pages zapped by ranged invalidations */
+static _mali_osk_atomic_t mali_mmu_stat_unmaps; /* Unmapped ranges added to invalidation batches */
+
 /* an empty page directory (no address valid) which is active on any MMU not currently marked as in use */
 static mali_dma_addr mali_empty_page_directory_phys   = MALI_INVALID_PAGE;
 static mali_io_address mali_empty_page_directory_virt = NULL;
@@ -59,6 +72,8 @@ static mali_io_address mali_empty_page_directory_virt = NULL;
 
 _mali_osk_errcode_t mali_mmu_initialize(void)
 {
+	_mali_osk_atomic_init(&mali_mmu_stat_unmaps, 0);
+
 	/* allocate the helper pages */
 	mali_empty_page_directory_phys = mali_allocate_empty_page(&mali_empty_page_directory_virt);
 	if (0 == mali_empty_page_directory_phys) {
@@ -334,6 +349,120 @@ void mali_mmu_invalidate_page(struct mali_mmu_core *mmu, u32 mali_address)
 	mali_hw_core_register_write(&mmu->hw_core, MALI_MMU_REGISTER_ZAP_ONE_LINE, MALI_MMU_PDE_ENTRY(mali_address));
 }
 
+void mali_mmu_invalidate_batch_init(struct mali_mmu_invalidate_batch *batch)
+{
+	MALI_DEBUG_ASSERT_POINTER(batch);
+
+	batch->num_ranges = 0;
+	batch->overflow = MALI_FALSE;
+}
+
+void mali_mmu_invalidate_batch_add(struct mali_mmu_invalidate_batch *batch, u32 mali_address, u32 size)
+{
+	MALI_DEBUG_ASSERT_POINTER(batch);
+
+	_mali_osk_atomic_inc(&mali_mmu_stat_unmaps);
+
+	if (0 == size || MALI_TRUE == batch->overflow) {
+		return;
+	}
+
+	/* Extend the previous range if this one follows it. */
+	if (0 < batch->num_ranges) {
+		u32 last = batch->num_ranges - 1;
+
+		if (batch->ranges[last].start + batch->ranges[last].size == mali_address) {
+			batch->ranges[last].size += size;
+			return;
+		}
+	}
+
+	if (MALI_MMU_INVALIDATE_MAX_RANGES == batch->num_ranges) {
+		batch->overflow = MALI_TRUE;
+		return;
+	}
+
+	batch->ranges[batch->num_ranges].start = mali_address;
+	batch->ranges[batch->num_ranges].size = size;
+	batch->num_ranges++;
+}
+
+/* Number of pages covered by a batch, stops counting above the limit */
+static u32 mali_mmu_invalidate_batch_lines(struct mali_mmu_invalidate_batch *batch)
+{
+	u32 lines = 0;
+	u32 i;
+
+	for (i = 0; i < batch->num_ranges && lines <= MALI_MMU_INVALIDATE_MAX_LINES; i++) {
+		u32 first = batch->ranges[i].start / MALI_MMU_PAGE_SIZE;
+		u32 last = (batch->ranges[i].start + batch->ranges[i].size - 1) / MALI_MMU_PAGE_SIZE;
+
+		lines += last - first + 1;
+	}
+
+	return lines;
+}
+
+mali_bool mali_mmu_invalidate(struct mali_mmu_core *mmu, struct mali_mmu_invalidate_batch *batch)
+{
+	mali_bool stall_success;
+	u32 lines;
+	u32 i;
+
+	MALI_DEBUG_ASSERT_POINTER(mmu);
+
+	if (NULL == batch || MALI_TRUE == batch->overflow) {
+		mali_mmu_stat_full_zaps++;
+		return mali_mmu_zap_tlb(mmu);
+	}
+
+	lines = mali_mmu_invalidate_batch_lines(batch);
+	if (MALI_MMU_INVALIDATE_MAX_LINES < lines) {
+		mali_mmu_stat_full_zaps++;
+		return mali_mmu_zap_tlb(mmu);
+	}
+
+	stall_success = mali_mmu_enable_stall(mmu);
+	if (MALI_FALSE == stall_success) {
+		/* Page fault pending, zap everything like mali_mmu_zap_tlb() does */
+		mali_mmu_stat_full_zaps++;
+		mali_hw_core_register_write(&mmu->hw_core, MALI_MMU_REGISTER_COMMAND, MALI_MMU_COMMAND_ZAP_CACHE);
+		return MALI_FALSE;
+	}
+
+	/* The TLB is zapped one 4KB page at a time. */
+	for (i = 0; i < batch->num_ranges; i++) {
+		u32 page = batch->ranges[i].start / MALI_MMU_PAGE_SIZE;
+		u32 last = (batch->ranges[i].start + batch->ranges[i].size - 1) / MALI_MMU_PAGE_SIZE;
+
+		for (; page <= last; page++) {
+			mali_mmu_invalidate_page(mmu, page * MALI_MMU_PAGE_SIZE);
+		}
+	}
+
+	mali_mmu_stat_ranged++;
+	mali_mmu_stat_lines += lines;
+
+	mali_mmu_disable_stall(mmu);
+	return MALI_TRUE;
+}
+
+void mali_mmu_invalidate_stats_print(_mali_osk_print_ctx *print_ctx)
+{
+	_mali_osk_ctxprintf(print_ctx, "unmaps: %u\n", _mali_osk_atomic_read(&mali_mmu_stat_unmaps));
+	_mali_osk_ctxprintf(print_ctx, "full_zaps: %u\n", mali_mmu_stat_full_zaps);
+	_mali_osk_ctxprintf(print_ctx, "ranged_invalidations: %u\n", mali_mmu_stat_ranged);
+	_mali_osk_ctxprintf(print_ctx, "lines_invalidated: %u\n", mali_mmu_stat_lines);
+}
+
+void mali_mmu_invalidate_stats_reset(void)
+{
+	_mali_osk_atomic_init(&mali_mmu_stat_unmaps, 0);
+	mali_mmu_stat_full_zaps = 0;
+	mali_mmu_stat_ranged = 0;
+	mali_mmu_stat_lines = 0;
+}
+
 static void mali_mmu_activate_address_space(struct mali_mmu_core *mmu, u32 page_directory)
 {
 	/* The MMU must be in stalled or page fault mode, for this writing to work */
@@ -57,6 +57,23 @@ typedef enum mali_mmu_status_bits {
 	MALI_MMU_STATUS_BIT_STALL_NOT_ACTIVE    = 1 << 31,
 } mali_mmu_status_bits;
 
+/* Maximum number of separate ranges an invalidation batch can hold */
+#define MALI_MMU_INVALIDATE_MAX_RANGES 8
+
+/**
+ * Mali virtual ranges whose TLB entries must be invalidated after unmapping.
+ * Unmaps done close together can be collected in one batch, so that the MMUs
+ * are only stalled once for all of them.
+ */
+struct mali_mmu_invalidate_batch {
+	u32 num_ranges;
+	mali_bool overflow;             /**< Too many ranges, the whole TLB must be zapped */
+	struct {
+		u32 start;
+		u32 size;
+	} ranges[MALI_MMU_INVALIDATE_MAX_RANGES];
+};
+
 /**
  * Definition of the MMU struct
  * Used to track a MMU unit in the system.
@@ -79,6 +96,30 @@ mali_bool mali_mmu_zap_tlb(struct mali_mmu_core *mmu);
 void mali_mmu_zap_tlb_without_stall(struct mali_mmu_core *mmu);
 void mali_mmu_invalidate_page(struct mali_mmu_core *mmu, u32 mali_address);
 
+void mali_mmu_invalidate_batch_init(struct mali_mmu_invalidate_batch *batch);
+void mali_mmu_invalidate_batch_add(struct mali_mmu_invalidate_batch *batch, u32 mali_address, u32 size);
+
+MALI_STATIC_INLINE mali_bool mali_mmu_invalidate_batch_is_empty(struct mali_mmu_invalidate_batch *batch)
+{
+	return (0 == batch->num_ranges && MALI_FALSE == batch->overflow) ? MALI_TRUE : MALI_FALSE;
+}
+
+/**
+ * Invalidate the TLB entries of an invalidation batch, on an MMU running a job.
+ *
+ * Small batches are invalidated one 4KB page at a time, so the running job keeps the
+ * rest of its TLB. Large batches, and a NULL batch, zap the whole TLB. Must be
+ * called with the executor lock held.
+ *
+ * @param mmu MMU to invalidate.
+ * @param batch Ranges to invalidate, NULL to zap everything.
+ * @return MALI_FALSE if the MMU could not be stalled because of a page fault.
+ */
+mali_bool mali_mmu_invalidate(struct mali_mmu_core *mmu, struct mali_mmu_invalidate_batch *batch);
+
+void mali_mmu_invalidate_stats_print(_mali_osk_print_ctx *print_ctx);
+void mali_mmu_invalidate_stats_reset(void);
+
 void mali_mmu_activate_page_directory(struct mali_mmu_core *mmu, struct mali_page_directory *pagedir);
 void mali_mmu_activate_empty_page_directory(struct mali_mmu_core *mmu);
 void mali_mmu_activate_fault_flush_page_directory(struct mali_mmu_core *mmu);
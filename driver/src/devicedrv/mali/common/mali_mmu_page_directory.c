@@ -138,6 +138,8 @@ _mali_osk_errcode_t mali_mmu_pagedir_map(struct mali_page_directory *pagedir, u3
 				return err;
 			}
 			pagedir->page_entries_mapped[i] = pde_mapping;
+			pagedir->page_table_count++;
+			pagedir->page_table_allocs++;
 
 			/* Update PDE, mark as present */
 			_mali_osk_mem_iowrite32_relaxed(pagedir->page_directory_mapped, i * sizeof(u32),
@@ -221,6 +223,7 @@ _mali_osk_errcode_t mali_mmu_pagedir_unmap(struct mali_page_directory *pagedir,
 			page_phys = MALI_MMU_ENTRY_ADDRESS(_mali_osk_mem_ioread32(pagedir->page_directory_mapped, i * sizeof(u32)));
 			page_virt = pagedir->page_entries_mapped[i];
 			pagedir->page_entries_mapped[i] = NULL;
+			pagedir->page_table_count--;
 			_mali_osk_mem_iowrite32_relaxed(pagedir->page_directory_mapped, i * sizeof(u32), 0);
 
 			mali_mmu_release_table_page(page_phys, page_virt);
@@ -316,15 +319,46 @@ void mali_mmu_pagedir_free(struct mali_page_directory *pagedir)
 void mali_mmu_pagedir_update(struct mali_page_directory *pagedir, u32 mali_address,
 			     mali_dma_addr phys_address, u32 size, u32 permission_bits)
 {
+	struct mali_mmu_pagedir_range range;
 	u32 end_address = mali_address + size;
 	u32 mali_phys = (u32)phys_address;
 
 	/* Map physical pages into MMU page tables */
+	mali_mmu_pagedir_range_begin(&range, pagedir, mali_address, permission_bits);
 	for (; mali_address < end_address; mali_address += MALI_MMU_PAGE_SIZE, mali_phys += MALI_MMU_PAGE_SIZE) {
-		MALI_DEBUG_ASSERT_POINTER(pagedir->page_entries_mapped[MALI_MMU_PDE_ENTRY(mali_address)]);
-		_mali_osk_mem_iowrite32_relaxed(pagedir->page_entries_mapped[MALI_MMU_PDE_ENTRY(mali_address)],
-						MALI_MMU_PTE_ENTRY(mali_address) * sizeof(u32),
-						mali_phys | permission_bits);
+		mali_mmu_pagedir_range_add(&range, mali_phys);
+	}
+	mali_mmu_pagedir_range_end(&range);
+}
+
+void mali_mmu_pagedir_range_begin(struct mali_mmu_pagedir_range *range, struct mali_page_directory *pagedir,
+				  u32 mali_address, u32 permission_bits)
+{
+	MALI_DEBUG_ASSERT_POINTER(range);
+	MALI_DEBUG_ASSERT_POINTER(pagedir);
+	MALI_DEBUG_ASSERT(0 == (mali_address & (MALI_MMU_PAGE_SIZE - 1)));
+
+	range->pagedir = pagedir;
+	range->entries = NULL;
+	range->index = MALI_MMU_PTE_ENTRY(mali_address);
+	range->mali_address = mali_address;
+	range->permission_bits = permission_bits;
+}
+
+void mali_mmu_pagedir_range_next_table(struct mali_mmu_pagedir_range *range)
+{
+	u32 pde_index = MALI_MMU_PDE_ENTRY(range->mali_address);
+
+	MALI_DEBUG_ASSERT_POINTER(range->pagedir->page_entries_mapped[pde_index]);
+	range->entries = range->pagedir->page_entries_mapped[pde_index];
+	range->index = MALI_MMU_PTE_ENTRY(range->mali_address);
+}
+
+void mali_mmu_pagedir_range_end(struct mali_mmu_pagedir_range *range)
+{
+	if (NULL != range->entries) {
+		_mali_osk_write_mem_barrier();
+		range->entries = NULL;
 	}
 }
 
@@ -81,6 +81,8 @@ struct mali_page_directory {
 
 	mali_io_address page_entries_mapped[1024]; /**< Pointers to the page tables which exists in the page directory mapped into the kernel's address space */
 	u32   page_entries_usage_count[1024]; /**< Tracks usage count of the page table pages, so they can be releases on the last reference */
+	u32   page_table_count; /**< Number of page table pages currently in the page directory */
+	u32   page_table_allocs; /**< Number of page table pages allocated since the page directory was created */
 };
 
 /* Map Mali virtual address space (i.e. ensure page tables exist for the virtual range)  */
@@ -91,6 +93,59 @@ _mali_osk_errcode_t mali_mmu_pagedir_unmap(struct mali_page_directory *pagedir,
 void mali_mmu_pagedir_update(struct mali_page_directory *pagedir, u32 mali_address,
 			     mali_dma_addr phys_address, u32 size, u32 permission_bits);
 
+/**
+ * Batched update of consecutive page table entries.
+ *
+ * Backs a virtual range with pages given one at a time, e.g. while walking a
+ * page list. Entries are written with relaxed writes, and a single write barrier
+ * is issued for each page table once it has been filled, and in
+ * mali_mmu_pagedir_range_end(). The virtual range must have been prepared with
+ * mali_mmu_pagedir_map() first.
+ */
+struct mali_mmu_pagedir_range {
+	struct mali_page_directory *pagedir;
+	mali_io_address entries; /**< Page table of next address, NULL if not looked up yet */
+	u32 index;              /**< Page table index of next address */
+	u32 mali_address;       /**< Next address to map */
+	u32 permission_bits;
+};
+
+void mali_mmu_pagedir_range_begin(struct mali_mmu_pagedir_range *range, struct mali_page_directory *pagedir,
+				  u32 mali_address, u32 permission_bits);
+void mali_mmu_pagedir_range_next_table(struct mali_mmu_pagedir_range *range);
+void mali_mmu_pagedir_range_end(struct mali_mmu_pagedir_range *range);
+
+/* Map the next page of the range */
+MALI_STATIC_INLINE void mali_mmu_pagedir_range_add(struct mali_mmu_pagedir_range *range, mali_dma_addr phys_address)
+{
+	if (unlikely(NULL == range->entries)) {
+		mali_mmu_pagedir_range_next_table(range);
+	}
+
+	_mali_osk_mem_iowrite32_relaxed(range->entries, range->index * sizeof(u32),
+					(u32)phys_address | range->permission_bits);
+	range->mali_address += MALI_MMU_PAGE_SIZE;
+
+	if (unlikely(1024 == ++range->index)) {
+		/* Page table filled, make the entries visible before moving on. */
+		_mali_osk_write_mem_barrier();
+		range->entries = NULL;
+	}
+}
+
+/* Skip the next page of the range, leaving its entry untouched */
+MALI_STATIC_INLINE void mali_mmu_pagedir_range_skip(struct mali_mmu_pagedir_range *range)
+{
+	range->mali_address += MALI_MMU_PAGE_SIZE;
+
+	if (unlikely(1024 == ++range->index)) {
+		if (NULL != range->entries) {
+			_mali_osk_write_mem_barrier();
+		}
+		range->entries = NULL;
+	}
+}
+
 u32 mali_allocate_empty_page(mali_io_address *virtual);
 void mali_free_empty_page(mali_dma_addr address, mali_io_address virt_addr);
 _mali_osk_errcode_t mali_create_fault_flush_pages(mali_dma_addr *page_directory,
@@ -345,6 +345,12 @@ void _mali_osk_atomic_inc(_mali_osk_atomic_t *atom);
  * @param atom pointer to an atomic counter */
 u32 _mali_osk_atomic_inc_return(_mali_osk_atomic_t *atom);
 
+/** @brief Increment an atomic counter, unless it is zero
+ *
+ * @param atom pointer to an atomic counter
+ * @return MALI_TRUE if the counter was incremented, MALI_FALSE if it was zero */
+mali_bool _mali_osk_atomic_inc_not_zero(_mali_osk_atomic_t *atom);
+
 /** @brief Initialize an atomic counter
  *
  * @note the parameter required is a u32, and so signed integers should be
@@ -520,6 +526,59 @@ void *_mali_osk_memcpy(void *dst, const void *src, u32 len);
 void *_mali_osk_memset(void *s, u32 c, u32 n);
 /** @} */ /* end group _mali_osk_memory */
 
+/** @addtogroup _mali_osk_object_pool
+ * @{ */
+
+/** @brief Create a pool of fixed size objects.
+ *
+ * Objects are taken from a per pool cache of recently freed objects when
+ * possible, and only fall back to the system allocator when that is empty.
+ * This keeps allocator calls off the job submit and completion paths for
+ * objects which are created and destroyed at a high rate.
+ *
+ * @param name Name of the pool, used for statistics.
+ * @param object_size Size of each object in bytes.
+ * @param max_cached Maximum number of freed objects kept for reuse.
+ * @return New pool, or NULL on error.
+ */
+_mali_osk_object_pool_t *_mali_osk_object_pool_create(const char *name, u32 object_size, u32 max_cached);
+
+/** @brief Destroy an object pool.
+ *
+ * All objects allocated from the pool must have been freed back to it.
+ *
+ * @param pool Pool to destroy.
+ */
+void _mali_osk_object_pool_destroy(_mali_osk_object_pool_t *pool);
+
+/** @brief Allocate a zero-initialized object from a pool.
+ *
+ * May sleep if the system allocator has to be used.
+ *
+ * @param pool Pool to allocate from.
+ * @return Pointer to object, or NULL on error.
+ */
+void *_mali_osk_object_pool_alloc(_mali_osk_object_pool_t *pool);
+
+/** @brief Return an object to the pool it was allocated from.
+ *
+ * Can be called from any context. It is legal to free the NULL pointer.
+ *
+ * @param pool Pool the object was allocated from.
+ * @param object Object to free.
+ */
+void _mali_osk_object_pool_free(_mali_osk_object_pool_t *pool, void *object);
+
+/** @brief Print hit/miss statistics for all object pools.
+ *
+ * @param print_ctx Print context.
+ */
+void _mali_osk_object_pool_print_stats(_mali_osk_print_ctx *print_ctx);
+
+/** @brief Reset statistics for all object pools. */
+void _mali_osk_object_pool_reset_stats(void);
+/** @} */ /* end group _mali_osk_object_pool */
+
 
 /** @brief Checks the amount of memory allocated
  *
@@ -818,6 +877,22 @@ u32 _mali_osk_mem_write_safe(void *dest, const void *src, u32 size);
  */
 _mali_osk_notification_t *_mali_osk_notification_create(u32 type, u32 size);
 
+/** @brief Set up the notification object pool
+ *
+ * Notifications with small result buffers are allocated from a pool after
+ * this has been called. Larger notifications, or all notifications before
+ * this is called, are allocated directly from the system.
+ *
+ * @return _MALI_OSK_ERR_OK on success, otherwise failure.
+ */
+_mali_osk_errcode_t _mali_osk_notification_initialize(void);
+
+/** @brief Tear down the notification object pool
+ *
+ * All pooled notifications must have been deleted.
+ */
+void _mali_osk_notification_terminate(void);
+
 /** @brief Delete a notification object
  *
  * This must be called to reclaim the resources of a notification object. This
@@ -1163,6 +1238,17 @@ u32 _mali_osk_clz(u32 val);
  */
 u32 _mali_osk_fls(u32 val);
 
+/** @brief Divide a 64-bit value by a 32-bit divisor
+ *
+ * Not all architectures provide a native 64-bit divide, so common code
+ * must use this function instead of the / operator on u64 values.
+ *
+ * @param dividend 64-bit value to divide
+ * @param divisor 32-bit divisor, must not be 0
+ * @return the quotient.
+ */
+u64 _mali_osk_div_u64(u64 dividend, u32 divisor);
+
 /** @} */ /* end group _mali_osk_math */
 
 /** @addtogroup _mali_osk_wait_queue OSK Wait Queue functionality
@@ -444,6 +444,12 @@ typedef struct _mali_osk_resource {
 typedef struct _mali_osk_wait_queue_t_struct _mali_osk_wait_queue_t;
 /** @} */ /* end group _mali_osk_wait_queue */
 
+/** @defgroup _mali_osk_object_pool OSK Object Pools
+ * @{ */
+/** @brief Private type for fixed size object pools */
+typedef struct _mali_osk_object_pool_t_struct _mali_osk_object_pool_t;
+/** @} */ /* end group _mali_osk_object_pool */
+
 /** @} */ /* end group osuapi */
 
 /** @} */ /* end group uddapi */
@@ -19,6 +19,7 @@
 #include "linux/mali_memory_dma_buf.h"
 #endif
 #include "mali_memory_swap_alloc.h"
+#include "mali_memory_manager.h"
 #include "mali_scheduler.h"
 
 static u32 pp_counter_src0 = MALI_HW_CORE_NO_COUNTER;   /**< Performance counter 0, MALI_HW_CORE_NO_COUNTER for disabled */
@@ -27,30 +28,51 @@ static _mali_osk_atomic_t pp_counter_per_sub_job_count; /**< Number of values in
 static u32 pp_counter_per_sub_job_src0[_MALI_PP_MAX_SUB_JOBS] = { MALI_HW_CORE_NO_COUNTER, MALI_HW_CORE_NO_COUNTER, MALI_HW_CORE_NO_COUNTER, MALI_HW_CORE_NO_COUNTER, MALI_HW_CORE_NO_COUNTER, MALI_HW_CORE_NO_COUNTER, MALI_HW_CORE_NO_COUNTER, MALI_HW_CORE_NO_COUNTER };
 static u32 pp_counter_per_sub_job_src1[_MALI_PP_MAX_SUB_JOBS] = { MALI_HW_CORE_NO_COUNTER, MALI_HW_CORE_NO_COUNTER, MALI_HW_CORE_NO_COUNTER, MALI_HW_CORE_NO_COUNTER, MALI_HW_CORE_NO_COUNTER, MALI_HW_CORE_NO_COUNTER, MALI_HW_CORE_NO_COUNTER, MALI_HW_CORE_NO_COUNTER };
 
-void mali_pp_job_initialize(void)
+#define MALI_PP_JOB_POOL_MAX_CACHED 64
+
+static _mali_osk_object_pool_t *pp_job_pool = NULL; /**< Recycled PP job objects */
+
+_mali_osk_errcode_t mali_pp_job_initialize(void)
 {
 	_mali_osk_atomic_init(&pp_counter_per_sub_job_count, 0);
+
+	pp_job_pool = _mali_osk_object_pool_create("mali_pp_job", sizeof(struct mali_pp_job),
+			MALI_PP_JOB_POOL_MAX_CACHED);
+	if (NULL == pp_job_pool) {
+		return _MALI_OSK_ERR_NOMEM;
+	}
+
+	return _MALI_OSK_ERR_OK;
 }
 
 void mali_pp_job_terminate(void)
 {
+	if (NULL != pp_job_pool) {
+		_mali_osk_object_pool_destroy(pp_job_pool);
+		pp_job_pool = NULL;
+	}
+
 	_mali_osk_atomic_term(&pp_counter_per_sub_job_count);
 }
 
-struct mali_pp_job *mali_pp_job_create(struct mali_session_data *session,
-				       _mali_uk_pp_start_job_s __user *uargs, u32 id)
+static struct mali_pp_job *mali_pp_job_create_internal(struct mali_session_data *session,
+		_mali_uk_pp_start_job_s __user *uargs,
+		const _mali_uk_pp_start_job_s *kargs, u32 id)
 {
 	struct mali_pp_job *job;
 	u32 perf_counter_flag;
 
-	job = _mali_osk_calloc(1, sizeof(struct mali_pp_job));
+	job = _mali_osk_object_pool_alloc(pp_job_pool);
 	if (NULL != job) {
 
 		_mali_osk_list_init(&job->list);
 		_mali_osk_list_init(&job->session_fb_lookup_list);
+		_mali_osk_list_init(&job->swap_in_list);
 		_mali_osk_atomic_inc(&session->number_of_pp_jobs);
 
-		if (0 != _mali_osk_copy_from_user(&job->uargs, uargs, sizeof(_mali_uk_pp_start_job_s))) {
+		if (NULL != kargs) {
+			_mali_osk_memcpy(&job->uargs, kargs, sizeof(_mali_uk_pp_start_job_s));
+		} else if (0 != _mali_osk_copy_from_user(&job->uargs, uargs, sizeof(_mali_uk_pp_start_job_s))) {
 			goto fail;
 		}
 
@@ -94,6 +116,7 @@ struct mali_pp_job *mali_pp_job_create(struct mali_session_data *session,
 		_mali_osk_atomic_init(&job->sub_jobs_completed, 0);
 		_mali_osk_atomic_init(&job->sub_job_errors, 0);
 		job->swap_status = MALI_NO_SWAP_IN;
+		job->swap_in_pending = MALI_FALSE;
 		job->user_notification = MALI_FALSE;
 		job->num_pp_cores_in_virtual = 0;
 
@@ -104,18 +127,29 @@ struct mali_pp_job *mali_pp_job_create(struct mali_session_data *session,
 
 		if (job->uargs.num_memory_cookies > 0) {
 			u32 size;
+			u32 *cookies;
+			_mali_osk_errcode_t err;
 			u32 __user *memory_cookies = (u32 __user *)(uintptr_t)job->uargs.memory_cookies;
 
 			size = sizeof(*memory_cookies) * (job->uargs.num_memory_cookies);
 
-			job->memory_cookies = _mali_osk_malloc(size);
-			if (NULL == job->memory_cookies) {
+			cookies = _mali_osk_malloc(size);
+			if (NULL == cookies) {
 				MALI_PRINT_ERROR(("Mali PP job: Failed to allocate %d bytes of memory cookies!\n", size));
 				goto fail;
 			}
 
-			if (0 != _mali_osk_copy_from_user(job->memory_cookies, memory_cookies, size)) {
+			if (0 != _mali_osk_copy_from_user(cookies, memory_cookies, size)) {
 				MALI_PRINT_ERROR(("Mali PP job: Failed to copy %d bytes of memory cookies from user!\n", size));
+				_mali_osk_free(cookies);
+				goto fail;
+			}
+
+			/* Later stages of the job only work on the resolved backends */
+			err = mali_mem_backend_resolve_job(job, cookies);
+			_mali_osk_free(cookies);
+			if (_MALI_OSK_ERR_OK != err) {
+				MALI_PRINT_ERROR(("Mali PP job: Failed to resolve memory cookies!\n"));
 				goto fail;
 			}
 		}
@@ -141,6 +175,19 @@ fail:
 	return NULL;
 }
 
+struct mali_pp_job *mali_pp_job_create(struct mali_session_data *session,
+				       _mali_uk_pp_start_job_s __user *uargs, u32 id)
+{
+	return mali_pp_job_create_internal(session, uargs, NULL, id);
+}
+
+struct mali_pp_job *mali_pp_job_create_from_kargs(struct mali_session_data *session,
+		const _mali_uk_pp_start_job_s *kargs, u32 id)
+{
+	MALI_DEBUG_ASSERT_POINTER(kargs);
+	return mali_pp_job_create_internal(session, NULL, kargs, id);
+}
+
 void mali_pp_job_delete(struct mali_pp_job *job)
 {
 	struct mali_session_data *session;
@@ -152,7 +199,7 @@ void mali_pp_job_delete(struct mali_pp_job *job)
 	session = mali_pp_job_get_session(job);
 	MALI_DEBUG_ASSERT_POINTER(session);
 
-	if (NULL != job->memory_cookies) {
+	if (NULL != job->memory_backends) {
 #if defined(CONFIG_DMA_SHARED_BUFFER) && !defined(CONFIG_MALI_DMA_BUF_MAP_ON_ATTACH)
 		/* Unmap buffers attached to job */
 		mali_dma_buf_unmap_job(job);
@@ -161,7 +208,7 @@ void mali_pp_job_delete(struct mali_pp_job *job)
 			mali_mem_swap_out_pages(job);
 		}
 
-		_mali_osk_free(job->memory_cookies);
+		mali_mem_backend_release_job(job);
 	}
 
 	if (job->user_notification) {
@@ -173,10 +220,22 @@ void mali_pp_job_delete(struct mali_pp_job *job)
 		_mali_osk_notification_delete(job->finished_notification);
 	}
 
+#if defined(CONFIG_MALI_DMA_BUF_FENCE)
+	/* A preallocated out-fence is still set if the job never ran */
+	if (NULL != job->rendered_dma_fence) {
+		mali_dma_fence_signal_error_and_put(&job->rendered_dma_fence, -ECANCELED);
+	}
+#if defined(MALI_DMA_FENCE_SYNC_FILE)
+	if (NULL != job->in_fence) {
+		dma_fence_put(job->in_fence);
+	}
+#endif
+#endif
+
 	_mali_osk_atomic_term(&job->sub_jobs_completed);
 	_mali_osk_atomic_term(&job->sub_job_errors);
 	_mali_osk_atomic_dec(&session->number_of_pp_jobs);
-	_mali_osk_free(job);
+	_mali_osk_object_pool_free(pp_job_pool, job);
 
 	_mali_osk_wait_queue_wake_up(session->wait_queue);
 }
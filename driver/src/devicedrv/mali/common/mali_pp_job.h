@@ -35,6 +35,8 @@ typedef enum pp_job_status {
 	MALI_SWAP_IN_SUCC,
 } pp_job_status;
 
+struct mali_mem_backend;
+
 /**
  * This structure represents a PP job, including all sub jobs.
  *
@@ -65,6 +67,9 @@ struct mali_pp_job {
 	u32 sub_jobs_num;                                  /**< Number of subjobs; set to 1 for Mali-450 if DLBU is used, otherwise equals number of PP cores */
 
 	pp_job_status swap_status;                         /**< Used to track each PP job swap status, if fail, we need to drop them in scheduler part */
+	mali_bool swap_in_pending;                         /**< MALI_TRUE if swap in is left to the swap in worker, the job waits for it in the timeline system */
+	_mali_osk_list_t swap_in_list;                     /**< Link in the swap in worker's job list */
+	u64 swap_in_start;                                 /**< Time the job was handed to the swap in worker, in ns */
 	mali_bool user_notification;                       /**< When we deferred delete PP job, we need to judge if we need to send job finish notification to user space */
 	u32 num_pp_cores_in_virtual;                       /**< How many PP cores we have when job finished */
 
@@ -80,7 +85,11 @@ struct mali_pp_job {
 	 * knows about this job object but the working function.
 	 * No lock is thus needed for these.
 	 */
-	u32 *memory_cookies;                               /**< Memory cookies attached to job */
+	struct mali_mem_backend **memory_backends;         /**< Backends of the memory cookies attached to job, swappable ones first, then dma-buf ones */
+	u32 num_swap_backends;                             /**< Number of swappable backends in memory_backends */
+	u32 num_dma_buf_backends;                          /**< Number of dma-buf backends in memory_backends */
+	u32 num_swapped_in_backends;                       /**< Swappable backends counted as in use by this job, the first ones of memory_backends */
+	mali_bool memory_cookies_invalid;                  /**< A memory cookie does not belong to any allocation of the session */
 
 	/*
 	 * These members are used by the scheduler,
@@ -90,6 +99,9 @@ struct mali_pp_job {
 	_mali_osk_list_t session_fb_lookup_list;           /**< Used to link jobs together from the same frame builder in the session */
 
 	u32 sub_jobs_started;                              /**< Total number of sub-jobs started (always started in ascending order) */
+	u64 sched_vtime;                                   /**< Virtual start time the PP scheduling policy orders the job by */
+	u64 time_queued;                                   /**< Time (ns) the job was added to the scheduler queue */
+	u64 time_started;                                  /**< Time (ns) the first sub-job was started, 0 if not started */
 
 	/*
 	 * Set by executor/group on job completion, read by scheduler when
@@ -106,13 +118,18 @@ struct mali_pp_job {
 #else
 	struct fence *rendered_dma_fence; /**< the new dma fence link to this job */
 #endif
+#if defined(MALI_DMA_FENCE_SYNC_FILE)
+	struct dma_fence *in_fence; /**< Explicit sync_file fence this job waits for, or NULL */
+#endif
 #endif
 };
 
-void mali_pp_job_initialize(void);
+_mali_osk_errcode_t mali_pp_job_initialize(void);
 void mali_pp_job_terminate(void);
 
 struct mali_pp_job *mali_pp_job_create(struct mali_session_data *session, _mali_uk_pp_start_job_s *uargs, u32 id);
+/* Same as mali_pp_job_create(), but with the job arguments already copied from user space */
+struct mali_pp_job *mali_pp_job_create_from_kargs(struct mali_session_data *session, const _mali_uk_pp_start_job_s *kargs, u32 id);
 void mali_pp_job_delete(struct mali_pp_job *job);
 
 u32 mali_pp_job_get_perf_counter_src0(struct mali_pp_job *job, u32 sub_job);
@@ -419,20 +436,47 @@ MALI_STATIC_INLINE u32 mali_pp_job_num_memory_cookies(struct mali_pp_job *job)
 	return job->uargs.num_memory_cookies;
 }
 
-MALI_STATIC_INLINE u32 mali_pp_job_get_memory_cookie(
+MALI_STATIC_INLINE mali_bool mali_pp_job_has_invalid_memory_cookies(struct mali_pp_job *job)
+{
+	MALI_DEBUG_ASSERT_POINTER(job);
+	return job->memory_cookies_invalid;
+}
+
+MALI_STATIC_INLINE u32 mali_pp_job_num_swap_backends(struct mali_pp_job *job)
+{
+	MALI_DEBUG_ASSERT_POINTER(job);
+	return job->num_swap_backends;
+}
+
+MALI_STATIC_INLINE struct mali_mem_backend *mali_pp_job_get_swap_backend(
+	struct mali_pp_job *job, u32 index)
+{
+	MALI_DEBUG_ASSERT_POINTER(job);
+	MALI_DEBUG_ASSERT(index < job->num_swap_backends);
+	MALI_DEBUG_ASSERT_POINTER(job->memory_backends);
+	return job->memory_backends[index];
+}
+
+MALI_STATIC_INLINE u32 mali_pp_job_num_dma_buf_backends(struct mali_pp_job *job)
+{
+	MALI_DEBUG_ASSERT_POINTER(job);
+	return job->num_dma_buf_backends;
+}
+
+MALI_STATIC_INLINE struct mali_mem_backend *mali_pp_job_get_dma_buf_backend(
 	struct mali_pp_job *job, u32 index)
 {
 	MALI_DEBUG_ASSERT_POINTER(job);
-	MALI_DEBUG_ASSERT(index < job->uargs.num_memory_cookies);
-	MALI_DEBUG_ASSERT_POINTER(job->memory_cookies);
-	return job->memory_cookies[index];
+	MALI_DEBUG_ASSERT(index < job->num_dma_buf_backends);
+	MALI_DEBUG_ASSERT_POINTER(job->memory_backends);
+	return job->memory_backends[job->num_swap_backends + index];
 }
 
 MALI_STATIC_INLINE mali_bool mali_pp_job_needs_dma_buf_mapping(struct mali_pp_job *job)
 {
 	MALI_DEBUG_ASSERT_POINTER(job);
 
-	if (0 < job->uargs.num_memory_cookies) {
+	if (0 < job->num_dma_buf_backends) {
 		return MALI_TRUE;
 	}
 
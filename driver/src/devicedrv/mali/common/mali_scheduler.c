@@ -9,6 +9,7 @@
  */
 
 #include "mali_scheduler.h"
+#include "mali_scheduler_policy.h"
 #include "mali_kernel_common.h"
 #include "mali_osk.h"
 #include "mali_osk_profiling.h"
@@ -16,6 +17,7 @@
 #include "mali_timeline.h"
 #include "mali_gp_job.h"
 #include "mali_pp_job.h"
+#include "mali_soft_job.h"
 #include "mali_executor.h"
 #include "mali_group.h"
 #include <linux/wait.h>
@@ -27,6 +29,11 @@
 #if defined(CONFIG_MALI_DMA_BUF_FENCE)
 #include "mali_dma_fence.h"
 #include <linux/dma-buf.h>
+#if defined(MALI_DMA_FENCE_SYNC_FILE)
+#include <linux/fcntl.h>
+#include <linux/file.h>
+#include <linux/sync_file.h>
+#endif
 #endif
 #endif
 
@@ -48,6 +55,14 @@
 #endif
 #endif
 
+#if defined(MALI_DMA_FENCE_SYNC_FILE)
+/* Out-fence of a batch job, the fd is only installed once the job is started. */
+struct mali_scheduler_batch_out_fence {
+	struct sync_file *sync_file;
+	int fd;
+};
+#endif
+
 
 /*
  * ---------- global variables (exported due to inline functions) ----------
@@ -56,6 +71,9 @@
 /* Lock protecting this module */
 _mali_osk_spinlock_irq_t *mali_scheduler_lock_obj = NULL;
 
+/* Contention statistics of the scheduler lock */
+struct mali_scheduler_lock_stats mali_scheduler_lock_stats;
+
 /* Queue of jobs to be executed on the GP group */
 struct mali_scheduler_job_queue job_queue_gp;
 
@@ -78,6 +96,9 @@ static _mali_osk_spinlock_irq_t *scheduler_pp_job_queue_lock = NULL;
 static _MALI_OSK_LIST_HEAD_STATIC_INIT(scheduler_pp_job_queue_list);
 #endif
 
+/* GP end to dependent PP start latency, protected by the scheduler lock */
+static struct mali_scheduler_gp_pp_latency_stats gp_pp_latency_stats;
+
 /*
  * ---------- Forward declaration of static functions ----------
  */
@@ -85,10 +106,29 @@ static _MALI_OSK_LIST_HEAD_STATIC_INIT(scheduler_pp_job_queue_list);
 static mali_timeline_point mali_scheduler_submit_gp_job(
 	struct mali_session_data *session, struct mali_gp_job *job);
 static _mali_osk_errcode_t mali_scheduler_submit_pp_job(
-	struct mali_session_data *session, struct mali_pp_job *job, mali_timeline_point *point);
+	struct mali_session_data *session, struct mali_pp_job *job,
+	enum mali_timeline_id timeline_id, mali_timeline_point *point);
 
 static mali_bool mali_scheduler_queue_gp_job(struct mali_gp_job *job);
 static mali_bool mali_scheduler_queue_pp_job(struct mali_pp_job *job);
+static void mali_scheduler_gp_pp_latency_record(struct mali_pp_job *job);
+
+static mali_bool mali_scheduler_batch_job_timelines_valid(
+	struct mali_session_data *session, _mali_uk_batch_job_s *desc);
+static _mali_osk_errcode_t mali_scheduler_batch_job_create(
+	struct mali_session_data *session, _mali_uk_batch_job_s *desc,
+	struct mali_timeline_batch_entry *entry);
+static void mali_scheduler_batch_job_delete(_mali_uk_batch_job_s *desc,
+		struct mali_timeline_batch_entry *entry);
+static void mali_scheduler_batch_job_prepare(_mali_uk_batch_job_s *desc,
+		struct mali_timeline_batch_entry *entry);
+static mali_bool mali_scheduler_batch_job_flags_valid(_mali_uk_batch_job_s *desc);
+#if defined(MALI_DMA_FENCE_SYNC_FILE)
+static _mali_osk_errcode_t mali_scheduler_batch_job_fences_get(_mali_uk_batch_job_s *desc,
+		struct mali_timeline_batch_entry *entry,
+		struct mali_scheduler_batch_out_fence *out_fence);
+static void mali_scheduler_batch_out_fence_put(struct mali_scheduler_batch_out_fence *out_fence);
+#endif
 
 static void mali_scheduler_return_gp_job_to_user(struct mali_gp_job *job,
 		mali_bool success);
@@ -127,6 +167,11 @@ _mali_osk_errcode_t mali_scheduler_initialize(void)
 		mali_scheduler_terminate();
 	}
 
+	if (_MALI_OSK_ERR_OK != mali_scheduler_pp_policy_initialize()) {
+		mali_scheduler_terminate();
+		return _MALI_OSK_ERR_FAULT;
+	}
+
 	scheduler_wq_pp_job_delete = _mali_osk_wq_create_work(
 					     mali_scheduler_do_pp_job_delete, NULL);
 	if (NULL == scheduler_wq_pp_job_delete) {
@@ -437,6 +482,10 @@ struct mali_pp_job *mali_scheduler_job_pp_physical_get(u32 *sub_job)
 		*sub_job = mali_pp_job_get_first_unstarted_sub_job(job);
 
 		mali_pp_job_mark_sub_job_started(job, *sub_job);
+		if (0 == *sub_job) {
+			mali_scheduler_pp_policy_job_started(job);
+			mali_scheduler_gp_pp_latency_record(job);
+		}
 		if (MALI_FALSE == mali_pp_job_has_unstarted_sub_jobs(job)) {
 			/* Remove from queue when last sub job has been retrieved */
 			mali_pp_job_list_remove(job);
@@ -467,6 +516,8 @@ struct mali_pp_job *mali_scheduler_job_pp_virtual_get(void)
 				  mali_pp_job_get_sub_job_count(job));
 
 		mali_pp_job_mark_sub_job_started(job, 0);
+		mali_scheduler_pp_policy_job_started(job);
+		mali_scheduler_gp_pp_latency_record(job);
 
 		mali_pp_job_list_remove(job);
 
@@ -593,11 +644,22 @@ void mali_scheduler_complete_pp_job(struct mali_pp_job *job,
 	job->num_pp_cores_in_virtual = num_cores_in_virtual;
 
 #if defined(CONFIG_MALI_DMA_BUF_FENCE)
-	if (NULL != job->rendered_dma_fence)
-		mali_dma_fence_signal_and_put(&job->rendered_dma_fence);
+	if (NULL != job->rendered_dma_fence) {
+		if (MALI_TRUE == mali_pp_job_was_success(job)) {
+			mali_dma_fence_signal_and_put(&job->rendered_dma_fence);
+		} else {
+			mali_dma_fence_signal_error_and_put(&job->rendered_dma_fence, -EIO);
+		}
+	}
 #endif
 
 	if (dequeued) {
+		mali_scheduler_lock();
+		mali_scheduler_pp_policy_job_completed(job,
+				mali_pp_job_is_virtual(job) ? num_cores_in_virtual :
+				mali_pp_job_get_sub_job_count(job));
+		mali_scheduler_unlock();
+
 #if defined(CONFIG_MALI_DVFS)
 		if (mali_pp_job_is_window_surface(job)) {
 			struct mali_session_data *session;
@@ -781,10 +843,16 @@ _mali_osk_errcode_t _mali_ukk_pp_start_job(void *ctx,
 		return _MALI_OSK_ERR_NOMEM;
 	}
 
+	if (MALI_TRUE == mali_pp_job_has_invalid_memory_cookies(job)) {
+		MALI_PRINT_ERROR(("Failed to find the memory backends for the memory cookies.\n"));
+		mali_pp_job_delete(job);
+		return _MALI_OSK_ERR_INVALID_ARGS;
+	}
+
 	point_ptr = (u32 __user *)(uintptr_t)mali_pp_job_get_timeline_point_ptr(job);
 
 	/* Submit PP job. */
-	ret = mali_scheduler_submit_pp_job(session, job, &point);
+	ret = mali_scheduler_submit_pp_job(session, job, MALI_TIMELINE_PP, &point);
 	job = NULL;
 
 	if (_MALI_OSK_ERR_OK == ret) {
@@ -833,6 +901,12 @@ _mali_osk_errcode_t _mali_ukk_pp_and_gp_start_job(void *ctx,
 		return _MALI_OSK_ERR_NOMEM;
 	}
 
+	if (MALI_TRUE == mali_pp_job_has_invalid_memory_cookies(pp_job)) {
+		MALI_PRINT_ERROR(("Failed to find the memory backends for the memory cookies.\n"));
+		mali_pp_job_delete(pp_job);
+		return _MALI_OSK_ERR_INVALID_ARGS;
+	}
+
 	gp_job = mali_gp_job_create(session, gp_args,
 				    mali_scheduler_get_new_id(),
 				    mali_pp_job_get_tracker(pp_job));
@@ -849,7 +923,7 @@ _mali_osk_errcode_t _mali_ukk_pp_and_gp_start_job(void *ctx,
 	gp_job = NULL;
 
 	/* Submit PP job. */
-	ret = mali_scheduler_submit_pp_job(session, pp_job, &point);
+	ret = mali_scheduler_submit_pp_job(session, pp_job, MALI_TIMELINE_PP, &point);
 	pp_job = NULL;
 
 	if (_MALI_OSK_ERR_OK == ret) {
@@ -865,6 +939,287 @@ _mali_osk_errcode_t _mali_ukk_pp_and_gp_start_job(void *ctx,
 	return ret;
 }
 
+_mali_osk_errcode_t _mali_ukk_submit_batch(void *ctx,
+		_mali_uk_submit_batch_s *uargs)
+{
+	_mali_osk_errcode_t ret = _MALI_OSK_ERR_OK;
+	struct mali_session_data *session;
+	_mali_uk_submit_batch_s kargs;
+	_mali_uk_batch_job_s __user *ujobs;
+	_mali_uk_batch_job_s *jobs = NULL;
+	struct mali_timeline_batch_entry *entries = NULL;
+#if defined(MALI_DMA_FENCE_SYNC_FILE)
+	struct mali_scheduler_batch_out_fence *out_fences = NULL;
+#endif
+	u32 num_created = 0;
+	u32 num_started = 0;
+	u32 i;
+
+	MALI_DEBUG_ASSERT_POINTER(ctx);
+	MALI_DEBUG_ASSERT_POINTER(uargs);
+
+	session = (struct mali_session_data *)ctx;
+
+	if (0 != _mali_osk_copy_from_user(&kargs, uargs,
+					  sizeof(_mali_uk_submit_batch_s))) {
+		return _MALI_OSK_ERR_FAULT;
+	}
+
+	if (0 == kargs.num_jobs ||
+	    _MALI_UK_SUBMIT_BATCH_MAX_JOBS < kargs.num_jobs) {
+		return _MALI_OSK_ERR_INVALID_ARGS;
+	}
+
+	MALI_DEBUG_ASSERT(MALI_TIMELINE_BATCH_MAX >= _MALI_UK_SUBMIT_BATCH_MAX_JOBS);
+
+	ujobs = (_mali_uk_batch_job_s __user *)(uintptr_t)kargs.jobs;
+
+	jobs = _mali_osk_malloc(sizeof(_mali_uk_batch_job_s) * kargs.num_jobs);
+	entries = _mali_osk_calloc(kargs.num_jobs,
+				   sizeof(struct mali_timeline_batch_entry));
+	if (NULL == jobs || NULL == entries) {
+		ret = _MALI_OSK_ERR_NOMEM;
+		goto out;
+	}
+
+#if defined(MALI_DMA_FENCE_SYNC_FILE)
+	out_fences = _mali_osk_calloc(kargs.num_jobs,
+				      sizeof(struct mali_scheduler_batch_out_fence));
+	if (NULL == out_fences) {
+		ret = _MALI_OSK_ERR_NOMEM;
+		goto out;
+	}
+#endif
+
+	/* Copy all job descriptors with a single copy. */
+	if (0 != _mali_osk_copy_from_user(jobs, ujobs,
+					  sizeof(_mali_uk_batch_job_s) * kargs.num_jobs)) {
+		ret = _MALI_OSK_ERR_FAULT;
+		goto out;
+	}
+
+	/* Validate the whole batch before any job is created. */
+	for (i = 0; i < kargs.num_jobs; i++) {
+		if (0 != (jobs[i].depends_on >> i)) {
+			MALI_PRINT_ERROR(("Mali scheduler: Batch job %u depends on a later job.\n", i));
+			ret = _MALI_OSK_ERR_INVALID_ARGS;
+			goto out;
+		}
+
+		switch (jobs[i].type) {
+		case _MALI_UK_BATCH_JOB_GP:
+		case _MALI_UK_BATCH_JOB_PP:
+			break;
+		case _MALI_UK_BATCH_JOB_SOFT:
+			if (MALI_SOFT_JOB_TYPE_USER_SIGNALED != jobs[i].args.soft.type &&
+			    MALI_SOFT_JOB_TYPE_SELF_SIGNALED != jobs[i].args.soft.type) {
+				ret = _MALI_OSK_ERR_INVALID_ARGS;
+				goto out;
+			}
+			break;
+		default:
+			MALI_PRINT_ERROR(("Mali scheduler: Batch job %u has invalid type %u.\n", i, jobs[i].type));
+			ret = _MALI_OSK_ERR_INVALID_ARGS;
+			goto out;
+		}
+
+		if (!mali_scheduler_batch_job_timelines_valid(session, &jobs[i])) {
+			MALI_PRINT_ERROR(("Mali scheduler: Batch job %u uses an invalid timeline.\n", i));
+			ret = _MALI_OSK_ERR_INVALID_ARGS;
+			goto out;
+		}
+
+		if (!mali_scheduler_batch_job_flags_valid(&jobs[i])) {
+			MALI_PRINT_ERROR(("Mali scheduler: Batch job %u has unsupported flags 0x%x.\n", i, jobs[i].flags));
+			ret = _MALI_OSK_ERR_INVALID_ARGS;
+			goto out;
+		}
+	}
+
+	/* Create all jobs, nothing is started unless all could be created. */
+	for (num_created = 0; num_created < kargs.num_jobs; num_created++) {
+		ret = mali_scheduler_batch_job_create(session, &jobs[num_created],
+						      &entries[num_created]);
+		if (_MALI_OSK_ERR_OK != ret) {
+			goto out;
+		}
+
+		entries[num_created].deps = jobs[num_created].depends_on;
+
+#if defined(MALI_DMA_FENCE_SYNC_FILE)
+		ret = mali_scheduler_batch_job_fences_get(&jobs[num_created],
+				&entries[num_created], &out_fences[num_created]);
+		if (_MALI_OSK_ERR_OK != ret) {
+			/* The job itself was created, delete it with the others. */
+			num_created++;
+			goto out;
+		}
+#endif
+	}
+
+	/* Only report soft job ids once every job of the batch has been created. */
+	for (i = 0; i < kargs.num_jobs; i++) {
+		struct mali_soft_job *soft_job;
+
+		if (_MALI_UK_BATCH_JOB_SOFT != jobs[i].type) {
+			continue;
+		}
+
+		soft_job = _MALI_OSK_CONTAINER_OF(entries[i].tracker, struct mali_soft_job, tracker);
+		if (0 != _mali_osk_put_user(soft_job->id,
+					    (u32 __user *)(uintptr_t)jobs[i].args.soft.job_id_ptr)) {
+			MALI_PRINT_ERROR(("Mali Soft Job: failed to put job id"));
+			ret = _MALI_OSK_ERR_FAULT;
+			goto out;
+		}
+	}
+
+#if !defined(CONFIG_MALI_DMA_BUF_FENCE)
+	/*
+	 * Add the PP jobs to the lookup list used to quickly discard writeback
+	 * units of queued jobs, with a single acquisition of the scheduler lock.
+	 */
+	mali_scheduler_lock();
+	for (i = 0; i < kargs.num_jobs; i++) {
+		if (_MALI_UK_BATCH_JOB_PP == jobs[i].type) {
+			mali_pp_job_fb_lookup_add((struct mali_pp_job *)entries[i].tracker->job);
+		}
+	}
+	mali_scheduler_unlock();
+
+	for (i = 0; i < kargs.num_jobs; i++) {
+		mali_scheduler_batch_job_prepare(&jobs[i], &entries[i]);
+	}
+
+	/* Add all jobs to the timelines under one lock, and schedule once. */
+	mali_timeline_system_add_tracker_batch(session->timeline_system,
+					       entries, kargs.num_jobs);
+	num_started = kargs.num_jobs;
+#else
+	/*
+	 * PP jobs might have to wait for dma fences, which is set up with the
+	 * reservation objects locked, so jobs are submitted one at a time.
+	 */
+	for (i = 0; i < kargs.num_jobs; i++) {
+		struct mali_timeline_tracker *tracker;
+		u32 j;
+
+		mali_scheduler_batch_job_prepare(&jobs[i], &entries[i]);
+
+		tracker = entries[i].tracker;
+		for (j = 0; j < i; j++) {
+			if (0 != (entries[i].deps & ((u32)1 << j))) {
+				mali_timeline_fence_add_point(&tracker->fence,
+							      entries[j].timeline_id, entries[j].point);
+			}
+		}
+
+		if (_MALI_UK_BATCH_JOB_PP == jobs[i].type) {
+			ret = mali_scheduler_submit_pp_job(session,
+							   (struct mali_pp_job *)tracker->job,
+							   entries[i].timeline_id,
+							   &entries[i].point);
+			if (_MALI_OSK_ERR_OK != ret) {
+				break;
+			}
+		} else {
+			entries[i].point = mali_timeline_system_add_tracker(
+						   session->timeline_system, tracker,
+						   entries[i].timeline_id);
+		}
+
+		num_started++;
+	}
+
+	/* Delete the failed job and the jobs following it, these were never started. */
+	if (_MALI_OSK_ERR_OK != ret) {
+		for (i = num_started; i < kargs.num_jobs; i++) {
+			mali_scheduler_batch_job_delete(&jobs[i], &entries[i]);
+		}
+		num_created = 0;
+	}
+#endif
+
+	/* Tell user space where the started jobs ended up on the timelines. */
+	for (i = 0; i < num_started; i++) {
+		u32 __user *point_ptr;
+
+		switch (jobs[i].type) {
+		case _MALI_UK_BATCH_JOB_GP:
+			point_ptr = (u32 __user *)(uintptr_t)jobs[i].args.gp.timeline_point_ptr;
+			break;
+		case _MALI_UK_BATCH_JOB_PP:
+			point_ptr = (u32 __user *)(uintptr_t)jobs[i].args.pp.timeline_point_ptr;
+			break;
+		default:
+			point_ptr = &ujobs[i].args.soft.point;
+			break;
+		}
+
+		if (0 != _mali_osk_put_user(((u32) entries[i].point), point_ptr)) {
+			/*
+			 * Let user space know that something failed
+			 * after the jobs were started.
+			 */
+			ret = _MALI_OSK_ERR_ITEM_NOT_FOUND;
+		}
+
+#if defined(MALI_DMA_FENCE_SYNC_FILE)
+		/* The job may already be gone, only the sync_file is used here. */
+		if (NULL != out_fences[i].sync_file) {
+			/*
+			 * Install the fd only once user space has been told about it,
+			 * otherwise it is released with the unused ones below.
+			 */
+			if (0 != _mali_osk_put_user(out_fences[i].fd, &ujobs[i].out_fence_fd)) {
+				ret = _MALI_OSK_ERR_ITEM_NOT_FOUND;
+			} else {
+				fd_install(out_fences[i].fd, out_fences[i].sync_file->file);
+				out_fences[i].sync_file = NULL;
+			}
+		}
+#endif
+	}
+
+	if (0 < num_started) {
+		/* All created jobs have been started or deleted. */
+		num_created = 0;
+
+		if (0 != _mali_osk_put_user(num_started, &uargs->num_started) &&
+		    _MALI_OSK_ERR_OK == ret) {
+			ret = _MALI_OSK_ERR_ITEM_NOT_FOUND;
+		}
+	}
+
+out:
+	/* Failed before anything was started, delete the jobs created so far. */
+	while (0 < num_created) {
+		num_created--;
+		mali_scheduler_batch_job_delete(&jobs[num_created],
+						&entries[num_created]);
+	}
+
+#if defined(MALI_DMA_FENCE_SYNC_FILE)
+	/* Out-fences of jobs that were not started, or whose fd could not be returned, are never handed out. */
+	if (NULL != out_fences) {
+		for (i = 0; i < kargs.num_jobs; i++) {
+			mali_scheduler_batch_out_fence_put(&out_fences[i]);
+		}
+		_mali_osk_free(out_fences);
+	}
+#endif
+
+	if (NULL != entries) {
+		_mali_osk_free(entries);
+	}
+
+	if (NULL != jobs) {
+		_mali_osk_free(jobs);
+	}
+
+	return ret;
+}
+
 void _mali_ukk_pp_job_disable_wb(_mali_uk_pp_disable_wb_s *args)
 {
 	struct mali_session_data *session;
@@ -934,7 +1289,8 @@ u32 mali_scheduler_dump_state(char *buf, u32 size)
 				"empty" : "not empty");
 
 	n += _mali_osk_snprintf(buf + n, size - n,
-				"PP queues\n");
+				"PP queues (%s policy)\n",
+				mali_scheduler_pp_policy_name());
 	n += _mali_osk_snprintf(buf + n, size - n,
 				"\tQueue depth: %u\n", job_queue_pp.depth);
 	n += _mali_osk_snprintf(buf + n, size - n,
@@ -952,10 +1308,127 @@ u32 mali_scheduler_dump_state(char *buf, u32 size)
 }
 #endif
 
+static void mali_scheduler_lock_stats_print_one(_mali_osk_print_ctx *print_ctx,
+		const char *name, struct mali_scheduler_lock_stats *stats)
+{
+	_mali_osk_ctxprintf(print_ctx, "%-10s %12llu %12llu %14llu %12llu %12llu\n",
+			    name, stats->acquired, stats->contended,
+			    stats->wait_time, stats->wait_time_max,
+			    stats->handoffs);
+}
+
+void mali_scheduler_lock_stats_print(_mali_osk_print_ctx *print_ctx)
+{
+	struct mali_scheduler_lock_stats executor_stats;
+	struct mali_scheduler_lock_stats scheduler_stats;
+
+	/* Take a snapshot of each lock's statistics with that lock held */
+	mali_executor_lock();
+	executor_stats = mali_executor_lock_stats;
+	mali_executor_unlock();
+
+	mali_scheduler_lock();
+	scheduler_stats = mali_scheduler_lock_stats;
+	mali_scheduler_unlock();
+
+	_mali_osk_ctxprintf(print_ctx, "%-10s %12s %12s %14s %12s %12s\n",
+			    "lock", "acquired", "contended",
+			    "wait_ns", "wait_max_ns", "handoffs");
+	mali_scheduler_lock_stats_print_one(print_ctx, "executor", &executor_stats);
+	mali_scheduler_lock_stats_print_one(print_ctx, "scheduler", &scheduler_stats);
+}
+
+void mali_scheduler_lock_stats_reset(void)
+{
+	mali_executor_lock();
+	_mali_osk_memset(&mali_executor_lock_stats, 0, sizeof(mali_executor_lock_stats));
+	mali_executor_unlock();
+
+	mali_scheduler_lock();
+	_mali_osk_memset(&mali_scheduler_lock_stats, 0, sizeof(mali_scheduler_lock_stats));
+	mali_scheduler_unlock();
+}
+
+void mali_scheduler_gp_pp_latency_print(_mali_osk_print_ctx *print_ctx)
+{
+	struct mali_scheduler_gp_pp_latency_stats stats;
+	u64 avg = 0;
+	u64 direct;
+	u64 deferred;
+	u32 i;
+
+	MALI_DEBUG_ASSERT_POINTER(print_ctx);
+
+	mali_scheduler_lock();
+	stats = gp_pp_latency_stats;
+	mali_scheduler_unlock();
+
+	mali_executor_dependent_start_stats(&direct, &deferred);
+
+	if (0 < stats.count) {
+		avg = _mali_osk_div_u64(stats.total, stats.count);
+	}
+
+	_mali_osk_ctxprintf(print_ctx, "GP end to PP start: %llu jobs, avg %llu us, max %u us\n",
+			    stats.count, avg, stats.max);
+	_mali_osk_ctxprintf(print_ctx, "Dependency callbacks: %llu started directly, %llu deferred\n\n",
+			    direct, deferred);
+
+	for (i = 0; i < MALI_SCHEDULER_GP_PP_LATENCY_BUCKETS; i++) {
+		if (MALI_SCHEDULER_GP_PP_LATENCY_BUCKETS - 1 == i) {
+			_mali_osk_ctxprintf(print_ctx, "  >= %6u us: %u\n",
+					    1 << (i - 1), stats.histogram[i]);
+		} else {
+			_mali_osk_ctxprintf(print_ctx, "  <  %6u us: %u\n",
+					    1 << i, stats.histogram[i]);
+		}
+	}
+}
+
+void mali_scheduler_gp_pp_latency_reset(void)
+{
+	mali_scheduler_lock();
+	_mali_osk_memset(&gp_pp_latency_stats, 0, sizeof(gp_pp_latency_stats));
+	mali_scheduler_unlock();
+
+	mali_executor_dependent_start_stats_reset();
+}
+
 /*
  * ---------- Implementation of static functions ----------
  */
 
+static void mali_scheduler_gp_pp_latency_record(struct mali_pp_job *job)
+{
+	u64 latency;
+	u32 bucket;
+
+	MALI_DEBUG_ASSERT_SCHEDULER_LOCK_HELD();
+
+	if (0 == job->tracker.gp_end_time) {
+		/* Job did not depend on a GP job */
+		return;
+	}
+
+	latency = _mali_osk_div_u64(_mali_osk_time_get_ns() - job->tracker.gp_end_time, 1000);
+	job->tracker.gp_end_time = 0;
+
+	gp_pp_latency_stats.count++;
+	gp_pp_latency_stats.total += latency;
+	if (0xFFFFFFFF < latency) {
+		latency = 0xFFFFFFFF;
+	}
+	if (gp_pp_latency_stats.max < (u32)latency) {
+		gp_pp_latency_stats.max = (u32)latency;
+	}
+
+	bucket = _mali_osk_fls((u32)latency);
+	if (MALI_SCHEDULER_GP_PP_LATENCY_BUCKETS <= bucket) {
+		bucket = MALI_SCHEDULER_GP_PP_LATENCY_BUCKETS - 1;
+	}
+	gp_pp_latency_stats.histogram[bucket]++;
+}
+
 static mali_timeline_point mali_scheduler_submit_gp_job(
 	struct mali_session_data *session, struct mali_gp_job *job)
 {
@@ -972,7 +1445,8 @@ static mali_timeline_point mali_scheduler_submit_gp_job(
 }
 
 static _mali_osk_errcode_t mali_scheduler_submit_pp_job(
-	struct mali_session_data *session, struct mali_pp_job *job, mali_timeline_point *point)
+	struct mali_session_data *session, struct mali_pp_job *job,
+	enum mali_timeline_id timeline_id, mali_timeline_point *point)
 
 {
 	_mali_osk_errcode_t ret = _MALI_OSK_ERR_OK;
@@ -980,9 +1454,10 @@ static _mali_osk_errcode_t mali_scheduler_submit_pp_job(
 #if defined(CONFIG_MALI_DMA_BUF_FENCE)
 	struct ww_acquire_ctx ww_actx;
 	u32 i;
-	u32 num_memory_cookies = 0;
+	u32 num_dma_buf_backends = 0;
 	struct reservation_object **reservation_object_list = NULL;
 	unsigned int num_reservation_object = 0;
+	mali_bool wait_in_fence = MALI_FALSE;
 #endif
 
 	MALI_DEBUG_ASSERT_POINTER(session);
@@ -998,10 +1473,13 @@ static _mali_osk_errcode_t mali_scheduler_submit_pp_job(
 
 #if defined(CONFIG_MALI_DMA_BUF_FENCE)
 
+	/* Jobs with unknown memory cookies are rejected when they are created */
+	MALI_DEBUG_ASSERT(MALI_FALSE == mali_pp_job_has_invalid_memory_cookies(job));
+
 	/* Allocate the reservation_object_list to list the dma reservation object of dependent dma buffer */
-	num_memory_cookies = mali_pp_job_num_memory_cookies(job);
-	if (0 < num_memory_cookies) {
-		reservation_object_list = kzalloc(sizeof(struct reservation_object *) * num_memory_cookies, GFP_KERNEL);
+	num_dma_buf_backends = mali_pp_job_num_dma_buf_backends(job);
+	if (0 < num_dma_buf_backends) {
+		reservation_object_list = kzalloc(sizeof(struct reservation_object *) * num_dma_buf_backends, GFP_KERNEL);
 		if (NULL == reservation_object_list) {
 			MALI_PRINT_ERROR(("Failed to alloc the reservation object list.\n"));
 			ret = _MALI_OSK_ERR_NOMEM;
@@ -1010,22 +1488,9 @@ static _mali_osk_errcode_t mali_scheduler_submit_pp_job(
 	}
 
 	/* Add the dma reservation object into reservation_object_list*/
-	for (i = 0; i < num_memory_cookies; i++) {
-		mali_mem_backend *mem_backend = NULL;
+	for (i = 0; i < num_dma_buf_backends; i++) {
+		mali_mem_backend *mem_backend = mali_pp_job_get_dma_buf_backend(job, i);
 		struct reservation_object *tmp_reservation_object = NULL;
-		u32 mali_addr  = mali_pp_job_get_memory_cookie(job, i);
-
-		mem_backend = mali_mem_backend_struct_search(session, mali_addr);
-
-		MALI_DEBUG_ASSERT_POINTER(mem_backend);
-
-		if (NULL == mem_backend) {
-			MALI_PRINT_ERROR(("Failed to find the memory backend for memory cookie[%d].\n", i));
-			goto failed_to_find_mem_backend;
-		}
-
-		if (MALI_MEM_DMA_BUF != mem_backend->type)
-			continue;
 
 		tmp_reservation_object = mem_backend->dma_buf.attachment->buf->resv;
 
@@ -1035,33 +1500,41 @@ static _mali_osk_errcode_t mali_scheduler_submit_pp_job(
 		}
 	}
 
+#if defined(MALI_DMA_FENCE_SYNC_FILE)
+	wait_in_fence = (NULL != job->in_fence) ? MALI_TRUE : MALI_FALSE;
+#endif
+
 	/*
 	 * Add the mali dma fence callback to wait for all dependent dma buf,
 	 * and extend the timeline system to support dma fence,
 	 * then create the new internal dma fence to replace all last dma fence for dependent dma buf.
+	 * An explicit in-fence is waited for through the same dma fence context.
 	 */
-	if (0 < num_reservation_object) {
+	if (0 < num_reservation_object || MALI_TRUE == wait_in_fence) {
 		int error;
 		int num_dma_fence_waiter = 0;
-		/* Create one new dma fence.*/
-		job->rendered_dma_fence = mali_dma_fence_new(job->session->fence_context,
-					  _mali_osk_atomic_inc_return(&job->session->fence_seqno));
-
-		if (NULL == job->rendered_dma_fence) {
-			MALI_PRINT_ERROR(("Failed to creat one new dma fence.\n"));
-			ret = _MALI_OSK_ERR_FAULT;
-			goto failed_to_create_dma_fence;
+		/* Create one new dma fence, unless one was preallocated as out-fence.*/
+		if (0 < num_reservation_object && NULL == job->rendered_dma_fence) {
+			job->rendered_dma_fence = mali_dma_fence_new(job->session->fence_context,
+						  _mali_osk_atomic_inc_return(&job->session->fence_seqno));
+
+			if (NULL == job->rendered_dma_fence) {
+				MALI_PRINT_ERROR(("Failed to creat one new dma fence.\n"));
+				ret = _MALI_OSK_ERR_FAULT;
+				goto failed_to_create_dma_fence;
+			}
 		}
 
 		/* In order to avoid deadlock, wait/wound mutex lock to lock all dma buffers*/
-
-		error = mali_dma_fence_lock_reservation_object_list(reservation_object_list,
-				num_reservation_object, &ww_actx);
-
-		if (0 != error) {
-			MALI_PRINT_ERROR(("Failed to lock all reservation objects.\n"));
-			ret = _MALI_OSK_ERR_FAULT;
-			goto failed_to_lock_reservation_object_list;
+		if (0 < num_reservation_object) {
+			error = mali_dma_fence_lock_reservation_object_list(reservation_object_list,
+					num_reservation_object, &ww_actx);
+
+			if (0 != error) {
+				MALI_PRINT_ERROR(("Failed to lock all reservation objects.\n"));
+				ret = _MALI_OSK_ERR_FAULT;
+				goto failed_to_lock_reservation_object_list;
+			}
 		}
 
 		mali_dma_fence_context_init(&job->dma_fence_context,
@@ -1076,6 +1549,16 @@ static _mali_osk_errcode_t mali_scheduler_submit_pp_job(
 			}
 		}
 
+#if defined(MALI_DMA_FENCE_SYNC_FILE)
+		if (MALI_TRUE == wait_in_fence) {
+			ret = mali_dma_fence_context_add_fence(&job->dma_fence_context, job->in_fence);
+			if (_MALI_OSK_ERR_OK != ret) {
+				MALI_PRINT_ERROR(("Failed to add in-fence waiter into mali dma fence context.\n"));
+				goto failed_to_add_dma_fence_waiter;
+			}
+		}
+#endif
+
 		for (i = 0; i < num_reservation_object; i++) {
 			reservation_object_add_excl_fence(reservation_object_list[i], job->rendered_dma_fence);
 		}
@@ -1084,19 +1567,21 @@ static _mali_osk_errcode_t mali_scheduler_submit_pp_job(
 
 		/* Add job to Timeline system. */
 		(*point) = mali_timeline_system_add_tracker(session->timeline_system,
-				mali_pp_job_get_tracker(job), MALI_TIMELINE_PP);
+				mali_pp_job_get_tracker(job), timeline_id);
 
 		if (0 != num_dma_fence_waiter) {
 			mali_dma_fence_context_dec_count(&job->dma_fence_context);
 		}
 
 		/* Unlock all wait/wound mutex lock. */
-		mali_dma_fence_unlock_reservation_object_list(reservation_object_list,
-				num_reservation_object, &ww_actx);
+		if (0 < num_reservation_object) {
+			mali_dma_fence_unlock_reservation_object_list(reservation_object_list,
+					num_reservation_object, &ww_actx);
+		}
 	} else {
 		/* Add job to Timeline system. */
 		(*point) = mali_timeline_system_add_tracker(session->timeline_system,
-				mali_pp_job_get_tracker(job), MALI_TIMELINE_PP);
+				mali_pp_job_get_tracker(job), timeline_id);
 	}
 
 	kfree(reservation_object_list);
@@ -1104,18 +1589,20 @@ static _mali_osk_errcode_t mali_scheduler_submit_pp_job(
 #else
 	/* Add job to Timeline system. */
 	(*point) = mali_timeline_system_add_tracker(session->timeline_system,
-			mali_pp_job_get_tracker(job), MALI_TIMELINE_PP);
+			mali_pp_job_get_tracker(job), timeline_id);
 #endif
 
 #if defined(CONFIG_MALI_DMA_BUF_FENCE)
 failed_to_add_dma_fence_waiter:
 	mali_dma_fence_context_term(&job->dma_fence_context);
-	mali_dma_fence_unlock_reservation_object_list(reservation_object_list,
-			num_reservation_object, &ww_actx);
+	if (0 < num_reservation_object) {
+		mali_dma_fence_unlock_reservation_object_list(reservation_object_list,
+				num_reservation_object, &ww_actx);
+	}
 failed_to_lock_reservation_object_list:
-	mali_dma_fence_signal_and_put(&job->rendered_dma_fence);
+	if (NULL != job->rendered_dma_fence)
+		mali_dma_fence_signal_error_and_put(&job->rendered_dma_fence, -ECANCELED);
 failed_to_create_dma_fence:
-failed_to_find_mem_backend:
 	if (NULL != reservation_object_list)
 		kfree(reservation_object_list);
 failed_to_alloc_reservation_object_list:
@@ -1230,8 +1717,8 @@ static mali_bool mali_scheduler_queue_pp_job(struct mali_pp_job *job)
 	job_queue_pp.depth +=
 		mali_pp_job_get_sub_job_count(job);
 
-	/* Add job to queue (mali_gp_job_queue_add find correct place). */
-	mali_pp_job_list_add(job, queue);
+	/* Add job to queue (the PP scheduling policy finds correct place). */
+	mali_scheduler_pp_policy_job_queued(job, queue);
 
 	/*
 	 * We hold a PM reference for every job we hold queued (and running)
@@ -1485,6 +1972,215 @@ static void mali_scheduler_do_pp_job_queue(void *arg)
 
 #endif /* defined(MALI_SCHEDULER_USE_DEFERRED_PP_JOB_QUEUE) */
 
+/* User timelines a batch job is put on, or waits on, must have been created. */
+static mali_bool mali_scheduler_batch_job_timelines_valid(
+	struct mali_session_data *session, _mali_uk_batch_job_s *desc)
+{
+	u32 i;
+
+	if (0 != desc->timeline) {
+		if (_MALI_UK_BATCH_JOB_SOFT == desc->type || MALI_TIMELINE_USER > desc->timeline ||
+		    !mali_timeline_system_has_timeline(session->timeline_system,
+						       (enum mali_timeline_id)desc->timeline)) {
+			return MALI_FALSE;
+		}
+	}
+
+	for (i = 0; i < MALI_UK_TIMELINE_USER_MAX; i++) {
+		if (MALI_TIMELINE_NO_POINT != desc->user_points[i] &&
+		    !mali_timeline_system_has_timeline(session->timeline_system,
+						       (enum mali_timeline_id)(MALI_TIMELINE_USER + i))) {
+			return MALI_FALSE;
+		}
+	}
+
+	return MALI_TRUE;
+}
+
+static _mali_osk_errcode_t mali_scheduler_batch_job_create(
+	struct mali_session_data *session, _mali_uk_batch_job_s *desc,
+	struct mali_timeline_batch_entry *entry)
+{
+	switch (desc->type) {
+	case _MALI_UK_BATCH_JOB_GP: {
+		struct mali_gp_job *job;
+
+		job = mali_gp_job_create_from_kargs(session, &desc->args.gp,
+						    mali_scheduler_get_new_id(),
+						    NULL);
+		if (NULL == job) {
+			MALI_PRINT_ERROR(("Failed to create GP job.\n"));
+			return _MALI_OSK_ERR_NOMEM;
+		}
+
+		entry->tracker = mali_gp_job_get_tracker(job);
+		entry->timeline_id = (0 != desc->timeline) ?
+				     (enum mali_timeline_id)desc->timeline : MALI_TIMELINE_GP;
+		break;
+	}
+	case _MALI_UK_BATCH_JOB_PP: {
+		struct mali_pp_job *job;
+
+		job = mali_pp_job_create_from_kargs(session, &desc->args.pp,
+						    mali_scheduler_get_new_id());
+		if (NULL == job) {
+			MALI_PRINT_ERROR(("Failed to create PP job.\n"));
+			return _MALI_OSK_ERR_NOMEM;
+		}
+
+		if (MALI_TRUE == mali_pp_job_has_invalid_memory_cookies(job)) {
+			MALI_PRINT_ERROR(("Failed to find the memory backends for the memory cookies.\n"));
+			mali_pp_job_delete(job);
+			return _MALI_OSK_ERR_INVALID_ARGS;
+		}
+
+		entry->tracker = mali_pp_job_get_tracker(job);
+		entry->timeline_id = (0 != desc->timeline) ?
+				     (enum mali_timeline_id)desc->timeline : MALI_TIMELINE_PP;
+		break;
+	}
+	default: {
+		struct mali_soft_job *job;
+
+		MALI_DEBUG_ASSERT(_MALI_UK_BATCH_JOB_SOFT == desc->type);
+
+		job = mali_soft_job_create(session->soft_job_system,
+					   (enum mali_soft_job_type)desc->args.soft.type,
+					   desc->args.soft.user_job);
+		if (NULL == job) {
+			return _MALI_OSK_ERR_NOMEM;
+		}
+
+		/*
+		 * The job id is written back once the whole batch is created.
+		 * The tracker is initialized when the job is prepared.
+		 */
+		entry->tracker = &job->tracker;
+		entry->timeline_id = MALI_TIMELINE_SOFT;
+		break;
+	}
+	}
+
+	return _MALI_OSK_ERR_OK;
+}
+
+static void mali_scheduler_batch_job_delete(_mali_uk_batch_job_s *desc,
+		struct mali_timeline_batch_entry *entry)
+{
+	switch (desc->type) {
+	case _MALI_UK_BATCH_JOB_GP:
+		mali_gp_job_delete((struct mali_gp_job *)entry->tracker->job);
+		break;
+	case _MALI_UK_BATCH_JOB_PP:
+		mali_pp_job_delete((struct mali_pp_job *)entry->tracker->job);
+		break;
+	default:
+		mali_soft_job_destroy(_MALI_OSK_CONTAINER_OF(entry->tracker,
+				      struct mali_soft_job, tracker));
+		break;
+	}
+}
+
+/* Last step before a created batch job can be added to the timeline system. */
+static void mali_scheduler_batch_job_prepare(_mali_uk_batch_job_s *desc,
+		struct mali_timeline_batch_entry *entry)
+{
+	u32 i;
+
+	if (_MALI_UK_BATCH_JOB_SOFT == desc->type) {
+		struct mali_timeline_fence fence;
+
+		mali_timeline_fence_copy_uk_fence(&fence, &desc->args.soft.fence);
+		mali_soft_job_prepare_start(_MALI_OSK_CONTAINER_OF(entry->tracker,
+					    struct mali_soft_job, tracker), &fence);
+	}
+
+	/* The UK fence of the job only has points on the GP, PP and soft timelines. */
+	for (i = 0; i < MALI_UK_TIMELINE_USER_MAX; i++) {
+		mali_timeline_fence_add_point(&entry->tracker->fence,
+					      (enum mali_timeline_id)(MALI_TIMELINE_USER + i),
+					      desc->user_points[i]);
+	}
+}
+
+/* Fence fds can only be used with PP jobs, and only with sync_file support. */
+static mali_bool mali_scheduler_batch_job_flags_valid(_mali_uk_batch_job_s *desc)
+{
+	if (0 == desc->flags) {
+		return MALI_TRUE;
+	}
+
+#if defined(MALI_DMA_FENCE_SYNC_FILE)
+	if (_MALI_UK_BATCH_JOB_PP == desc->type &&
+	    0 == (desc->flags & ~(_MALI_UK_BATCH_JOB_FLAG_IN_FENCE |
+				  _MALI_UK_BATCH_JOB_FLAG_OUT_FENCE))) {
+		return MALI_TRUE;
+	}
+#endif
+
+	return MALI_FALSE;
+}
+
+#if defined(MALI_DMA_FENCE_SYNC_FILE)
+/*
+ * Take the in-fence of a created PP job, and preallocate its out-fence
+ * together with a sync_file and fd for it. The job owns the fences and
+ * releases them when deleted.
+ */
+static _mali_osk_errcode_t mali_scheduler_batch_job_fences_get(_mali_uk_batch_job_s *desc,
+		struct mali_timeline_batch_entry *entry,
+		struct mali_scheduler_batch_out_fence *out_fence)
+{
+	struct mali_pp_job *job;
+
+	if (0 == desc->flags) {
+		return _MALI_OSK_ERR_OK;
+	}
+
+	MALI_DEBUG_ASSERT(_MALI_UK_BATCH_JOB_PP == desc->type);
+	job = (struct mali_pp_job *)entry->tracker->job;
+
+	if (0 != (desc->flags & _MALI_UK_BATCH_JOB_FLAG_IN_FENCE)) {
+		job->in_fence = sync_file_get_fence(desc->in_fence_fd);
+		if (NULL == job->in_fence) {
+			MALI_PRINT_ERROR(("Mali scheduler: Invalid in-fence fd %d.\n", desc->in_fence_fd));
+			return _MALI_OSK_ERR_INVALID_ARGS;
+		}
+	}
+
+	if (0 != (desc->flags & _MALI_UK_BATCH_JOB_FLAG_OUT_FENCE)) {
+		job->rendered_dma_fence = mali_dma_fence_new(job->session->fence_context,
+					  _mali_osk_atomic_inc_return(&job->session->fence_seqno));
+		if (NULL == job->rendered_dma_fence) {
+			return _MALI_OSK_ERR_NOMEM;
+		}
+
+		out_fence->sync_file = sync_file_create(job->rendered_dma_fence);
+		if (NULL == out_fence->sync_file) {
+			return _MALI_OSK_ERR_NOMEM;
+		}
+
+		out_fence->fd = get_unused_fd_flags(O_CLOEXEC);
+		if (0 > out_fence->fd) {
+			fput(out_fence->sync_file->file);
+			out_fence->sync_file = NULL;
+			return _MALI_OSK_ERR_NOMEM;
+		}
+	}
+
+	return _MALI_OSK_ERR_OK;
+}
+
+static void mali_scheduler_batch_out_fence_put(struct mali_scheduler_batch_out_fence *out_fence)
+{
+	if (NULL != out_fence->sync_file) {
+		put_unused_fd(out_fence->fd);
+		fput(out_fence->sync_file->file);
+		out_fence->sync_file = NULL;
+	}
+}
+#endif
+
 void mali_scheduler_gp_pp_job_queue_print(void)
 {
 	struct mali_gp_job *gp_job = NULL;
@@ -39,9 +39,36 @@ extern _mali_osk_atomic_t mali_job_cache_order_autonumber;
 _mali_osk_errcode_t mali_scheduler_initialize(void);
 void mali_scheduler_terminate(void);
 
+/* Contention statistics of the scheduler lock */
+extern struct mali_scheduler_lock_stats mali_scheduler_lock_stats;
+
+/**
+ * Take an irq spinlock, and account the time spent waiting for it if it was busy.
+ * The statistics are updated with the lock held.
+ */
+MALI_STATIC_INLINE void mali_scheduler_lock_with_stats(_mali_osk_spinlock_irq_t *lock,
+		struct mali_scheduler_lock_stats *stats)
+{
+	if (!_mali_osk_spinlock_irq_trylock(lock)) {
+		u64 start = _mali_osk_time_get_ns();
+		u64 wait;
+
+		_mali_osk_spinlock_irq_lock(lock);
+
+		wait = _mali_osk_time_get_ns() - start;
+		stats->contended++;
+		stats->wait_time += wait;
+		if (wait > stats->wait_time_max) {
+			stats->wait_time_max = wait;
+		}
+	}
+
+	stats->acquired++;
+}
+
 MALI_STATIC_INLINE void mali_scheduler_lock(void)
 {
-	_mali_osk_spinlock_irq_lock(mali_scheduler_lock_obj);
+	mali_scheduler_lock_with_stats(mali_scheduler_lock_obj, &mali_scheduler_lock_stats);
 	MALI_DEBUG_PRINT(5, ("Mali scheduler: scheduler lock taken.\n"));
 }
 
@@ -128,4 +155,12 @@ u32 mali_scheduler_dump_state(char *buf, u32 size);
 
 void mali_scheduler_gp_pp_job_queue_print(void);
 
+/* Print/reset contention statistics of the executor and scheduler locks */
+void mali_scheduler_lock_stats_print(_mali_osk_print_ctx *print_ctx);
+void mali_scheduler_lock_stats_reset(void);
+
+/* Print/reset GP end to dependent PP start latency statistics */
+void mali_scheduler_gp_pp_latency_print(_mali_osk_print_ctx *print_ctx);
+void mali_scheduler_gp_pp_latency_reset(void);
+
 #endif /* __MALI_SCHEDULER_H__ */
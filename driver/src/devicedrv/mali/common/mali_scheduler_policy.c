@@ -0,0 +1,337 @@
+/*
+ * Copyright (C) 2017 ARM Limited. All rights reserved.
+ * 
+ * This program is free software and is provided to you under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation, and any use by you of this program is subject to the terms of such GNU licence.
+ * 
+ * A copy of the licence is included with the program, and can also be obtained from Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "mali_scheduler_policy.h"
+#include "mali_scheduler.h"
+#include "mali_kernel_common.h"
+#include "mali_osk.h"
+#include "mali_osk_list.h"
+#include "mali_session.h"
+#include "mali_pp_job.h"
+
+/* Cost (us of GPU core time) assumed for PP jobs from a session without history */
+#define MALI_SCHEDULER_PP_COST_DEFAULT 1000
+
+/* Upper limit on the cost (us) of a single PP job, keeps vtime math in 32 bits */
+#define MALI_SCHEDULER_PP_COST_MAX 1000000
+
+/** Selected PP scheduling policy, can be set by module insert parameter */
+int mali_pp_scheduler_policy = MALI_SCHEDULER_PP_POLICY_FIFO;
+
+static const struct mali_scheduler_pp_policy *pp_policy = NULL;
+
+/*
+ * Virtual time of the fair policy; the virtual start time of the last PP job
+ * started. Sessions which have been idle are moved up to this point when they
+ * queue new work, so idle time can not be saved up and spent as a burst later.
+ */
+static u64 fair_vtime_now = 0;
+
+static u32 mali_scheduler_pp_ns_to_us(u64 ns)
+{
+	u64 us = _mali_osk_div_u64(ns, 1000);
+
+	return (0xFFFFFFFF < us) ? 0xFFFFFFFF : (u32)us;
+}
+
+/*
+ * ---------- FIFO policy ----------
+ */
+
+static void mali_scheduler_pp_fifo_enqueue(struct mali_pp_job *job, _mali_osk_list_t *queue)
+{
+	/* Ordered by job id */
+	mali_pp_job_list_add(job, queue);
+}
+
+static const struct mali_scheduler_pp_policy pp_policy_fifo = {
+	.name = "fifo",
+	.job_enqueue = mali_scheduler_pp_fifo_enqueue,
+	.job_start = NULL,
+	.job_charge = NULL,
+};
+
+/*
+ * ---------- Fair-share policy ----------
+ *
+ * Each session has a virtual clock which advances by the GPU time its jobs
+ * use, scaled down by the session weight. A job is stamped with the virtual
+ * clock of its session when it is queued, and the queues are kept sorted on
+ * this stamp. This gives the same order as keeping one run queue per session
+ * and always picking from the session which has received the least weighted
+ * GPU time, while the executor can still look ahead through a single queue
+ * when it fills several physical cores at once.
+ */
+
+static u32 mali_scheduler_pp_fair_delta(struct mali_scheduler_session_pp *pp, u32 cost)
+{
+	u32 delta;
+
+	if (MALI_SCHEDULER_PP_COST_MAX < cost) {
+		cost = MALI_SCHEDULER_PP_COST_MAX;
+	}
+
+	delta = (cost * MALI_SCHEDULER_PP_WEIGHT_DEFAULT) / pp->weight;
+
+	return (0 == delta) ? 1 : delta;
+}
+
+static void mali_scheduler_pp_fair_enqueue(struct mali_pp_job *job, _mali_osk_list_t *queue)
+{
+	struct mali_scheduler_session_pp *pp;
+	struct mali_pp_job *iter;
+	struct mali_pp_job *tmp;
+
+	pp = &mali_pp_job_get_session(job)->pp_sched;
+
+	if (0 == pp->cost_estimate) {
+		pp->cost_estimate = MALI_SCHEDULER_PP_COST_DEFAULT;
+	}
+
+	if (pp->vtime < fair_vtime_now) {
+		pp->vtime = fair_vtime_now;
+	}
+
+	job->sched_vtime = pp->vtime;
+	pp->vtime += mali_scheduler_pp_fair_delta(pp, pp->cost_estimate);
+
+	/* Find position in queue, jobs with equal stamps keep queue order. */
+	_MALI_OSK_LIST_FOREACHENTRY_REVERSE(iter, tmp, queue,
+					    struct mali_pp_job, list) {
+		/* job should be started after iter if iter is in progress. */
+		if (0 < iter->sub_jobs_started) {
+			break;
+		}
+
+		if (iter->sched_vtime <= job->sched_vtime) {
+			break;
+		}
+	}
+
+	_mali_osk_list_add(&job->list, &iter->list);
+}
+
+static void mali_scheduler_pp_fair_start(struct mali_pp_job *job)
+{
+	if (fair_vtime_now < job->sched_vtime) {
+		fair_vtime_now = job->sched_vtime;
+	}
+}
+
+static void mali_scheduler_pp_fair_charge(struct mali_pp_job *job, u32 gpu_time)
+{
+	struct mali_scheduler_session_pp *pp;
+
+	pp = &mali_pp_job_get_session(job)->pp_sched;
+
+	if (MALI_SCHEDULER_PP_COST_MAX < gpu_time) {
+		gpu_time = MALI_SCHEDULER_PP_COST_MAX;
+	}
+
+	/*
+	 * The job was stamped with the estimated cost when it was queued,
+	 * charge the session for whatever the job used on top of that.
+	 */
+	if (gpu_time > pp->cost_estimate) {
+		pp->vtime += mali_scheduler_pp_fair_delta(pp, gpu_time - pp->cost_estimate);
+	}
+
+	pp->cost_estimate = (pp->cost_estimate * 7 + gpu_time) / 8;
+}
+
+static const struct mali_scheduler_pp_policy pp_policy_fair = {
+	.name = "fair",
+	.job_enqueue = mali_scheduler_pp_fair_enqueue,
+	.job_start = mali_scheduler_pp_fair_start,
+	.job_charge = mali_scheduler_pp_fair_charge,
+};
+
+/*
+ * ---------- Policy independent part ----------
+ */
+
+_mali_osk_errcode_t mali_scheduler_pp_policy_initialize(void)
+{
+	switch (mali_pp_scheduler_policy) {
+	case MALI_SCHEDULER_PP_POLICY_FIFO:
+		pp_policy = &pp_policy_fifo;
+		break;
+	case MALI_SCHEDULER_PP_POLICY_FAIR:
+		pp_policy = &pp_policy_fair;
+		break;
+	default:
+		MALI_PRINT_ERROR(("Mali scheduler: Unknown PP scheduling policy %d, using fifo\n",
+				  mali_pp_scheduler_policy));
+		mali_pp_scheduler_policy = MALI_SCHEDULER_PP_POLICY_FIFO;
+		pp_policy = &pp_policy_fifo;
+		break;
+	}
+
+	fair_vtime_now = 0;
+
+	MALI_DEBUG_PRINT(2, ("Mali scheduler: Using %s PP scheduling policy\n",
+			     pp_policy->name));
+
+	return _MALI_OSK_ERR_OK;
+}
+
+const char *mali_scheduler_pp_policy_name(void)
+{
+	MALI_DEBUG_ASSERT_POINTER(pp_policy);
+	return pp_policy->name;
+}
+
+void mali_scheduler_pp_policy_job_queued(struct mali_pp_job *job, _mali_osk_list_t *queue)
+{
+	MALI_DEBUG_ASSERT_POINTER(job);
+	MALI_DEBUG_ASSERT_SCHEDULER_LOCK_HELD();
+
+	job->time_queued = _mali_osk_time_get_ns();
+	job->time_started = 0;
+
+	pp_policy->job_enqueue(job, queue);
+}
+
+void mali_scheduler_pp_policy_job_started(struct mali_pp_job *job)
+{
+	struct mali_scheduler_session_pp *pp;
+	u32 wait_time;
+	u32 bucket;
+
+	MALI_DEBUG_ASSERT_POINTER(job);
+	MALI_DEBUG_ASSERT_SCHEDULER_LOCK_HELD();
+
+	pp = &mali_pp_job_get_session(job)->pp_sched;
+
+	job->time_started = _mali_osk_time_get_ns();
+	wait_time = mali_scheduler_pp_ns_to_us(job->time_started - job->time_queued);
+
+	pp->jobs_started++;
+	pp->wait_time += wait_time;
+	if (pp->wait_time_max < wait_time) {
+		pp->wait_time_max = wait_time;
+	}
+
+	bucket = _mali_osk_fls(wait_time / 1000);
+	if (MALI_SCHEDULER_PP_WAIT_BUCKETS <= bucket) {
+		bucket = MALI_SCHEDULER_PP_WAIT_BUCKETS - 1;
+	}
+	pp->wait_histogram[bucket]++;
+
+	if (NULL != pp_policy->job_start) {
+		pp_policy->job_start(job);
+	}
+}
+
+void mali_scheduler_pp_policy_job_completed(struct mali_pp_job *job, u32 num_cores)
+{
+	struct mali_scheduler_session_pp *pp;
+	u64 gpu_time;
+
+	MALI_DEBUG_ASSERT_POINTER(job);
+	MALI_DEBUG_ASSERT_SCHEDULER_LOCK_HELD();
+
+	if (0 == job->time_started) {
+		/* Job was aborted before it was started */
+		return;
+	}
+
+	pp = &mali_pp_job_get_session(job)->pp_sched;
+
+	gpu_time = (u64)mali_scheduler_pp_ns_to_us(_mali_osk_time_get_ns() - job->time_started);
+	gpu_time *= (0 == num_cores) ? 1 : num_cores;
+
+	pp->jobs_completed++;
+	pp->gpu_time += gpu_time;
+
+	if (NULL != pp_policy->job_charge) {
+		pp_policy->job_charge(job, (0xFFFFFFFF < gpu_time) ? 0xFFFFFFFF : (u32)gpu_time);
+	}
+}
+
+_mali_osk_errcode_t mali_scheduler_pp_policy_set_weight(u32 pid, u32 weight)
+{
+	struct mali_session_data *session, *tmp;
+	_mali_osk_errcode_t ret = _MALI_OSK_ERR_ITEM_NOT_FOUND;
+
+	if (MALI_SCHEDULER_PP_WEIGHT_MIN > weight || MALI_SCHEDULER_PP_WEIGHT_MAX < weight) {
+		return _MALI_OSK_ERR_INVALID_ARGS;
+	}
+
+	mali_session_lock();
+	MALI_SESSION_FOREACH(session, tmp, link) {
+		if (session->pid == pid) {
+			mali_scheduler_lock();
+			session->pp_sched.weight = weight;
+			mali_scheduler_unlock();
+			ret = _MALI_OSK_ERR_OK;
+		}
+	}
+	mali_session_unlock();
+
+	return ret;
+}
+
+void mali_scheduler_pp_policy_reset_stats(void)
+{
+	struct mali_session_data *session, *tmp;
+
+	mali_session_lock();
+	MALI_SESSION_FOREACH(session, tmp, link) {
+		struct mali_scheduler_session_pp *pp = &session->pp_sched;
+
+		mali_scheduler_lock();
+		pp->jobs_started = 0;
+		pp->jobs_completed = 0;
+		pp->wait_time = 0;
+		pp->wait_time_max = 0;
+		pp->gpu_time = 0;
+		_mali_osk_memset(pp->wait_histogram, 0, sizeof(pp->wait_histogram));
+		mali_scheduler_unlock();
+	}
+	mali_session_unlock();
+}
+
+void mali_scheduler_pp_policy_print_stats(_mali_osk_print_ctx *print_ctx)
+{
+	struct mali_session_data *session, *tmp;
+
+	MALI_DEBUG_ASSERT_POINTER(print_ctx);
+
+	_mali_osk_ctxprintf(print_ctx, "PP scheduling policy: %s\n\n", mali_scheduler_pp_policy_name());
+	_mali_osk_ctxprintf(print_ctx, "  %-25s  %-8s  %-6s  %-10s  %-10s  %-12s  %-12s  %-14s  %s\n",
+			    "Name", "pid", "weight", "started", "completed",
+			    "wait_avg_us", "wait_max_us", "gpu_time_us",
+			    "wait_ms <1 <2 <4 <8 <16 <32 <64 >=64");
+
+	mali_session_lock();
+	MALI_SESSION_FOREACH(session, tmp, link) {
+		struct mali_scheduler_session_pp pp;
+		u64 wait_avg = 0;
+
+		mali_scheduler_lock();
+		pp = session->pp_sched;
+		mali_scheduler_unlock();
+
+		if (0 < pp.jobs_started) {
+			wait_avg = _mali_osk_div_u64(pp.wait_time, pp.jobs_started);
+		}
+
+		_mali_osk_ctxprintf(print_ctx, "  %-25s  %-8u  %-6u  %-10u  %-10u  %-12llu  %-12u  %-14llu  %u %u %u %u %u %u %u %u\n",
+				    session->comm, session->pid, pp.weight,
+				    pp.jobs_started, pp.jobs_completed,
+				    wait_avg, pp.wait_time_max, pp.gpu_time,
+				    pp.wait_histogram[0], pp.wait_histogram[1],
+				    pp.wait_histogram[2], pp.wait_histogram[3],
+				    pp.wait_histogram[4], pp.wait_histogram[5],
+				    pp.wait_histogram[6], pp.wait_histogram[7]);
+	}
+	mali_session_unlock();
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2017 ARM Limited. All rights reserved.
+ * 
+ * This program is free software and is provided to you under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation, and any use by you of this program is subject to the terms of such GNU licence.
+ * 
+ * A copy of the licence is included with the program, and can also be obtained from Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __MALI_SCHEDULER_POLICY_H__
+#define __MALI_SCHEDULER_POLICY_H__
+
+#include "mali_osk.h"
+#include "mali_osk_list.h"
+#include "mali_scheduler_types.h"
+
+struct mali_pp_job;
+
+/**
+ * PP scheduling policy.
+ *
+ * The scheduler keeps a normal and a high priority PP queue, and always
+ * starts jobs from the head of these. A policy decides where in a queue a
+ * new job is placed, and is told when the job starts and how much GPU time
+ * it used once it is done.
+ *
+ * All callbacks are called with the scheduler lock held.
+ */
+struct mali_scheduler_pp_policy {
+	const char *name;
+
+	/* Insert job into queue. */
+	void (*job_enqueue)(struct mali_pp_job *job, _mali_osk_list_t *queue);
+
+	/* First sub job of job has been handed to the executor (optional). */
+	void (*job_start)(struct mali_pp_job *job);
+
+	/* Job used gpu_time us of GPU core time (optional). */
+	void (*job_charge)(struct mali_pp_job *job, u32 gpu_time);
+};
+
+/* Module parameter selecting the PP policy, see enum mali_scheduler_pp_policy_id */
+extern int mali_pp_scheduler_policy;
+
+_mali_osk_errcode_t mali_scheduler_pp_policy_initialize(void);
+
+const char *mali_scheduler_pp_policy_name(void);
+
+/**
+ * Add PP job to scheduler queue, according to the active policy.
+ *
+ * @param job PP job to queue.
+ * @param queue Scheduler queue (normal or high priority).
+ */
+void mali_scheduler_pp_policy_job_queued(struct mali_pp_job *job, _mali_osk_list_t *queue);
+
+/**
+ * Called when the first sub job of a PP job is taken from the queue.
+ *
+ * @param job PP job which is starting.
+ */
+void mali_scheduler_pp_policy_job_started(struct mali_pp_job *job);
+
+/**
+ * Called when a started PP job has completed (or failed).
+ *
+ * @param job PP job which completed.
+ * @param num_cores Number of PP cores the job occupied.
+ */
+void mali_scheduler_pp_policy_job_completed(struct mali_pp_job *job, u32 num_cores);
+
+/**
+ * Set fair-share weight of all sessions belonging to a process.
+ *
+ * @param pid Process ID.
+ * @param weight New weight, MALI_SCHEDULER_PP_WEIGHT_MIN to MALI_SCHEDULER_PP_WEIGHT_MAX.
+ * @return _MALI_OSK_ERR_OK on success, _MALI_OSK_ERR_ITEM_NOT_FOUND if process has no sessions.
+ */
+_mali_osk_errcode_t mali_scheduler_pp_policy_set_weight(u32 pid, u32 weight);
+
+void mali_scheduler_pp_policy_reset_stats(void);
+
+void mali_scheduler_pp_policy_print_stats(_mali_osk_print_ctx *print_ctx);
+
+#endif /* __MALI_SCHEDULER_POLICY_H__ */
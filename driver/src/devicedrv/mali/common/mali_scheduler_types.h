@@ -26,4 +26,65 @@ typedef u32 mali_scheduler_mask;
 #define MALI_SCHEDULER_MASK_EMPTY 0
 #define MALI_SCHEDULER_MASK_ALL (MALI_SCHEDULER_MASK_GP | MALI_SCHEDULER_MASK_PP)
 
+/**
+ * PP scheduling policies, selected with the mali_pp_scheduler_policy
+ * module parameter.
+ */
+enum mali_scheduler_pp_policy_id {
+	MALI_SCHEDULER_PP_POLICY_FIFO = 0, /**< Jobs run in submission order, regardless of session */
+	MALI_SCHEDULER_PP_POLICY_FAIR,     /**< Sessions share PP cores in proportion to their weight */
+	MALI_SCHEDULER_PP_POLICY_COUNT,
+};
+
+/* Fair-share weight range of a session, default is the weight of a CFS nice 0 task */
+#define MALI_SCHEDULER_PP_WEIGHT_DEFAULT 1024
+#define MALI_SCHEDULER_PP_WEIGHT_MIN 16
+#define MALI_SCHEDULER_PP_WEIGHT_MAX 16384
+
+/* Number of log2 buckets (in ms) in the per session PP queue wait histogram */
+#define MALI_SCHEDULER_PP_WAIT_BUCKETS 8
+
+/**
+ * Per session PP scheduling state and statistics.
+ * Protected by the scheduler lock.
+ */
+struct mali_scheduler_session_pp {
+	u32 weight;         /**< Fair-share weight of the session */
+	u64 vtime;          /**< Virtual start time handed to the next PP job queued by the session */
+	u32 cost_estimate;  /**< Running average of GPU core time (us) per PP job */
+
+	u32 jobs_started;   /**< Number of PP jobs started */
+	u32 jobs_completed; /**< Number of started PP jobs which have completed */
+	u64 wait_time;      /**< Accumulated time (us) PP jobs have been queued before they started */
+	u32 wait_time_max;  /**< Longest time (us) a PP job has been queued before it started */
+	u64 gpu_time;       /**< Accumulated GPU core time (us) used by PP jobs */
+	u32 wait_histogram[MALI_SCHEDULER_PP_WAIT_BUCKETS]; /**< Queue wait times, bucket n counts waits below 2^n ms, last bucket counts the rest */
+};
+
+/**
+ * Contention statistics of a scheduler or executor lock.
+ * Updated and read with the lock in question held.
+ */
+struct mali_scheduler_lock_stats {
+	u64 acquired;      /**< Number of times the lock has been taken */
+	u64 contended;     /**< Number of times the lock was busy when we tried to take it */
+	u64 wait_time;     /**< Accumulated time (ns) spent spinning on the lock */
+	u64 wait_time_max; /**< Longest time (ns) spent spinning on the lock */
+	u64 handoffs;      /**< Submit schedule requests handed to the worker instead of spinning */
+};
+
+/* Number of log2 buckets (in us) in the GP end to PP start latency histogram */
+#define MALI_SCHEDULER_GP_PP_LATENCY_BUCKETS 16
+
+/**
+ * Latency from the completion of a GP job to the start of a PP job which
+ * depended on it. Updated and read with the scheduler lock held.
+ */
+struct mali_scheduler_gp_pp_latency_stats {
+	u64 count;       /**< Number of PP jobs started after a GP job they depended on */
+	u64 total;       /**< Accumulated latency (us) */
+	u32 max;         /**< Longest latency (us) */
+	u32 histogram[MALI_SCHEDULER_GP_PP_LATENCY_BUCKETS]; /**< Bucket n counts latencies below 2^n us, last bucket counts the rest */
+};
+
 #endif /* __MALI_SCHEDULER_TYPES_H__ */
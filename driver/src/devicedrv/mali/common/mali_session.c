@@ -12,6 +12,7 @@
 #include "mali_osk_list.h"
 #include "mali_session.h"
 #include "mali_ukk.h"
+#include "mali_mmu_page_directory.h"
 #ifdef MALI_MEM_SWAP_TRACKING
 #include "mali_memory_swap_alloc.h"
 #endif
@@ -124,23 +125,25 @@ void mali_session_memory_tracking(_mali_osk_print_ctx *print_ctx)
 	mali_session_lock();
 	MALI_SESSION_FOREACH(session, tmp, link) {
 #ifdef MALI_MEM_SWAP_TRACKING
-		_mali_osk_ctxprintf(print_ctx, "  %-25s  %-10u  %-10u  %-15u  %-15u  %-10u  %-10u  %-10u\n",
+		_mali_osk_ctxprintf(print_ctx, "  %-25s  %-10u  %-10u  %-15u  %-15u  %-10u  %-10u  %-10u  %-6u  %-10u\n",
 				    session->comm, session->pid,
 				    (atomic_read(&session->mali_mem_allocated_pages)) * _MALI_OSK_MALI_PAGE_SIZE,
 				    (unsigned int)session->max_mali_mem_allocated_size,
 				    (unsigned int)((atomic_read(&session->mali_mem_array[MALI_MEM_EXTERNAL])) * _MALI_OSK_MALI_PAGE_SIZE),
 				    (unsigned int)((atomic_read(&session->mali_mem_array[MALI_MEM_UMP])) * _MALI_OSK_MALI_PAGE_SIZE),
 				    (unsigned int)((atomic_read(&session->mali_mem_array[MALI_MEM_DMA_BUF])) * _MALI_OSK_MALI_PAGE_SIZE),
-				    (unsigned int)((atomic_read(&session->mali_mem_array[MALI_MEM_SWAP])) * _MALI_OSK_MALI_PAGE_SIZE)
+				    (unsigned int)((atomic_read(&session->mali_mem_array[MALI_MEM_SWAP])) * _MALI_OSK_MALI_PAGE_SIZE),
+				    session->page_directory->page_table_count, session->page_directory->page_table_allocs
 				   );
 #else
-		_mali_osk_ctxprintf(print_ctx, "  %-25s  %-10u  %-10u  %-15u  %-15u  %-10u  %-10u  \n",
+		_mali_osk_ctxprintf(print_ctx, "  %-25s  %-10u  %-10u  %-15u  %-15u  %-10u  %-10u  %-6u  %-10u\n",
 				    session->comm, session->pid,
 				    (unsigned int)((atomic_read(&session->mali_mem_allocated_pages)) * _MALI_OSK_MALI_PAGE_SIZE),
 				    (unsigned int)session->max_mali_mem_allocated_size,
 				    (unsigned int)((atomic_read(&session->mali_mem_array[MALI_MEM_EXTERNAL])) * _MALI_OSK_MALI_PAGE_SIZE),
 				    (unsigned int)((atomic_read(&session->mali_mem_array[MALI_MEM_UMP])) * _MALI_OSK_MALI_PAGE_SIZE),
-				    (unsigned int)((atomic_read(&session->mali_mem_array[MALI_MEM_DMA_BUF])) * _MALI_OSK_MALI_PAGE_SIZE)
+				    (unsigned int)((atomic_read(&session->mali_mem_array[MALI_MEM_DMA_BUF])) * _MALI_OSK_MALI_PAGE_SIZE),
+				    session->page_directory->page_table_count, session->page_directory->page_table_allocs
 				   );
 #endif
 	}
@@ -16,6 +16,9 @@
 #include "mali_osk_list.h"
 #include "mali_memory_types.h"
 #include "mali_memory_manager.h"
+#include "mali_scheduler_types.h"
+#include "mali_completion_ring.h"
+#include "mali_timeline_seqno.h"
 
 struct mali_timeline_system;
 struct mali_soft_system;
@@ -28,6 +31,8 @@ struct mali_soft_system;
 
 struct mali_session_data {
 	_mali_osk_notification_queue_t *ioctl_queue;
+	struct mali_completion_ring *completion_ring; /**< Job completion ring mapped by user space, or NULL if not set up */
+	_mali_uk_timeline_seqno_page_s *timeline_seqno_page; /**< Timeline seqno page mapped by user space, or NULL if not set up */
 
 	_mali_osk_wait_queue_t *wait_queue; /**The wait queue to wait for the number of pp job become 0.*/
 
@@ -45,6 +50,7 @@ struct mali_session_data {
 	_mali_osk_atomic_t number_of_window_jobs; /**< Record the window jobs completed on this session in a period */
 #endif
 	_mali_osk_atomic_t number_of_pp_jobs; /** < Record the pp jobs on this session */
+	_mali_osk_atomic_t number_of_gp_jobs; /**< Record the gp jobs on this session */
 
 	_mali_osk_list_t pp_job_fb_lookup_list[MALI_PP_JOB_FB_LOOKUP_LIST_SIZE]; /**< List of PP job lists per frame builder id.  Used to link jobs from same frame builder. */
 	struct mali_soft_job_system *soft_job_system; /**< Soft job system for this session. */
@@ -52,6 +58,7 @@ struct mali_session_data {
 
 	mali_bool is_aborting; /**< MALI_TRUE if the session is aborting, MALI_FALSE if not. */
 	mali_bool use_high_priority_job_queue; /**< If MALI_TRUE, jobs added from this session will use the high priority job queues. */
+	struct mali_scheduler_session_pp pp_sched; /**< PP fair-share scheduling state and statistics for this session. */
 	u32 pid;
 	char *comm;
 	atomic_t mali_mem_array[MALI_MEM_TYPE_MAX]; /**< The array to record mem types' usage for this session. */
@@ -110,8 +117,23 @@ MALI_STATIC_INLINE void mali_session_memory_unlock(struct mali_session_data *ses
 	_mali_osk_mutex_signal(session->memory_lock);
 }
 
+/* MALI_TRUE if the session has no GP or PP jobs, neither waiting nor running */
+MALI_STATIC_INLINE mali_bool mali_session_is_idle(struct mali_session_data *session)
+{
+	MALI_DEBUG_ASSERT_POINTER(session);
+	return (0 == _mali_osk_atomic_read(&session->number_of_gp_jobs) &&
+		0 == _mali_osk_atomic_read(&session->number_of_pp_jobs)) ? MALI_TRUE : MALI_FALSE;
+}
+
 MALI_STATIC_INLINE void mali_session_send_notification(struct mali_session_data *session, _mali_osk_notification_t *object)
 {
+	struct mali_completion_ring *ring = session->completion_ring;
+
+	/* Job completions go through the completion ring if user space has set one up. */
+	if (NULL != ring && MALI_TRUE == mali_completion_ring_post(ring, object)) {
+		return;
+	}
+
 	_mali_osk_notification_queue_send(session->ioctl_queue, object);
 }
 
@@ -46,6 +46,29 @@ MALI_STATIC_INLINE void mali_soft_job_system_assert_locked(struct mali_soft_job_
 #define MALI_ASSERT_SOFT_JOB_SYSTEM_LOCKED(system)
 #endif /* defined(DEBUG) */
 
+#define MALI_SOFT_JOB_POOL_MAX_CACHED 64
+
+static _mali_osk_object_pool_t *soft_job_pool = NULL; /**< Recycled soft job objects */
+
+_mali_osk_errcode_t mali_soft_job_initialize(void)
+{
+	soft_job_pool = _mali_osk_object_pool_create("mali_soft_job", sizeof(struct mali_soft_job),
+			MALI_SOFT_JOB_POOL_MAX_CACHED);
+	if (NULL == soft_job_pool) {
+		return _MALI_OSK_ERR_NOMEM;
+	}
+
+	return _MALI_OSK_ERR_OK;
+}
+
+void mali_soft_job_terminate(void)
+{
+	if (NULL != soft_job_pool) {
+		_mali_osk_object_pool_destroy(soft_job_pool);
+		soft_job_pool = NULL;
+	}
+}
+
 struct mali_soft_job_system *mali_soft_job_system_create(struct mali_session_data *session)
 {
 	struct mali_soft_job_system *system;
@@ -101,7 +124,7 @@ static void mali_soft_job_system_free_job(struct mali_soft_job_system *system, s
 
 	mali_soft_job_system_unlock(job->system);
 
-	_mali_osk_free(job);
+	_mali_osk_object_pool_free(soft_job_pool, job);
 }
 
 MALI_STATIC_INLINE struct mali_soft_job *mali_soft_job_system_lookup_job(struct mali_soft_job_system *system, u32 job_id)
@@ -155,9 +178,10 @@ struct mali_soft_job *mali_soft_job_create(struct mali_soft_job_system *system,
 		return NULL;
 	}
 
-	job = _mali_osk_malloc(sizeof(struct mali_soft_job));
+	job = _mali_osk_object_pool_alloc(soft_job_pool);
 	if (unlikely(NULL == job)) {
 		MALI_DEBUG_PRINT(2, ("Mali Soft Job: system alloc job failed. \n"));
+		_mali_osk_notification_delete(notification);
 		return NULL;
 	}
 
@@ -186,9 +210,8 @@ struct mali_soft_job *mali_soft_job_create(struct mali_soft_job_system *system,
 	return job;
 }
 
-mali_timeline_point mali_soft_job_start(struct mali_soft_job *job, struct mali_timeline_fence *fence)
+void mali_soft_job_prepare_start(struct mali_soft_job *job, struct mali_timeline_fence *fence)
 {
-	mali_timeline_point point;
 	struct mali_soft_job_system *system;
 
 	MALI_DEBUG_ASSERT_POINTER(job);
@@ -210,7 +233,16 @@ mali_timeline_point mali_soft_job_start(struct mali_soft_job *job, struct mali_t
 	MALI_DEBUG_PRINT(4, ("Mali Soft Job: starting soft job %u (0x%08X)\n", job->id, job));
 
 	mali_timeline_tracker_init(&job->tracker, MALI_TIMELINE_TRACKER_SOFT, fence, job);
-	point = mali_timeline_system_add_tracker(system->session->timeline_system, &job->tracker, MALI_TIMELINE_SOFT);
+}
+
+mali_timeline_point mali_soft_job_start(struct mali_soft_job *job, struct mali_timeline_fence *fence)
+{
+	mali_timeline_point point;
+
+	MALI_DEBUG_ASSERT_POINTER(job);
+
+	mali_soft_job_prepare_start(job, fence);
+	point = mali_timeline_system_add_tracker(job->system->session->timeline_system, &job->tracker, MALI_TIMELINE_SOFT);
 
 	return point;
 }
@@ -92,6 +92,18 @@ typedef struct mali_soft_job_system {
 	u32 last_job_id;                                      /**< Recored the last job id protected by lock. */
 } mali_soft_job_system;
 
+/**
+ * Set up the soft job object pool.
+ *
+ * @return _MALI_OSK_ERR_OK on success, otherwise failure.
+ */
+_mali_osk_errcode_t mali_soft_job_initialize(void);
+
+/**
+ * Tear down the soft job object pool.
+ */
+void mali_soft_job_terminate(void);
+
 /**
  * Create a soft job system.
  *
@@ -141,6 +153,17 @@ void mali_soft_job_destroy(struct mali_soft_job *job);
  */
 mali_timeline_point mali_soft_job_start(struct mali_soft_job *job, struct mali_timeline_fence *fence);
 
+/**
+ * Prepare a soft job for being started, without adding it to the Timeline system.
+ *
+ * Used when the caller adds the job's tracker to the Timeline system itself, together with
+ * other trackers (@ref mali_timeline_system_add_tracker_batch).
+ *
+ * @param job Soft job to start.
+ * @param fence Fence representing dependencies for this soft job.
+ */
+void mali_soft_job_prepare_start(struct mali_soft_job *job, struct mali_timeline_fence *fence);
+
 /**
  * Use by user-space to signal that a soft job has completed.
  *
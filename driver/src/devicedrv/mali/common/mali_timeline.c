@@ -16,6 +16,7 @@
 #include "mali_timeline_sync_fence.h"
 #include "mali_executor.h"
 #include "mali_pp_job.h"
+#include "mali_memory_swap_alloc.h"
 
 #define MALI_TIMELINE_SYSTEM_LOCKED(system) (mali_spinlock_reentrant_is_held((system)->spinlock, _mali_osk_get_tid()))
 
@@ -35,6 +36,11 @@ _mali_osk_atomic_t gp_tracker_count;
 _mali_osk_atomic_t phy_pp_tracker_count;
 _mali_osk_atomic_t virt_pp_tracker_count;
 
+#define MALI_TIMELINE_WAITER_POOL_MAX_CACHED 256
+
+/* Backing store for waiters, each timeline system also keeps its own list of free waiters */
+static _mali_osk_object_pool_t *waiter_pool = NULL;
+
 static mali_scheduler_mask mali_timeline_system_release_waiter(struct mali_timeline_system *system,
 		struct mali_timeline_waiter *waiter);
 
@@ -160,7 +166,7 @@ void mali_timeline_system_stop_timer(struct mali_timeline_system *system)
 	for (i = 0; i < MALI_TIMELINE_MAX; ++i) {
 		struct mali_timeline *timeline = system->timelines[i];
 
-		MALI_DEBUG_ASSERT_POINTER(timeline);
+		if (NULL == timeline) continue;
 
 		if (NULL != timeline->delayed_work) {
 			_mali_osk_wq_delayed_cancel_work_sync(timeline->delayed_work);
@@ -177,8 +183,7 @@ static void mali_timeline_destroy(struct mali_timeline *timeline)
 		MALI_DEBUG_ASSERT(timeline->point_oldest == timeline->point_next);
 		MALI_DEBUG_ASSERT(NULL == timeline->tracker_head);
 		MALI_DEBUG_ASSERT(NULL == timeline->tracker_tail);
-		MALI_DEBUG_ASSERT(NULL == timeline->waiter_head);
-		MALI_DEBUG_ASSERT(NULL == timeline->waiter_tail);
+		MALI_DEBUG_ASSERT(0 == timeline->num_waiters);
 		MALI_DEBUG_ASSERT(NULL != timeline->system);
 		MALI_DEBUG_ASSERT(MALI_TIMELINE_MAX > timeline->id);
 
@@ -221,8 +226,9 @@ static struct mali_timeline *mali_timeline_create(struct mali_timeline_system *s
 	timeline->point_next = 1;
 #endif
 	timeline->point_oldest = timeline->point_next;
+	timeline->waiter_released = timeline->point_oldest;
 
-	/* The tracker and waiter lists will initially be empty. */
+	/* The tracker list and waiter buckets will initially be empty. */
 
 	timeline->system = system;
 	timeline->id = id;
@@ -250,9 +256,8 @@ static struct mali_timeline *mali_timeline_create(struct mali_timeline_system *s
 			_mali_osk_snprintf(timeline_name, 32, "mali-%u-soft", _mali_osk_get_pid());
 			break;
 		default:
-			MALI_PRINT_ERROR(("Mali Timeline: Invalid timeline id %d\n", id));
-			mali_timeline_destroy(timeline);
-			return NULL;
+			_mali_osk_snprintf(timeline_name, 32, "mali-%u-user%u", _mali_osk_get_pid(), id - MALI_TIMELINE_USER);
+			break;
 		}
 
 		timeline->destroyed = MALI_FALSE;
@@ -332,46 +337,72 @@ static void mali_timeline_insert_tracker(struct mali_timeline *timeline, struct
 /* Inserting the waiter object into the given timeline */
 static void mali_timeline_insert_waiter(struct mali_timeline *timeline, struct mali_timeline_waiter *waiter_new)
 {
-	struct mali_timeline_waiter *waiter_prev;
-	struct mali_timeline_waiter *waiter_next;
+	struct mali_timeline_waiter **bucket;
 
 	/* Waiter time must be between timeline head and tail, and there must
 	 * be less than MALI_TIMELINE_MAX_POINT_SPAN elements between */
 	MALI_DEBUG_ASSERT((waiter_new->point - timeline->point_oldest) < MALI_TIMELINE_MAX_POINT_SPAN);
 	MALI_DEBUG_ASSERT((-waiter_new->point + timeline->point_next) < MALI_TIMELINE_MAX_POINT_SPAN);
 
-	/* Finding out where to put this waiter, in the linked waiter list of the given timeline **/
-	waiter_prev = timeline->waiter_head; /* Insert new after  waiter_prev */
-	waiter_next = NULL;                  /* Insert new before waiter_next */
-
-	/* Iterating backwards from head (newest) to tail (oldest) until we
-	 * find the correct spot to insert the new waiter */
-	while (waiter_prev && mali_timeline_point_after(waiter_prev->point, waiter_new->point)) {
-		waiter_next = waiter_prev;
-		waiter_prev = waiter_prev->timeline_prev;
-	}
-
-	if (NULL == waiter_prev && NULL == waiter_next) {
-		/* list is empty */
-		timeline->waiter_head = waiter_new;
-		timeline->waiter_tail = waiter_new;
-	} else if (NULL == waiter_next) {
-		/* insert at head */
-		waiter_new->timeline_prev = timeline->waiter_head;
-		timeline->waiter_head->timeline_next = waiter_new;
-		timeline->waiter_head = waiter_new;
-	} else if (NULL == waiter_prev) {
-		/* insert at tail */
-		waiter_new->timeline_next = timeline->waiter_tail;
-		timeline->waiter_tail->timeline_prev = waiter_new;
-		timeline->waiter_tail = waiter_new;
-	} else {
-		/* insert between */
-		waiter_new->timeline_next = waiter_next;
-		waiter_new->timeline_prev = waiter_prev;
-		waiter_next->timeline_prev = waiter_new;
-		waiter_prev->timeline_next = waiter_new;
+	/* The order within a bucket does not matter, all waiters on a point are released together. */
+	bucket = &timeline->waiter_buckets[waiter_new->point & (MALI_TIMELINE_WAITER_BUCKETS - 1)];
+	waiter_new->timeline_next = *bucket;
+	*bucket = waiter_new;
+
+	timeline->num_waiters++;
+}
+
+/* Remove a waiter that is no longer on the timeline's point list from a bucket, returns NULL if there is none. */
+static struct mali_timeline_waiter *mali_timeline_remove_released_waiter(struct mali_timeline *timeline, u32 bucket)
+{
+	struct mali_timeline_waiter **link = &timeline->waiter_buckets[bucket];
+	u32 time_head_relative = timeline->point_next - timeline->point_oldest;
+
+	while (NULL != *link) {
+		struct mali_timeline_waiter *waiter = *link;
+
+		if ((waiter->point - timeline->point_oldest) >= time_head_relative) {
+			*link = waiter->timeline_next;
+			waiter->timeline_next = NULL;
+			timeline->num_waiters--;
+			return waiter;
+		}
+
+		/* Waiter on a later point sharing the bucket. */
+		link = &waiter->timeline_next;
 	}
+
+	return NULL;
+}
+
+/* Take the next waiter no longer on the timeline's point list off the buckets, returns NULL if there is none.
+ * Such waiters can only be in the buckets of the points released since the last update, and the last
+ * MALI_TIMELINE_WAITER_BUCKETS of those points cover every bucket.  How far the buckets have been swept
+ * is kept in the timeline, as releasing a waiter can update the same timeline again. */
+static struct mali_timeline_waiter *mali_timeline_next_released_waiter(struct mali_timeline *timeline)
+{
+	struct mali_timeline_waiter *waiter;
+
+	if (MALI_TIMELINE_WAITER_BUCKETS < (timeline->point_oldest - timeline->waiter_released)) {
+		timeline->waiter_released = timeline->point_oldest - MALI_TIMELINE_WAITER_BUCKETS;
+	}
+
+	while (0 < timeline->num_waiters && timeline->waiter_released != timeline->point_oldest) {
+		waiter = mali_timeline_remove_released_waiter(timeline,
+				timeline->waiter_released & (MALI_TIMELINE_WAITER_BUCKETS - 1));
+		if (NULL != waiter) {
+			return waiter;
+		}
+
+		/* Bucket done, move on to the next point. */
+		timeline->waiter_released++;
+	}
+
+	if (0 == timeline->num_waiters) {
+		timeline->waiter_released = timeline->point_oldest;
+	}
+
+	return NULL;
 }
 
 static void mali_timeline_update_delayed_work(struct mali_timeline *timeline)
@@ -406,9 +437,24 @@ static void mali_timeline_update_delayed_work(struct mali_timeline *timeline)
 	}
 }
 
-static mali_scheduler_mask mali_timeline_update_oldest_point(struct mali_timeline *timeline)
+/* Update the timeline's entry in the seqno page user space polls, if any. */
+MALI_STATIC_INLINE void mali_timeline_publish_oldest_point(struct mali_timeline *timeline)
+{
+	_mali_uk_timeline_seqno_page_s *seqno_page = timeline->system->seqno_page;
+
+	if (NULL != seqno_page) {
+		/* Whatever the released points guard must be visible first. */
+		_mali_osk_write_mem_barrier();
+		*(volatile u32 *)&seqno_page->point_oldest[timeline->id] = timeline->point_oldest;
+	}
+}
+
+/* released_type is the type of the tracker whose release moved the oldest point. */
+static mali_scheduler_mask mali_timeline_update_oldest_point(struct mali_timeline *timeline,
+		enum mali_timeline_tracker_type released_type)
 {
 	mali_scheduler_mask schedule_mask = MALI_SCHEDULER_MASK_EMPTY;
+	u64 gp_end_time = 0;
 
 	MALI_DEBUG_ASSERT_POINTER(timeline);
 
@@ -427,30 +473,27 @@ static mali_scheduler_mask mali_timeline_update_oldest_point(struct mali_timelin
 		timeline->point_oldest = timeline->point_next;
 	}
 
+	mali_timeline_publish_oldest_point(timeline);
+
 	/* Release all waiters no longer on the timeline's point list.
 	 * Releasing a waiter can trigger this function to be called again, so
-	 * we do not store any pointers on stack. */
-	while (NULL != timeline->waiter_tail) {
-		u32 waiter_time_relative;
-		u32 time_head_relative;
-		struct mali_timeline_waiter *waiter = timeline->waiter_tail;
-
-		time_head_relative = timeline->point_next - timeline->point_oldest;
-		waiter_time_relative = waiter->point - timeline->point_oldest;
+	 * we do not store any pointers on stack across the release. */
+	for (;;) {
+		struct mali_timeline_waiter *waiter = mali_timeline_next_released_waiter(timeline);
 
-		if (waiter_time_relative < time_head_relative) {
-			/* This and all following waiters are on the point list, so we are done. */
+		if (NULL == waiter) {
 			break;
 		}
 
-		/* Remove waiter from timeline's waiter list. */
-		if (NULL != waiter->timeline_next) {
-			waiter->timeline_next->timeline_prev = NULL;
-		} else {
-			/* This was the last waiter */
-			timeline->waiter_head = NULL;
+		/* Remember when the GP work a PP job waited on ended, for the
+		 * GP to PP latency statistics. GP jobs can be on any timeline. */
+		if (MALI_TIMELINE_TRACKER_GP == released_type &&
+		    MALI_TIMELINE_TRACKER_PP == waiter->tracker->type) {
+			if (0 == gp_end_time) {
+				gp_end_time = _mali_osk_time_get_ns();
+			}
+			waiter->tracker->gp_end_time = gp_end_time;
 		}
-		timeline->waiter_tail = waiter->timeline_next;
 
 		/* Release waiter.  This could activate a tracker, if this was
 		 * the last waiter for the tracker. */
@@ -460,6 +503,66 @@ static mali_scheduler_mask mali_timeline_update_oldest_point(struct mali_timelin
 	return schedule_mask;
 }
 
+_mali_osk_errcode_t mali_timeline_waiter_benchmark(u32 num_waiters, u64 *insert_ns, u64 *release_ns)
+{
+	struct mali_timeline *timeline;
+	struct mali_timeline_waiter *waiters;
+	u32 num_released = 0;
+	u32 i;
+	u64 start;
+
+	MALI_DEBUG_ASSERT_POINTER(insert_ns);
+	MALI_DEBUG_ASSERT_POINTER(release_ns);
+
+	if (0 == num_waiters || MALI_TIMELINE_WAITER_BENCHMARK_MAX < num_waiters) {
+		return _MALI_OSK_ERR_INVALID_ARGS;
+	}
+
+	/* The timeline is not part of any timeline system, nothing else can reach it. */
+	timeline = _mali_osk_calloc(1, sizeof(*timeline));
+	if (NULL == timeline) {
+		return _MALI_OSK_ERR_NOMEM;
+	}
+
+	waiters = _mali_osk_valloc(sizeof(*waiters) * num_waiters);
+	if (NULL == waiters) {
+		_mali_osk_free(timeline);
+		return _MALI_OSK_ERR_NOMEM;
+	}
+	_mali_osk_memset(waiters, 0, sizeof(*waiters) * num_waiters);
+
+	/* One waiter per point, as for a deep pipeline of jobs each waiting on the one before. */
+	timeline->point_oldest = 1;
+	timeline->point_next = timeline->point_oldest + num_waiters;
+	timeline->waiter_released = timeline->point_oldest;
+	for (i = 0; i < num_waiters; i++) {
+		waiters[i].point = timeline->point_oldest + i;
+	}
+
+	start = _mali_osk_time_get_ns();
+	for (i = 0; i < num_waiters; i++) {
+		mali_timeline_insert_waiter(timeline, &waiters[i]);
+	}
+	*insert_ns = _mali_osk_time_get_ns() - start;
+
+	/* Release the points one at a time, as jobs completing in order do. */
+	start = _mali_osk_time_get_ns();
+	while (timeline->point_oldest != timeline->point_next) {
+		timeline->point_oldest++;
+		while (NULL != mali_timeline_next_released_waiter(timeline)) {
+			num_released++;
+		}
+	}
+	*release_ns = _mali_osk_time_get_ns() - start;
+
+	MALI_DEBUG_ASSERT(0 == timeline->num_waiters);
+
+	_mali_osk_vfree(waiters);
+	_mali_osk_free(timeline);
+
+	return (num_waiters == num_released) ? _MALI_OSK_ERR_OK : _MALI_OSK_ERR_FAULT;
+}
+
 void mali_timeline_tracker_init(struct mali_timeline_tracker *tracker,
 				mali_timeline_tracker_type type,
 				struct mali_timeline_fence *fence,
@@ -544,7 +647,7 @@ mali_scheduler_mask mali_timeline_tracker_release(struct mali_timeline_tracker *
 		timeline->tracker_tail = tracker_next;
 		MALI_DEBUG_ASSERT(MALI_TIMELINE_SYSTEM_LOCKED(system));
 		/* Update the timeline's oldest time and release any waiters */
-		schedule_mask |= mali_timeline_update_oldest_point(timeline);
+		schedule_mask |= mali_timeline_update_oldest_point(timeline, tracker->type);
 		MALI_DEBUG_ASSERT(MALI_TIMELINE_SYSTEM_LOCKED(system));
 	} else {
 		tracker_prev->timeline_next = tracker_next;
@@ -687,10 +790,15 @@ void mali_timeline_fence_copy_uk_fence(struct mali_timeline_fence *fence, _mali_
 	MALI_DEBUG_ASSERT_POINTER(fence);
 	MALI_DEBUG_ASSERT_POINTER(uk_fence);
 
-	for (i = 0; i < MALI_TIMELINE_MAX; ++i) {
+	for (i = 0; i < MALI_UK_TIMELINE_MAX; ++i) {
 		fence->points[i] = uk_fence->points[i];
 	}
 
+	/* UK fences have no points on user timelines. */
+	for (; i < MALI_TIMELINE_MAX; ++i) {
+		fence->points[i] = MALI_TIMELINE_NO_POINT;
+	}
+
 	fence->sync_fd = uk_fence->sync_fd;
 }
 
@@ -713,7 +821,8 @@ struct mali_timeline_system *mali_timeline_system_create(struct mali_session_dat
 		return NULL;
 	}
 
-	for (i = 0; i < MALI_TIMELINE_MAX; ++i) {
+	/* User timelines are created on request. */
+	for (i = 0; i < MALI_TIMELINE_USER; ++i) {
 		system->timelines[i] = mali_timeline_create(system, (enum mali_timeline_id)i);
 		if (NULL == system->timelines[i]) {
 			mali_timeline_system_destroy(system);
@@ -742,6 +851,97 @@ struct mali_timeline_system *mali_timeline_system_create(struct mali_session_dat
 	return system;
 }
 
+_mali_osk_errcode_t mali_timeline_system_create_user_timeline(struct mali_timeline_system *system,
+		enum mali_timeline_id *timeline_id)
+{
+	struct mali_timeline *timeline;
+	u32 i;
+	u32 tid = _mali_osk_get_tid();
+
+	MALI_DEBUG_ASSERT_POINTER(system);
+	MALI_DEBUG_ASSERT_POINTER(timeline_id);
+
+	for (;;) {
+		/* Find a free id, the timeline can't be created with the lock held. */
+		mali_spinlock_reentrant_wait(system->spinlock, tid);
+		for (i = MALI_TIMELINE_USER; i < MALI_TIMELINE_MAX; ++i) {
+			if (NULL == system->timelines[i]) break;
+		}
+		mali_spinlock_reentrant_signal(system->spinlock, tid);
+
+		if (MALI_TIMELINE_MAX == i) {
+			return _MALI_OSK_ERR_BUSY;
+		}
+
+		timeline = mali_timeline_create(system, (enum mali_timeline_id)i);
+		if (NULL == timeline) {
+			return _MALI_OSK_ERR_NOMEM;
+		}
+
+		mali_spinlock_reentrant_wait(system->spinlock, tid);
+		if (NULL == system->timelines[i]) {
+			system->timelines[i] = timeline;
+			mali_timeline_publish_oldest_point(timeline);
+			mali_spinlock_reentrant_signal(system->spinlock, tid);
+
+			MALI_DEBUG_PRINT(4, ("Mali Timeline: created user timeline %u\n", i));
+			*timeline_id = (enum mali_timeline_id)i;
+			return _MALI_OSK_ERR_OK;
+		}
+		mali_spinlock_reentrant_signal(system->spinlock, tid);
+
+		/* Another thread took the id, try the next one. */
+		mali_timeline_destroy(timeline);
+	}
+}
+
+mali_bool mali_timeline_system_has_timeline(struct mali_timeline_system *system,
+		enum mali_timeline_id timeline_id)
+{
+	mali_bool ret;
+	u32 tid = _mali_osk_get_tid();
+
+	MALI_DEBUG_ASSERT_POINTER(system);
+
+	if (MALI_TIMELINE_MAX <= timeline_id) {
+		return MALI_FALSE;
+	}
+
+	mali_spinlock_reentrant_wait(system->spinlock, tid);
+	ret = (NULL != system->timelines[timeline_id]) ? MALI_TRUE : MALI_FALSE;
+	mali_spinlock_reentrant_signal(system->spinlock, tid);
+
+	return ret;
+}
+
+_mali_osk_errcode_t mali_timeline_system_set_seqno_page(struct mali_timeline_system *system,
+		_mali_uk_timeline_seqno_page_s *seqno_page)
+{
+	u32 i;
+	u32 tid = _mali_osk_get_tid();
+
+	MALI_DEBUG_ASSERT_POINTER(system);
+	MALI_DEBUG_ASSERT_POINTER(seqno_page);
+
+	mali_spinlock_reentrant_wait(system->spinlock, tid);
+
+	if (NULL != system->seqno_page) {
+		mali_spinlock_reentrant_signal(system->spinlock, tid);
+		return _MALI_OSK_ERR_BUSY;
+	}
+
+	system->seqno_page = seqno_page;
+
+	for (i = 0; i < MALI_TIMELINE_MAX; ++i) {
+		if (NULL == system->timelines[i]) continue;
+		mali_timeline_publish_oldest_point(system->timelines[i]);
+	}
+
+	mali_spinlock_reentrant_signal(system->spinlock, tid);
+
+	return _MALI_OSK_ERR_OK;
+}
+
 #if defined(CONFIG_MALI_DMA_BUF_FENCE) ||defined(CONFIG_SYNC) ||defined(CONFIG_SYNC_FILE)
 /**
  * Check if there are any trackers left on timeline.
@@ -784,7 +984,7 @@ static void mali_timeline_cancel_sync_fence_waiters(struct mali_timeline_system
 	for (i = 0; i < MALI_TIMELINE_MAX; ++i) {
 		struct mali_timeline *timeline = system->timelines[i];
 
-		MALI_DEBUG_ASSERT_POINTER(timeline);
+		if (NULL == timeline) continue;
 
 		tracker_next = timeline->tracker_tail;
 		while (NULL != tracker_next) {
@@ -818,7 +1018,7 @@ static void mali_timeline_cancel_sync_fence_waiters(struct mali_timeline_system
 	for (i = 0; i < MALI_TIMELINE_MAX; ++i) {
 		struct mali_timeline *timeline = system->timelines[i];
 
-		MALI_DEBUG_ASSERT_POINTER(timeline);
+		if (NULL == timeline) continue;
 
 		_mali_osk_wait_queue_wait_event(system->wait_queue, mali_timeline_has_no_trackers, (void *) timeline);
 	}
@@ -843,44 +1043,46 @@ static void mali_timeline_cancel_dma_fence_waiters(struct mali_timeline_system *
 
 	mali_spinlock_reentrant_wait(system->spinlock, tid);
 
-	/* Cancel dma fence waiters. */
-	timeline = system->timelines[MALI_TIMELINE_PP];
-	MALI_DEBUG_ASSERT_POINTER(timeline);
+	/* Cancel dma fence waiters, PP jobs are on the PP timeline or on user timelines. */
+	for (i = 0; i < MALI_TIMELINE_MAX; ++i) {
+		timeline = system->timelines[i];
+		if (NULL == timeline) continue;
+
+		tracker_next = timeline->tracker_tail;
+		while (NULL != tracker_next) {
+			mali_bool fence_is_signaled = MALI_TRUE;
+			tracker = tracker_next;
+			tracker_next = tracker->timeline_next;
 
-	tracker_next = timeline->tracker_tail;
-	while (NULL != tracker_next) {
-		mali_bool fence_is_signaled = MALI_TRUE;
-		tracker = tracker_next;
-		tracker_next = tracker->timeline_next;
-
-		if (NULL == tracker->waiter_dma_fence) continue;
-		pp_job = (struct mali_pp_job *)tracker->job;
-		MALI_DEBUG_ASSERT_POINTER(pp_job);
-		MALI_DEBUG_PRINT(3, ("Mali Timeline: Cancelling dma fence waiter for tracker 0x%08X.\n", tracker));
-
-		for (j = 0; j < pp_job->dma_fence_context.num_dma_fence_waiter; j++) {
-			if (pp_job->dma_fence_context.mali_dma_fence_waiters[j]) {
-				/* Cancel a previously callback from the fence.
-				* This function returns true if the callback is successfully removed,
-				* or false if the fence has already been signaled.
-				*/
+			if (MALI_TIMELINE_TRACKER_PP != tracker->type || NULL == tracker->waiter_dma_fence) continue;
+			pp_job = (struct mali_pp_job *)tracker->job;
+			MALI_DEBUG_ASSERT_POINTER(pp_job);
+			MALI_DEBUG_PRINT(3, ("Mali Timeline: Cancelling dma fence waiter for tracker 0x%08X.\n", tracker));
+
+			for (j = 0; j < pp_job->dma_fence_context.num_dma_fence_waiter; j++) {
+				if (pp_job->dma_fence_context.mali_dma_fence_waiters[j]) {
+					/* Cancel a previously callback from the fence.
+					* This function returns true if the callback is successfully removed,
+					* or false if the fence has already been signaled.
+					*/
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 10, 0)
-				bool ret = dma_fence_remove_callback(pp_job->dma_fence_context.mali_dma_fence_waiters[j]->fence,
-								     &pp_job->dma_fence_context.mali_dma_fence_waiters[j]->base);
+					bool ret = dma_fence_remove_callback(pp_job->dma_fence_context.mali_dma_fence_waiters[j]->fence,
+									     &pp_job->dma_fence_context.mali_dma_fence_waiters[j]->base);
 
 #else
-				bool ret = fence_remove_callback(pp_job->dma_fence_context.mali_dma_fence_waiters[j]->fence,
-								 &pp_job->dma_fence_context.mali_dma_fence_waiters[j]->base);
+					bool ret = fence_remove_callback(pp_job->dma_fence_context.mali_dma_fence_waiters[j]->fence,
+									 &pp_job->dma_fence_context.mali_dma_fence_waiters[j]->base);
 #endif
-				if (ret) {
-					fence_is_signaled = MALI_FALSE;
+					if (ret) {
+						fence_is_signaled = MALI_FALSE;
+					}
 				}
 			}
-		}
 
-		/* Callbacks were not called, move pp job to local list. */
-		if (MALI_FALSE == fence_is_signaled)
-			_mali_osk_list_add(&pp_job->list, &pp_job_list);
+			/* Callbacks were not called, move pp job to local list. */
+			if (MALI_FALSE == fence_is_signaled)
+				_mali_osk_list_add(&pp_job->list, &pp_job_list);
+		}
 	}
 
 	mali_spinlock_reentrant_signal(system->spinlock, tid);
@@ -893,12 +1095,30 @@ static void mali_timeline_cancel_dma_fence_waiters(struct mali_timeline_system *
 	/* Sleep until all dma fence callbacks are done and all timelines are empty. */
 	for (i = 0; i < MALI_TIMELINE_MAX; ++i) {
 		struct mali_timeline *timeline = system->timelines[i];
-		MALI_DEBUG_ASSERT_POINTER(timeline);
+		if (NULL == timeline) continue;
 		_mali_osk_wait_queue_wait_event(system->wait_queue, mali_timeline_has_no_trackers, (void *) timeline);
 	}
 }
 #endif
 #endif
+
+/**
+ * Check if there are any trackers waiting for the swap in worker.
+ *
+ * Used as a wait queue conditional.
+ *
+ * @param data Timeline system.
+ * @return MALI_TRUE if no tracker waits for swap in, MALI_FALSE if not.
+ */
+static mali_bool mali_timeline_has_no_swap_in_waiters(void *data)
+{
+	struct mali_timeline_system *system = (struct mali_timeline_system *) data;
+
+	MALI_DEBUG_ASSERT_POINTER(system);
+
+	return (0 == system->num_swap_in_waiters) ? MALI_TRUE : MALI_FALSE;
+}
+
 void mali_timeline_system_abort(struct mali_timeline_system *system)
 {
 	MALI_DEBUG_CODE(u32 tid = _mali_osk_get_tid(););
@@ -917,6 +1137,9 @@ void mali_timeline_system_abort(struct mali_timeline_system *system)
 	mali_timeline_cancel_dma_fence_waiters(system);
 #endif
 
+	/* Swap in can not be cancelled, sleep until the swap in worker is done with this session. */
+	_mali_osk_wait_queue_wait_event(system->wait_queue, mali_timeline_has_no_swap_in_waiters, (void *) system);
+
 	/* Should not be any waiters or trackers left at this point. */
 	MALI_DEBUG_CODE({
 		u32 i;
@@ -924,12 +1147,11 @@ void mali_timeline_system_abort(struct mali_timeline_system *system)
 		for (i = 0; i < MALI_TIMELINE_MAX; ++i)
 		{
 			struct mali_timeline *timeline = system->timelines[i];
-			MALI_DEBUG_ASSERT_POINTER(timeline);
+			if (NULL == timeline) continue;
 			MALI_DEBUG_ASSERT(timeline->point_oldest == timeline->point_next);
 			MALI_DEBUG_ASSERT(NULL == timeline->tracker_head);
 			MALI_DEBUG_ASSERT(NULL == timeline->tracker_tail);
-			MALI_DEBUG_ASSERT(NULL == timeline->waiter_head);
-			MALI_DEBUG_ASSERT(NULL == timeline->waiter_tail);
+			MALI_DEBUG_ASSERT(0 == timeline->num_waiters);
 		}
 		mali_spinlock_reentrant_signal(system->spinlock, tid);
 	});
@@ -960,7 +1182,7 @@ void mali_timeline_system_destroy(struct mali_timeline_system *system)
 		waiter = system->waiter_empty_list;
 		while (NULL != waiter) {
 			next = waiter->tracker_next;
-			_mali_osk_free(waiter);
+			_mali_osk_object_pool_free(waiter_pool, waiter);
 			waiter = next;
 		}
 
@@ -1066,7 +1288,7 @@ static void mali_timeline_system_allocate_waiters(struct mali_timeline_system *s
 				continue;
 			}
 		} else {
-			waiter = _mali_osk_calloc(1, sizeof(struct mali_timeline_waiter));
+			waiter = _mali_osk_object_pool_alloc(waiter_pool);
 			if (NULL == waiter) break;
 		}
 		++i;
@@ -1090,16 +1312,15 @@ static void mali_timeline_system_allocate_waiters(struct mali_timeline_system *s
  *
  * @param system Timeline system.
  * @param tracker Tracker we will create waiters for.
- * @param waiter_tail List of pre-allocated waiters.
- * @param waiter_head List of pre-allocated waiters.
+ * @param waiter_list List of pre-allocated waiters, the waiters used are removed from the list.
+ * @return Scheduling bitmask.
  */
-static void mali_timeline_system_create_waiters_and_unlock(struct mali_timeline_system *system,
+static mali_scheduler_mask mali_timeline_system_create_waiters(struct mali_timeline_system *system,
 		struct mali_timeline_tracker *tracker,
-		struct mali_timeline_waiter *waiter_tail,
-		struct mali_timeline_waiter *waiter_head)
+		struct mali_timeline_waiter **waiter_list)
 {
 	int i;
-	u32 tid = _mali_osk_get_tid();
+	struct mali_timeline_waiter *waiter_tail = *waiter_list;
 	mali_scheduler_mask schedule_mask = MALI_SCHEDULER_MASK_EMPTY;
 #if defined(CONFIG_SYNC) || defined(CONFIG_SYNC_FILE)
 #if LINUX_VERSION_CODE < KERNEL_VERSION(4, 6, 0)
@@ -1134,7 +1355,10 @@ static void mali_timeline_system_create_waiters_and_unlock(struct mali_timeline_
 		}
 
 		timeline = system->timelines[i];
-		MALI_DEBUG_ASSERT_POINTER(timeline);
+		if (unlikely(NULL == timeline)) {
+			MALI_PRINT_ERROR(("Mali Timeline: point %d is on timeline %d which does not exist\n", point, i));
+			continue;
+		}
 
 		if (unlikely(!mali_timeline_is_point_valid(timeline, point))) {
 			MALI_PRINT_ERROR(("Mali Timeline: point %d is not valid (oldest=%d, next=%d)\n",
@@ -1179,6 +1403,47 @@ static void mali_timeline_system_create_waiters_and_unlock(struct mali_timeline_
 		/* Add waiter to timeline. */
 		mali_timeline_insert_waiter(timeline, waiter);
 	}
+
+	if (MALI_TIMELINE_TRACKER_PP == tracker->type &&
+	    MALI_TRUE == ((struct mali_pp_job *)tracker->job)->swap_in_pending) {
+		struct mali_timeline_waiter *waiter;
+
+		/* Check if we have a zeroed waiter object available. */
+		if (unlikely(NULL == waiter_tail)) {
+			MALI_PRINT_ERROR(("Mali Timeline: failed to allocate memory for waiter\n"));
+			/* The job's memory will not be swapped in, so the job must not run. */
+			tracker->activation_error |= MALI_TIMELINE_ACTIVATION_ERROR_FATAL_BIT;
+			goto exit;
+		}
+
+		/* Grab new zeroed waiter object. */
+		waiter = waiter_tail;
+		waiter_tail = waiter_tail->tracker_next;
+
+		/* Increase the trigger ref count of the tracker. */
+		tracker->trigger_ref_count++;
+
+		waiter->point   = MALI_TIMELINE_NO_POINT;
+		waiter->tracker = tracker;
+
+		/* Insert waiter on tracker's singly-linked waiter list. */
+		if (NULL == tracker->waiter_head) {
+			/* list is empty */
+			MALI_DEBUG_ASSERT(NULL == tracker->waiter_tail);
+			tracker->waiter_tail = waiter;
+		} else {
+			tracker->waiter_head->tracker_next = waiter;
+		}
+		tracker->waiter_head = waiter;
+
+		/* Also store waiter in separate field for easy access by swap in callback. */
+		tracker->waiter_swap_in = waiter;
+		system->num_swap_in_waiters++;
+
+		/* The waiter is in place, let the swap in worker start reading in pages. */
+		mali_mem_swap_in_pages_async((struct mali_pp_job *)tracker->job);
+	}
+
 #if defined(CONFIG_SYNC) || defined(CONFIG_SYNC_FILE)
 	if (-1 != tracker->fence.sync_fd) {
 		int ret;
@@ -1247,7 +1512,7 @@ static void mali_timeline_system_create_waiters_and_unlock(struct mali_timeline_
 	}
 #endif /* defined(CONFIG_SYNC) || defined(CONFIG_SYNC_FILE)*/
 #if defined(CONFIG_MALI_DMA_BUF_FENCE)
-	if ((NULL != tracker->timeline) && (MALI_TIMELINE_PP == tracker->timeline->id)) {
+	if ((NULL != tracker->timeline) && (MALI_TIMELINE_TRACKER_PP == tracker->type)) {
 
 		struct mali_pp_job *job = (struct mali_pp_job *)tracker->job;
 
@@ -1285,13 +1550,9 @@ static void mali_timeline_system_create_waiters_and_unlock(struct mali_timeline_
 	}
 #endif /* defined(CONFIG_MALI_DMA_BUF_FENCE)*/
 
-#if defined(CONFIG_MALI_DMA_BUF_FENCE) ||defined(CONFIG_SYNC) || defined(CONFIG_SYNC_FILE)
 exit:
-#endif /* defined(CONFIG_MALI_DMA_BUF_FENCE) || defined(CONFIG_SYNC) || defined(CONFIG_SYNC_FILE) */
 
-	if (NULL != waiter_tail) {
-		mali_timeline_system_release_waiter_list(system, waiter_tail, waiter_head);
-	}
+	*waiter_list = waiter_tail;
 
 	/* Release the initial trigger ref count. */
 	tracker->trigger_ref_count--;
@@ -1301,9 +1562,8 @@ exit:
 		schedule_mask |= mali_timeline_tracker_activate(tracker);
 	}
 
-	mali_spinlock_reentrant_signal(system->spinlock, tid);
-
 #if defined(CONFIG_SYNC) || defined(CONFIG_SYNC_FILE)
+	/* fput() defers the final release of the file, so this is safe with the lock held. */
 	if (NULL != sync_fence) {
 #if LINUX_VERSION_CODE < KERNEL_VERSION(4, 6, 0)
 		sync_fence_put(sync_fence);
@@ -1313,7 +1573,34 @@ exit:
 	}
 #endif /* defined(CONFIG_SYNC) || defined(CONFIG_SYNC_FILE) */
 
-	mali_executor_schedule_from_mask(schedule_mask, MALI_FALSE);
+	return schedule_mask;
+}
+
+/**
+ * Create waiters for the given tracker, then release the timeline system lock and schedule.
+ *
+ * @param system Timeline system.
+ * @param tracker Tracker we will create waiters for.
+ * @param waiter_tail List of pre-allocated waiters.
+ * @param waiter_head List of pre-allocated waiters.
+ */
+static void mali_timeline_system_create_waiters_and_unlock(struct mali_timeline_system *system,
+		struct mali_timeline_tracker *tracker,
+		struct mali_timeline_waiter *waiter_tail,
+		struct mali_timeline_waiter *waiter_head)
+{
+	u32 tid = _mali_osk_get_tid();
+	mali_scheduler_mask schedule_mask;
+
+	schedule_mask = mali_timeline_system_create_waiters(system, tracker, &waiter_tail);
+
+	if (NULL != waiter_tail) {
+		mali_timeline_system_release_waiter_list(system, waiter_tail, waiter_head);
+	}
+
+	mali_spinlock_reentrant_signal(system->spinlock, tid);
+
+	mali_executor_submit_from_mask(schedule_mask);
 }
 
 mali_timeline_point mali_timeline_system_add_tracker(struct mali_timeline_system *system,
@@ -1344,13 +1631,18 @@ mali_timeline_point mali_timeline_system_add_tracker(struct mali_timeline_system
 	num_waiters = mali_timeline_fence_num_waiters(&tracker->fence);
 
 #if defined(CONFIG_MALI_DMA_BUF_FENCE)
-	if (MALI_TIMELINE_PP == timeline_id) {
+	if (MALI_TIMELINE_TRACKER_PP == tracker->type) {
 		struct mali_pp_job *job = (struct mali_pp_job *)tracker->job;
 		if (0 < job->dma_fence_context.num_dma_fence_waiter)
 			num_waiters++;
 	}
 #endif
 
+	if (MALI_TIMELINE_TRACKER_PP == tracker->type &&
+	    MALI_TRUE == ((struct mali_pp_job *)tracker->job)->swap_in_pending) {
+		num_waiters++;
+	}
+
 	/* Allocate waiters. */
 	mali_timeline_system_allocate_waiters(system, &waiter_tail, &waiter_head, num_waiters);
 	MALI_DEBUG_ASSERT(MALI_TIMELINE_SYSTEM_LOCKED(system));
@@ -1364,6 +1656,7 @@ mali_timeline_point mali_timeline_system_add_tracker(struct mali_timeline_system
 	MALI_DEBUG_ASSERT(timeline_id < MALI_TIMELINE_MAX || timeline_id == MALI_TIMELINE_NONE);
 	if (likely(timeline_id < MALI_TIMELINE_MAX)) {
 		struct mali_timeline *timeline = system->timelines[timeline_id];
+		MALI_DEBUG_ASSERT_POINTER(timeline);
 		mali_timeline_insert_tracker(timeline, tracker);
 		MALI_DEBUG_ASSERT(!mali_timeline_is_empty(timeline));
 	}
@@ -1384,6 +1677,124 @@ mali_timeline_point mali_timeline_system_add_tracker(struct mali_timeline_system
 	return point;
 }
 
+void mali_timeline_fence_add_point(struct mali_timeline_fence *fence,
+				   enum mali_timeline_id timeline_id, mali_timeline_point point)
+{
+	MALI_DEBUG_ASSERT_POINTER(fence);
+
+	if (MALI_TIMELINE_MAX <= timeline_id || MALI_TIMELINE_NO_POINT == point) {
+		return;
+	}
+
+	if (MALI_TIMELINE_NO_POINT == fence->points[timeline_id] ||
+	    mali_timeline_point_after(point, fence->points[timeline_id])) {
+		fence->points[timeline_id] = point;
+	}
+}
+
+void mali_timeline_system_add_tracker_batch(struct mali_timeline_system *system,
+		struct mali_timeline_batch_entry *entries, u32 num_entries)
+{
+	u32 i, j;
+	int num_waiters = 0;
+	struct mali_timeline_waiter *waiter_tail, *waiter_head;
+	mali_scheduler_mask schedule_mask = MALI_SCHEDULER_MASK_EMPTY;
+	u32 tid = _mali_osk_get_tid();
+
+	MALI_DEBUG_ASSERT_POINTER(system);
+	MALI_DEBUG_ASSERT_POINTER(system->session);
+	MALI_DEBUG_ASSERT_POINTER(entries);
+	MALI_DEBUG_ASSERT(MALI_TIMELINE_BATCH_MAX >= num_entries);
+
+	MALI_DEBUG_ASSERT(MALI_FALSE == system->session->is_aborting);
+
+	/* Count the waiters needed by all trackers, so they can be allocated in one go. */
+	for (i = 0; i < num_entries; ++i) {
+		struct mali_timeline_tracker *tracker = entries[i].tracker;
+		mali_bool dep_timelines[MALI_TIMELINE_MAX] = { MALI_FALSE };
+
+		MALI_DEBUG_ASSERT_POINTER(tracker);
+		MALI_DEBUG_ASSERT(MALI_TIMELINE_TRACKER_MAX > tracker->type);
+		MALI_DEBUG_ASSERT(MALI_TIMELINE_TRACKER_MAGIC == tracker->magic);
+		MALI_DEBUG_ASSERT(0 < tracker->trigger_ref_count);
+		MALI_DEBUG_ASSERT(entries[i].timeline_id < MALI_TIMELINE_MAX || entries[i].timeline_id == MALI_TIMELINE_NONE);
+		MALI_DEBUG_ASSERT(0 == (entries[i].deps >> i));
+
+		tracker->system = system;
+		entries[i].point = MALI_TIMELINE_NO_POINT;
+
+		num_waiters += mali_timeline_fence_num_waiters(&tracker->fence);
+
+		/* A dependency needs an extra waiter unless the fence already waits on that timeline. */
+		for (j = 0; j < i; ++j) {
+			enum mali_timeline_id id = entries[j].timeline_id;
+
+			if (0 == (entries[i].deps & ((u32)1 << j)) || MALI_TIMELINE_MAX <= id) {
+				continue;
+			}
+
+			if (MALI_TIMELINE_NO_POINT == tracker->fence.points[id] && !dep_timelines[id]) {
+				dep_timelines[id] = MALI_TRUE;
+				++num_waiters;
+			}
+		}
+
+#if defined(CONFIG_MALI_DMA_BUF_FENCE)
+		if (MALI_TIMELINE_TRACKER_PP == tracker->type) {
+			struct mali_pp_job *job = (struct mali_pp_job *)tracker->job;
+			if (0 < job->dma_fence_context.num_dma_fence_waiter)
+				num_waiters++;
+		}
+#endif
+
+		if (MALI_TIMELINE_TRACKER_PP == tracker->type &&
+		    MALI_TRUE == ((struct mali_pp_job *)tracker->job)->swap_in_pending) {
+			num_waiters++;
+		}
+	}
+
+	MALI_DEBUG_PRINT(4, ("Mali Timeline: adding batch of %u trackers\n", num_entries));
+
+	mali_spinlock_reentrant_wait(system->spinlock, tid);
+
+	/* Allocate waiters. */
+	mali_timeline_system_allocate_waiters(system, &waiter_tail, &waiter_head, num_waiters);
+	MALI_DEBUG_ASSERT(MALI_TIMELINE_SYSTEM_LOCKED(system));
+
+	for (i = 0; i < num_entries; ++i) {
+		struct mali_timeline_tracker *tracker = entries[i].tracker;
+
+		/* Earlier trackers in the batch have their points by now. */
+		for (j = 0; j < i; ++j) {
+			if (0 != (entries[i].deps & ((u32)1 << j))) {
+				mali_timeline_fence_add_point(&tracker->fence,
+							      entries[j].timeline_id, entries[j].point);
+			}
+		}
+
+		/* See mali_timeline_system_add_tracker(). */
+		if (likely(entries[i].timeline_id < MALI_TIMELINE_MAX)) {
+			struct mali_timeline *timeline = system->timelines[entries[i].timeline_id];
+			MALI_DEBUG_ASSERT_POINTER(timeline);
+			mali_timeline_insert_tracker(timeline, tracker);
+			MALI_DEBUG_ASSERT(!mali_timeline_is_empty(timeline));
+		}
+
+		entries[i].point = tracker->point;
+
+		schedule_mask |= mali_timeline_system_create_waiters(system, tracker, &waiter_tail);
+	}
+
+	if (NULL != waiter_tail) {
+		mali_timeline_system_release_waiter_list(system, waiter_tail, waiter_head);
+	}
+
+	mali_spinlock_reentrant_signal(system->spinlock, tid);
+
+	/* Start all activated jobs with one schedule. */
+	mali_executor_submit_from_mask(schedule_mask);
+}
+
 static mali_scheduler_mask mali_timeline_system_release_waiter(struct mali_timeline_system *system,
 		struct mali_timeline_waiter *waiter)
 {
@@ -1431,10 +1842,9 @@ mali_timeline_point mali_timeline_system_get_latest_point(struct mali_timeline_s
 	mali_spinlock_reentrant_wait(system->spinlock, tid);
 
 	timeline = system->timelines[timeline_id];
-	MALI_DEBUG_ASSERT_POINTER(timeline);
 
 	point = MALI_TIMELINE_NO_POINT;
-	if (timeline->point_oldest != timeline->point_next) {
+	if (NULL != timeline && timeline->point_oldest != timeline->point_next) {
 		point = timeline->point_next - 1;
 		if (MALI_TIMELINE_NO_POINT == point) point--;
 	}
@@ -1551,7 +1961,8 @@ static void mali_timeline_do_sync_fence_callback(void *arg)
 #endif /* LINUX_VERSION_CODE < KERNEL_VERSION(3,5,0) */
 
 		if (!is_aborting) {
-			mali_executor_schedule_from_mask(schedule_mask, MALI_TRUE);
+			/* Already on a worker, start the released jobs from here */
+			mali_executor_schedule_dependents(schedule_mask);
 		}
 	}
 }
@@ -1562,6 +1973,12 @@ _mali_osk_errcode_t mali_timeline_initialize(void)
 	_mali_osk_atomic_init(&phy_pp_tracker_count, 0);
 	_mali_osk_atomic_init(&virt_pp_tracker_count, 0);
 
+	waiter_pool = _mali_osk_object_pool_create("mali_timeline_waiter",
+			sizeof(struct mali_timeline_waiter), MALI_TIMELINE_WAITER_POOL_MAX_CACHED);
+	if (NULL == waiter_pool) {
+		return _MALI_OSK_ERR_NOMEM;
+	}
+
 #if defined(CONFIG_SYNC) || defined(CONFIG_SYNC_FILE)
 	sync_fence_callback_list_lock = _mali_osk_spinlock_irq_init(_MALI_OSK_LOCKFLAG_UNORDERED, _MALI_OSK_LOCK_ORDER_FIRST);
 	if (NULL == sync_fence_callback_list_lock) {
@@ -1585,6 +2002,11 @@ void mali_timeline_terminate(void)
 	_mali_osk_atomic_term(&phy_pp_tracker_count);
 	_mali_osk_atomic_term(&virt_pp_tracker_count);
 
+	if (NULL != waiter_pool) {
+		_mali_osk_object_pool_destroy(waiter_pool);
+		waiter_pool = NULL;
+	}
+
 #if defined(CONFIG_SYNC) || defined(CONFIG_SYNC_FILE)
 	if (NULL != sync_fence_callback_list_lock) {
 		_mali_osk_spinlock_irq_term(sync_fence_callback_list_lock);
@@ -1635,7 +2057,7 @@ static const char *timeline_id_to_string(enum mali_timeline_id id)
 	case MALI_TIMELINE_SOFT:
 		return "SOFT";
 	default:
-		return "NONE";
+		return (MALI_TIMELINE_MAX > id) ? "USER" : "NONE";
 	}
 }
 
@@ -1830,15 +2252,14 @@ void mali_timeline_debug_print_system(struct mali_timeline_system *system, _mali
 	for (i = 0; i < MALI_TIMELINE_MAX; ++i) {
 		struct mali_timeline *timeline = system->timelines[i];
 
-		MALI_DEBUG_ASSERT_POINTER(timeline);
-
-		if (NULL == timeline->tracker_head) continue;
+		if (NULL == timeline || NULL == timeline->tracker_head) continue;
 		if (print_ctx)
 			_mali_osk_ctxprintf(print_ctx, "TL: Timeline %s:\n",
 					    timeline_id_to_string((enum mali_timeline_id)i));
 		else
-			MALI_DEBUG_PRINT(2, ("TL: Timeline %s: oldest (%u) next(%u)\n",
-					     timeline_id_to_string((enum mali_timeline_id)i), timeline->point_oldest, timeline->point_next));
+			MALI_DEBUG_PRINT(2, ("TL: Timeline %s: oldest (%u) next(%u) waiters(%u)\n",
+					     timeline_id_to_string((enum mali_timeline_id)i), timeline->point_oldest, timeline->point_next,
+					     timeline->num_waiters));
 
 		mali_timeline_debug_print_timeline(timeline, print_ctx);
 		num_printed++;
@@ -1893,7 +2314,50 @@ void mali_timeline_dma_fence_callback(void *pp_job_ptr)
 	mali_spinlock_reentrant_signal(system->spinlock, tid);
 
 	if (!is_aborting) {
-		mali_executor_schedule_from_mask(schedule_mask, MALI_TRUE);
+		mali_executor_schedule_dependents(schedule_mask);
 	}
 }
 #endif
+
+void mali_timeline_swap_in_callback(void *pp_job_ptr)
+{
+	struct mali_timeline_system  *system;
+	struct mali_timeline_waiter  *waiter;
+	struct mali_timeline_tracker *tracker;
+	struct mali_pp_job *pp_job = (struct mali_pp_job *)pp_job_ptr;
+	mali_scheduler_mask schedule_mask = MALI_SCHEDULER_MASK_EMPTY;
+	u32 tid = _mali_osk_get_tid();
+	mali_bool is_aborting = MALI_FALSE;
+
+	MALI_DEBUG_ASSERT_POINTER(pp_job);
+
+	tracker = &pp_job->tracker;
+	MALI_DEBUG_ASSERT_POINTER(tracker);
+
+	system = tracker->system;
+	MALI_DEBUG_ASSERT_POINTER(system);
+	MALI_DEBUG_ASSERT_POINTER(system->session);
+
+	mali_spinlock_reentrant_wait(system->spinlock, tid);
+
+	waiter = tracker->waiter_swap_in;
+	MALI_DEBUG_ASSERT_POINTER(waiter);
+
+	MALI_DEBUG_ASSERT(0 < system->num_swap_in_waiters);
+	system->num_swap_in_waiters--;
+
+	schedule_mask |= mali_timeline_system_release_waiter(system, waiter);
+
+	is_aborting = system->session->is_aborting;
+
+	/* If aborting, wake up sleepers that are waiting for swap in to complete. */
+	if (is_aborting) {
+		_mali_osk_wait_queue_wake_up(system->wait_queue);
+	}
+
+	mali_spinlock_reentrant_signal(system->spinlock, tid);
+
+	if (!is_aborting) {
+		mali_executor_schedule_dependents(schedule_mask);
+	}
+}
@@ -35,7 +35,8 @@ typedef enum mali_timeline_id {
 	MALI_TIMELINE_GP   = MALI_UK_TIMELINE_GP,   /**< GP job timeline. */
 	MALI_TIMELINE_PP   = MALI_UK_TIMELINE_PP,   /**< PP job timeline. */
 	MALI_TIMELINE_SOFT = MALI_UK_TIMELINE_SOFT, /**< Soft job timeline. */
-	MALI_TIMELINE_MAX  = MALI_UK_TIMELINE_MAX
+	MALI_TIMELINE_USER = MALI_UK_TIMELINE_MAX,  /**< First user timeline, for GP and PP jobs. */
+	MALI_TIMELINE_MAX  = MALI_UK_TIMELINE_MAX + MALI_UK_TIMELINE_USER_MAX
 } mali_timeline_id;
 
 /**
@@ -79,6 +80,12 @@ typedef u32 mali_timeline_point;
  */
 #define MALI_TIMELINE_MAX_POINT_SPAN 65536
 
+/**
+ * Number of waiter buckets per timeline.  Waiters are hashed on their point, so a bucket only
+ * holds more than one point while more than this many points are waited on.  Power of two.
+ */
+#define MALI_TIMELINE_WAITER_BUCKETS 256
+
 /**
  * Magic value used to assert on validity of trackers.
  */
@@ -103,7 +110,7 @@ struct mali_timeline_fence {
  */
 struct mali_timeline_system {
 	struct mali_spinlock_reentrant *spinlock;   /**< Spin lock protecting the timeline system */
-	struct mali_timeline           *timelines[MALI_TIMELINE_MAX]; /**< The timelines in this system */
+	struct mali_timeline           *timelines[MALI_TIMELINE_MAX]; /**< The timelines in this system, NULL for user timelines not created */
 
 	/* Single-linked list of unused waiter objects.  Uses the tracker_next field in tracker. */
 	struct mali_timeline_waiter    *waiter_empty_list;
@@ -113,6 +120,8 @@ struct mali_timeline_system {
 	mali_bool                       timer_enabled; /**< Set to MALI_TRUE if soft job timer should be enabled, MALI_FALSE if not. */
 
 	_mali_osk_wait_queue_t         *wait_queue; /**< Wait queue. */
+	u32                             num_swap_in_waiters; /**< Trackers waiting for the swap in worker. */
+	_mali_uk_timeline_seqno_page_s *seqno_page; /**< Page user space polls point_oldest of each timeline in, or NULL. */
 
 #if defined(CONFIG_SYNC) || defined(CONFIG_SYNC_FILE)
 #if LINUX_VERSION_CODE < KERNEL_VERSION(4, 6, 0)
@@ -124,7 +133,8 @@ struct mali_timeline_system {
 };
 
 /**
- * Timeline.  Each Timeline system will have MALI_TIMELINE_MAX timelines.
+ * Timeline.  Each Timeline system will have the GP, PP and soft timelines, and the user timelines
+ * created for the session.
  */
 struct mali_timeline {
 	mali_timeline_point           point_next;   /**< The next available point. */
@@ -135,10 +145,11 @@ struct mali_timeline {
 	struct mali_timeline_tracker *tracker_head;
 	struct mali_timeline_tracker *tracker_tail;
 
-	/* Double-linked list of waiters.  Sorted in ascending order by waiter->time_number_wait
-	 * with tail pointing to the waiter with oldest wait time. */
-	struct mali_timeline_waiter  *waiter_head;
-	struct mali_timeline_waiter  *waiter_tail;
+	/* Waiters, in singly-linked lists indexed by point modulo MALI_TIMELINE_WAITER_BUCKETS.
+	 * Waiters on points before waiter_released have all been released. */
+	struct mali_timeline_waiter  *waiter_buckets[MALI_TIMELINE_WAITER_BUCKETS];
+	u32                           num_waiters;
+	mali_timeline_point           waiter_released;
 
 	struct mali_timeline_system  *system;       /**< Timeline system this timeline belongs to. */
 	enum mali_timeline_id         id;           /**< Timeline type. */
@@ -165,8 +176,7 @@ struct mali_timeline_waiter {
 	mali_timeline_point           point;         /**< Point on timeline we are waiting for to be released. */
 	struct mali_timeline_tracker *tracker;       /**< Tracker that is waiting. */
 
-	struct mali_timeline_waiter  *timeline_next; /**< Next waiter on timeline's waiter list. */
-	struct mali_timeline_waiter  *timeline_prev; /**< Previous waiter on timeline's waiter list. */
+	struct mali_timeline_waiter  *timeline_next; /**< Next waiter in timeline's waiter bucket. */
 
 	struct mali_timeline_waiter  *tracker_next;  /**< Next waiter on tracker's waiter list. */
 };
@@ -209,6 +219,7 @@ struct mali_timeline_tracker {
 #if defined(CONFIG_MALI_DMA_BUF_FENCE)
 	struct mali_timeline_waiter   *waiter_dma_fence; /**< A direct pointer to timeline waiter representing dma fence. */
 #endif
+	struct mali_timeline_waiter   *waiter_swap_in; /**< A direct pointer to timeline waiter representing swap in of the job's memory. */
 
 	struct mali_timeline_system   *system;       /**< Timeline system. */
 	struct mali_timeline          *timeline;     /**< Timeline, or NULL if not on a timeline. */
@@ -219,6 +230,8 @@ struct mali_timeline_tracker {
 	unsigned long                 os_tick_create;
 	unsigned long                 os_tick_activate;
 	mali_bool                     timer_active;
+
+	u64                           gp_end_time; /**< Time (ns) a GP job this PP tracker waited on completed, 0 if none. */
 };
 
 extern _mali_osk_atomic_t gp_tracker_count;
@@ -351,6 +364,40 @@ MALI_STATIC_INLINE mali_bool mali_timeline_is_full(struct mali_timeline *timelin
  */
 struct mali_timeline_system *mali_timeline_system_create(struct mali_session_data *session);
 
+/**
+ * Create a user timeline.
+ *
+ * @param system Timeline system.
+ * @param timeline_id Where the id of the new timeline is returned.
+ * @return _MALI_OSK_ERR_OK on success, _MALI_OSK_ERR_BUSY if all user timelines are in use, or
+ * _MALI_OSK_ERR_NOMEM.
+ */
+_mali_osk_errcode_t mali_timeline_system_create_user_timeline(struct mali_timeline_system *system,
+		enum mali_timeline_id *timeline_id);
+
+/**
+ * Check if a timeline exists in a timeline system.
+ *
+ * @param system Timeline system.
+ * @param timeline_id Id of timeline.
+ * @return MALI_TRUE if the timeline exists, MALI_FALSE if not.
+ */
+mali_bool mali_timeline_system_has_timeline(struct mali_timeline_system *system,
+		enum mali_timeline_id timeline_id);
+
+/**
+ * Start publishing the oldest point of each timeline in a page shared with user space.
+ *
+ * The page is filled in with the current points before this function returns, and is updated
+ * whenever a point is released from then on. It must stay allocated until the system is destroyed.
+ *
+ * @param system Timeline system.
+ * @param seqno_page Page to publish points in.
+ * @return _MALI_OSK_ERR_OK on success, _MALI_OSK_ERR_BUSY if the system already has a page.
+ */
+_mali_osk_errcode_t mali_timeline_system_set_seqno_page(struct mali_timeline_system *system,
+		_mali_uk_timeline_seqno_page_s *seqno_page);
+
 /**
  * Abort timeline system.
  *
@@ -397,6 +444,45 @@ mali_timeline_point mali_timeline_system_add_tracker(struct mali_timeline_system
 		struct mali_timeline_tracker *tracker,
 		enum mali_timeline_id timeline_id);
 
+/* Maximum number of trackers added with @ref mali_timeline_system_add_tracker_batch */
+#define MALI_TIMELINE_BATCH_MAX 32
+
+/**
+ * A tracker to be added with @ref mali_timeline_system_add_tracker_batch.
+ */
+struct mali_timeline_batch_entry {
+	struct mali_timeline_tracker *tracker; /**< [in] Initialized tracker to add. */
+	enum mali_timeline_id timeline_id;     /**< [in] Timeline to add the tracker to, or MALI_TIMELINE_NONE. */
+	u32 deps;                              /**< [in] Bit n set if the tracker must wait for entry n, n lower than the index of this entry. */
+	mali_timeline_point point;             /**< [out] Point of the tracker, or MALI_TIMELINE_NO_POINT if not on timeline. */
+};
+
+/**
+ * Add several trackers to a timeline system with a single acquisition of the timeline system
+ * lock, and schedule any activated jobs once afterwards.
+ *
+ * Trackers are added in array order.  On top of its own fence, a tracker will wait for the
+ * points given to the earlier entries selected by its deps mask.  Otherwise the same rules as for
+ * @ref mali_timeline_system_add_tracker apply to each tracker.
+ *
+ * @param system Timeline system the trackers will be added to.
+ * @param entries Trackers to add, points are returned here.
+ * @param num_entries Number of entries, at most MALI_TIMELINE_BATCH_MAX.
+ */
+void mali_timeline_system_add_tracker_batch(struct mali_timeline_system *system,
+		struct mali_timeline_batch_entry *entries, u32 num_entries);
+
+/**
+ * Make a fence also wait for a point, keeping the latest point if the fence already has one on
+ * the same timeline.
+ *
+ * @param fence Timeline fence.
+ * @param timeline_id Id of timeline point is on, ignored if not a real timeline.
+ * @param point Point to wait for, ignored if MALI_TIMELINE_NO_POINT.
+ */
+void mali_timeline_fence_add_point(struct mali_timeline_fence *fence,
+				   enum mali_timeline_id timeline_id, mali_timeline_point point);
+
 /**
  * Get latest point on timeline.
  *
@@ -560,4 +646,28 @@ void mali_timeline_debug_print_system(struct mali_timeline_system *system, _mali
 void mali_timeline_dma_fence_callback(void *pp_job_ptr);
 #endif
 
+/**
+ * The timeline swap in callback, called when all memory of a PP job has been swapped in.
+ *
+ * @param pp_job_ptr The pointer to pp job whose memory was swapped in.
+ */
+void mali_timeline_swap_in_callback(void *pp_job_ptr);
+
+/**
+ * Largest number of waiters of a waiter benchmark run.
+ */
+#define MALI_TIMELINE_WAITER_BENCHMARK_MAX (MALI_TIMELINE_MAX_POINT_SPAN / 2)
+
+/**
+ * Time inserting waiters into the buckets of a timeline, and releasing them again.
+ *
+ * Runs on a timeline of its own, with one waiter per point, releasing one point at a time.
+ *
+ * @param num_waiters Number of waiters, at most MALI_TIMELINE_WAITER_BENCHMARK_MAX.
+ * @param insert_ns Time spent inserting is returned here.
+ * @param release_ns Time spent releasing is returned here.
+ * @return _MALI_OSK_ERR_OK on success, error code if failure.
+ */
+_mali_osk_errcode_t mali_timeline_waiter_benchmark(u32 num_waiters, u64 *insert_ns, u64 *release_ns);
+
 #endif /* __MALI_TIMELINE_H__ */
@@ -157,6 +157,11 @@ mali_bool mali_timeline_fence_wait(struct mali_timeline_system *system, struct m
 		return mali_timeline_fence_wait_check_status(system, fence);
 	}
 
+	/* Don't set up a tracker for a fence which has already signaled. */
+	if (MALI_TRUE == mali_timeline_fence_wait_check_status(system, fence)) {
+		return MALI_TRUE;
+	}
+
 	wait = mali_timeline_fence_wait_tracker_alloc();
 	if (unlikely(NULL == wait)) {
 		MALI_PRINT_ERROR(("Mali Timeline: failed to allocate data for fence wait\n"));
@@ -396,6 +396,18 @@ _mali_osk_errcode_t _mali_ukk_pp_start_job(void *ctx, _mali_uk_pp_start_job_s *u
  */
 _mali_osk_errcode_t _mali_ukk_pp_and_gp_start_job(void *ctx, _mali_uk_pp_and_gp_start_job_s *uargs);
 
+/**
+ * @brief Issue a request to start a batch of GP, PP and soft jobs.
+ *
+ * All job descriptors are copied and validated up front, and the jobs are
+ * added to the timelines together before they are scheduled.
+ *
+ * @param ctx user-kernel context (mali_session)
+ * @param uargs see _mali_uk_submit_batch_s in "mali_utgard_uk_types.h". Use _mali_osk_copy_from_user to retrieve data!
+ * @return _MALI_OSK_ERR_OK on success, otherwise a suitable _mali_osk_errcode_t on failure.
+ */
+_mali_osk_errcode_t _mali_ukk_submit_batch(void *ctx, _mali_uk_submit_batch_s *uargs);
+
 /** @brief Returns the number of Fragment Processors in the system
  *
  * @param args see _mali_uk_get_pp_number_of_cores_s in "mali_utgard_uk_types.h"
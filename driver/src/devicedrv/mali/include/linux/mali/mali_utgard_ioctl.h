@@ -61,6 +61,10 @@ extern "C" {
 #define MALI_IOC_SOFT_JOB_START             _IOWR(MALI_IOC_CORE_BASE, _MALI_UK_SOFT_JOB_START, _mali_uk_soft_job_start_s)
 #define MALI_IOC_SOFT_JOB_SIGNAL            _IOWR(MALI_IOC_CORE_BASE, _MALI_UK_SOFT_JOB_SIGNAL, _mali_uk_soft_job_signal_s)
 #define MALI_IOC_PENDING_SUBMIT             _IOWR(MALI_IOC_CORE_BASE, _MALI_UK_PENDING_SUBMIT, _mali_uk_pending_submit_s)
+#define MALI_IOC_SUBMIT_BATCH               _IOWR(MALI_IOC_CORE_BASE, _MALI_UK_SUBMIT_BATCH, _mali_uk_submit_batch_s)
+#define MALI_IOC_COMPLETION_RING_SETUP      _IOWR(MALI_IOC_CORE_BASE, _MALI_UK_COMPLETION_RING_SETUP, _mali_uk_completion_ring_setup_s)
+#define MALI_IOC_TIMELINE_CREATE            _IOWR(MALI_IOC_CORE_BASE, _MALI_UK_TIMELINE_CREATE, _mali_uk_timeline_create_s)
+#define MALI_IOC_TIMELINE_SEQNO_SETUP       _IOWR(MALI_IOC_CORE_BASE, _MALI_UK_TIMELINE_SEQNO_SETUP, _mali_uk_timeline_seqno_setup_s)
 
 #define MALI_IOC_MEM_ALLOC                  _IOWR(MALI_IOC_MEMORY_BASE, _MALI_UK_ALLOC_MEM, _mali_uk_alloc_mem_s)
 #define MALI_IOC_MEM_FREE                   _IOWR(MALI_IOC_MEMORY_BASE, _MALI_UK_FREE_MEM, _mali_uk_free_mem_s)
@@ -73,6 +77,8 @@ extern "C" {
 #define MALI_IOC_MEM_QUERY_MMU_PAGE_TABLE_DUMP_SIZE _IOR (MALI_IOC_MEMORY_BASE, _MALI_UK_QUERY_MMU_PAGE_TABLE_DUMP_SIZE, _mali_uk_query_mmu_page_table_dump_size_s)
 #define MALI_IOC_MEM_DUMP_MMU_PAGE_TABLE    _IOWR(MALI_IOC_MEMORY_BASE, _MALI_UK_DUMP_MMU_PAGE_TABLE, _mali_uk_dump_mmu_page_table_s)
 #define MALI_IOC_MEM_WRITE_SAFE             _IOWR(MALI_IOC_MEMORY_BASE, _MALI_UK_MEM_WRITE_SAFE, _mali_uk_mem_write_safe_s)
+#define MALI_IOC_MEM_SPARSE_BIND            _IOWR(MALI_IOC_MEMORY_BASE, _MALI_UK_MEM_SPARSE_BIND, _mali_uk_mem_sparse_bind_s)
+#define MALI_IOC_MEM_MADVISE                _IOWR(MALI_IOC_MEMORY_BASE, _MALI_UK_MEM_MADVISE, _mali_uk_mem_madvise_s)
 
 #define MALI_IOC_PP_START_JOB               _IOWR(MALI_IOC_PP_BASE, _MALI_UK_PP_START_JOB, _mali_uk_pp_start_job_s)
 #define MALI_IOC_PP_AND_GP_START_JOB        _IOWR(MALI_IOC_PP_BASE, _MALI_UK_PP_AND_GP_START_JOB, _mali_uk_pp_and_gp_start_job_s)
@@ -36,6 +36,9 @@ extern "C" {
 #define MALI_UK_TIMELINE_SOFT 2
 #define MALI_UK_TIMELINE_MAX  3
 
+/* User timelines of a session have ids MALI_UK_TIMELINE_MAX and up, see _mali_uk_timeline_create_s. */
+#define MALI_UK_TIMELINE_USER_MAX 8
+
 #define MALI_UK_BIG_VARYING_SIZE  (1024*1024*2)
 
 typedef struct {
@@ -94,6 +97,10 @@ typedef enum {
 	_MALI_UK_SOFT_JOB_START,              /**< _mali_ukk_soft_job_start() */
 	_MALI_UK_SOFT_JOB_SIGNAL,             /**< _mali_ukk_soft_job_signal() */
 	_MALI_UK_PENDING_SUBMIT,             /**< _mali_ukk_pending_submit() */
+	_MALI_UK_SUBMIT_BATCH,                /**< _mali_ukk_submit_batch() */
+	_MALI_UK_COMPLETION_RING_SETUP,       /**< mali_completion_ring_setup() */
+	_MALI_UK_TIMELINE_CREATE,             /**< mali_timeline_system_create_user_timeline() */
+	_MALI_UK_TIMELINE_SEQNO_SETUP,        /**< mali_timeline_seqno_setup() */
 
 	/** Memory functions */
 
@@ -108,6 +115,8 @@ typedef enum {
 	_MALI_UK_DUMP_MMU_PAGE_TABLE,            /**< _mali_ukk_mem_dump_mmu_page_table() */
 	_MALI_UK_DMA_BUF_GET_SIZE,               /**< _mali_ukk_dma_buf_get_size() */
 	_MALI_UK_MEM_WRITE_SAFE,                 /**< _mali_uku_mem_write_safe() */
+	_MALI_UK_MEM_SPARSE_BIND,                /**< _mali_ukk_mem_sparse_bind() */
+	_MALI_UK_MEM_MADVISE,                    /**< _mali_ukk_mem_madvise() */
 
 	/** Common functions for each core */
 
@@ -460,6 +469,70 @@ typedef struct {
 
 /** @} */ /* end group _mali_uk_soft_job */
 
+/** @defgroup _mali_uk_submit_batch U/K Batched job submission
+ * @{ */
+
+/** Maximum number of jobs in one batch (one bit per job in depends_on) */
+#define _MALI_UK_SUBMIT_BATCH_MAX_JOBS 32
+
+/** Job types in a batch */
+#define _MALI_UK_BATCH_JOB_GP   0
+#define _MALI_UK_BATCH_JOB_PP   1
+#define _MALI_UK_BATCH_JOB_SOFT 2
+
+/** Batch job flags */
+#define _MALI_UK_BATCH_JOB_FLAG_IN_FENCE  (1 << 0) /**< Wait for the sync_file in in_fence_fd before starting */
+#define _MALI_UK_BATCH_JOB_FLAG_OUT_FENCE (1 << 1) /**< Return a sync_file signaled on completion in out_fence_fd */
+
+/** @brief One job in a batch
+ *
+ * The job arguments are the same as for the single job ioctls, and are
+ * copied from user space together with the rest of the batch. Points and
+ * soft job ids are written back exactly as for the single job ioctls; for
+ * soft jobs the point is written to args.soft.point of this descriptor.
+ *
+ * A GP job in a batch is never linked to a PP job the way
+ * _mali_uk_pp_and_gp_start_job_s does it, use depends_on instead.
+ *
+ * Batches are the only way to put jobs on user timelines, and to wait for
+ * points on them. A soft job waiting for user timeline points gives a point
+ * on the soft timeline which can be used with the other timeline calls.
+ *
+ * PP jobs can also wait for a standard sync_file fd and hand out one that
+ * is signaled when the job completes, without going through the Mali sync
+ * fence layer. This needs dma-buf fence and sync_file support in the
+ * kernel; the flags are rejected otherwise, and for GP and soft jobs.
+ */
+typedef struct {
+	u32 type;                           /**< [in] _MALI_UK_BATCH_JOB_* */
+	u32 depends_on;                     /**< [in] bit n set if this job must wait for job n of the batch, n must be lower than the index of this job */
+	u32 timeline;                       /**< [in] user timeline to put a GP or PP job on, or 0 for the timeline of the job type. Must be 0 for soft jobs */
+	u32 flags;                          /**< [in] _MALI_UK_BATCH_JOB_FLAG_* */
+	u32 user_points[MALI_UK_TIMELINE_USER_MAX]; /**< [in] point on user timeline MALI_UK_TIMELINE_MAX + n this job must also wait for, or 0 */
+	s32 in_fence_fd;                    /**< [in] sync_file fd to wait for, if _MALI_UK_BATCH_JOB_FLAG_IN_FENCE */
+	s32 out_fence_fd;                   /**< [out] sync_file fd signaled when the job completes, if _MALI_UK_BATCH_JOB_FLAG_OUT_FENCE */
+	union {
+		_mali_uk_gp_start_job_s gp;
+		_mali_uk_pp_start_job_s pp;
+		_mali_uk_soft_job_start_s soft;
+	} args;                             /**< [in,out] job arguments, selected by type */
+} _mali_uk_batch_job_s;
+
+/** @brief Arguments for _mali_ukk_submit_batch()
+ *
+ * Starts num_jobs GP, PP and soft jobs in one call. Jobs are added to the
+ * timelines in array order, so a job can wait for jobs earlier in the batch
+ * through depends_on, in addition to its own fence.
+ */
+typedef struct {
+	u64 ctx;                            /**< [in,out] user-kernel context (trashed on output) */
+	u64 jobs;                           /**< [in] pointer to array of num_jobs _mali_uk_batch_job_s */
+	u32 num_jobs;                       /**< [in] number of jobs, at most _MALI_UK_SUBMIT_BATCH_MAX_JOBS */
+	u32 num_started;                    /**< [out] number of jobs, from the start of the array, which were started */
+} _mali_uk_submit_batch_s;
+
+/** @} */ /* end group _mali_uk_submit_batch */
+
 typedef struct {
 	u32 counter_id;
 	u32 key;
@@ -630,6 +703,76 @@ typedef struct {
 
 /** @} */ /* end group _mali_uk_waitfornotification_s */
 
+/** @defgroup _mali_uk_completion_ring Completion ring
+ *
+ * A per session ring of job completion records, shared with user space.
+ * The kernel is the only producer and user space the only consumer, so no
+ * system call is needed to pick up a completed job.
+ *
+ * After setup, the ring is mapped by calling mmap() on the device file with
+ * the returned mmap_offset and mmap_size. The mapping starts with a
+ * _mali_uk_completion_ring_header_s, followed by num_entries records of type
+ * _mali_uk_completion_record_s.
+ *
+ * head and tail are free running counters. The kernel writes a record at
+ * index (head % num_entries) and then increments head. User space reads the
+ * record at index (tail % num_entries) and then increments tail. The ring is
+ * empty when head equals tail.
+ *
+ * Only _MALI_NOTIFICATION_PP_FINISHED and _MALI_NOTIFICATION_GP_FINISHED are
+ * delivered through the ring. All other notifications, and job completions
+ * arriving while the ring is full, are still delivered through
+ * _mali_ukk_wait_for_notification(). The overflow counter in the header is
+ * incremented for each such job completion.
+ *
+ * User space is woken up through poll() on the device file and, if given,
+ * an eventfd.
+ * @{ */
+
+/** Offset to pass to mmap() to map the completion ring, outside the Mali virtual address range */
+#define _MALI_UK_COMPLETION_RING_MMAP_OFFSET 0x100000000ULL
+
+/** Maximum number of records in a completion ring */
+#define _MALI_UK_COMPLETION_RING_MAX_ENTRIES 1024
+
+/** @brief One completion record */
+typedef struct {
+	u32 type;                       /**< _MALI_NOTIFICATION_PP_FINISHED or _MALI_NOTIFICATION_GP_FINISHED */
+	u32 padding;
+	union {
+		_mali_uk_gp_job_finished_s gp_job_finished;
+		_mali_uk_pp_job_finished_s pp_job_finished;
+	} data;
+} _mali_uk_completion_record_s;
+
+/** @brief Shared ring header, head and tail are kept on separate cache lines */
+typedef struct {
+	u32 head;                       /**< Written by kernel, number of records produced */
+	u32 padding0[15];
+	u32 tail;                       /**< Written by user space, number of records consumed */
+	u32 padding1[15];
+	u32 num_entries;                /**< Number of records in the ring */
+	u32 overflow;                   /**< Job completions sent through the notification queue because the ring was full */
+	u32 padding2[14];
+} _mali_uk_completion_ring_header_s;
+
+/** @brief Arguments for mali_completion_ring_setup()
+ *
+ * A session can only have one completion ring.
+ */
+typedef struct {
+	u64 ctx;                        /**< [in,out] user-kernel context (trashed on output) */
+	u32 num_entries;                /**< [in] number of records, a power of two no larger than _MALI_UK_COMPLETION_RING_MAX_ENTRIES */
+	s32 eventfd;                    /**< [in] eventfd to signal on wake up, or -1 to only use poll() */
+	u32 coalesce_count;             /**< [in] wake up once this many records are pending, 0 or 1 to wake up on every record */
+	u32 coalesce_time_ms;           /**< [in] maximum time a record is left pending before waking up, when coalescing */
+	u64 mmap_offset;                /**< [out] offset to pass to mmap() */
+	u32 mmap_size;                  /**< [out] size of mapping */
+	u32 padding;
+} _mali_uk_completion_ring_setup_s;
+
+/** @} */ /* end group _mali_uk_completion_ring */
+
 /** @defgroup _mali_uk_getapiversion_s Get API Version
  * @{ */
 
@@ -754,11 +897,14 @@ typedef struct {
 #define _MALI_MEMORY_ALLOCATE_SWAPPABLE   (1<<6) /* Allocate swappale memory. */
 #define _MALI_MEMORY_ALLOCATE_DEFER_BIND (1<<7) /*Not map to GPU when allocate, must call bind later*/
 #define _MALI_MEMORY_ALLOCATE_SECURE (1<<8) /* Allocate secure memory. */
+#define _MALI_MEMORY_ALLOCATE_GROWABLE (1<<9) /* GP heap, grown up to vsize by the kernel when the PLBU runs out of heap. */
+#define _MALI_MEMORY_ALLOCATE_SPARSE (1<<10) /* Reserve vsize, pages are bound with _mali_uk_mem_sparse_bind_s. */
+#define _MALI_MEMORY_ALLOCATE_KERNEL_VA (1<<11) /* The kernel chooses gpu_vaddr, packing small allocations into shared page tables. */
 
 
 typedef struct {
 	u64 ctx;                                          /**< [in,out] user-kernel context (trashed on output) */
-	u32 gpu_vaddr;                                    /**< [in] GPU virtual address */
+	u32 gpu_vaddr;                                    /**< [in,out] GPU virtual address, [out] only with _MALI_MEMORY_ALLOCATE_KERNEL_VA */
 	u32 vsize;                                        /**< [in] vitrual size of the allocation */
 	u32 psize;                                        /**< [in] physical size of the allocation */
 	u32 flags;
@@ -853,6 +999,8 @@ typedef struct {
 
 /** Flag for _mali_uk_map_external_mem_s, _mali_uk_attach_ump_mem_s and _mali_uk_attach_dma_buf_s */
 #define _MALI_MAP_EXTERNAL_MAP_GUARD_PAGE (1<<0)
+/** Flag for _mali_uk_attach_dma_buf_s, keep the buffer mapped between jobs until it is evicted or released */
+#define _MALI_MAP_EXTERNAL_MAP_CACHED (1<<1)
 
 
 typedef struct {
@@ -861,6 +1009,46 @@ typedef struct {
 	u32 psize;                              /* wanted physical size of this memory */
 } _mali_uk_mem_resize_s;
 
+/** Flag for _mali_uk_mem_sparse_bind_s, unbind the range instead of binding it */
+#define _MALI_MEMORY_SPARSE_UNBIND (1<<0)
+
+/**
+ * @brief Arguments for _mali_ukk_mem_sparse_bind()
+ *
+ * Binds pages to, or unbinds them from, a page range of an allocation made
+ * with _MALI_MEMORY_ALLOCATE_SPARSE. Pages already bound in a range being
+ * bound are kept. Unbound pages read as zero on Mali, and fault on writes and
+ * on CPU access.
+ */
+typedef struct {
+	u64 ctx;                                /**< [in,out] user-kernel context (trashed on output) */
+	u64 vaddr;                              /**< [in] Mali address of the sparse allocation */
+	u32 offset;                             /**< [in] Start of the range, offset from the start of the allocation */
+	u32 size;                               /**< [in] Size of the range */
+	u32 flags;                              /**< [in] _MALI_MEMORY_SPARSE_UNBIND, or 0 to bind */
+	u32 padding;
+} _mali_uk_mem_sparse_bind_s;
+
+/** Advice for _mali_uk_mem_madvise_s */
+#define _MALI_MEM_MADVISE_WILLNEED 0 /* The contents are needed, pages are allocated again if purged */
+#define _MALI_MEM_MADVISE_DONTNEED 1 /* The pages may be purged under memory pressure */
+
+/**
+ * @brief Arguments for _mali_ukk_mem_madvise()
+ *
+ * Marks OS memory as purgeable, or not any more. The pages of purgeable memory
+ * may be freed while the session has no GP or PP jobs, which unmaps the memory
+ * from Mali and makes CPU access to it fail. Purgeable memory must not be used
+ * by jobs until it is marked _MALI_MEM_MADVISE_WILLNEED again. Growable,
+ * resizeable, defer-bind and no-bind memory can't be made purgeable.
+ */
+typedef struct {
+	u64 ctx;                                /**< [in,out] user-kernel context (trashed on output) */
+	u64 vaddr;                              /**< [in] Mali address of the allocation */
+	u32 advice;                             /**< [in] _MALI_MEM_MADVISE_WILLNEED or _MALI_MEM_MADVISE_DONTNEED */
+	u32 retained;                           /**< [out] 0 if the pages were purged, and the contents are lost */
+} _mali_uk_mem_madvise_s;
+
 /**
  * @brief Arguments for _mali_uk[uk]_mem_write_safe()
  */
@@ -1074,6 +1262,55 @@ typedef struct {
 	s32 sync_fd;                    /**< [out] file descriptor for new linux sync fence */
 } _mali_uk_timeline_create_sync_fence_s;
 
+/** @brief Arguments for mali_timeline_system_create_user_timeline()
+ *
+ * Creates a user timeline, an ordering domain of its own for GP and PP jobs
+ * of the session. Jobs on the GP and PP timelines wait for each other to be
+ * released in submission order, a job on a user timeline only waits for the
+ * points given in its fence, so independent pipelines of a session don't hold
+ * each other back. Up to MALI_UK_TIMELINE_USER_MAX user timelines can be
+ * created, they live as long as the session.
+ */
+typedef struct {
+	u64 ctx;                      /**< [in,out] user-kernel context (trashed on output) */
+	u32 timeline;                   /**< [out] id of the new timeline */
+	u32 padding;
+} _mali_uk_timeline_create_s;
+
+/** Offset to pass to mmap() to map the timeline seqno page, outside the Mali virtual address range */
+#define _MALI_UK_TIMELINE_SEQNO_MMAP_OFFSET 0x200000000ULL
+
+/** @brief Timeline seqno page
+ *
+ * A read-only page shared with user space, holding the oldest point not yet
+ * released on each timeline of the session, indexed by timeline id. It is
+ * updated by the kernel whenever a point is released, after the work of the
+ * point has completed.
+ *
+ * A point returned by the kernel has been released, and fences made of it
+ * signaled, when (s32)(point - point_oldest[timeline]) < 0. This lets user
+ * space check the status of a fence with plain memory reads, and only call
+ * _mali_ukk_timeline_wait() when it needs to block. Entries of user
+ * timelines not yet created are 0. Sync fences in a fence are not covered.
+ */
+typedef struct {
+	u32 point_oldest[MALI_UK_TIMELINE_MAX + MALI_UK_TIMELINE_USER_MAX];
+} _mali_uk_timeline_seqno_page_s;
+
+/** @brief Arguments for mali_timeline_seqno_setup()
+ *
+ * Creates the timeline seqno page of the session, which is then mapped by
+ * calling mmap() on the device file with the returned mmap_offset and
+ * mmap_size. The mapping must be read-only. A session can only have one
+ * seqno page.
+ */
+typedef struct {
+	u64 ctx;                      /**< [in,out] user-kernel context (trashed on output) */
+	u64 mmap_offset;                /**< [out] offset to pass to mmap() */
+	u32 mmap_size;                  /**< [out] size of mapping */
+	u32 padding;
+} _mali_uk_timeline_seqno_setup_s;
+
 /** @} */ /* end group _mali_uk_timeline */
 
 /** @} */ /* end group u_k_api */
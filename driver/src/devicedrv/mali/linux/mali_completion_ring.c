@@ -0,0 +1,271 @@
+/*
+ * Copyright (C) 2017 ARM Limited. All rights reserved.
+ * 
+ * This program is free software and is provided to you under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation, and any use by you of this program is subject to the terms of such GNU licence.
+ * 
+ * A copy of the licence is included with the program, and can also be obtained from Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <linux/eventfd.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+#include <linux/wait.h>
+
+#include "mali_completion_ring.h"
+#include "mali_kernel_common.h"
+#include "mali_session.h"
+
+struct mali_completion_ring {
+	void *base;                                     /**< vmalloc_user() memory shared with user space */
+	u32 size;                                       /**< Size of shared memory */
+	_mali_uk_completion_ring_header_s *header;
+	_mali_uk_completion_record_s *records;
+	u32 num_entries;
+	u32 head;                                       /**< Kernel copy of head, the shared copy is never read back */
+
+	spinlock_t lock;                                /**< Serializes producers */
+	wait_queue_head_t wait_queue;                   /**< poll() waiters */
+	struct eventfd_ctx *eventfd;                    /**< Optional eventfd to signal */
+
+	u32 coalesce_count;                             /**< Wake up when this many records are pending */
+	u32 coalesce_time_ms;                           /**< Wake up when a record has been pending this long */
+	u32 pending;                                    /**< Records produced since last wake up */
+	_mali_osk_timer_t *timer;                       /**< Coalescing timeout */
+};
+
+MALI_STATIC_INLINE u32 mali_completion_ring_read_tail(struct mali_completion_ring *ring)
+{
+	return *(volatile u32 *)&ring->header->tail;
+}
+
+static void mali_completion_ring_wake_up(struct mali_completion_ring *ring)
+{
+	wake_up_interruptible(&ring->wait_queue);
+
+	if (NULL != ring->eventfd) {
+		eventfd_signal(ring->eventfd, 1);
+	}
+}
+
+static void mali_completion_ring_timeout(void *data)
+{
+	struct mali_completion_ring *ring = (struct mali_completion_ring *)data;
+	unsigned long flags;
+	mali_bool wake_up;
+
+	spin_lock_irqsave(&ring->lock, flags);
+	wake_up = (0 != ring->pending) ? MALI_TRUE : MALI_FALSE;
+	ring->pending = 0;
+	spin_unlock_irqrestore(&ring->lock, flags);
+
+	if (wake_up) {
+		mali_completion_ring_wake_up(ring);
+	}
+}
+
+int mali_completion_ring_setup(struct mali_session_data *session, _mali_uk_completion_ring_setup_s __user *uargs)
+{
+	_mali_uk_completion_ring_setup_s kargs;
+	struct mali_completion_ring *ring;
+	int err;
+
+	MALI_DEBUG_ASSERT_POINTER(session);
+
+	if (0 != copy_from_user(&kargs, uargs, sizeof(kargs))) {
+		return -EFAULT;
+	}
+
+	if (0 == kargs.num_entries || _MALI_UK_COMPLETION_RING_MAX_ENTRIES < kargs.num_entries ||
+	    0 != (kargs.num_entries & (kargs.num_entries - 1))) {
+		return -EINVAL;
+	}
+
+	if (NULL != session->completion_ring) {
+		return -EBUSY;
+	}
+
+	ring = kzalloc(sizeof(*ring), GFP_KERNEL);
+	if (NULL == ring) {
+		return -ENOMEM;
+	}
+
+	ring->size = PAGE_ALIGN(sizeof(_mali_uk_completion_ring_header_s) +
+				kargs.num_entries * sizeof(_mali_uk_completion_record_s));
+	ring->base = vmalloc_user(ring->size);
+	if (NULL == ring->base) {
+		err = -ENOMEM;
+		goto err_free;
+	}
+
+	ring->header = (_mali_uk_completion_ring_header_s *)ring->base;
+	ring->records = (_mali_uk_completion_record_s *)((u8 *)ring->base + sizeof(_mali_uk_completion_ring_header_s));
+	ring->num_entries = kargs.num_entries;
+	ring->header->num_entries = kargs.num_entries;
+
+	spin_lock_init(&ring->lock);
+	init_waitqueue_head(&ring->wait_queue);
+
+	ring->coalesce_count = (0 == kargs.coalesce_count) ? 1 : kargs.coalesce_count;
+	ring->coalesce_time_ms = kargs.coalesce_time_ms;
+
+	ring->timer = _mali_osk_timer_init();
+	if (NULL == ring->timer) {
+		err = -ENOMEM;
+		goto err_free;
+	}
+	_mali_osk_timer_setcallback(ring->timer, mali_completion_ring_timeout, ring);
+
+	if (0 <= kargs.eventfd) {
+		ring->eventfd = eventfd_ctx_fdget(kargs.eventfd);
+		if (IS_ERR(ring->eventfd)) {
+			err = PTR_ERR(ring->eventfd);
+			ring->eventfd = NULL;
+			goto err_free;
+		}
+	}
+
+	kargs.mmap_offset = _MALI_UK_COMPLETION_RING_MMAP_OFFSET;
+	kargs.mmap_size = ring->size;
+	if (0 != copy_to_user(uargs, &kargs, sizeof(kargs))) {
+		err = -EFAULT;
+		goto err_free;
+	}
+
+	/* Publish ring, notifications may be posted to it from now on. */
+	if (NULL != cmpxchg(&session->completion_ring, NULL, ring)) {
+		err = -EBUSY;
+		goto err_free;
+	}
+
+	MALI_DEBUG_PRINT(3, ("Mali completion ring: %u entries for session 0x%08X\n", ring->num_entries, session));
+
+	return 0;
+
+err_free:
+	mali_completion_ring_destroy(ring);
+	return err;
+}
+
+void mali_completion_ring_destroy(struct mali_completion_ring *ring)
+{
+	MALI_DEBUG_ASSERT_POINTER(ring);
+
+	if (NULL != ring->timer) {
+		_mali_osk_timer_del(ring->timer);
+		_mali_osk_timer_term(ring->timer);
+	}
+
+	if (NULL != ring->eventfd) {
+		eventfd_ctx_put(ring->eventfd);
+	}
+
+	vfree(ring->base);
+	kfree(ring);
+}
+
+mali_bool mali_completion_ring_post(struct mali_completion_ring *ring, _mali_osk_notification_t *notification)
+{
+	_mali_uk_completion_record_s *record;
+	unsigned long flags;
+	mali_bool wake_up = MALI_FALSE;
+	u32 size;
+
+	MALI_DEBUG_ASSERT_POINTER(ring);
+	MALI_DEBUG_ASSERT_POINTER(notification);
+
+	if (_MALI_NOTIFICATION_PP_FINISHED != notification->notification_type &&
+	    _MALI_NOTIFICATION_GP_FINISHED != notification->notification_type) {
+		return MALI_FALSE;
+	}
+
+	spin_lock_irqsave(&ring->lock, flags);
+
+	/* Tail is written by user space, so only trust it to tell if there is room. */
+	if (ring->num_entries <= (u32)(ring->head - mali_completion_ring_read_tail(ring))) {
+		ring->header->overflow++;
+		spin_unlock_irqrestore(&ring->lock, flags);
+		return MALI_FALSE;
+	}
+
+	/* Make sure user space is done with the slot before it is overwritten. */
+	smp_mb();
+
+	record = &ring->records[ring->head & (ring->num_entries - 1)];
+	record->type = notification->notification_type;
+	record->padding = 0;
+	size = notification->result_buffer_size;
+	if (sizeof(record->data) < size) {
+		size = sizeof(record->data);
+	}
+	memcpy(&record->data, notification->result_buffer, size);
+
+	/* Record must be visible before the new head. */
+	smp_wmb();
+
+	ring->head++;
+	*(volatile u32 *)&ring->header->head = ring->head;
+
+	ring->pending++;
+	if (ring->coalesce_count <= ring->pending) {
+		ring->pending = 0;
+		wake_up = MALI_TRUE;
+	} else if (1 == ring->pending) {
+		_mali_osk_timer_mod(ring->timer, _mali_osk_time_mstoticks(ring->coalesce_time_ms));
+	}
+
+	spin_unlock_irqrestore(&ring->lock, flags);
+
+	if (wake_up) {
+		mali_completion_ring_wake_up(ring);
+	}
+
+	_mali_osk_notification_delete(notification);
+
+	return MALI_TRUE;
+}
+
+int mali_completion_ring_mmap(struct mali_session_data *session, struct vm_area_struct *vma)
+{
+	struct mali_completion_ring *ring;
+
+	MALI_DEBUG_ASSERT_POINTER(session);
+
+	ring = session->completion_ring;
+	if (NULL == ring) {
+		return -EINVAL;
+	}
+
+	if (vma->vm_end - vma->vm_start > ring->size) {
+		return -EINVAL;
+	}
+
+	vma->vm_flags |= VM_DONTCOPY;
+	vma->vm_flags |= VM_DONTEXPAND;
+
+	return remap_vmalloc_range(vma, ring->base, 0);
+}
+
+unsigned int mali_completion_ring_poll(struct mali_session_data *session, struct file *filp, poll_table *wait)
+{
+	struct mali_completion_ring *ring;
+
+	MALI_DEBUG_ASSERT_POINTER(session);
+
+	ring = session->completion_ring;
+	if (NULL == ring) {
+		/* Without a ring, job completions are only on the notification queue */
+		return _mali_osk_notification_queue_poll(session->ioctl_queue, filp, wait);
+	}
+
+	poll_wait(filp, &ring->wait_queue, wait);
+
+	if (ring->head != mali_completion_ring_read_tail(ring)) {
+		return POLLIN | POLLRDNORM;
+	}
+
+	return 0;
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2017 ARM Limited. All rights reserved.
+ * 
+ * This program is free software and is provided to you under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation, and any use by you of this program is subject to the terms of such GNU licence.
+ * 
+ * A copy of the licence is included with the program, and can also be obtained from Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/**
+ * @file mali_completion_ring.h
+ *
+ * Per session job completion ring, mapped into user space.
+ */
+
+#ifndef __MALI_COMPLETION_RING_H__
+#define __MALI_COMPLETION_RING_H__
+
+#include <linux/fs.h>
+#include <linux/mm.h>
+#include <linux/poll.h>
+#include "mali_osk.h"
+#include "mali_uk_types.h"
+
+struct mali_session_data;
+struct mali_completion_ring;
+
+/**
+ * Create the completion ring of a session, as requested by user space.
+ *
+ * @param session Session to create ring for.
+ * @param uargs Setup arguments in user space.
+ * @return 0 on success, negative error code on failure.
+ */
+int mali_completion_ring_setup(struct mali_session_data *session, _mali_uk_completion_ring_setup_s __user *uargs);
+
+/**
+ * Destroy a completion ring.
+ *
+ * Must only be called when no more notifications can be posted to it, and
+ * after user space has unmapped it.
+ *
+ * @param ring Ring to destroy.
+ */
+void mali_completion_ring_destroy(struct mali_completion_ring *ring);
+
+/**
+ * Try to deliver a notification through the completion ring.
+ *
+ * Only job finished notifications are accepted. If accepted, the
+ * notification is copied into the ring and deleted. Can be called from any
+ * context.
+ *
+ * @param ring Completion ring.
+ * @param notification Notification to deliver.
+ * @return MALI_TRUE if notification was consumed, MALI_FALSE if it must be sent through the notification queue.
+ */
+mali_bool mali_completion_ring_post(struct mali_completion_ring *ring, _mali_osk_notification_t *notification);
+
+/**
+ * Map the completion ring of a session into user space.
+ *
+ * @param session Session owning the ring.
+ * @param vma Virtual memory area to map ring into.
+ * @return 0 on success, negative error code on failure.
+ */
+int mali_completion_ring_mmap(struct mali_session_data *session, struct vm_area_struct *vma);
+
+/**
+ * poll() support for the device file, readable when the ring is not empty.
+ * Sessions without a ring poll their notification queue instead.
+ *
+ * @param session Session owning the ring.
+ * @param filp Device file.
+ * @param wait Poll table.
+ * @return Poll mask.
+ */
+unsigned int mali_completion_ring_poll(struct mali_session_data *session, struct file *filp, poll_table *wait);
+
+#endif /* __MALI_COMPLETION_RING_H__ */
@@ -259,6 +259,25 @@ void mali_dma_fence_signal_and_put(struct fence **fence)
 	*fence = NULL;
 }
 
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 10, 0)
+void mali_dma_fence_signal_error_and_put(struct dma_fence **fence, int error)
+#else
+void mali_dma_fence_signal_error_and_put(struct fence **fence, int error)
+#endif
+{
+	MALI_DEBUG_ASSERT_POINTER(fence);
+	MALI_DEBUG_ASSERT_POINTER(*fence);
+	MALI_DEBUG_ASSERT(0 > error);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 11, 0)
+	dma_fence_set_error(*fence, error);
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(4, 10, 0)
+	(*fence)->error = error;
+#else
+	(*fence)->status = error;
+#endif
+	mali_dma_fence_signal_and_put(fence);
+}
+
 void mali_dma_fence_context_init(struct mali_dma_fence_context *dma_fence_context,
 				 mali_dma_fence_context_callback_func_t  cb_func,
 				 void *pp_job_ptr)
@@ -338,6 +357,24 @@ ended:
 	return ret;
 }
 
+#if defined(MALI_DMA_FENCE_SYNC_FILE)
+_mali_osk_errcode_t mali_dma_fence_context_add_fence(struct mali_dma_fence_context *dma_fence_context,
+		struct dma_fence *fence)
+{
+	_mali_osk_errcode_t ret;
+
+	MALI_DEBUG_ASSERT_POINTER(dma_fence_context);
+	MALI_DEBUG_ASSERT_POINTER(fence);
+
+	ret = mali_dma_fence_add_callback(dma_fence_context, fence);
+	if (_MALI_OSK_ERR_OK != ret) {
+		MALI_DEBUG_PRINT(1, ("Mali dma fence: failed to add callback into in-fence.\n"));
+		mali_dma_fence_context_cleanup(dma_fence_context);
+	}
+
+	return ret;
+}
+#endif
 
 void mali_dma_fence_context_term(struct mali_dma_fence_context *dma_fence_context)
 {
@@ -26,6 +26,11 @@
 #include <linux/reservation.h>
 #endif
 
+/* Jobs can take in-fences from and hand out out-fences as sync_file fds */
+#if defined(CONFIG_SYNC_FILE) && LINUX_VERSION_CODE >= KERNEL_VERSION(4, 10, 0)
+#define MALI_DMA_FENCE_SYNC_FILE 1
+#endif
+
 struct mali_dma_fence_context;
 
 /* The mali dma fence context callback function */
@@ -69,6 +74,15 @@ void mali_dma_fence_signal_and_put(struct dma_fence **fence);
 #else
 void mali_dma_fence_signal_and_put(struct fence **fence);
 #endif
+/* Set an error on dma fence, then signal and put it
+ * @param fence The dma fence to signal and put
+ * @param error Negative errno waiters will see, e.g. -ECANCELED
+ */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 10, 0)
+void mali_dma_fence_signal_error_and_put(struct dma_fence **fence, int error);
+#else
+void mali_dma_fence_signal_error_and_put(struct fence **fence, int error);
+#endif
 /**
  * Initialize a mali dma fence context for pp job.
  * @param dma_fence_context The mali dma fence context to initialize.
@@ -88,6 +102,17 @@ void mali_dma_fence_context_init(struct mali_dma_fence_context *dma_fence_contex
 _mali_osk_errcode_t mali_dma_fence_context_add_waiters(struct mali_dma_fence_context *dma_fence_context,
 		struct reservation_object *dma_reservation_object);
 
+#if defined(MALI_DMA_FENCE_SYNC_FILE)
+/**
+ * Add a mali dma fence waiter for a single fence into mali dma fence context
+ * @param dma_fence_context The mali dma fence context
+ * @param fence The fence to wait for, the context takes its own reference
+ * @return _MALI_OSK_ERR_OK if success, or not.
+ */
+_mali_osk_errcode_t mali_dma_fence_context_add_fence(struct mali_dma_fence_context *dma_fence_context,
+		struct dma_fence *fence);
+#endif
+
 /**
  * Release the dma fence context
  * @param dma_fence_text The mali dma fence context.
@@ -134,6 +134,30 @@ extern unsigned int mali_mem_swap_out_threshold_value;
 module_param(mali_mem_swap_out_threshold_value, uint, S_IRUSR | S_IRGRP | S_IROTH);
 MODULE_PARM_DESC(mali_mem_swap_out_threshold_value, "Threshold value used to limit how much swappable memory cached in Mali driver.");
 
+extern unsigned int mali_mem_swap_out_background_value;
+module_param(mali_mem_swap_out_background_value, uint, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(mali_mem_swap_out_background_value, "System free memory below which swappable memory not used by recent jobs is swapped out in the background.");
+
+extern unsigned int mali_mem_cow_fault_window;
+module_param(mali_mem_cow_fault_window, uint, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(mali_mem_cow_fault_window, "Max number of still shared pages copied on one CPU fault on a copy-on-write allocation, 1 to 32 (default 16).");
+
+extern unsigned int mali_mem_heap_grow_pages;
+module_param(mali_mem_heap_grow_pages, uint, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(mali_mem_heap_grow_pages, "Pages a growable heap is backed by beyond the heap end of each GP job, given to the PLBU on out of memory, 0 leaves it to user space (default 128).");
+
+extern unsigned int mali_mem_os_alloc_max_order;
+module_param(mali_mem_os_alloc_max_order, uint, S_IRUSR | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(mali_mem_os_alloc_max_order, "Largest order of contiguous chunks OS memory is allocated in, 0 allocates single pages (default 4).");
+
+extern int mali_pp_scheduler_policy;
+module_param(mali_pp_scheduler_policy, int, S_IRUSR | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(mali_pp_scheduler_policy, "PP job scheduling policy: 0 = fifo (default), 1 = fair share between sessions.");
+
+extern int mali_dependent_start_direct;
+module_param(mali_dependent_start_direct, int, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(mali_dependent_start_direct, "Start jobs released by fence and swap-in callbacks directly when powered cores are available, 0 always defers to the schedule workqueue (default 1).");
+
 #if defined(CONFIG_MALI_DVFS)
 /** the max fps the same as display vsync default 60, can set by module insert parameter */
 extern int mali_max_system_fps;
@@ -172,6 +196,7 @@ static void mali_miscdevice_unregister(void);
 
 static int mali_open(struct inode *inode, struct file *filp);
 static int mali_release(struct inode *inode, struct file *filp);
+static unsigned int mali_poll(struct file *filp, poll_table *wait);
 #ifdef HAVE_UNLOCKED_IOCTL
 static long mali_ioctl(struct file *filp, unsigned int cmd, unsigned long arg);
 #else
@@ -270,7 +295,8 @@ struct file_operations mali_fops = {
 	.ioctl = mali_ioctl,
 #endif
 	.compat_ioctl = mali_ioctl,
-	.mmap = mali_mmap
+	.mmap = mali_mmap,
+	.poll = mali_poll
 };
 
 #if MALI_ENABLE_CPU_CYCLES
@@ -866,6 +892,17 @@ static int mali_release(struct inode *inode, struct file *filp)
 	return 0;
 }
 
+static unsigned int mali_poll(struct file *filp, poll_table *wait)
+{
+	struct mali_session_data *session_data = (struct mali_session_data *)filp->private_data;
+
+	if (NULL == session_data) {
+		return POLLERR;
+	}
+
+	return mali_completion_ring_poll(session_data, filp, wait);
+}
+
 int map_errcode(_mali_osk_errcode_t err)
 {
 	switch (err) {
@@ -952,6 +989,19 @@ static int mali_ioctl(struct inode *inode, struct file *filp, unsigned int cmd,
 		err = pending_submit_wrapper(session_data, (_mali_uk_pending_submit_s __user *)arg);
 		break;
 
+	case MALI_IOC_SUBMIT_BATCH:
+		BUILD_BUG_ON(!IS_ALIGNED(sizeof(_mali_uk_submit_batch_s), sizeof(u64)));
+		BUILD_BUG_ON(!IS_ALIGNED(sizeof(_mali_uk_batch_job_s), sizeof(u64)));
+		err = submit_batch_wrapper(session_data, (_mali_uk_submit_batch_s __user *)arg);
+		break;
+
+	case MALI_IOC_COMPLETION_RING_SETUP:
+		BUILD_BUG_ON(!IS_ALIGNED(sizeof(_mali_uk_completion_ring_setup_s), sizeof(u64)));
+		BUILD_BUG_ON(!IS_ALIGNED(sizeof(_mali_uk_completion_ring_header_s), sizeof(u64)));
+		BUILD_BUG_ON(!IS_ALIGNED(sizeof(_mali_uk_completion_record_s), sizeof(u64)));
+		err = mali_completion_ring_setup(session_data, (_mali_uk_completion_ring_setup_s __user *)arg);
+		break;
+
 #if defined(CONFIG_MALI400_PROFILING)
 	case MALI_IOC_PROFILING_ADD_EVENT:
 		BUILD_BUG_ON(!IS_ALIGNED(sizeof(_mali_uk_profiling_add_event_s), sizeof(u64)));
@@ -1021,6 +1071,16 @@ static int mali_ioctl(struct inode *inode, struct file *filp, unsigned int cmd,
 		err = mem_resize_mem_wrapper(session_data, (_mali_uk_mem_resize_s __user *)arg);
 		break;
 
+	case MALI_IOC_MEM_SPARSE_BIND:
+		BUILD_BUG_ON(!IS_ALIGNED(sizeof(_mali_uk_mem_sparse_bind_s), sizeof(u64)));
+		err = mem_sparse_bind_wrapper(session_data, (_mali_uk_mem_sparse_bind_s __user *)arg);
+		break;
+
+	case MALI_IOC_MEM_MADVISE:
+		BUILD_BUG_ON(!IS_ALIGNED(sizeof(_mali_uk_mem_madvise_s), sizeof(u64)));
+		err = mem_madvise_wrapper(session_data, (_mali_uk_mem_madvise_s __user *)arg);
+		break;
+
 	case MALI_IOC_MEM_WRITE_SAFE:
 		BUILD_BUG_ON(!IS_ALIGNED(sizeof(_mali_uk_mem_write_safe_s), sizeof(u64)));
 		err = mem_write_safe_wrapper(session_data, (_mali_uk_mem_write_safe_s __user *)arg);
@@ -1108,6 +1168,14 @@ static int mali_ioctl(struct inode *inode, struct file *filp, unsigned int cmd,
 		BUILD_BUG_ON(!IS_ALIGNED(sizeof(_mali_uk_timeline_create_sync_fence_s), sizeof(u64)));
 		err = timeline_create_sync_fence_wrapper(session_data, (_mali_uk_timeline_create_sync_fence_s __user *)arg);
 		break;
+	case MALI_IOC_TIMELINE_CREATE:
+		BUILD_BUG_ON(!IS_ALIGNED(sizeof(_mali_uk_timeline_create_s), sizeof(u64)));
+		err = timeline_create_wrapper(session_data, (_mali_uk_timeline_create_s __user *)arg);
+		break;
+	case MALI_IOC_TIMELINE_SEQNO_SETUP:
+		BUILD_BUG_ON(!IS_ALIGNED(sizeof(_mali_uk_timeline_seqno_setup_s), sizeof(u64)));
+		err = mali_timeline_seqno_setup(session_data, (_mali_uk_timeline_seqno_setup_s __user *)arg);
+		break;
 	case MALI_IOC_SOFT_JOB_START:
 		BUILD_BUG_ON(!IS_ALIGNED(sizeof(_mali_uk_soft_job_start_s), sizeof(u64)));
 		err = soft_job_start_wrapper(session_data, (_mali_uk_soft_job_start_s __user *)arg);
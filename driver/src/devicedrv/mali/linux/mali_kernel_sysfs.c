@@ -26,6 +26,8 @@
 
 #include <linux/seq_file.h>
 #include <linux/debugfs.h>
+#include <linux/math64.h>
+#include <linux/mutex.h>
 #include <linux/version.h>
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(4,12,0)
 #include <linux/uaccess.h>
@@ -54,6 +56,15 @@
 #include "mali_gp_job.h"
 #include "mali_pp_job.h"
 #include "mali_executor.h"
+#include "mali_scheduler.h"
+#include "mali_scheduler_policy.h"
+#include "mali_memory_os_alloc.h"
+#include "mali_memory_manager.h"
+#include "mali_memory_swap_alloc.h"
+#include "mali_memory_purgeable.h"
+#if defined(CONFIG_DMA_SHARED_BUFFER) && !defined(CONFIG_MALI_DMA_BUF_MAP_ON_ATTACH)
+#include "mali_memory_dma_buf.h"
+#endif
 
 #define PRIVATE_DATA_COUNTER_MAKE_GP(src) (src)
 #define PRIVATE_DATA_COUNTER_MAKE_PP(src) ((1 << 24) | src)
@@ -886,17 +897,19 @@ static const struct file_operations profiling_events_human_readable_fops = {
 static int memory_debugfs_show(struct seq_file *s, void *private_data)
 {
 #ifdef MALI_MEM_SWAP_TRACKING
-	seq_printf(s, "  %-25s  %-10s  %-10s  %-15s  %-15s  %-10s  %-10s %-10s \n"\
-		   "=================================================================================================================================\n",
+	seq_printf(s, "  %-25s  %-10s  %-10s  %-15s  %-15s  %-10s  %-10s %-10s  %-6s  %-10s\n"\
+		   "==============================================================================================================================================\n",
 		   "Name (:bytes)", "pid", "mali_mem", "max_mali_mem",
-		   "external_mem", "ump_mem", "dma_mem", "swap_mem");
+		   "external_mem", "ump_mem", "dma_mem", "swap_mem", "pt", "pt_allocs");
 #else
-	seq_printf(s, "  %-25s  %-10s  %-10s  %-15s  %-15s  %-10s  %-10s \n"\
-		   "========================================================================================================================\n",
+	seq_printf(s, "  %-25s  %-10s  %-10s  %-15s  %-15s  %-10s  %-10s  %-6s  %-10s\n"\
+		   "=====================================================================================================================================\n",
 		   "Name (:bytes)", "pid", "mali_mem", "max_mali_mem",
-		   "external_mem", "ump_mem", "dma_mem");
+		   "external_mem", "ump_mem", "dma_mem", "pt", "pt_allocs");
 #endif
 	mali_session_memory_tracking(s);
+	mali_mem_os_pool_print_stats(s);
+	mali_mem_purgeable_print_stats(s);
 	return 0;
 }
 
@@ -1130,6 +1143,525 @@ static const struct file_operations pp_core_scaling_enabled_fops = {
 	.llseek = default_llseek,
 };
 
+static int pp_scheduler_debugfs_show(struct seq_file *s, void *private_data)
+{
+	mali_scheduler_pp_policy_print_stats(s);
+	return 0;
+}
+
+static int pp_scheduler_debugfs_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, pp_scheduler_debugfs_show, inode->i_private);
+}
+
+/*
+ * Write "<pid> <weight>" to set the fair-share weight of all sessions of a
+ * process, or "reset" to clear the statistics of all sessions.
+ */
+static ssize_t pp_scheduler_debugfs_write(struct file *filp, const char __user *ubuf, size_t cnt, loff_t *ppos)
+{
+	char buf[32];
+	unsigned int pid;
+	unsigned int weight;
+	_mali_osk_errcode_t err;
+
+	cnt = min(cnt, sizeof(buf) - 1);
+	if (copy_from_user(buf, ubuf, cnt)) {
+		return -EFAULT;
+	}
+	buf[cnt] = '\0';
+
+	if (0 == strncmp(buf, "reset", 5)) {
+		mali_scheduler_pp_policy_reset_stats();
+		*ppos += cnt;
+		return cnt;
+	}
+
+	if (2 != sscanf(buf, "%u %u", &pid, &weight)) {
+		return -EINVAL;
+	}
+
+	err = mali_scheduler_pp_policy_set_weight(pid, weight);
+	if (_MALI_OSK_ERR_OK != err) {
+		return (_MALI_OSK_ERR_ITEM_NOT_FOUND == err) ? -ESRCH : -EINVAL;
+	}
+
+	*ppos += cnt;
+	return cnt;
+}
+
+static const struct file_operations pp_scheduler_fops = {
+	.owner = THIS_MODULE,
+	.open = pp_scheduler_debugfs_open,
+	.read  = seq_read,
+	.write = pp_scheduler_debugfs_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int lock_stats_debugfs_show(struct seq_file *s, void *private_data)
+{
+	mali_scheduler_lock_stats_print(s);
+	return 0;
+}
+
+static int lock_stats_debugfs_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, lock_stats_debugfs_show, inode->i_private);
+}
+
+/* Any write clears the lock statistics */
+static ssize_t lock_stats_debugfs_write(struct file *filp, const char __user *ubuf, size_t cnt, loff_t *ppos)
+{
+	mali_scheduler_lock_stats_reset();
+
+	*ppos += cnt;
+	return cnt;
+}
+
+static const struct file_operations lock_stats_fops = {
+	.owner = THIS_MODULE,
+	.open = lock_stats_debugfs_open,
+	.read  = seq_read,
+	.write = lock_stats_debugfs_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int gp_pp_latency_debugfs_show(struct seq_file *s, void *private_data)
+{
+	mali_scheduler_gp_pp_latency_print(s);
+	return 0;
+}
+
+static int gp_pp_latency_debugfs_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, gp_pp_latency_debugfs_show, inode->i_private);
+}
+
+/* Any write clears the latency statistics */
+static ssize_t gp_pp_latency_debugfs_write(struct file *filp, const char __user *ubuf, size_t cnt, loff_t *ppos)
+{
+	mali_scheduler_gp_pp_latency_reset();
+
+	*ppos += cnt;
+	return cnt;
+}
+
+static const struct file_operations gp_pp_latency_fops = {
+	.owner = THIS_MODULE,
+	.open = gp_pp_latency_debugfs_open,
+	.read  = seq_read,
+	.write = gp_pp_latency_debugfs_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int tlb_invalidate_stats_debugfs_show(struct seq_file *s, void *private_data)
+{
+	mali_mmu_invalidate_stats_print(s);
+	return 0;
+}
+
+static int tlb_invalidate_stats_debugfs_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, tlb_invalidate_stats_debugfs_show, inode->i_private);
+}
+
+/* Any write clears the invalidation counters */
+static ssize_t tlb_invalidate_stats_debugfs_write(struct file *filp, const char __user *ubuf, size_t cnt, loff_t *ppos)
+{
+	mali_mmu_invalidate_stats_reset();
+
+	*ppos += cnt;
+	return cnt;
+}
+
+static const struct file_operations tlb_invalidate_stats_fops = {
+	.owner = THIS_MODULE,
+	.open = tlb_invalidate_stats_debugfs_open,
+	.read  = seq_read,
+	.write = tlb_invalidate_stats_debugfs_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int swap_in_latency_debugfs_show(struct seq_file *s, void *private_data)
+{
+	mali_mem_swap_in_print_stats(s);
+	return 0;
+}
+
+static int swap_in_latency_debugfs_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, swap_in_latency_debugfs_show, inode->i_private);
+}
+
+/* Any write clears the histogram */
+static ssize_t swap_in_latency_debugfs_write(struct file *filp, const char __user *ubuf, size_t cnt, loff_t *ppos)
+{
+	mali_mem_swap_in_reset_stats();
+
+	*ppos += cnt;
+	return cnt;
+}
+
+static const struct file_operations swap_in_latency_fops = {
+	.owner = THIS_MODULE,
+	.open = swap_in_latency_debugfs_open,
+	.read  = seq_read,
+	.write = swap_in_latency_debugfs_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+#if defined(CONFIG_DMA_SHARED_BUFFER) && !defined(CONFIG_MALI_DMA_BUF_MAP_ON_ATTACH)
+static int dma_buf_cache_debugfs_show(struct seq_file *s, void *private_data)
+{
+	mali_dma_buf_cache_print_stats(s);
+	return 0;
+}
+
+static int dma_buf_cache_debugfs_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, dma_buf_cache_debugfs_show, inode->i_private);
+}
+
+/* Any write clears the hit, miss and eviction counters */
+static ssize_t dma_buf_cache_debugfs_write(struct file *filp, const char __user *ubuf, size_t cnt, loff_t *ppos)
+{
+	mali_dma_buf_cache_reset_stats();
+
+	*ppos += cnt;
+	return cnt;
+}
+
+static const struct file_operations dma_buf_cache_fops = {
+	.owner = THIS_MODULE,
+	.open = dma_buf_cache_debugfs_open,
+	.read  = seq_read,
+	.write = dma_buf_cache_debugfs_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+#endif
+
+static int object_pools_debugfs_show(struct seq_file *s, void *private_data)
+{
+	_mali_osk_object_pool_print_stats(s);
+	return 0;
+}
+
+static int object_pools_debugfs_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, object_pools_debugfs_show, inode->i_private);
+}
+
+/* Any write clears the hit/miss counters */
+static ssize_t object_pools_debugfs_write(struct file *filp, const char __user *ubuf, size_t cnt, loff_t *ppos)
+{
+	_mali_osk_object_pool_reset_stats();
+
+	*ppos += cnt;
+	return cnt;
+}
+
+static const struct file_operations object_pools_fops = {
+	.owner = THIS_MODULE,
+	.open = object_pools_debugfs_open,
+	.read  = seq_read,
+	.write = object_pools_debugfs_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+/* Largest OS memory benchmark run, in MB */
+#define MALI_OS_ALLOC_BENCHMARK_MAX_MB 512
+
+static struct {
+	u32 size_mb;
+	u32 order;                      /**< Max order used for the chunked run */
+	int err;
+	u64 alloc_ns[2];                /**< Single page run, chunked run */
+	u64 free_ns[2];
+} os_alloc_benchmark;
+static DEFINE_MUTEX(os_alloc_benchmark_lock);
+
+static u64 os_alloc_benchmark_mbps(u32 size_mb, u64 ns)
+{
+	if (0 == ns) return 0;
+	return div64_u64((u64)size_mb * NSEC_PER_SEC, ns);
+}
+
+static int os_alloc_benchmark_debugfs_show(struct seq_file *s, void *private_data)
+{
+	mutex_lock(&os_alloc_benchmark_lock);
+
+	if (0 == os_alloc_benchmark.size_mb) {
+		seq_printf(s, "No benchmark run, write a size in MB (max %u) to run one\n", MALI_OS_ALLOC_BENCHMARK_MAX_MB);
+	} else if (0 != os_alloc_benchmark.err) {
+		seq_printf(s, "Benchmark of %u MB failed: %d\n", os_alloc_benchmark.size_mb, os_alloc_benchmark.err);
+	} else {
+		seq_printf(s, "%-8s %8s %12s %12s\n", "order", "size_mb", "alloc_mb/s", "free_mb/s");
+		seq_printf(s, "%-8u %8u %12llu %12llu\n", 0, os_alloc_benchmark.size_mb,
+			   os_alloc_benchmark_mbps(os_alloc_benchmark.size_mb, os_alloc_benchmark.alloc_ns[0]),
+			   os_alloc_benchmark_mbps(os_alloc_benchmark.size_mb, os_alloc_benchmark.free_ns[0]));
+		seq_printf(s, "%-8u %8u %12llu %12llu\n", os_alloc_benchmark.order, os_alloc_benchmark.size_mb,
+			   os_alloc_benchmark_mbps(os_alloc_benchmark.size_mb, os_alloc_benchmark.alloc_ns[1]),
+			   os_alloc_benchmark_mbps(os_alloc_benchmark.size_mb, os_alloc_benchmark.free_ns[1]));
+	}
+
+	mutex_unlock(&os_alloc_benchmark_lock);
+
+	return 0;
+}
+
+static int os_alloc_benchmark_debugfs_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, os_alloc_benchmark_debugfs_show, inode->i_private);
+}
+
+/* Writing a size in MB allocates and frees that much memory, one page at a time and in chunks */
+static ssize_t os_alloc_benchmark_debugfs_write(struct file *filp, const char __user *ubuf, size_t cnt, loff_t *ppos)
+{
+	unsigned long val;
+	u32 page_count;
+	int ret;
+	char buf[32];
+
+	cnt = min(cnt, sizeof(buf) - 1);
+	if (copy_from_user(buf, ubuf, cnt)) {
+		return -EFAULT;
+	}
+	buf[cnt] = '\0';
+
+	ret = kstrtoul(buf, 10, &val);
+	if (0 != ret) {
+		return ret;
+	}
+
+	if (0 == val || MALI_OS_ALLOC_BENCHMARK_MAX_MB < val) {
+		return -EINVAL;
+	}
+
+	page_count = (u32)val * (1024 * 1024 / _MALI_OSK_MALI_PAGE_SIZE);
+
+	mutex_lock(&os_alloc_benchmark_lock);
+
+	os_alloc_benchmark.size_mb = (u32)val;
+	os_alloc_benchmark.order = mali_mem_os_alloc_max_order;
+	os_alloc_benchmark.err = mali_mem_os_alloc_benchmark(page_count, 0,
+				 &os_alloc_benchmark.alloc_ns[0], &os_alloc_benchmark.free_ns[0]);
+	if (0 == os_alloc_benchmark.err) {
+		os_alloc_benchmark.err = mali_mem_os_alloc_benchmark(page_count, os_alloc_benchmark.order,
+					 &os_alloc_benchmark.alloc_ns[1], &os_alloc_benchmark.free_ns[1]);
+	}
+	ret = os_alloc_benchmark.err;
+
+	mutex_unlock(&os_alloc_benchmark_lock);
+
+	if (0 != ret) {
+		return ret;
+	}
+
+	*ppos += cnt;
+	return cnt;
+}
+
+static const struct file_operations os_alloc_benchmark_fops = {
+	.owner = THIS_MODULE,
+	.open = os_alloc_benchmark_debugfs_open,
+	.read  = seq_read,
+	.write = os_alloc_benchmark_debugfs_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+/* Largest thread count of a backend lookup benchmark run, and lookups done by each thread */
+#define MALI_BACKEND_LOOKUP_BENCHMARK_MAX_THREADS 16
+#define MALI_BACKEND_LOOKUP_BENCHMARK_LOOKUPS (1 << 20)
+
+static struct {
+	u32 threads;
+	int err;
+	u64 rcu_ns;
+	u64 mutex_ns;
+} backend_lookup_benchmark;
+static DEFINE_MUTEX(backend_lookup_benchmark_lock);
+
+static u64 backend_lookup_benchmark_per_sec(u32 threads, u64 ns)
+{
+	if (0 == ns) return 0;
+	return div64_u64((u64)threads * MALI_BACKEND_LOOKUP_BENCHMARK_LOOKUPS * NSEC_PER_SEC, ns);
+}
+
+static int backend_lookup_benchmark_debugfs_show(struct seq_file *s, void *private_data)
+{
+	mutex_lock(&backend_lookup_benchmark_lock);
+
+	if (0 == backend_lookup_benchmark.threads) {
+		seq_printf(s, "No benchmark run, write a thread count (max %u) to run one\n", MALI_BACKEND_LOOKUP_BENCHMARK_MAX_THREADS);
+	} else if (0 != backend_lookup_benchmark.err) {
+		seq_printf(s, "Benchmark with %u threads failed: %d\n", backend_lookup_benchmark.threads, backend_lookup_benchmark.err);
+	} else {
+		seq_printf(s, "%-8s %12s %16s %16s\n", "threads", "lookups", "rcu_lookups/s", "mutex_lookups/s");
+		seq_printf(s, "%-8u %12u %16llu %16llu\n", backend_lookup_benchmark.threads,
+			   backend_lookup_benchmark.threads * MALI_BACKEND_LOOKUP_BENCHMARK_LOOKUPS,
+			   backend_lookup_benchmark_per_sec(backend_lookup_benchmark.threads, backend_lookup_benchmark.rcu_ns),
+			   backend_lookup_benchmark_per_sec(backend_lookup_benchmark.threads, backend_lookup_benchmark.mutex_ns));
+	}
+
+	mutex_unlock(&backend_lookup_benchmark_lock);
+
+	return 0;
+}
+
+static int backend_lookup_benchmark_debugfs_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, backend_lookup_benchmark_debugfs_show, inode->i_private);
+}
+
+/* Writing a thread count runs that many threads looking up memory backends, lock free and under mali_idr_mutex */
+static ssize_t backend_lookup_benchmark_debugfs_write(struct file *filp, const char __user *ubuf, size_t cnt, loff_t *ppos)
+{
+	unsigned long val;
+	int ret;
+	char buf[32];
+
+	cnt = min(cnt, sizeof(buf) - 1);
+	if (copy_from_user(buf, ubuf, cnt)) {
+		return -EFAULT;
+	}
+	buf[cnt] = '\0';
+
+	ret = kstrtoul(buf, 10, &val);
+	if (0 != ret) {
+		return ret;
+	}
+
+	if (0 == val || MALI_BACKEND_LOOKUP_BENCHMARK_MAX_THREADS < val) {
+		return -EINVAL;
+	}
+
+	mutex_lock(&backend_lookup_benchmark_lock);
+
+	backend_lookup_benchmark.threads = (u32)val;
+	backend_lookup_benchmark.err = mali_mem_backend_lookup_benchmark(backend_lookup_benchmark.threads,
+				       MALI_BACKEND_LOOKUP_BENCHMARK_LOOKUPS,
+				       &backend_lookup_benchmark.rcu_ns, &backend_lookup_benchmark.mutex_ns);
+	ret = backend_lookup_benchmark.err;
+
+	mutex_unlock(&backend_lookup_benchmark_lock);
+
+	if (0 != ret) {
+		return ret;
+	}
+
+	*ppos += cnt;
+	return cnt;
+}
+
+static const struct file_operations backend_lookup_benchmark_fops = {
+	.owner = THIS_MODULE,
+	.open = backend_lookup_benchmark_debugfs_open,
+	.read  = seq_read,
+	.write = backend_lookup_benchmark_debugfs_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static struct {
+	u32 waiters;
+	int err;
+	u64 insert_ns;
+	u64 release_ns;
+} timeline_waiter_benchmark;
+static DEFINE_MUTEX(timeline_waiter_benchmark_lock);
+
+static u64 timeline_waiter_benchmark_per_sec(u32 waiters, u64 ns)
+{
+	if (0 == ns) return 0;
+	return div64_u64((u64)waiters * NSEC_PER_SEC, ns);
+}
+
+static int timeline_waiter_benchmark_debugfs_show(struct seq_file *s, void *private_data)
+{
+	mutex_lock(&timeline_waiter_benchmark_lock);
+
+	if (0 == timeline_waiter_benchmark.waiters) {
+		seq_printf(s, "No benchmark run, write a waiter count (max %u) to run one\n", MALI_TIMELINE_WAITER_BENCHMARK_MAX);
+	} else if (0 != timeline_waiter_benchmark.err) {
+		seq_printf(s, "Benchmark of %u waiters failed: %d\n", timeline_waiter_benchmark.waiters, timeline_waiter_benchmark.err);
+	} else {
+		seq_printf(s, "%-8s %12s %12s %12s %12s\n", "waiters", "insert_ns", "release_ns", "inserts/s", "releases/s");
+		seq_printf(s, "%-8u %12llu %12llu %12llu %12llu\n", timeline_waiter_benchmark.waiters,
+			   timeline_waiter_benchmark.insert_ns, timeline_waiter_benchmark.release_ns,
+			   timeline_waiter_benchmark_per_sec(timeline_waiter_benchmark.waiters, timeline_waiter_benchmark.insert_ns),
+			   timeline_waiter_benchmark_per_sec(timeline_waiter_benchmark.waiters, timeline_waiter_benchmark.release_ns));
+	}
+
+	mutex_unlock(&timeline_waiter_benchmark_lock);
+
+	return 0;
+}
+
+static int timeline_waiter_benchmark_debugfs_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, timeline_waiter_benchmark_debugfs_show, inode->i_private);
+}
+
+/* Writing a waiter count inserts that many timeline waiters, one per point, and releases them point by point */
+static ssize_t timeline_waiter_benchmark_debugfs_write(struct file *filp, const char __user *ubuf, size_t cnt, loff_t *ppos)
+{
+	unsigned long val;
+	int ret;
+	char buf[32];
+
+	cnt = min(cnt, sizeof(buf) - 1);
+	if (copy_from_user(buf, ubuf, cnt)) {
+		return -EFAULT;
+	}
+	buf[cnt] = '\0';
+
+	ret = kstrtoul(buf, 10, &val);
+	if (0 != ret) {
+		return ret;
+	}
+
+	if (0 == val || MALI_TIMELINE_WAITER_BENCHMARK_MAX < val) {
+		return -EINVAL;
+	}
+
+	mutex_lock(&timeline_waiter_benchmark_lock);
+
+	timeline_waiter_benchmark.waiters = (u32)val;
+	if (_MALI_OSK_ERR_OK != mali_timeline_waiter_benchmark(timeline_waiter_benchmark.waiters,
+			&timeline_waiter_benchmark.insert_ns, &timeline_waiter_benchmark.release_ns)) {
+		timeline_waiter_benchmark.err = -ENOMEM;
+	} else {
+		timeline_waiter_benchmark.err = 0;
+	}
+	ret = timeline_waiter_benchmark.err;
+
+	mutex_unlock(&timeline_waiter_benchmark_lock);
+
+	if (0 != ret) {
+		return ret;
+	}
+
+	*ppos += cnt;
+	return cnt;
+}
+
+static const struct file_operations timeline_waiter_benchmark_fops = {
+	.owner = THIS_MODULE,
+	.open = timeline_waiter_benchmark_debugfs_open,
+	.read  = seq_read,
+	.write = timeline_waiter_benchmark_debugfs_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static ssize_t version_read(struct file *filp, char __user *buf, size_t count, loff_t *offp)
 {
 	int r = 0;
@@ -1251,6 +1783,7 @@ int mali_sysfs_register(const char *mali_dev_name)
 				debugfs_create_file("num_cores_total", 0400, mali_pp_dir, NULL, &pp_num_cores_total_fops);
 				debugfs_create_file("num_cores_enabled", 0600, mali_pp_dir, NULL, &pp_num_cores_enabled_fops);
 				debugfs_create_file("core_scaling_enabled", 0600, mali_pp_dir, NULL, &pp_core_scaling_enabled_fops);
+				debugfs_create_file("scheduler", 0600, mali_pp_dir, NULL, &pp_scheduler_fops);
 
 				num_groups = mali_group_get_glob_num_groups();
 				for (i = 0; i < num_groups; i++) {
@@ -1372,6 +1905,18 @@ int mali_sysfs_register(const char *mali_dev_name)
 #endif
 			}
 
+			debugfs_create_file("lock_stats", 0600, mali_debugfs_dir, NULL, &lock_stats_fops);
+			debugfs_create_file("gp_pp_latency", 0600, mali_debugfs_dir, NULL, &gp_pp_latency_fops);
+			debugfs_create_file("object_pools", 0600, mali_debugfs_dir, NULL, &object_pools_fops);
+			debugfs_create_file("tlb_invalidate_stats", 0600, mali_debugfs_dir, NULL, &tlb_invalidate_stats_fops);
+			debugfs_create_file("swap_in_latency", 0600, mali_debugfs_dir, NULL, &swap_in_latency_fops);
+#if defined(CONFIG_DMA_SHARED_BUFFER) && !defined(CONFIG_MALI_DMA_BUF_MAP_ON_ATTACH)
+			debugfs_create_file("dma_buf_cache", 0600, mali_debugfs_dir, NULL, &dma_buf_cache_fops);
+#endif
+			debugfs_create_file("os_alloc_benchmark", 0600, mali_debugfs_dir, NULL, &os_alloc_benchmark_fops);
+			debugfs_create_file("backend_lookup_benchmark", 0600, mali_debugfs_dir, NULL, &backend_lookup_benchmark_fops);
+			debugfs_create_file("timeline_waiter_benchmark", 0600, mali_debugfs_dir, NULL, &timeline_waiter_benchmark_fops);
+
 #if MALI_STATE_TRACKING
 			debugfs_create_file("state_dump", 0400, mali_debugfs_dir, NULL, &mali_seq_internal_state_fops);
 #endif
@@ -20,6 +20,7 @@
 
 #include "mali_osk.h"
 #include "mali_executor.h"
+#include "mali_mmu.h"
 
 #include "mali_memory.h"
 #include "mali_memory_os_alloc.h"
@@ -30,8 +31,11 @@
 #include "mali_memory_cow.h"
 #include "mali_memory_swap_alloc.h"
 #include "mali_memory_defer_bind.h"
+#include "mali_memory_sparse.h"
+#include "mali_memory_purgeable.h"
 #if defined(CONFIG_DMA_SHARED_BUFFER)
 #include "mali_memory_secure.h"
+#include "mali_memory_dma_buf.h"
 #endif
 
 extern unsigned int mali_dedicated_mem_size;
@@ -42,8 +46,14 @@ extern unsigned int mali_shared_mem_size;
 static void mali_mem_vma_open(struct vm_area_struct *vma)
 {
 	mali_mem_allocation *alloc = (mali_mem_allocation *)vma->vm_private_data;
+	struct mali_session_data *session = (struct mali_session_data *)vma->vm_file->private_data;
 	MALI_DEBUG_PRINT(4, ("Open called on vma %p\n", vma));
 
+	/* The vma was split or copied by mremap(), it maps the allocation too */
+	mali_session_memory_lock(session);
+	alloc->cpu_mapping.count++;
+	mali_session_memory_unlock(session);
+
 	/* If need to share the allocation, add ref_count here */
 	mali_allocation_ref(alloc);
 	return;
@@ -64,6 +74,10 @@ static void mali_mem_vma_close(struct vm_area_struct *vma)
 
 		mali_session_memory_lock(session);
 		vma->vm_private_data = NULL;
+		alloc->cpu_mapping.count--;
+		if (alloc->cpu_mapping.vma == vma) {
+			alloc->cpu_mapping.vma = NULL;
+		}
 		mali_session_memory_unlock(session);
 
 		mali_allocation_unref(&alloc);
@@ -111,31 +125,45 @@ static int mali_mem_vma_fault(struct vm_area_struct *vma, struct vm_fault *vmf)
 
 
 	/* Get backend memory & Map on CPU */
-	mutex_lock(&mali_idr_mutex);
-	if (!(mem_bkend = idr_find(&mali_backend_idr, alloc->backend_handle))) {
+	if (!(mem_bkend = mali_mem_backend_get(alloc->backend_handle))) {
 		MALI_DEBUG_PRINT(1, ("Can't find memory backend in mmap!\n"));
-		mutex_unlock(&mali_idr_mutex);
 		mali_allocation_unref(&alloc);
 		return VM_FAULT_SIGBUS;
 	}
-	mutex_unlock(&mali_idr_mutex);
 	MALI_DEBUG_ASSERT(mem_bkend->type == alloc->type);
 
 	if ((mem_bkend->type == MALI_MEM_COW && (MALI_MEM_BACKEND_FLAG_SWAP_COWED !=
 			(mem_bkend->flags & MALI_MEM_BACKEND_FLAG_SWAP_COWED))) &&
 	    (mem_bkend->flags & MALI_MEM_BACKEND_FLAG_COW_CPU_NO_WRITE)) {
+		u32 cow_num;
+
 		/*check if use page fault to do COW*/
 		MALI_DEBUG_PRINT(4, ("mali_vma_fault: do cow allocate on demand!, address=0x%x\n", address));
+		/* Copy the pages after the faulting one too, as far as the vma goes */
+		cow_num = min_t(u32, clamp_t(u32, mali_mem_cow_fault_window, 1, MALI_MEM_COW_FAULT_WINDOW_MAX),
+				(vma->vm_end - address) / PAGE_SIZE);
+
+		/*
+		 * Pages after the faulting one may be mapped by another vma, which
+		 * would keep the replaced page. Only copy the faulting page then.
+		 */
+		mali_session_memory_lock(session);
+		if (vma != alloc->cpu_mapping.vma || 1 != alloc->cpu_mapping.count) {
+			cow_num = 1;
+		}
+		mali_session_memory_unlock(session);
+
 		mutex_lock(&mem_bkend->mutex);
 		ret = mali_mem_cow_allocate_on_demand(mem_bkend,
-						      (address - vma->vm_start) / PAGE_SIZE);
+						      (address - vma->vm_start) / PAGE_SIZE, &cow_num);
 		mutex_unlock(&mem_bkend->mutex);
 
 		if (ret != _MALI_OSK_ERR_OK) {
+			mali_mem_backend_put(mem_bkend);
 			mali_allocation_unref(&alloc);
 			return VM_FAULT_OOM;
 		}
-		prefetch_num = 1;
+		prefetch_num = cow_num;
 
 		/* handle COW modified range cpu mapping
 		 we zap the mapping in cow_modify_range, it will trigger page fault
@@ -145,6 +173,7 @@ static int mali_mem_vma_fault(struct vm_area_struct *vma, struct vm_fault *vmf)
 		mutex_unlock(&mem_bkend->mutex);
 
 		if (unlikely(ret != _MALI_OSK_ERR_OK)) {
+			mali_mem_backend_put(mem_bkend);
 			mali_allocation_unref(&alloc);
 			return VM_FAULT_SIGBUS;
 		}
@@ -163,19 +192,38 @@ static int mali_mem_vma_fault(struct vm_area_struct *vma, struct vm_fault *vmf)
 
 		if (ret != _MALI_OSK_ERR_OK) {
 			MALI_DEBUG_PRINT(2, ("Mali swap memory page fault process failed, address=0x%x\n", address));
+			mali_mem_backend_put(mem_bkend);
 			mali_allocation_unref(&alloc);
 			return VM_FAULT_OOM;
 		} else {
+			mali_mem_backend_put(mem_bkend);
 			mali_allocation_unref(&alloc);
 			return VM_FAULT_LOCKED;
 		}
+	} else if (mem_bkend->type == MALI_MEM_SPARSE) {
+		ret = mali_mem_sparse_cpu_fault(mem_bkend, vma, address);
+
+		/* -EBUSY if another thread mapped the page first */
+		if (unlikely(0 != ret && -EBUSY != ret)) {
+			MALI_DEBUG_PRINT(2, ("Mali sparse memory fault on unbound page, address=0x%x\n", address));
+			mali_mem_backend_put(mem_bkend);
+			mali_allocation_unref(&alloc);
+			return VM_FAULT_SIGBUS;
+		}
+	} else if (mem_bkend->type == MALI_MEM_OS && (mem_bkend->flags & MALI_MEM_BACKEND_FLAG_PURGED)) {
+		MALI_DEBUG_PRINT(2, ("Mali purged memory CPU access, address=0x%x\n", address));
+		mali_mem_backend_put(mem_bkend);
+		mali_allocation_unref(&alloc);
+		return VM_FAULT_SIGBUS;
 	} else {
 		MALI_PRINT_ERROR(("Mali vma fault! It never happen, indicating some logic errors in caller.\n"));
+		mali_mem_backend_put(mem_bkend);
 		mali_allocation_unref(&alloc);
 		/*NOT support yet or OOM*/
 		return VM_FAULT_OOM;
 	}
 
+	mali_mem_backend_put(mem_bkend);
 	mali_allocation_unref(&alloc);
 	return VM_FAULT_NOPAGE;
 }
@@ -213,6 +261,14 @@ int mali_mmap(struct file *filp, struct vm_area_struct *vma)
 		return -EFAULT;
 	}
 
+	if ((_MALI_UK_COMPLETION_RING_MMAP_OFFSET >> PAGE_SHIFT) == vma->vm_pgoff) {
+		return mali_completion_ring_mmap(session, vma);
+	}
+
+	if ((_MALI_UK_TIMELINE_SEQNO_MMAP_OFFSET >> PAGE_SHIFT) == vma->vm_pgoff) {
+		return mali_timeline_seqno_mmap(session, vma);
+	}
+
 	MALI_DEBUG_PRINT(4, ("MMap() handler: start=0x%08X, phys=0x%08X, size=0x%08X vma->flags 0x%08x\n",
 			     (unsigned int)vma->vm_start, (unsigned int)(vma->vm_pgoff << PAGE_SHIFT),
 			     (unsigned int)(vma->vm_end - vma->vm_start), vma->vm_flags));
@@ -235,24 +291,25 @@ int mali_mmap(struct file *filp, struct vm_area_struct *vma)
 		return -EFAULT;
 	}
 
-	mali_alloc->cpu_mapping.addr = (void __user *)vma->vm_start;
-
 	if (mali_alloc->flags & _MALI_MEMORY_ALLOCATE_DEFER_BIND) {
 		MALI_DEBUG_PRINT(1, ("ERROR : trying to access varying memory by CPU!\n"));
 		return -EFAULT;
 	}
 
+	if (mali_alloc->flags & MALI_MEM_FLAG_GROWABLE) {
+		MALI_DEBUG_PRINT(1, ("ERROR : trying to access growable heap memory by CPU!\n"));
+		return -EFAULT;
+	}
+
 	/* Get backend memory & Map on CPU */
-	mutex_lock(&mali_idr_mutex);
-	if (!(mem_bkend = idr_find(&mali_backend_idr, mali_alloc->backend_handle))) {
+	if (!(mem_bkend = mali_mem_backend_get(mali_alloc->backend_handle))) {
 		MALI_DEBUG_PRINT(1, ("Can't find memory backend in mmap!\n"));
-		mutex_unlock(&mali_idr_mutex);
 		return -EFAULT;
 	}
-	mutex_unlock(&mali_idr_mutex);
 
 	if ((vma->vm_start + mem_bkend->size) > vma->vm_end) {
 		MALI_PRINT_ERROR(("mali_mmap: out of memory mapping map_size %d, physical_size %d\n",  vma->vm_end - vma->vm_start, mem_bkend->size));
+		mali_mem_backend_put(mem_bkend);
 		return -EFAULT;
 	}
 
@@ -280,8 +337,6 @@ int mali_mmap(struct file *filp, struct vm_area_struct *vma)
 	vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
 	vma->vm_ops = &mali_kernel_vm_ops;
 
-	mali_alloc->cpu_mapping.addr = (void __user *)vma->vm_start;
-
 	/* If it's a copy-on-write mapping, map to read only */
 	if (!(vma->vm_flags & VM_WRITE)) {
 		MALI_DEBUG_PRINT(4, ("mmap allocation with read only !\n"));
@@ -304,28 +359,48 @@ int mali_mmap(struct file *filp, struct vm_area_struct *vma)
 			(MALI_MEM_BACKEND_FLAG_SWAP_COWED == (mem_bkend->flags & MALI_MEM_BACKEND_FLAG_SWAP_COWED)))) {
 		/*For swappable memory, CPU page table will be created by page fault handler. */
 		ret = 0;
+	} else if (mem_bkend->type == MALI_MEM_SPARSE) {
+		/* Bound pages are mapped by the page fault handler too. */
+		ret = 0;
 	} else if (mem_bkend->type == MALI_MEM_SECURE) {
 #if defined(CONFIG_DMA_SHARED_BUFFER)
 		ret = mali_mem_secure_cpu_map(mem_bkend, vma);
 #else
 		MALI_DEBUG_PRINT(1, ("DMA not supported for mali secure memory\n"));
-		return -EFAULT;
+		ret = -EFAULT;
 #endif
 	} else {
 		/* Not support yet*/
 		MALI_DEBUG_PRINT_ERROR(("Invalid type of backend memory! \n"));
-		return -EFAULT;
+		ret = -EFAULT;
 	}
 
 	if (ret != 0) {
 		MALI_DEBUG_PRINT(1, ("ret != 0\n"));
+		mali_mem_backend_put(mem_bkend);
 		return -EFAULT;
 	}
 out:
 	MALI_DEBUG_ASSERT(MALI_MEM_ALLOCATION_VALID_MAGIC == mali_alloc->magic);
 
+	mali_session_memory_lock(session);
+
+	/* Sparse unbind and purging only zap the recorded vma, so these are mapped once */
+	if (0 != mali_alloc->cpu_mapping.count && (MALI_MEM_SPARSE == mem_bkend->type ||
+			((MALI_MEM_BACKEND_FLAG_PURGEABLE | MALI_MEM_BACKEND_FLAG_PURGED) & mem_bkend->flags))) {
+		MALI_DEBUG_PRINT(1, ("ERROR : trying to map sparse or purgeable memory twice by CPU!\n"));
+		mali_session_memory_unlock(session);
+		mali_mem_backend_put(mem_bkend);
+		return -EBUSY;
+	}
+
 	vma->vm_private_data = (void *)mali_alloc;
+	mali_alloc->cpu_mapping.addr = (void __user *)vma->vm_start;
 	mali_alloc->cpu_mapping.vma = vma;
+	mali_alloc->cpu_mapping.count++;
+
+	mali_session_memory_unlock(session);
+	mali_mem_backend_put(mem_bkend);
 
 	mali_allocation_ref(mali_alloc);
 
@@ -334,7 +409,7 @@ out:
 
 _mali_osk_errcode_t mali_mem_mali_map_prepare(mali_mem_allocation *descriptor)
 {
-	u32 size = descriptor->psize;
+	u32 size = mali_mem_mali_map_size(descriptor);
 	struct mali_session_data *session = descriptor->session;
 
 	MALI_DEBUG_ASSERT(MALI_MEM_ALLOCATION_VALID_MAGIC == descriptor->magic);
@@ -366,7 +441,17 @@ _mali_osk_errcode_t mali_mem_mali_map_resize(mali_mem_allocation *descriptor, u3
 	return _MALI_OSK_ERR_OK;
 }
 
-void mali_mem_mali_map_free(struct mali_session_data *session, u32 size, mali_address_t vaddr, u32 flags)
+u32 mali_mem_mali_map_size(mali_mem_allocation *descriptor)
+{
+	if ((descriptor->flags & MALI_MEM_FLAG_GROWABLE) || (MALI_MEM_SPARSE == descriptor->type)) {
+		return descriptor->vsize;
+	}
+
+	return descriptor->psize;
+}
+
+void mali_mem_mali_map_free(struct mali_session_data *session, u32 size, mali_address_t vaddr, u32 flags,
+			    struct mali_mmu_invalidate_batch *batch)
 {
 	if (flags & MALI_MEM_FLAG_MALI_GUARD_PAGE) {
 		size += MALI_MMU_PAGE_SIZE;
@@ -374,7 +459,17 @@ void mali_mem_mali_map_free(struct mali_session_data *session, u32 size, mali_ad
 
 	/* Umap and flush L2 */
 	mali_mmu_pagedir_unmap(session->page_directory, vaddr, size);
-	mali_executor_zap_all_active(session);
+
+	if (NULL != batch) {
+		/* The caller invalidates the TLBs once for the whole batch */
+		mali_mmu_invalidate_batch_add(batch, vaddr, size);
+	} else {
+		struct mali_mmu_invalidate_batch single;
+
+		mali_mmu_invalidate_batch_init(&single);
+		mali_mmu_invalidate_batch_add(&single, vaddr, size);
+		mali_executor_zap_all_active(session, &single);
+	}
 }
 
 u32 _mali_ukk_report_memory_usage(void)
@@ -450,6 +545,10 @@ _mali_osk_errcode_t mali_memory_initialize(void)
 
 	idr_init(&mali_backend_idr);
 	mutex_init(&mali_idr_mutex);
+#if defined(CONFIG_DMA_SHARED_BUFFER) && !defined(CONFIG_MALI_DMA_BUF_MAP_ON_ATTACH)
+	mali_dma_buf_cache_init();
+#endif
+	mali_mem_purgeable_init();
 
 	err = mali_mem_swap_init();
 	if (err != _MALI_OSK_ERR_OK) {
@@ -459,13 +558,21 @@ _mali_osk_errcode_t mali_memory_initialize(void)
 	if (_MALI_OSK_ERR_OK == err) {
 		err = mali_mem_defer_bind_manager_init();
 	}
+	if (_MALI_OSK_ERR_OK == err) {
+		err = mali_mem_sparse_init();
+	}
 
 	return err;
 }
 
 void mali_memory_terminate(void)
 {
+#if defined(CONFIG_DMA_SHARED_BUFFER) && !defined(CONFIG_MALI_DMA_BUF_MAP_ON_ATTACH)
+	mali_dma_buf_cache_term();
+#endif
 	mali_mem_swap_term();
+	mali_mem_purgeable_term();
+	mali_mem_sparse_term();
 	mali_mem_defer_bind_manager_destory();
 	mali_mem_os_term();
 	if (mali_memory_have_dedicated_memory()) {
@@ -20,6 +20,8 @@
 #include "mali_memory_types.h"
 #include "mali_memory_os_alloc.h"
 
+struct mali_mmu_invalidate_batch;
+
 _mali_osk_errcode_t mali_memory_initialize(void);
 void mali_memory_terminate(void);
 
@@ -58,6 +60,23 @@ mali_mmu_release_table_page(mali_dma_addr phys, void *virt)
  */
 int mali_mmap(struct file *filp, struct vm_area_struct *vma);
 
+/** @brief Check if a vma other than cpu_mapping.vma maps an allocation
+ *
+ * Split vmas, and vmas moved by mremap(), aren't recorded in the allocation,
+ * zapping cpu_mapping.vma leaves their pages mapped.
+ *
+ * Must be called with the session memory lock held.
+ *
+ * @param alloc Allocation to check
+ * @return MALI_TRUE if an unrecorded vma maps the allocation
+ */
+MALI_STATIC_INLINE mali_bool mali_mem_cpu_mapping_untracked(mali_mem_allocation *alloc)
+{
+	u32 tracked = (NULL != alloc->cpu_mapping.vma) ? 1 : 0;
+
+	return (alloc->cpu_mapping.count > tracked) ? MALI_TRUE : MALI_FALSE;
+}
+
 /** @brief Start a new memory session
  *
  * Called when a process opens the Mali device node.
@@ -99,6 +118,16 @@ _mali_osk_errcode_t mali_mem_mali_map_prepare(mali_mem_allocation *descriptor);
  */
 _mali_osk_errcode_t mali_mem_mali_map_resize(mali_mem_allocation *descriptor, u32 new_size);
 
+/** @brief Size of the Mali page tables prepared for an allocation
+ *
+ * Growable heaps and sparse allocations have page tables for their whole
+ * virtual range, so that pages can be added without allocating memory. Other
+ * allocations have them for their physical size.
+ *
+ * @param descriptor Pointer to the memory descriptor of the mapping
+ */
+u32 mali_mem_mali_map_size(mali_mem_allocation *descriptor);
+
 /** @brief Free Mali page tables for mapping
  *
  * This function will unmap pages from Mali memory and free the page tables
@@ -107,8 +136,13 @@ _mali_osk_errcode_t mali_mem_mali_map_resize(mali_mem_allocation *descriptor, u3
  * The updated pages in the Mali L2 cache will be invalidated, and the MMU TLBs will be zapped if necessary.
  *
  * @param descriptor Pointer to the memory descriptor to unmap
+ * @param batch If not NULL, the TLB invalidation is only added to \a batch,
+ * and the caller zaps the TLBs for the whole batch with
+ * mali_executor_zap_all_active(). Only do this where the unmapped pages cannot
+ * be reused before then.
  */
-void mali_mem_mali_map_free(struct mali_session_data *session, u32 size, mali_address_t vaddr, u32 flags);
+void mali_mem_mali_map_free(struct mali_session_data *session, u32 size, mali_address_t vaddr, u32 flags,
+			    struct mali_mmu_invalidate_batch *batch);
 
 /** @brief Parse resource and prepare the OS memory allocator
  *
@@ -264,10 +264,11 @@ _mali_osk_errcode_t mali_mem_block_unref_node(struct mali_page_node *node)
 int mali_mem_block_mali_map(mali_mem_block_mem *block_mem, struct mali_session_data *session, u32 vaddr, u32 props)
 {
 	struct mali_page_directory *pagedir = session->page_directory;
+	struct mali_mmu_pagedir_range range;
 	struct mali_page_node *m_page;
 	dma_addr_t phys;
-	u32 virt = vaddr;
-	u32 prop = props;
+
+	mali_mmu_pagedir_range_begin(&range, pagedir, vaddr, props);
 
 	list_for_each_entry(m_page, &block_mem->pfns, list) {
 		MALI_DEBUG_ASSERT(m_page->type == MALI_PAGE_NODE_BLOCK);
@@ -278,10 +279,11 @@ int mali_mem_block_mali_map(mali_mem_block_mem *block_mem, struct mali_session_d
 		 * wider than 32-bit. */
 		MALI_DEBUG_ASSERT(0 == (phys >> 32));
 #endif
-		mali_mmu_pagedir_update(pagedir, virt, (mali_dma_addr)phys, MALI_MMU_PAGE_SIZE, prop);
-		virt += MALI_MMU_PAGE_SIZE;
+		mali_mmu_pagedir_range_add(&range, (mali_dma_addr)phys);
 	}
 
+	mali_mmu_pagedir_range_end(&range);
+
 	return 0;
 }
 
@@ -294,7 +296,7 @@ void mali_mem_block_mali_unmap(mali_mem_allocation *alloc)
 
 	mali_session_memory_lock(session);
 	mali_mem_mali_map_free(session, alloc->psize, alloc->mali_vma_node.vm_node.start,
-			       alloc->flags);
+			       alloc->flags, NULL);
 	mali_session_memory_unlock(session);
 }
 
@@ -29,6 +29,10 @@
 #include "mali_memory_block_alloc.h"
 #include "mali_memory_swap_alloc.h"
 
+#define MALI_MEM_COW_FAULT_WINDOW_DEFAULT (16)
+
+unsigned int mali_mem_cow_fault_window = MALI_MEM_COW_FAULT_WINDOW_DEFAULT;
+
 /**
 * allocate pages for COW backend and flush cache
 */
@@ -488,6 +492,7 @@ int mali_mem_cow_mali_map(mali_mem_backend *mem_bkend, u32 range_start, u32 rang
 	struct mali_page_node *m_page;
 	struct mali_session_data *session;
 	struct mali_page_directory *pagedir;
+	struct mali_mmu_pagedir_range range;
 	u32 virt, start;
 
 	cow_alloc = mem_bkend->mali_allocation;
@@ -501,17 +506,23 @@ int mali_mem_cow_mali_map(mali_mem_backend *mem_bkend, u32 range_start, u32 rang
 	session = cow_alloc->session;
 	pagedir = session->page_directory;
 	MALI_CHECK_NON_NULL(session, _MALI_OSK_ERR_INVALID_ARGS);
+	mali_mmu_pagedir_range_begin(&range, pagedir, virt, MALI_MMU_FLAGS_DEFAULT);
 	list_for_each_entry(m_page, &mem_bkend->cow_mem.pages, list) {
-		if ((virt - start >= range_start) && (virt - start < range_start + range_size)) {
+		if (virt - start >= range_start + range_size) {
+			break;
+		}
+		if (virt - start >= range_start) {
 			dma_addr_t phys = _mali_page_node_get_dma_addr(m_page);
 #if defined(CONFIG_ARCH_DMA_ADDR_T_64BIT)
 			MALI_DEBUG_ASSERT(0 == (phys >> 32));
 #endif
-			mali_mmu_pagedir_update(pagedir, virt, (mali_dma_addr)phys,
-						MALI_MMU_PAGE_SIZE, MALI_MMU_FLAGS_DEFAULT);
+			mali_mmu_pagedir_range_add(&range, (mali_dma_addr)phys);
+		} else {
+			mali_mmu_pagedir_range_skip(&range);
 		}
 		virt += MALI_MMU_PAGE_SIZE;
 	}
+	mali_mmu_pagedir_range_end(&range);
 	return 0;
 }
 
@@ -632,8 +643,9 @@ u32 mali_mem_cow_release(mali_mem_backend *mem_bkend, mali_bool is_mali_mapped)
 void _mali_mem_cow_copy_page(mali_page_node *src_node, mali_page_node *dst_node)
 {
 	void *dst, *src;
+	void __iomem *src_io = NULL;
 	struct page *dst_page;
-	dma_addr_t dma_addr;
+	dma_addr_t dst_dma_addr;
 
 	MALI_DEBUG_ASSERT(src_node != NULL);
 	MALI_DEBUG_ASSERT(dst_node != NULL);
@@ -645,9 +657,19 @@ void _mali_mem_cow_copy_page(mali_page_node *src_node, mali_page_node *dst_node)
 	} else {
 		dst_page = dst_node->swap_it->page;
 	}
-
-	dma_unmap_page(&mali_platform_device->dev, _mali_page_node_get_dma_addr(dst_node),
-		       _MALI_OSK_MALI_PAGE_SIZE, DMA_BIDIRECTIONAL);
+	dst_dma_addr = _mali_page_node_get_dma_addr(dst_node);
+
+	/*
+	* use ioremap to map src for BLOCK memory, one page at a time, before
+	* the atomic kmap as ioremap may sleep
+	*/
+	if (src_node->type == MALI_PAGE_NODE_BLOCK) {
+		src_io = ioremap_nocache(_mali_page_node_get_dma_addr(src_node), _MALI_OSK_MALI_PAGE_SIZE);
+		if (NULL == src_io) {
+			MALI_PRINT_ERROR(("Mali COW: failed to map block page 0x%08lx for copy\n",
+					  (unsigned long)_mali_page_node_get_dma_addr(src_node)));
+		}
+	}
 
 	/* map it , and copy the content*/
 	dst = kmap_atomic(dst_page);
@@ -655,6 +677,7 @@ void _mali_mem_cow_copy_page(mali_page_node *src_node, mali_page_node *dst_node)
 	if (src_node->type == MALI_PAGE_NODE_OS ||
 	    src_node->type == MALI_PAGE_NODE_SWAP) {
 		struct page *src_page;
+		dma_addr_t src_dma_addr = _mali_page_node_get_dma_addr(src_node);
 
 		if (src_node->type == MALI_PAGE_NODE_OS) {
 			src_page = src_node->page;
@@ -665,64 +688,68 @@ void _mali_mem_cow_copy_page(mali_page_node *src_node, mali_page_node *dst_node)
 		/* Clear and invaliate cache */
 		/* In ARM architecture, speculative read may pull stale data into L1 cache
 		 * for kernel linear mapping page table. DMA_BIDIRECTIONAL could
-		 * invalidate the L1 cache so that following read get the latest data
+		 * invalidate the L1 cache so that following read get the latest data.
+		 * Syncing keeps the page's DMA mapping, so it needn't be set up again.
 		*/
-		dma_unmap_page(&mali_platform_device->dev, _mali_page_node_get_dma_addr(src_node),
-			       _MALI_OSK_MALI_PAGE_SIZE, DMA_BIDIRECTIONAL);
+		dma_sync_single_for_cpu(&mali_platform_device->dev, src_dma_addr,
+					_MALI_OSK_MALI_PAGE_SIZE, DMA_BIDIRECTIONAL);
 
 		src = kmap_atomic(src_page);
 		memcpy(dst, src , _MALI_OSK_MALI_PAGE_SIZE);
 		kunmap_atomic(src);
-		dma_addr = dma_map_page(&mali_platform_device->dev, src_page,
-					0, _MALI_OSK_MALI_PAGE_SIZE, DMA_BIDIRECTIONAL);
-
-		if (src_node->type == MALI_PAGE_NODE_SWAP) {
-			src_node->swap_it->dma_addr = dma_addr;
-		}
-	} else if (src_node->type == MALI_PAGE_NODE_BLOCK) {
-		/*
-		* use ioremap to map src for BLOCK memory
-		*/
-		src = ioremap_nocache(_mali_page_node_get_dma_addr(src_node), _MALI_OSK_MALI_PAGE_SIZE);
-		memcpy(dst, src , _MALI_OSK_MALI_PAGE_SIZE);
-		iounmap(src);
+		dma_sync_single_for_device(&mali_platform_device->dev, src_dma_addr,
+					   _MALI_OSK_MALI_PAGE_SIZE, DMA_BIDIRECTIONAL);
+	} else if (NULL != src_io) {
+		memcpy_fromio(dst, src_io, _MALI_OSK_MALI_PAGE_SIZE);
 	}
 	kunmap_atomic(dst);
-	dma_addr = dma_map_page(&mali_platform_device->dev, dst_page,
-				0, _MALI_OSK_MALI_PAGE_SIZE, DMA_BIDIRECTIONAL);
 
-	if (dst_node->type == MALI_PAGE_NODE_SWAP) {
-		dst_node->swap_it->dma_addr = dma_addr;
+	if (NULL != src_io) {
+		iounmap(src_io);
 	}
+
+	/* Write the copy back to memory before the GPU reads the page */
+	dma_sync_single_for_device(&mali_platform_device->dev, dst_dma_addr,
+				   _MALI_OSK_MALI_PAGE_SIZE, DMA_BIDIRECTIONAL);
 }
 
 
 /*
 * allocate page on demand when CPU access it,
 * THis used in page fault handler
+* @offset_page - page which CPU faulted on
+* @num_pages - in: max number of pages to copy from offset_page, out: number of pages copied
+*
+* The pages following offset_page which are still shared with the COW target
+* are copied too, as they can't have been mapped to CPU yet. All of them are
+* allocated, copied, unreferenced and mapped to GPU in one go. The caller
+* passes 1 in num_pages if the allocation is mapped by more than the
+* faulting vma, as another vma could map those pages.
 */
-_mali_osk_errcode_t mali_mem_cow_allocate_on_demand(mali_mem_backend *mem_bkend, u32 offset_page)
+_mali_osk_errcode_t mali_mem_cow_allocate_on_demand(mali_mem_backend *mem_bkend, u32 offset_page, u32 *num_pages)
 {
-	struct page *new_page = NULL;
+	struct mali_page_node *src_nodes[MALI_MEM_COW_FAULT_WINDOW_MAX];
 	struct mali_page_node *new_node = NULL;
-	int i = 0;
+	mali_mem_os_mem os_mem;
+	u32 i = 0;
+	u32 count = 0;
+	u32 put_count;
+	u32 max_count;
+	u32 change_pages_nr = 0;
 	struct mali_page_node *m_page, *found_node = NULL;
 	struct  mali_session_data *session = NULL;
 	mali_mem_cow *cow = &mem_bkend->cow_mem;
 	MALI_DEBUG_ASSERT(MALI_MEM_COW == mem_bkend->type);
 	MALI_DEBUG_ASSERT(offset_page < mem_bkend->size / _MALI_OSK_MALI_PAGE_SIZE);
+	MALI_DEBUG_ASSERT_POINTER(num_pages);
 	MALI_DEBUG_PRINT(4, ("mali_mem_cow_allocate_on_demand !, offset_page =0x%x\n", offset_page));
 
-	/* allocate new page here */
-	new_page = mali_mem_cow_alloc_page();
-	if (!new_page)
-		return _MALI_OSK_ERR_NOMEM;
-
-	new_node = _mali_page_node_allocate(MALI_PAGE_NODE_OS);
-	if (!new_node) {
-		__free_page(new_page);
-		return _MALI_OSK_ERR_NOMEM;
+	max_count = min_t(u32, *num_pages, MALI_MEM_COW_FAULT_WINDOW_MAX);
+	max_count = min_t(u32, max_count, mem_bkend->size / _MALI_OSK_MALI_PAGE_SIZE - offset_page);
+	if (0 == max_count) {
+		max_count = 1;
 	}
+	*num_pages = 0;
 
 	/* find the page in backend*/
 	list_for_each_entry(m_page, &cow->pages, list) {
@@ -734,43 +761,85 @@ _mali_osk_errcode_t mali_mem_cow_allocate_on_demand(mali_mem_backend *mem_bkend,
 	}
 	MALI_DEBUG_ASSERT(found_node);
 	if (NULL == found_node) {
-		__free_page(new_page);
-		kfree(new_node);
 		return _MALI_OSK_ERR_ITEM_NOT_FOUND;
 	}
 
-	_mali_page_node_add_page(new_node, new_page);
+	/* Collect the window: the faulting page, then following pages still shared */
+	src_nodes[count++] = found_node;
+	m_page = found_node;
+	while (count < max_count && m_page->list.next != &cow->pages) {
+		m_page = list_entry(m_page->list.next, struct mali_page_node, list);
+		if (1 == _mali_page_node_get_ref_count(m_page)) {
+			break;
+		}
+		src_nodes[count++] = m_page;
+	}
+
+	/* allocate new pages here, only the faulting one if the window can't be had */
+	if (mali_mem_os_alloc_pages(&os_mem, count * _MALI_OSK_MALI_PAGE_SIZE)) {
+		if (1 == count) {
+			return _MALI_OSK_ERR_NOMEM;
+		}
+		count = 1;
+		if (mali_mem_os_alloc_pages(&os_mem, _MALI_OSK_MALI_PAGE_SIZE)) {
+			return _MALI_OSK_ERR_NOMEM;
+		}
+	}
+	MALI_DEBUG_ASSERT(count == os_mem.count);
 
-	/* Copy the src page's content to new page */
-	_mali_mem_cow_copy_page(found_node, new_node);
+	/* Copy the src pages' content to new pages */
+	i = 0;
+	list_for_each_entry(new_node, &os_mem.pages, list) {
+		_mali_mem_cow_copy_page(src_nodes[i], new_node);
+		i++;
+	}
 
 	MALI_DEBUG_ASSERT_POINTER(mem_bkend->mali_allocation);
 	session = mem_bkend->mali_allocation->session;
 	MALI_DEBUG_ASSERT_POINTER(session);
-	if (1 != _mali_page_node_get_ref_count(found_node)) {
-		atomic_add(1, &session->mali_mem_allocated_pages);
-		if (atomic_read(&session->mali_mem_allocated_pages) * MALI_MMU_PAGE_SIZE > session->max_mali_mem_allocated_size) {
-			session->max_mali_mem_allocated_size = atomic_read(&session->mali_mem_allocated_pages) * MALI_MMU_PAGE_SIZE;
-		}
-		mem_bkend->cow_mem.change_pages_nr++;
-	}
 
+	/* unref old pages, under one hold of the cow lock for the whole window */
 	_mali_osk_mutex_wait(session->cow_lock);
-	if (_mali_mem_put_page_node(found_node)) {
-		__free_page(new_page);
-		kfree(new_node);
-		_mali_osk_mutex_signal(session->cow_lock);
-		return _MALI_OSK_ERR_NOMEM;
+	for (put_count = 0; put_count < count; put_count++) {
+		mali_bool shared = (1 != _mali_page_node_get_ref_count(src_nodes[put_count])) ? MALI_TRUE : MALI_FALSE;
+
+		if (_mali_mem_put_page_node(src_nodes[put_count])) {
+			break;
+		}
+		if (MALI_TRUE == shared) {
+			change_pages_nr++;
+		}
 	}
 	_mali_osk_mutex_signal(session->cow_lock);
 
-	list_replace(&found_node->list, &new_node->list);
+	for (i = 0; i < put_count; i++) {
+		new_node = list_first_entry(&os_mem.pages, struct mali_page_node, list);
+		list_del(&new_node->list);
+		list_replace(&src_nodes[i]->list, &new_node->list);
+		kfree(src_nodes[i]);
+	}
 
-	kfree(found_node);
+	/* Copies of pages which couldn't be unreferenced are not used */
+	if (put_count < count) {
+		mali_mem_os_free(&os_mem.pages, count - put_count, MALI_FALSE);
+		if (0 == put_count) {
+			return _MALI_OSK_ERR_NOMEM;
+		}
+	}
+
+	if (0 < change_pages_nr) {
+		atomic_add(change_pages_nr, &session->mali_mem_allocated_pages);
+		if (atomic_read(&session->mali_mem_allocated_pages) * MALI_MMU_PAGE_SIZE > session->max_mali_mem_allocated_size) {
+			session->max_mali_mem_allocated_size = atomic_read(&session->mali_mem_allocated_pages) * MALI_MMU_PAGE_SIZE;
+		}
+		mem_bkend->cow_mem.change_pages_nr += change_pages_nr;
+	}
 
 	/* map to GPU side*/
 	_mali_osk_mutex_wait(session->memory_lock);
-	mali_mem_cow_mali_map(mem_bkend, offset_page * _MALI_OSK_MALI_PAGE_SIZE, _MALI_OSK_MALI_PAGE_SIZE);
+	mali_mem_cow_mali_map(mem_bkend, offset_page * _MALI_OSK_MALI_PAGE_SIZE, put_count * _MALI_OSK_MALI_PAGE_SIZE);
 	_mali_osk_mutex_signal(session->memory_lock);
+
+	*num_pages = put_count;
 	return _MALI_OSK_ERR_OK;
 }
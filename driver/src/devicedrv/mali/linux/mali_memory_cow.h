@@ -15,6 +15,11 @@
 #include "mali_session.h"
 #include "mali_memory_types.h"
 
+/* Upper bound of mali_mem_cow_fault_window, pages copied per CPU fault on a COW allocation */
+#define MALI_MEM_COW_FAULT_WINDOW_MAX (32)
+
+extern unsigned int mali_mem_cow_fault_window;
+
 int mali_mem_cow_cpu_map(mali_mem_backend *mem_bkend, struct vm_area_struct *vma);
 _mali_osk_errcode_t mali_mem_cow_cpu_map_pages_locked(mali_mem_backend *mem_bkend,
 		struct vm_area_struct *vma,
@@ -43,6 +48,6 @@ void _mali_mem_cow_copy_page(mali_page_node *src_node, mali_page_node *dst_node)
 
 int mali_mem_cow_mali_map(mali_mem_backend *mem_bkend, u32 range_start, u32 range_size);
 u32 mali_mem_cow_release(mali_mem_backend *mem_bkend, mali_bool is_mali_mapped);
-_mali_osk_errcode_t mali_mem_cow_allocate_on_demand(mali_mem_backend *mem_bkend, u32 offset_page);
+_mali_osk_errcode_t mali_mem_cow_allocate_on_demand(mali_mem_backend *mem_bkend, u32 offset_page, u32 *num_pages);
 #endif
 
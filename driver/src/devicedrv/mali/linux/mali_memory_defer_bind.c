@@ -30,9 +30,19 @@
 #include "mali_osk.h"
 #include "mali_scheduler.h"
 #include "mali_gp_job.h"
+#include "mali_memory_manager.h"
+#include "mali_memory_util.h"
+#include "mali_memory_virtual.h"
+
+#define MALI_MEM_HEAP_GROW_PAGES_DEFAULT (128)
+
+/* Pages reserved per GP job to grow a growable heap with, 0 leaves out of memory to user space */
+unsigned int mali_mem_heap_grow_pages = MALI_MEM_HEAP_GROW_PAGES_DEFAULT;
 
 mali_defer_bind_manager *mali_dmem_man = NULL;
 
+static void mali_mem_defer_heap_release_work(void *arg);
+
 static u32 mali_dmem_get_gp_varying_size(struct mali_gp_job *gp_job)
 {
 	return gp_job->required_varying_memsize / _MALI_OSK_MALI_PAGE_SIZE;
@@ -47,6 +57,15 @@ _mali_osk_errcode_t mali_mem_defer_bind_manager_init(void)
 	atomic_set(&mali_dmem_man->num_used_pages, 0);
 	atomic_set(&mali_dmem_man->num_dmem, 0);
 
+	spin_lock_init(&mali_dmem_man->heap_release_lock);
+	INIT_LIST_HEAD(&mali_dmem_man->heap_release_list);
+	mali_dmem_man->heap_release_work = _mali_osk_wq_create_work(mali_mem_defer_heap_release_work, NULL);
+	if (NULL == mali_dmem_man->heap_release_work) {
+		kfree(mali_dmem_man);
+		mali_dmem_man = NULL;
+		return _MALI_OSK_ERR_NOMEM;
+	}
+
 	return _MALI_OSK_ERR_OK;
 }
 
@@ -55,6 +74,8 @@ void mali_mem_defer_bind_manager_destory(void)
 {
 	if (mali_dmem_man) {
 		MALI_DEBUG_ASSERT(0 == atomic_read(&mali_dmem_man->num_dmem));
+		_mali_osk_wq_delete_work(mali_dmem_man->heap_release_work);
+		MALI_DEBUG_ASSERT(list_empty(&mali_dmem_man->heap_release_list));
 		kfree(mali_dmem_man);
 	}
 	mali_dmem_man = NULL;
@@ -117,17 +138,15 @@ _mali_osk_errcode_t mali_mem_defer_bind_allocation_prepare(mali_mem_allocation *
 
 	INIT_LIST_HEAD(&bk_list->node);
 	/* Get backend memory */
-	mutex_lock(&mali_idr_mutex);
-	if (!(mem_bkend = idr_find(&mali_backend_idr, alloc->backend_handle))) {
+	if (!(mem_bkend = mali_mem_backend_get(alloc->backend_handle))) {
 		MALI_DEBUG_PRINT(1, ("Can't find memory backend in defer bind!\n"));
-		mutex_unlock(&mali_idr_mutex);
 		_mali_osk_free(bk_list);
 		return _MALI_OSK_ERR_FAULT;
 	}
-	mutex_unlock(&mali_idr_mutex);
 
 	/* If the mem backend has already been bound, no need to bind again.*/
 	if (mem_bkend->os_mem.count > 0) {
+		mali_mem_backend_put(mem_bkend);
 		_mali_osk_free(bk_list);
 		return _MALI_OSK_ERR_OK;
 	}
@@ -146,6 +165,9 @@ _mali_osk_errcode_t mali_mem_defer_bind_allocation_prepare(mali_mem_allocation *
 	/* add to job to do list */
 	list_add(&bk_list->node, list);
 
+	/* The allocation, which the job holds a reference on, keeps the backend alive from here. */
+	mali_mem_backend_put(mem_bkend);
+
 	return _MALI_OSK_ERR_OK;
 }
 
@@ -260,3 +282,179 @@ void mali_mem_defer_dmem_free(struct mali_gp_job *gp)
 	}
 }
 
+/* Prepare growing the job's heap, if it lies in a growable allocation.
+ * Growing the heap allocates memory and takes the backend mutex, so it is done here:
+ * the heap is backed up to mali_mem_heap_grow_pages beyond the job's heap end,
+ * and the interrupt handler only hands out the range recorded in the job.
+ */
+_mali_osk_errcode_t mali_mem_defer_heap_prepare(struct mali_gp_job *gp)
+{
+	struct mali_session_data *session = gp->session;
+	u32 heap_start = gp->uargs.frame_registers[4];
+	u32 heap_end = gp->uargs.frame_registers[5];
+	mali_mem_allocation *alloc = NULL;
+	mali_mem_backend *mem_bkend = NULL;
+	struct mali_mem_heap_grow *heap = NULL;
+	mali_mem_os_mem os_mem;
+	u32 alloc_start, backed_end, num_pages;
+	_mali_osk_errcode_t ret = _MALI_OSK_ERR_OK;
+
+	gp->heap = NULL;
+
+	if (0 == mali_mem_heap_grow_pages || heap_end <= heap_start) {
+		return _MALI_OSK_ERR_OK;
+	}
+
+	/* The heap holds the reference taken in the lookup, a concurrent free can't release the allocation */
+	alloc = mali_vma_offset_search_ref(&session->allocation_mgr, heap_start);
+	if (NULL == alloc) {
+		return _MALI_OSK_ERR_OK;
+	}
+
+	if (!(alloc->flags & MALI_MEM_FLAG_GROWABLE)) {
+		mali_allocation_unref(&alloc);
+		return _MALI_OSK_ERR_OK;
+	}
+
+	if (!(mem_bkend = mali_mem_backend_get(alloc->backend_handle))) {
+		MALI_DEBUG_PRINT(1, ("Can't find memory backend of growable heap!\n"));
+		mali_allocation_unref(&alloc);
+		return _MALI_OSK_ERR_FAULT;
+	}
+
+	heap = _mali_osk_calloc(1, sizeof(struct mali_mem_heap_grow));
+	if (NULL == heap) {
+		mali_mem_backend_put(mem_bkend);
+		mali_allocation_unref(&alloc);
+		return _MALI_OSK_ERR_NOMEM;
+	}
+
+	mutex_lock(&mem_bkend->mutex);
+
+	alloc_start = alloc->mali_vma_node.vm_node.start;
+	backed_end = alloc_start + mem_bkend->size;
+	if (heap_end > backed_end) {
+		MALI_DEBUG_PRINT(2, ("Mali GP job: heap end 0x%08x beyond the backed end of growable heap 0x%08x\n", heap_end, backed_end));
+		goto out;
+	}
+
+	/* Other jobs may have grown the heap beyond this job's heap end already */
+	num_pages = (backed_end - heap_end) / _MALI_OSK_MALI_PAGE_SIZE;
+	num_pages = (num_pages < mali_mem_heap_grow_pages) ? mali_mem_heap_grow_pages - num_pages : 0;
+	num_pages = min_t(u32, num_pages, (alloc_start + alloc->vsize - backed_end) / _MALI_OSK_MALI_PAGE_SIZE);
+
+	if (0 < num_pages) {
+		if (mali_mem_os_alloc_pages(&os_mem, num_pages * _MALI_OSK_MALI_PAGE_SIZE)) {
+			ret = _MALI_OSK_ERR_NOMEM;
+			goto out;
+		}
+
+		mali_mem_os_resize_pages(&os_mem, &mem_bkend->os_mem, 0, os_mem.count);
+
+		/* Page tables for the whole heap were allocated with it */
+		mali_session_memory_lock(session);
+		ret = mali_mem_os_mali_map(&mem_bkend->os_mem, session, alloc_start, mem_bkend->os_mem.count - num_pages,
+					   num_pages, alloc->mali_mapping.properties);
+		mali_session_memory_unlock(session);
+		if (_MALI_OSK_ERR_OK != ret) {
+			mali_mem_os_resize_pages(&mem_bkend->os_mem, &os_mem, mem_bkend->os_mem.count - num_pages, num_pages);
+			mali_mem_os_free(&os_mem.pages, os_mem.count, MALI_FALSE);
+			goto out;
+		}
+
+		mem_bkend->size += num_pages * _MALI_OSK_MALI_PAGE_SIZE;
+		alloc->psize = mem_bkend->size;
+		backed_end = alloc_start + mem_bkend->size;
+
+		atomic_add(num_pages, &session->mali_mem_allocated_pages);
+		if (atomic_read(&session->mali_mem_allocated_pages) * MALI_MMU_PAGE_SIZE > session->max_mali_mem_allocated_size) {
+			session->max_mali_mem_allocated_size = atomic_read(&session->mali_mem_allocated_pages) * MALI_MMU_PAGE_SIZE;
+		}
+
+		MALI_DEBUG_PRINT(3, ("Mali GP job: grew heap 0x%08x by 0x%x pages\n", alloc_start, num_pages));
+	}
+
+	if (heap_end < backed_end) {
+		INIT_LIST_HEAD(&heap->node);
+		heap->end = heap_end;
+		heap->backed_end = backed_end;
+		/* The allocation, which the heap holds a reference on, keeps the backend alive from here. */
+		heap->alloc = alloc;
+		gp->heap = heap;
+		heap = NULL;
+		alloc = NULL;
+	}
+
+out:
+	mutex_unlock(&mem_bkend->mutex);
+	mali_mem_backend_put(mem_bkend);
+	if (NULL != alloc) {
+		mali_allocation_unref(&alloc);
+	}
+	if (NULL != heap) {
+		_mali_osk_free(heap);
+	}
+
+	return ret;
+}
+
+/* Give the PLBU more heap, called with the executor lock held from the GP interrupt handler.
+ * Hands out the backed range beyond the heap end recorded when the job was created,
+ * the backend itself is not touched here.
+ * Returns MALI_FALSE if the heap can't grow and user space has to be asked for a new one.
+ */
+mali_bool mali_mem_defer_heap_grow(struct mali_gp_job *gp, u32 *start, u32 *end)
+{
+	struct mali_mem_heap_grow *heap = gp->heap;
+
+	MALI_DEBUG_ASSERT_EXECUTOR_LOCK_HELD();
+
+	if (NULL == heap || heap->end == heap->backed_end) {
+		return MALI_FALSE;
+	}
+
+	*start = heap->end;
+	*end = heap->backed_end;
+	heap->end = heap->backed_end;
+
+	return MALI_TRUE;
+}
+
+static void mali_mem_defer_heap_free(struct mali_mem_heap_grow *heap)
+{
+	mali_allocation_unref(&heap->alloc);
+	_mali_osk_free(heap);
+}
+
+static void mali_mem_defer_heap_release_work(void *arg)
+{
+	struct mali_mem_heap_grow *heap, *tmp;
+	unsigned long flags;
+	LIST_HEAD(list);
+
+	spin_lock_irqsave(&mali_dmem_man->heap_release_lock, flags);
+	list_splice_init(&mali_dmem_man->heap_release_list, &list);
+	spin_unlock_irqrestore(&mali_dmem_man->heap_release_lock, flags);
+
+	list_for_each_entry_safe(heap, tmp, &list, node) {
+		list_del(&heap->node);
+		mali_mem_defer_heap_free(heap);
+	}
+}
+
+/* The job may be deleted with the executor lock held, so the heap is freed from a work queue */
+void mali_mem_defer_heap_release(struct mali_gp_job *gp)
+{
+	unsigned long flags;
+
+	if (NULL == gp->heap) {
+		return;
+	}
+
+	spin_lock_irqsave(&mali_dmem_man->heap_release_lock, flags);
+	list_add_tail(&gp->heap->node, &mali_dmem_man->heap_release_list);
+	spin_unlock_irqrestore(&mali_dmem_man->heap_release_lock, flags);
+
+	_mali_osk_wq_schedule_work(mali_dmem_man->heap_release_work);
+	gp->heap = NULL;
+}
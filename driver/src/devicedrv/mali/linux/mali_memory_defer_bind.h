@@ -49,9 +49,20 @@ typedef struct mali_backend_bind_list {
 } mali_backend_bind_lists;
 
 
+/* growable GP heap a job may grow on PLBU out of memory */
+typedef struct mali_mem_heap_grow {
+	struct list_head node;          /* node in the release list of the bind manager */
+	mali_mem_allocation *alloc;     /* referenced until the heap is released */
+	u32 end;                        /* end of the heap last given to the PLBU */
+	u32 backed_end;                 /* end of the backed heap at job creation, the PLBU may be given up to here */
+} mali_mem_heap_grow;
+
 typedef struct mali_defer_bind_manager {
 	atomic_t num_used_pages;
 	atomic_t num_dmem;
+	spinlock_t heap_release_lock;
+	struct list_head heap_release_list;
+	_mali_osk_wq_work_t *heap_release_work;
 } mali_defer_bind_manager;
 
 _mali_osk_errcode_t mali_mem_defer_bind_manager_init(void);
@@ -61,4 +72,9 @@ _mali_osk_errcode_t mali_mem_defer_bind_allocation_prepare(mali_mem_allocation *
 _mali_osk_errcode_t mali_mem_prepare_mem_for_job(struct mali_gp_job *next_gp_job, mali_defer_mem_block *dblock);
 void mali_mem_defer_dmem_free(struct mali_gp_job *gp);
 
+/* Growable GP heaps, grown at job creation and handed to the PLBU from the GP interrupt handler */
+_mali_osk_errcode_t mali_mem_defer_heap_prepare(struct mali_gp_job *gp);
+mali_bool mali_mem_defer_heap_grow(struct mali_gp_job *gp, u32 *start, u32 *end);
+void mali_mem_defer_heap_release(struct mali_gp_job *gp);
+
 #endif
@@ -33,6 +33,220 @@
 #include "mali_memory_dma_buf.h"
 #include "mali_memory_virtual.h"
 #include "mali_pp_job.h"
+#include "mali_mmu.h"
+#include "mali_executor.h"
+
+/*
+ * Unmap DMA buf attachment \a mem from Mali and from the device.
+ * TLB invalidation is added to \a batch, or done right away if it is NULL.
+ * The session memory lock must be held.
+ */
+static void mali_dma_buf_release_mapping(mali_mem_allocation *alloc, struct mali_dma_buf_attachment *mem,
+		struct mali_mmu_invalidate_batch *batch)
+{
+	if (NULL != mem->sgt) {
+		dma_buf_unmap_attachment(mem->attachment, mem->sgt, DMA_BIDIRECTIONAL);
+		mem->sgt = NULL;
+	}
+	if (MALI_TRUE == mem->is_mapped) {
+		mali_mem_mali_map_free(alloc->session, alloc->psize, alloc->mali_vma_node.vm_node.start,
+				       alloc->flags, batch);
+	}
+	mem->is_mapped = MALI_FALSE;
+}
+
+#if !defined(CONFIG_MALI_DMA_BUF_MAP_ON_ATTACH)
+/*
+ * Mapping cache. Attachments which are still mapped but not used by any job
+ * sit on an LRU, oldest first. Lock order is session memory lock, then cache lock.
+ */
+static struct mali_dma_buf_cache {
+	struct mutex lock;
+	struct list_head lru;
+	unsigned long idle_pages; /* Pages mapped by attachments on the LRU */
+	u64 hits;
+	u64 misses;
+	u64 evictions;
+	struct shrinker shrinker;
+} mali_dma_buf_cache;
+
+/*
+ * Take \a mem off the LRU as a job is about to use it, and count whether its
+ * mapping could be reused. The session memory lock must be held.
+ */
+static void mali_dma_buf_cache_take(struct mali_dma_buf_attachment *mem)
+{
+	mutex_lock(&mali_dma_buf_cache.lock);
+	if (!list_empty(&mem->cache_link)) {
+		list_del_init(&mem->cache_link);
+		mali_dma_buf_cache.idle_pages -= mem->buf->size >> PAGE_SHIFT;
+	}
+	if (MALI_TRUE == mem->is_mapped) {
+		mali_dma_buf_cache.hits++;
+	} else {
+		mali_dma_buf_cache.misses++;
+	}
+	mutex_unlock(&mali_dma_buf_cache.lock);
+}
+
+/*
+ * Put \a mem on the LRU when the last job using it is done, if it is cached.
+ * The session memory lock must be held.
+ *
+ * Returns MALI_FALSE if the attachment is not cached and must be unmapped.
+ */
+static mali_bool mali_dma_buf_cache_put(struct mali_dma_buf_attachment *mem)
+{
+	if (MALI_FALSE == mem->cached || MALI_FALSE == mem->is_mapped) {
+		return MALI_FALSE;
+	}
+
+	mutex_lock(&mali_dma_buf_cache.lock);
+	MALI_DEBUG_ASSERT(list_empty(&mem->cache_link));
+	list_add_tail(&mem->cache_link, &mali_dma_buf_cache.lru);
+	mali_dma_buf_cache.idle_pages += mem->buf->size >> PAGE_SHIFT;
+	mutex_unlock(&mali_dma_buf_cache.lock);
+
+	return MALI_TRUE;
+}
+
+/*
+ * Drop the cached mapping of \a mem, if any, before the attachment is released.
+ * If a job still uses the mapping, its last unmap releases it.
+ */
+static void mali_dma_buf_cache_evict(mali_mem_allocation *alloc, struct mali_dma_buf_attachment *mem)
+{
+	mali_session_memory_lock(alloc->session);
+
+	/* Keep the last unmap from putting the attachment back on the LRU. */
+	mem->cached = MALI_FALSE;
+
+	mutex_lock(&mali_dma_buf_cache.lock);
+	if (!list_empty(&mem->cache_link)) {
+		list_del_init(&mem->cache_link);
+		mali_dma_buf_cache.idle_pages -= mem->buf->size >> PAGE_SHIFT;
+	}
+	mutex_unlock(&mali_dma_buf_cache.lock);
+
+	if (0 == mem->map_ref) {
+		mali_dma_buf_release_mapping(alloc, mem, NULL);
+		wake_up_all(&mem->wait_queue);
+	}
+
+	mali_session_memory_unlock(alloc->session);
+}
+
+static unsigned long mali_dma_buf_cache_shrink_count(struct shrinker *shrinker, struct shrink_control *sc)
+{
+	return mali_dma_buf_cache.idle_pages;
+}
+
+/*
+ * Unmap least recently used idle attachments. Sessions whose memory lock is
+ * busy are skipped, the lock may be held by the thread doing the reclaim.
+ */
+#if LINUX_VERSION_CODE < KERNEL_VERSION(3, 12, 0)
+static int mali_dma_buf_cache_shrink(struct shrinker *shrinker, struct shrink_control *sc)
+#else
+static unsigned long mali_dma_buf_cache_shrink(struct shrinker *shrinker, struct shrink_control *sc)
+#endif
+{
+	struct mali_dma_buf_attachment *mem, *tmp;
+	unsigned long nr = sc->nr_to_scan;
+	unsigned long freed = 0;
+
+	if (0 == nr) {
+		return mali_dma_buf_cache_shrink_count(shrinker, sc);
+	}
+
+	if (0 == mutex_trylock(&mali_dma_buf_cache.lock)) {
+		/* Not able to lock. */
+		return -1;
+	}
+
+	list_for_each_entry_safe(mem, tmp, &mali_dma_buf_cache.lru, cache_link) {
+		unsigned long pages = mem->buf->size >> PAGE_SHIFT;
+
+		if (freed >= nr) {
+			break;
+		}
+
+		if (MALI_FALSE == _mali_osk_mutex_trywait(mem->session->memory_lock)) {
+			continue;
+		}
+
+		/* Still idle, a job would have taken it off the LRU under the memory lock. */
+		MALI_DEBUG_ASSERT(0 == mem->map_ref);
+		list_del_init(&mem->cache_link);
+		mali_dma_buf_cache.idle_pages -= pages;
+		mali_dma_buf_cache.evictions++;
+
+		mali_dma_buf_release_mapping(mem->alloc, mem, NULL);
+		wake_up_all(&mem->wait_queue);
+
+		mali_session_memory_unlock(mem->session);
+
+		freed += pages;
+	}
+
+	mutex_unlock(&mali_dma_buf_cache.lock);
+
+#if LINUX_VERSION_CODE < KERNEL_VERSION(3, 12, 0)
+	return mali_dma_buf_cache_shrink_count(shrinker, sc);
+#else
+	return freed;
+#endif
+}
+
+void mali_dma_buf_cache_init(void)
+{
+	mutex_init(&mali_dma_buf_cache.lock);
+	INIT_LIST_HEAD(&mali_dma_buf_cache.lru);
+	mali_dma_buf_cache.idle_pages = 0;
+	mali_dma_buf_cache_reset_stats();
+
+#if LINUX_VERSION_CODE < KERNEL_VERSION(3, 12, 0)
+	mali_dma_buf_cache.shrinker.shrink = mali_dma_buf_cache_shrink;
+#else
+	mali_dma_buf_cache.shrinker.count_objects = mali_dma_buf_cache_shrink_count;
+	mali_dma_buf_cache.shrinker.scan_objects = mali_dma_buf_cache_shrink;
+#endif
+	mali_dma_buf_cache.shrinker.seeks = DEFAULT_SEEKS;
+	register_shrinker(&mali_dma_buf_cache.shrinker);
+}
+
+void mali_dma_buf_cache_term(void)
+{
+	unregister_shrinker(&mali_dma_buf_cache.shrinker);
+	MALI_DEBUG_ASSERT(list_empty(&mali_dma_buf_cache.lru));
+}
+
+void mali_dma_buf_cache_print_stats(_mali_osk_print_ctx *print_ctx)
+{
+	u64 hits, misses, evictions;
+	unsigned long idle_pages;
+
+	mutex_lock(&mali_dma_buf_cache.lock);
+	hits = mali_dma_buf_cache.hits;
+	misses = mali_dma_buf_cache.misses;
+	evictions = mali_dma_buf_cache.evictions;
+	idle_pages = mali_dma_buf_cache.idle_pages;
+	mutex_unlock(&mali_dma_buf_cache.lock);
+
+	_mali_osk_ctxprintf(print_ctx, "Job mappings reused: %llu, mapped: %llu\n", hits, misses);
+	_mali_osk_ctxprintf(print_ctx, "Idle mappings evicted: %llu\n", evictions);
+	_mali_osk_ctxprintf(print_ctx, "Idle mapped pages: %lu\n", idle_pages);
+}
+
+void mali_dma_buf_cache_reset_stats(void)
+{
+	mutex_lock(&mali_dma_buf_cache.lock);
+	mali_dma_buf_cache.hits = 0;
+	mali_dma_buf_cache.misses = 0;
+	mali_dma_buf_cache.evictions = 0;
+	mutex_unlock(&mali_dma_buf_cache.lock);
+}
+#endif /* !CONFIG_MALI_DMA_BUF_MAP_ON_ATTACH */
 
 /*
  * Map DMA buf attachment \a mem into \a session at virtual address \a virt.
@@ -43,6 +257,7 @@ static int mali_dma_buf_map(mali_mem_backend *mem_backend)
 	struct mali_dma_buf_attachment *mem;
 	struct  mali_session_data *session;
 	struct mali_page_directory *pagedir;
+	struct mali_mmu_pagedir_range range;
 	_mali_osk_errcode_t err;
 	struct scatterlist *sg;
 	u32 virt, flags, unmap_dma_size;
@@ -68,12 +283,11 @@ static int mali_dma_buf_map(mali_mem_backend *mem_backend)
 	mem->map_ref++;
 
 	MALI_DEBUG_PRINT(5, ("Mali DMA-buf: map attachment %p, new map_ref = %d\n", mem, mem->map_ref));
-#if (!defined(CONFIG_MALI_DMA_BUF_MAP_ON_ATTACH)) && (defined(CONFIG_MALI_DMA_BUF_LAZY_MAP))
-	if (MALI_FALSE == mem->is_mapped)
-#else
-	if (1 == mem->map_ref)
+#if !defined(CONFIG_MALI_DMA_BUF_MAP_ON_ATTACH)
+	mali_dma_buf_cache_take(mem);
 #endif
-	{
+	/* Lazy and cached attachments stay mapped when no job references them */
+	if (MALI_FALSE == mem->is_mapped) {
 		/* First reference taken, so we need to map the dma buf */
 		MALI_DEBUG_ASSERT(!mem->is_mapped);
 
@@ -96,16 +310,21 @@ static int mali_dma_buf_map(mali_mem_backend *mem_backend)
 		pagedir = mali_session_get_page_directory(session);
 		MALI_DEBUG_ASSERT_POINTER(pagedir);
 
+		mali_mmu_pagedir_range_begin(&range, pagedir, virt, MALI_MMU_FLAGS_DEFAULT);
+
 		for_each_sg(mem->sgt->sgl, sg, mem->sgt->nents, i) {
 			u32 size = sg_dma_len(sg);
 			dma_addr_t phys = sg_dma_address(sg);
+			u32 offset;
 
 			unmap_dma_size -= size;
 			/* sg must be page aligned. */
 			MALI_DEBUG_ASSERT(0 == size % MALI_MMU_PAGE_SIZE);
 			MALI_DEBUG_ASSERT(0 == (phys & ~(uintptr_t)0xFFFFFFFF));
 
-			mali_mmu_pagedir_update(pagedir, virt, phys, size, MALI_MMU_FLAGS_DEFAULT);
+			for (offset = 0; offset < size; offset += MALI_MMU_PAGE_SIZE) {
+				mali_mmu_pagedir_range_add(&range, phys + offset);
+			}
 
 			virt += size;
 		}
@@ -115,9 +334,11 @@ static int mali_dma_buf_map(mali_mem_backend *mem_backend)
 			MALI_DEBUG_PRINT(7, ("Mapping in extra guard page\n"));
 
 			guard_phys = sg_dma_address(mem->sgt->sgl);
-			mali_mmu_pagedir_update(pagedir, virt, guard_phys, MALI_MMU_PAGE_SIZE, MALI_MMU_FLAGS_DEFAULT);
+			mali_mmu_pagedir_range_add(&range, guard_phys);
 		}
 
+		mali_mmu_pagedir_range_end(&range);
+
 		mem->is_mapped = MALI_TRUE;
 
 		if (0 != unmap_dma_size) {
@@ -138,7 +359,8 @@ static int mali_dma_buf_map(mali_mem_backend *mem_backend)
 	return 0;
 }
 
-static void mali_dma_buf_unmap(mali_mem_allocation *alloc, struct mali_dma_buf_attachment *mem)
+static void mali_dma_buf_unmap(mali_mem_allocation *alloc, struct mali_dma_buf_attachment *mem,
+			       struct mali_mmu_invalidate_batch *batch)
 {
 	MALI_DEBUG_ASSERT_POINTER(alloc);
 	MALI_DEBUG_ASSERT_POINTER(mem);
@@ -152,15 +374,12 @@ static void mali_dma_buf_unmap(mali_mem_allocation *alloc, struct mali_dma_buf_a
 	MALI_DEBUG_PRINT(5, ("Mali DMA-buf: unmap attachment %p, new map_ref = %d\n", mem, mem->map_ref));
 
 	if (0 == mem->map_ref) {
-		if (NULL != mem->sgt) {
-			dma_buf_unmap_attachment(mem->attachment, mem->sgt, DMA_BIDIRECTIONAL);
-			mem->sgt = NULL;
-		}
-		if (MALI_TRUE == mem->is_mapped) {
-			mali_mem_mali_map_free(alloc->session, alloc->psize, alloc->mali_vma_node.vm_node.start,
-					       alloc->flags);
+#if !defined(CONFIG_MALI_DMA_BUF_MAP_ON_ATTACH)
+		if (MALI_FALSE == mali_dma_buf_cache_put(mem))
+#endif
+		{
+			mali_dma_buf_release_mapping(alloc, mem, batch);
 		}
-		mem->is_mapped = MALI_FALSE;
 	}
 
 	/* Wake up any thread waiting for buffer to become unmapped */
@@ -174,37 +393,18 @@ int mali_dma_buf_map_job(struct mali_pp_job *job)
 {
 	struct mali_dma_buf_attachment *mem;
 	_mali_osk_errcode_t err;
-	int i;
+	u32 i;
 	int ret = 0;
-	u32 num_memory_cookies;
-	struct mali_session_data *session;
-	struct mali_vma_node *mali_vma_node = NULL;
-	mali_mem_allocation *mali_alloc = NULL;
+	u32 num_dma_buf_backends;
 	mali_mem_backend *mem_bkend = NULL;
 
 	MALI_DEBUG_ASSERT_POINTER(job);
 
-	num_memory_cookies = mali_pp_job_num_memory_cookies(job);
-
-	session = mali_pp_job_get_session(job);
-
-	MALI_DEBUG_ASSERT_POINTER(session);
-
-	for (i = 0; i < num_memory_cookies; i++) {
-		u32 mali_addr  = mali_pp_job_get_memory_cookie(job, i);
-		mali_vma_node = mali_vma_offset_search(&session->allocation_mgr, mali_addr, 0);
-		MALI_DEBUG_ASSERT(NULL != mali_vma_node);
-		mali_alloc = container_of(mali_vma_node, struct mali_mem_allocation, mali_vma_node);
-		MALI_DEBUG_ASSERT(NULL != mali_alloc);
-		if (MALI_MEM_DMA_BUF != mali_alloc->type) {
-			continue;
-		}
+	num_dma_buf_backends = mali_pp_job_num_dma_buf_backends(job);
 
-		/* Get backend memory & Map on CPU */
-		mutex_lock(&mali_idr_mutex);
-		mem_bkend = idr_find(&mali_backend_idr, mali_alloc->backend_handle);
-		mutex_unlock(&mali_idr_mutex);
-		MALI_DEBUG_ASSERT(NULL != mem_bkend);
+	for (i = 0; i < num_dma_buf_backends; i++) {
+		mem_bkend = mali_pp_job_get_dma_buf_backend(job, i);
+		MALI_DEBUG_ASSERT(MALI_MEM_DMA_BUF == mem_bkend->type);
 
 		mem = mem_bkend->dma_buf.attachment;
 
@@ -213,9 +413,9 @@ int mali_dma_buf_map_job(struct mali_pp_job *job)
 
 		err = mali_dma_buf_map(mem_bkend);
 		if (0 != err) {
-			MALI_DEBUG_PRINT_ERROR(("Mali DMA-buf: Failed to map dma-buf for mali address %x\n", mali_addr));
+			MALI_DEBUG_PRINT_ERROR(("Mali DMA-buf: Failed to map dma-buf for mali address %x\n",
+						mem_bkend->mali_allocation->mali_vma_node.vm_node.start));
 			ret = -EFAULT;
-			continue;
 		}
 	}
 	return ret;
@@ -224,42 +424,39 @@ int mali_dma_buf_map_job(struct mali_pp_job *job)
 void mali_dma_buf_unmap_job(struct mali_pp_job *job)
 {
 	struct mali_dma_buf_attachment *mem;
-	int i;
-	u32 num_memory_cookies;
+	u32 i;
+	u32 num_dma_buf_backends;
 	struct mali_session_data *session;
-	struct mali_vma_node *mali_vma_node = NULL;
-	mali_mem_allocation *mali_alloc = NULL;
 	mali_mem_backend *mem_bkend = NULL;
+	struct mali_mmu_invalidate_batch batch;
 
 	MALI_DEBUG_ASSERT_POINTER(job);
 
-	num_memory_cookies = mali_pp_job_num_memory_cookies(job);
+	num_dma_buf_backends = mali_pp_job_num_dma_buf_backends(job);
+	if (0 == num_dma_buf_backends) {
+		return;
+	}
 
 	session = mali_pp_job_get_session(job);
 
 	MALI_DEBUG_ASSERT_POINTER(session);
 
-	for (i = 0; i < num_memory_cookies; i++) {
-		u32 mali_addr  = mali_pp_job_get_memory_cookie(job, i);
-		mali_vma_node = mali_vma_offset_search(&session->allocation_mgr, mali_addr, 0);
-		MALI_DEBUG_ASSERT(NULL != mali_vma_node);
-		mali_alloc = container_of(mali_vma_node, struct mali_mem_allocation, mali_vma_node);
-		MALI_DEBUG_ASSERT(NULL != mali_alloc);
-		if (MALI_MEM_DMA_BUF != mali_alloc->type) {
-			continue;
-		}
+	/* Invalidate TLBs once for all buffers of the job. */
+	mali_mmu_invalidate_batch_init(&batch);
 
-		/* Get backend memory & Map on CPU */
-		mutex_lock(&mali_idr_mutex);
-		mem_bkend = idr_find(&mali_backend_idr, mali_alloc->backend_handle);
-		mutex_unlock(&mali_idr_mutex);
-		MALI_DEBUG_ASSERT(NULL != mem_bkend);
+	for (i = 0; i < num_dma_buf_backends; i++) {
+		mem_bkend = mali_pp_job_get_dma_buf_backend(job, i);
+		MALI_DEBUG_ASSERT(MALI_MEM_DMA_BUF == mem_bkend->type);
 
 		mem = mem_bkend->dma_buf.attachment;
 
 		MALI_DEBUG_ASSERT_POINTER(mem);
 		MALI_DEBUG_ASSERT(mem->session == mali_pp_job_get_session(job));
-		mali_dma_buf_unmap(mem_bkend->mali_allocation, mem);
+		mali_dma_buf_unmap(mem_bkend->mali_allocation, mem, &batch);
+	}
+
+	if (MALI_FALSE == mali_mmu_invalidate_batch_is_empty(&batch)) {
+		mali_executor_zap_all_active(session, &batch);
 	}
 }
 #endif /* !CONFIG_MALI_DMA_BUF_MAP_ON_ATTACH */
@@ -324,6 +521,11 @@ _mali_osk_errcode_t mali_mem_bind_dma_buf(mali_mem_allocation *alloc,
 
 	dma_mem->buf = buf;
 	dma_mem->session = session;
+	dma_mem->alloc = alloc;
+	INIT_LIST_HEAD(&dma_mem->cache_link);
+	if (flags & _MALI_MAP_EXTERNAL_MAP_CACHED) {
+		dma_mem->cached = MALI_TRUE;
+	}
 #if (!defined(CONFIG_MALI_DMA_BUF_MAP_ON_ATTACH)) && (defined(CONFIG_MALI_DMA_BUF_LAZY_MAP))
 	dma_mem->map_ref = 1;
 #else
@@ -355,7 +557,7 @@ _mali_osk_errcode_t mali_mem_bind_dma_buf(mali_mem_allocation *alloc,
 
 #if defined(CONFIG_MALI_DMA_BUF_MAP_ON_ATTACH)
 Failed_dma_map:
-	mali_dma_buf_unmap(alloc, dma_mem);
+	mali_dma_buf_unmap(alloc, dma_mem, NULL);
 #endif
 	/* Wait for buffer to become unmapped */
 	wait_event(dma_mem->wait_queue, !dma_mem->is_mapped);
@@ -387,7 +589,11 @@ void mali_mem_unbind_dma_buf(mali_mem_backend *mem_backend)
 
 #if (defined(CONFIG_MALI_DMA_BUF_MAP_ON_ATTACH)) ||((!defined(CONFIG_MALI_DMA_BUF_MAP_ON_ATTACH)) && (defined(CONFIG_MALI_DMA_BUF_LAZY_MAP)))
 	/* We mapped implicitly on attach, so we need to unmap on release */
-	mali_dma_buf_unmap(mem_backend->mali_allocation, mem);
+	mali_dma_buf_unmap(mem_backend->mali_allocation, mem, NULL);
+#endif
+#if !defined(CONFIG_MALI_DMA_BUF_MAP_ON_ATTACH)
+	/* Drop the mapping kept by the mapping cache */
+	mali_dma_buf_cache_evict(mem_backend->mali_allocation, mem);
 #endif
 	/* Wait for buffer to become unmapped */
 	wait_event(mem->wait_queue, !mem->is_mapped);
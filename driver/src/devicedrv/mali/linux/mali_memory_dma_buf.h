@@ -27,9 +27,12 @@ struct mali_dma_buf_attachment {
 	struct dma_buf_attachment *attachment;
 	struct sg_table *sgt;
 	struct mali_session_data *session;
+	mali_mem_allocation *alloc;
 	int map_ref;
 	struct mutex map_lock;
 	mali_bool is_mapped;
+	mali_bool cached; /* Keep mapped when no job uses it, see _MALI_MAP_EXTERNAL_MAP_CACHED */
+	struct list_head cache_link; /* On the mapping cache LRU while mapped and not used by any job */
 	wait_queue_head_t wait_queue;
 };
 
@@ -44,6 +47,15 @@ _mali_osk_errcode_t mali_mem_bind_dma_buf(mali_mem_allocation *alloc,
 #if !defined(CONFIG_MALI_DMA_BUF_MAP_ON_ATTACH)
 int mali_dma_buf_map_job(struct mali_pp_job *job);
 void mali_dma_buf_unmap_job(struct mali_pp_job *job);
+
+/*
+ * Cache of dma-buf mappings kept between jobs, for buffers attached with
+ * _MALI_MAP_EXTERNAL_MAP_CACHED. Idle mappings are evicted under memory pressure.
+ */
+void mali_dma_buf_cache_init(void);
+void mali_dma_buf_cache_term(void);
+void mali_dma_buf_cache_print_stats(_mali_osk_print_ctx *print_ctx);
+void mali_dma_buf_cache_reset_stats(void);
 #endif
 
 #ifdef __cplusplus
@@ -28,7 +28,7 @@ void mali_mem_unbind_ext_buf(mali_mem_backend *mem_backend)
 	MALI_DEBUG_ASSERT_POINTER(session);
 	mali_session_memory_lock(session);
 	mali_mem_mali_map_free(session, alloc->psize, alloc->mali_vma_node.vm_node.start,
-			       alloc->flags);
+			       alloc->flags, NULL);
 	mali_session_memory_unlock(session);
 }
 
@@ -22,6 +22,9 @@
 #include <linux/dma-buf.h>
 #endif
 #include <linux/idr.h>
+#include <linux/rcupdate.h>
+#include <linux/kthread.h>
+#include <linux/completion.h>
 
 #include "mali_osk.h"
 #include "mali_osk_mali.h"
@@ -44,6 +47,8 @@
 #include "mali_memory_block_alloc.h"
 #include "mali_ukk.h"
 #include "mali_memory_swap_alloc.h"
+#include "mali_memory_sparse.h"
+#include "mali_memory_purgeable.h"
 
 /*
 * New memory system interface
@@ -51,6 +56,7 @@
 
 /*inti idr for backend memory */
 struct idr mali_backend_idr;
+/* Serializes changes to mali_backend_idr, lookups only need rcu_read_lock() */
 struct mutex mali_idr_mutex;
 
 /* init allocation manager */
@@ -66,6 +72,8 @@ int mali_memory_manager_init(struct mali_allocation_manager *mgr)
 	/* init RB tree */
 	mgr->allocation_mgr_rb = RB_ROOT;
 	mgr->mali_allocation_num = 0;
+
+	mali_vma_allocator_init(mgr);
 	return 0;
 }
 
@@ -78,6 +86,8 @@ void mali_memory_manager_uninit(struct mali_allocation_manager *mgr)
 	MALI_DEBUG_ASSERT(((void *)(mgr->allocation_mgr_rb.rb_node) == (void *)rb_last(&mgr->allocation_mgr_rb)));
 	/* check allocation List */
 	MALI_DEBUG_ASSERT(list_empty(&mgr->head));
+
+	mali_vma_allocator_term(mgr);
 }
 
 /* Prepare memory descriptor */
@@ -136,8 +146,10 @@ int mali_mem_backend_struct_create(mali_mem_backend **backend, u32 psize)
 	}
 	mem_backend = *backend;
 	mem_backend->size = psize;
+	atomic_set(&mem_backend->ref_count, 1);
 	mutex_init(&mem_backend->mutex);
 	INIT_LIST_HEAD(&mem_backend->list);
+	INIT_LIST_HEAD(&mem_backend->purge_link);
 	mem_backend->using_count = 0;
 
 
@@ -173,17 +185,157 @@ again:
 }
 
 
-static void mali_mem_backend_struct_destory(mali_mem_backend **backend, s32 backend_handle)
+/* Remove the backend from the idr and drop the allocation's reference to it */
+void mali_mem_backend_struct_destory(mali_mem_backend **backend, s32 backend_handle)
 {
 	mali_mem_backend *mem_backend = *backend;
 
 	mutex_lock(&mali_idr_mutex);
 	idr_remove(&mali_backend_idr, backend_handle);
 	mutex_unlock(&mali_idr_mutex);
-	kfree(mem_backend);
+	mali_mem_backend_put(mem_backend);
 	*backend = NULL;
 }
 
+mali_mem_backend *mali_mem_backend_get(s32 backend_handle)
+{
+	mali_mem_backend *mem_backend;
+
+	rcu_read_lock();
+	mem_backend = idr_find(&mali_backend_idr, backend_handle);
+	if (NULL != mem_backend && !atomic_inc_not_zero(&mem_backend->ref_count)) {
+		/* Being destroyed */
+		mem_backend = NULL;
+	}
+	rcu_read_unlock();
+
+	return mem_backend;
+}
+
+void mali_mem_backend_put(mali_mem_backend *mem_backend)
+{
+	MALI_DEBUG_ASSERT_POINTER(mem_backend);
+
+	if (atomic_dec_and_test(&mem_backend->ref_count)) {
+		/* A lookup may still be looking at it under rcu_read_lock() */
+		kfree_rcu(mem_backend, rcu);
+	}
+}
+
+/* Number of backends the lookup benchmark spreads its lookups over */
+#define MALI_MEM_BACKEND_BENCHMARK_HANDLES 64
+
+struct mali_mem_backend_benchmark {
+	mali_mem_backend *backends[MALI_MEM_BACKEND_BENCHMARK_HANDLES];
+	s32 handles[MALI_MEM_BACKEND_BENCHMARK_HANDLES];
+	u32 lookups_per_thread;
+	mali_bool use_mutex;
+	atomic_t running;
+	struct completion done;
+};
+
+static int mali_mem_backend_benchmark_thread(void *data)
+{
+	struct mali_mem_backend_benchmark *bench = data;
+	mali_mem_backend *mem_backend;
+	u32 i;
+
+	for (i = 0; i < bench->lookups_per_thread; i++) {
+		s32 handle = bench->handles[i % MALI_MEM_BACKEND_BENCHMARK_HANDLES];
+
+		if (bench->use_mutex) {
+			mutex_lock(&mali_idr_mutex);
+			mem_backend = idr_find(&mali_backend_idr, handle);
+			mutex_unlock(&mali_idr_mutex);
+		} else {
+			mem_backend = mali_mem_backend_get(handle);
+			if (NULL != mem_backend) {
+				mali_mem_backend_put(mem_backend);
+			}
+		}
+		MALI_DEBUG_ASSERT(NULL != mem_backend);
+
+		if (0 == (i & 1023)) {
+			cond_resched();
+		}
+	}
+
+	if (atomic_dec_and_test(&bench->running)) {
+		complete(&bench->done);
+	}
+
+	return 0;
+}
+
+static int mali_mem_backend_benchmark_run(struct mali_mem_backend_benchmark *bench, u32 num_threads,
+		mali_bool use_mutex, u64 *ns)
+{
+	struct task_struct *thread;
+	u64 start;
+	u32 i;
+
+	bench->use_mutex = use_mutex;
+	/* Hold one count ourselves until all threads are started */
+	atomic_set(&bench->running, 1);
+	init_completion(&bench->done);
+
+	start = _mali_osk_time_get_ns();
+	for (i = 0; i < num_threads; i++) {
+		atomic_inc(&bench->running);
+		thread = kthread_run(mali_mem_backend_benchmark_thread, bench, "mali_lookup_bench");
+		if (IS_ERR(thread)) {
+			atomic_dec(&bench->running);
+			break;
+		}
+	}
+
+	if (!atomic_dec_and_test(&bench->running)) {
+		wait_for_completion(&bench->done);
+	}
+	*ns = _mali_osk_time_get_ns() - start;
+
+	return (i == num_threads) ? 0 : -ENOMEM;
+}
+
+int mali_mem_backend_lookup_benchmark(u32 num_threads, u32 lookups_per_thread, u64 *rcu_ns, u64 *mutex_ns)
+{
+	struct mali_mem_backend_benchmark *bench;
+	int err = 0;
+	u32 i;
+
+	MALI_DEBUG_ASSERT_POINTER(rcu_ns);
+	MALI_DEBUG_ASSERT_POINTER(mutex_ns);
+
+	bench = kzalloc(sizeof(*bench), GFP_KERNEL);
+	if (NULL == bench) {
+		return -ENOMEM;
+	}
+	bench->lookups_per_thread = lookups_per_thread;
+
+	for (i = 0; i < MALI_MEM_BACKEND_BENCHMARK_HANDLES; i++) {
+		bench->handles[i] = mali_mem_backend_struct_create(&bench->backends[i], 0);
+		if (0 > bench->handles[i]) {
+			err = bench->handles[i];
+			break;
+		}
+	}
+
+	if (0 == err) {
+		err = mali_mem_backend_benchmark_run(bench, num_threads, MALI_FALSE, rcu_ns);
+	}
+	if (0 == err) {
+		err = mali_mem_backend_benchmark_run(bench, num_threads, MALI_TRUE, mutex_ns);
+	}
+
+	while (0 < i--) {
+		mali_mem_backend_struct_destory(&bench->backends[i], bench->handles[i]);
+	}
+
+	kfree(bench);
+
+	return err;
+}
+
 mali_mem_backend *mali_mem_backend_struct_search(struct mali_session_data *session, u32 mali_address)
 {
 	struct mali_vma_node *mali_vma_node = NULL;
@@ -197,13 +349,106 @@ mali_mem_backend *mali_mem_backend_struct_search(struct mali_session_data *sessi
 	}
 	mali_alloc = container_of(mali_vma_node, struct mali_mem_allocation, mali_vma_node);
 	/* Get backend memory & Map on CPU */
-	mutex_lock(&mali_idr_mutex);
-	mem_bkend = idr_find(&mali_backend_idr, mali_alloc->backend_handle);
-	mutex_unlock(&mali_idr_mutex);
+	mem_bkend = mali_mem_backend_get(mali_alloc->backend_handle);
 	MALI_DEBUG_ASSERT(NULL != mem_bkend);
 	return mem_bkend;
 }
 
+static mali_bool mali_mem_backend_is_swappable(mali_mem_backend *mem_bkend)
+{
+	if (MALI_MEM_SWAP == mem_bkend->type) {
+		return MALI_TRUE;
+	}
+
+	return (MALI_MEM_COW == mem_bkend->type) && (mem_bkend->flags & MALI_MEM_BACKEND_FLAG_SWAP_COWED);
+}
+
+_mali_osk_errcode_t mali_mem_backend_resolve_job(struct mali_pp_job *job, const u32 *cookies)
+{
+	struct mali_session_data *session;
+	mali_mem_allocation *mali_alloc;
+	mali_mem_backend *mem_bkend;
+	mali_mem_backend **backends;
+	u32 num_cookies;
+	u32 num_dma_buf = 0;
+	u32 i;
+
+	MALI_DEBUG_ASSERT_POINTER(job);
+	MALI_DEBUG_ASSERT_POINTER(cookies);
+	MALI_DEBUG_ASSERT(NULL == job->memory_backends);
+
+	session = mali_pp_job_get_session(job);
+	num_cookies = mali_pp_job_num_memory_cookies(job);
+
+	backends = _mali_osk_malloc(sizeof(*backends) * num_cookies);
+	if (NULL == backends) {
+		return _MALI_OSK_ERR_NOMEM;
+	}
+	job->memory_backends = backends;
+
+	/* Swappable backends are gathered from the front and dma-buf ones from the back */
+	for (i = 0; i < num_cookies; i++) {
+		/* Referenced in the lookup, so a concurrent free can't release the allocation under us */
+		mali_alloc = mali_vma_offset_search_ref(&session->allocation_mgr, cookies[i]);
+		if (NULL == mali_alloc) {
+			MALI_PRINT_ERROR(("Mali PP job: failed to find allocation through Mali address: 0x%08x.\n", cookies[i]));
+			job->memory_cookies_invalid = MALI_TRUE;
+			continue;
+		}
+
+		mem_bkend = mali_mem_backend_get(mali_alloc->backend_handle);
+		if (NULL == mem_bkend) {
+			job->memory_cookies_invalid = MALI_TRUE;
+			mali_allocation_unref(&mali_alloc);
+			continue;
+		}
+
+		if (MALI_TRUE == mali_mem_backend_is_swappable(mem_bkend)) {
+			backends[job->num_swap_backends++] = mem_bkend;
+		} else if (MALI_MEM_DMA_BUF == mem_bkend->type) {
+			backends[num_cookies - ++num_dma_buf] = mem_bkend;
+		} else {
+			/* Nothing does anything with the other backends while the job runs */
+			mali_mem_backend_put(mem_bkend);
+			mali_allocation_unref(&mali_alloc);
+			continue;
+		}
+
+		/* The allocation keeps the backend alive, and is not freed until the job is deleted */
+		mali_mem_backend_put(mem_bkend);
+	}
+
+	if (0 < num_dma_buf) {
+		memmove(&backends[job->num_swap_backends], &backends[num_cookies - num_dma_buf],
+			sizeof(*backends) * num_dma_buf);
+		job->num_dma_buf_backends = num_dma_buf;
+	}
+
+	return _MALI_OSK_ERR_OK;
+}
+
+void mali_mem_backend_release_job(struct mali_pp_job *job)
+{
+	mali_mem_allocation *mali_alloc;
+	u32 i;
+
+	MALI_DEBUG_ASSERT_POINTER(job);
+
+	if (NULL == job->memory_backends) {
+		return;
+	}
+
+	for (i = 0; i < job->num_swap_backends + job->num_dma_buf_backends; i++) {
+		mali_alloc = job->memory_backends[i]->mali_allocation;
+		mali_allocation_unref(&mali_alloc);
+	}
+
+	_mali_osk_free(job->memory_backends);
+	job->memory_backends = NULL;
+	job->num_swap_backends = 0;
+	job->num_dma_buf_backends = 0;
+}
+
 static _mali_osk_errcode_t mali_mem_resize(struct mali_session_data *session, mali_mem_backend *mem_backend, u32 physical_size)
 {
 	_mali_osk_errcode_t ret = _MALI_OSK_ERR_FAULT;
@@ -220,7 +465,11 @@ static _mali_osk_errcode_t mali_mem_resize(struct mali_session_data *session, ma
 	mali_allocation = mem_backend->mali_allocation;
 	MALI_DEBUG_ASSERT_POINTER(mali_allocation);
 
-	MALI_DEBUG_ASSERT(MALI_MEM_FLAG_CAN_RESIZE & mali_allocation->flags);
+	/* Growable heaps and sparse memory change size by other means */
+	if (!(MALI_MEM_FLAG_CAN_RESIZE & mali_allocation->flags)) {
+		MALI_DEBUG_PRINT(2, ("_mali_ukk_mem_resize: memory not allocated resizeable!\n"));
+		return _MALI_OSK_ERR_INVALID_ARGS;
+	}
 	MALI_DEBUG_ASSERT(MALI_MEM_OS == mali_allocation->type);
 
 	mutex_lock(&mem_backend->mutex);
@@ -302,7 +551,7 @@ static _mali_osk_errcode_t mali_mem_resize(struct mali_session_data *session, ma
 
 		/* Resize mali map */
 		_mali_osk_mutex_wait(session->memory_lock);
-		mali_mem_mali_map_free(session, dec_size, vaddr, mali_allocation->flags);
+		mali_mem_mali_map_free(session, dec_size, vaddr, mali_allocation->flags, NULL);
 		_mali_osk_mutex_signal(session->memory_lock);
 
 		/* Zap cpu mapping */
@@ -385,13 +634,13 @@ _mali_osk_errcode_t mali_mem_add_mem_size(struct mali_session_data *session, u32
 
 	new_physical_size = add_size + mem_backend->size;
 
-	if (new_physical_size > (mali_allocation->mali_vma_node.vm_node.size))
-		return ret;
+	if (new_physical_size <= (mali_allocation->mali_vma_node.vm_node.size)) {
+		MALI_DEBUG_ASSERT(new_physical_size != mem_backend->size);
 
-	MALI_DEBUG_ASSERT(new_physical_size != mem_backend->size);
-
-	ret = mali_mem_resize(session, mem_backend, new_physical_size);
+		ret = mali_mem_resize(session, mem_backend, new_physical_size);
+	}
 
+	mali_mem_backend_put(mem_backend);
 	return ret;
 }
 
@@ -418,6 +667,24 @@ _mali_osk_errcode_t _mali_ukk_mem_allocate(_mali_uk_alloc_mem_s *args)
 	} else if ((args->vsize != args->psize) && ((args->flags & _MALI_MEMORY_ALLOCATE_SWAPPABLE) || (args->flags & _MALI_MEMORY_ALLOCATE_SECURE))) {
 		MALI_PRINT_ERROR(("_mali_ukk_mem_allocate: not supported mem resizeable for mem flag %d\n",  args->flags));
 		return _MALI_OSK_ERR_INVALID_ARGS;
+	} else if ((args->flags & _MALI_MEMORY_ALLOCATE_GROWABLE) && ((0 == args->psize) ||
+			(args->flags & (_MALI_MEMORY_ALLOCATE_SWAPPABLE | _MALI_MEMORY_ALLOCATE_SECURE | _MALI_MEMORY_ALLOCATE_RESIZEABLE |
+					_MALI_MEMORY_ALLOCATE_DEFER_BIND | _MALI_MEMORY_ALLOCATE_NO_BIND_GPU)))) {
+		MALI_PRINT_ERROR(("_mali_ukk_mem_allocate: not supported growable heap for mem flag %d, psize %d\n",  args->flags, args->psize));
+		return _MALI_OSK_ERR_INVALID_ARGS;
+	} else if ((args->flags & _MALI_MEMORY_ALLOCATE_SPARSE) && ((0 != args->psize) || (0 == args->vsize) ||
+			(args->flags & (_MALI_MEMORY_ALLOCATE_SWAPPABLE | _MALI_MEMORY_ALLOCATE_SECURE | _MALI_MEMORY_ALLOCATE_RESIZEABLE |
+					_MALI_MEMORY_ALLOCATE_DEFER_BIND | _MALI_MEMORY_ALLOCATE_NO_BIND_GPU | _MALI_MEMORY_ALLOCATE_GROWABLE)))) {
+		MALI_PRINT_ERROR(("_mali_ukk_mem_allocate: not supported sparse memory for mem flag %d, psize %d\n",  args->flags, args->psize));
+		return _MALI_OSK_ERR_INVALID_ARGS;
+	}
+
+	if (args->flags & _MALI_MEMORY_ALLOCATE_KERNEL_VA) {
+		retval = mali_vma_offset_alloc(&session->allocation_mgr, args->vsize, &args->gpu_vaddr);
+		if (retval) {
+			MALI_DEBUG_PRINT(2, ("_mali_ukk_mem_allocate: can't place 0x%x bytes in Mali address space\n", args->vsize));
+			return (-ENOMEM == retval) ? _MALI_OSK_ERR_NOMEM : _MALI_OSK_ERR_INVALID_ARGS;
+		}
 	}
 
 	/* Check if the address is allocated
@@ -426,7 +693,8 @@ _mali_osk_errcode_t _mali_ukk_mem_allocate(_mali_uk_alloc_mem_s *args)
 
 	if (unlikely(mali_vma_node)) {
 		MALI_DEBUG_PRINT_ERROR(("The mali virtual address has already been used ! \n"));
-		return _MALI_OSK_ERR_FAULT;
+		ret = _MALI_OSK_ERR_FAULT;
+		goto failed_alloc_struct;
 	}
 	/**
 	*create mali memory allocation
@@ -436,7 +704,8 @@ _mali_osk_errcode_t _mali_ukk_mem_allocate(_mali_uk_alloc_mem_s *args)
 
 	if (mali_allocation == NULL) {
 		MALI_DEBUG_PRINT(1, ("_mali_ukk_mem_allocate: Failed to create allocation struct! \n"));
-		return _MALI_OSK_ERR_NOMEM;
+		ret = _MALI_OSK_ERR_NOMEM;
+		goto failed_alloc_struct;
 	}
 	mali_allocation->psize = args->psize;
 	mali_allocation->vsize = args->vsize;
@@ -448,6 +717,12 @@ _mali_osk_errcode_t _mali_ukk_mem_allocate(_mali_uk_alloc_mem_s *args)
 	 */
 	if (args->flags & _MALI_MEMORY_ALLOCATE_SWAPPABLE) {
 		mali_allocation->type = MALI_MEM_SWAP;
+	} else if (args->flags & _MALI_MEMORY_ALLOCATE_SPARSE) {
+		mali_allocation->type = MALI_MEM_SPARSE;
+	} else if (args->flags & _MALI_MEMORY_ALLOCATE_GROWABLE) {
+		/* Only grown by mali_mem_defer_heap_grow(), never resized by user space */
+		mali_allocation->type = MALI_MEM_OS;
+		mali_allocation->flags |= MALI_MEM_FLAG_GROWABLE;
 	} else if (args->flags & _MALI_MEMORY_ALLOCATE_RESIZEABLE) {
 		mali_allocation->type = MALI_MEM_OS;
 		mali_allocation->flags |= MALI_MEM_FLAG_CAN_RESIZE;
@@ -459,11 +734,17 @@ _mali_osk_errcode_t _mali_ukk_mem_allocate(_mali_uk_alloc_mem_s *args)
 		mali_allocation->type = MALI_MEM_OS;
 	}
 
+	if (args->flags & _MALI_MEMORY_ALLOCATE_NO_BIND_GPU) {
+		mali_allocation->flags |= MALI_MEM_FLAG_NO_BIND_GPU;
+	}
+
 	/**
 	*add allocation node to RB tree for index
 	*/
 	mali_allocation->mali_vma_node.vm_node.start = args->gpu_vaddr;
 	mali_allocation->mali_vma_node.vm_node.size = args->vsize;
+	/* Freed by mali_vma_offset_remove() from now on */
+	mali_allocation->mali_vma_node.vm_node.kernel_placed = (args->flags & _MALI_MEMORY_ALLOCATE_KERNEL_VA) ? 1 : 0;
 
 	mali_vma_offset_add(&session->allocation_mgr, &mali_allocation->mali_vma_node);
 
@@ -483,7 +764,7 @@ _mali_osk_errcode_t _mali_ukk_mem_allocate(_mali_uk_alloc_mem_s *args)
 	/* set gpu mmu propery */
 	_mali_memory_gpu_map_property_set(&mali_allocation->mali_mapping.properties, args->flags);
 	/* do prepare for MALI mapping */
-	if (!(args->flags & _MALI_MEMORY_ALLOCATE_NO_BIND_GPU) && mali_allocation->psize > 0) {
+	if (!(args->flags & _MALI_MEMORY_ALLOCATE_NO_BIND_GPU) && mali_mem_mali_map_size(mali_allocation) > 0) {
 		_mali_osk_mutex_wait(session->memory_lock);
 
 		ret = mali_mem_mali_map_prepare(mali_allocation);
@@ -494,6 +775,21 @@ _mali_osk_errcode_t _mali_ukk_mem_allocate(_mali_uk_alloc_mem_s *args)
 		_mali_osk_mutex_signal(session->memory_lock);
 	}
 
+	if (MALI_MEM_SPARSE == mem_backend->type) {
+		/* Covers the whole virtual range, with every page unbound */
+		mem_backend->size = mali_allocation->vsize;
+		ret = mali_mem_sparse_alloc(&mem_backend->sparse_mem, mem_backend->size);
+		if (_MALI_OSK_ERR_OK != ret) {
+			goto failed_alloc_pages;
+		}
+
+		_mali_osk_mutex_wait(session->memory_lock);
+		mali_mem_sparse_mali_map(&mem_backend->sparse_mem, session, args->gpu_vaddr, 0,
+					 mem_backend->sparse_mem.num_pages, mali_allocation->mali_mapping.properties);
+		_mali_osk_mutex_signal(session->memory_lock);
+		goto done;
+	}
+
 	if (mali_allocation->psize == 0) {
 		mem_backend->os_mem.count = 0;
 		INIT_LIST_HEAD(&mem_backend->os_mem.pages);
@@ -587,6 +883,8 @@ done:
 		atomic_add(mem_backend->block_mem.count, &session->mali_mem_allocated_pages);
 	} else if (MALI_MEM_SECURE == mem_backend->type) {
 		atomic_add(mem_backend->secure_mem.count, &session->mali_mem_allocated_pages);
+	} else if (MALI_MEM_SPARSE == mem_backend->type) {
+		/* Pages are accounted as they are bound */
 	} else {
 		MALI_DEBUG_ASSERT(MALI_MEM_SWAP == mem_backend->type);
 		atomic_add(mem_backend->swap_mem.count, &session->mali_mem_allocated_pages);
@@ -599,7 +897,7 @@ done:
 	return _MALI_OSK_ERR_OK;
 
 failed_alloc_pages:
-	mali_mem_mali_map_free(session, mali_allocation->psize, mali_allocation->mali_vma_node.vm_node.start, mali_allocation->flags);
+	mali_mem_mali_map_free(session, mali_mem_mali_map_size(mali_allocation), mali_allocation->mali_vma_node.vm_node.start, mali_allocation->flags, NULL);
 failed_prepare_map:
 	mali_mem_backend_struct_destory(&mem_backend, mali_allocation->backend_handle);
 failed_alloc_backend:
@@ -607,6 +905,13 @@ failed_alloc_backend:
 	mali_vma_offset_remove(&session->allocation_mgr, &mali_allocation->mali_vma_node);
 	mali_mem_allocation_struct_destory(mali_allocation);
 
+	return ret;
+
+failed_alloc_struct:
+	if (args->flags & _MALI_MEMORY_ALLOCATE_KERNEL_VA) {
+		mali_vma_offset_free(&session->allocation_mgr, args->gpu_vaddr, args->vsize);
+	}
+
 	return ret;
 }
 
@@ -821,17 +1126,29 @@ _mali_osk_errcode_t _mali_ukk_mem_cow(_mali_uk_cow_mem_s *args)
 	if (NULL == target_backend || 0 == target_backend->size) {
 		MALI_DEBUG_ASSERT_POINTER(target_backend);
 		MALI_DEBUG_ASSERT(0 != target_backend->size);
+		if (NULL != target_backend) {
+			mali_mem_backend_put(target_backend);
+		}
 		return ret;
 	}
 
 	/*Cow not support resized mem */
 	MALI_DEBUG_ASSERT(MALI_MEM_FLAG_CAN_RESIZE != (MALI_MEM_FLAG_CAN_RESIZE & target_backend->mali_allocation->flags));
 
+	/* Nor growable heaps, sparse or purgeable memory, their pages change under the GP */
+	if ((MALI_MEM_FLAG_GROWABLE & target_backend->mali_allocation->flags) || (MALI_MEM_SPARSE == target_backend->type) ||
+	    ((MALI_MEM_BACKEND_FLAG_PURGEABLE | MALI_MEM_BACKEND_FLAG_PURGED) & target_backend->flags)) {
+		MALI_DEBUG_PRINT(1, ("_mali_ukk_mem_cow: can't cow a growable heap, sparse or purgeable memory!\n"));
+		mali_mem_backend_put(target_backend);
+		return ret;
+	}
+
 	/* Check if the new mali address is allocated */
 	mali_vma_node = mali_vma_offset_search(&session->allocation_mgr, args->vaddr, 0);
 
 	if (unlikely(mali_vma_node)) {
 		MALI_DEBUG_PRINT_ERROR(("The mali virtual address has already been used ! \n"));
+		mali_mem_backend_put(target_backend);
 		return ret;
 	}
 
@@ -839,6 +1156,7 @@ _mali_osk_errcode_t _mali_ukk_mem_cow(_mali_uk_cow_mem_s *args)
 	mali_allocation = mali_mem_allocation_struct_create(session);
 	if (mali_allocation == NULL) {
 		MALI_DEBUG_PRINT(1, ("_mali_ukk_mem_cow: Failed to create allocation struct!\n"));
+		mali_mem_backend_put(target_backend);
 		return _MALI_OSK_ERR_NOMEM;
 	}
 	mali_allocation->psize = args->target_size;
@@ -919,6 +1237,7 @@ _mali_osk_errcode_t _mali_ukk_mem_cow(_mali_uk_cow_mem_s *args)
 	if (atomic_read(&session->mali_mem_allocated_pages) * MALI_MMU_PAGE_SIZE > session->max_mali_mem_allocated_size) {
 		session->max_mali_mem_allocated_size = atomic_read(&session->mali_mem_allocated_pages) * MALI_MMU_PAGE_SIZE;
 	}
+	mali_mem_backend_put(target_backend);
 	return _MALI_OSK_ERR_OK;
 
 failed_gpu_map:
@@ -930,6 +1249,7 @@ failed_do_cow:
 failed_alloc_backend:
 	mali_vma_offset_remove(&session->allocation_mgr, &mali_allocation->mali_vma_node);
 	mali_mem_allocation_struct_destory(mali_allocation);
+	mali_mem_backend_put(target_backend);
 
 	return ret;
 }
@@ -947,23 +1267,30 @@ _mali_osk_errcode_t _mali_ukk_mem_cow_modify_range(_mali_uk_cow_modify_range_s *
 	if (NULL == mem_backend || 0 == mem_backend->size) {
 		MALI_DEBUG_ASSERT_POINTER(mem_backend);
 		MALI_DEBUG_ASSERT(0 != mem_backend->size);
+		if (NULL != mem_backend) {
+			mali_mem_backend_put(mem_backend);
+		}
 		return ret;
 	}
 
 	if (MALI_MEM_COW  != mem_backend->type) {
 		MALI_PRINT_ERROR(("_mali_ukk_mem_cow_modify_range: not supported for memory type %d !\n", mem_backend->type));
+		mali_mem_backend_put(mem_backend);
 		return _MALI_OSK_ERR_FAULT;
 	}
 
 	ret =  mali_memory_cow_modify_range(mem_backend, args->range_start, args->size);
 	args->change_pages_nr = mem_backend->cow_mem.change_pages_nr;
-	if (_MALI_OSK_ERR_OK != ret)
+	if (_MALI_OSK_ERR_OK != ret) {
+		mali_mem_backend_put(mem_backend);
 		return  ret;
+	}
 	_mali_osk_mutex_wait(session->memory_lock);
 	if (!(mem_backend->flags & MALI_MEM_BACKEND_FLAG_SWAP_COWED)) {
 		mali_mem_cow_mali_map(mem_backend, args->range_start, args->size);
 	}
 	_mali_osk_mutex_signal(session->memory_lock);
+	mali_mem_backend_put(mem_backend);
 
 	atomic_add(args->change_pages_nr, &session->mali_mem_allocated_pages);
 	if (atomic_read(&session->mali_mem_allocated_pages) * MALI_MMU_PAGE_SIZE > session->max_mali_mem_allocated_size) {
@@ -997,6 +1324,80 @@ _mali_osk_errcode_t _mali_ukk_mem_resize(_mali_uk_mem_resize_s *args)
 
 	ret = mali_mem_resize(session, mem_backend, args->psize);
 
+	mali_mem_backend_put(mem_backend);
+	return ret;
+}
+
+_mali_osk_errcode_t _mali_ukk_mem_sparse_bind(_mali_uk_mem_sparse_bind_s *args)
+{
+	mali_mem_backend *mem_backend = NULL;
+	_mali_osk_errcode_t ret = _MALI_OSK_ERR_OK;
+	struct  mali_session_data *session = (struct mali_session_data *)(uintptr_t)args->ctx;
+
+	MALI_DEBUG_ASSERT_POINTER(session);
+
+	if ((args->offset % MALI_MMU_PAGE_SIZE) || (args->size % MALI_MMU_PAGE_SIZE) || (0 == args->size)) {
+		MALI_DEBUG_PRINT(2, ("_mali_ukk_mem_sparse_bind: range not page aligned!\n"));
+		return _MALI_OSK_ERR_INVALID_ARGS;
+	}
+
+	mem_backend = mali_mem_backend_struct_search(session, args->vaddr);
+	if (NULL == mem_backend) {
+		MALI_DEBUG_PRINT(2, ("_mali_ukk_mem_sparse_bind: memory backend = NULL!\n"));
+		return _MALI_OSK_ERR_FAULT;
+	}
+
+	if ((MALI_MEM_SPARSE != mem_backend->type) || (args->offset > mem_backend->size) ||
+	    (args->size > mem_backend->size - args->offset)) {
+		MALI_DEBUG_PRINT(2, ("_mali_ukk_mem_sparse_bind: not sparse memory, or range out of it!\n"));
+		mali_mem_backend_put(mem_backend);
+		return _MALI_OSK_ERR_INVALID_ARGS;
+	}
+
+	if (args->flags & _MALI_MEMORY_SPARSE_UNBIND) {
+		ret = mali_mem_sparse_unbind(mem_backend, args->offset / MALI_MMU_PAGE_SIZE, args->size / MALI_MMU_PAGE_SIZE);
+	} else {
+		ret = mali_mem_sparse_bind(mem_backend, args->offset / MALI_MMU_PAGE_SIZE, args->size / MALI_MMU_PAGE_SIZE);
+	}
+
+	mali_mem_backend_put(mem_backend);
+	return ret;
+}
+
+_mali_osk_errcode_t _mali_ukk_mem_madvise(_mali_uk_mem_madvise_s *args)
+{
+	mali_mem_backend *mem_backend = NULL;
+	mali_mem_allocation *mali_allocation;
+	mali_bool retained = MALI_TRUE;
+	_mali_osk_errcode_t ret;
+	struct  mali_session_data *session = (struct mali_session_data *)(uintptr_t)args->ctx;
+
+	MALI_DEBUG_ASSERT_POINTER(session);
+
+	if (_MALI_MEM_MADVISE_WILLNEED != args->advice && _MALI_MEM_MADVISE_DONTNEED != args->advice) {
+		return _MALI_OSK_ERR_INVALID_ARGS;
+	}
+
+	mem_backend = mali_mem_backend_struct_search(session, args->vaddr);
+	if (NULL == mem_backend) {
+		MALI_DEBUG_PRINT(2, ("_mali_ukk_mem_madvise: memory backend = NULL!\n"));
+		return _MALI_OSK_ERR_FAULT;
+	}
+
+	/* Only OS memory mapped on Mali at allocation, and whose pages don't change otherwise */
+	mali_allocation = mem_backend->mali_allocation;
+	if ((MALI_MEM_OS != mem_backend->type) || (0 == mali_allocation->psize) ||
+	    ((MALI_MEM_FLAG_CAN_RESIZE | MALI_MEM_FLAG_GROWABLE | MALI_MEM_FLAG_NO_BIND_GPU | _MALI_MEMORY_ALLOCATE_DEFER_BIND) & mali_allocation->flags) ||
+	    (MALI_MEM_BACKEND_FLAG_COWED & mem_backend->flags)) {
+		MALI_DEBUG_PRINT(2, ("_mali_ukk_mem_madvise: memory can't be made purgeable!\n"));
+		mali_mem_backend_put(mem_backend);
+		return _MALI_OSK_ERR_INVALID_ARGS;
+	}
+
+	ret = mali_mem_purgeable_advise(mem_backend, args->advice, &retained);
+	args->retained = (MALI_TRUE == retained) ? 1 : 0;
+
+	mali_mem_backend_put(mem_backend);
 	return ret;
 }
 
@@ -1015,6 +1416,8 @@ _mali_osk_errcode_t _mali_ukk_mem_usage_get(_mali_uk_profiling_memory_usage_get_
 
 		if (MALI_MEM_COW == mem_backend->type)
 			args->change_pages_nr = mem_backend->cow_mem.change_pages_nr;
+
+		mali_mem_backend_put(mem_backend);
 	}
 	return _MALI_OSK_ERR_OK;
 }
@@ -20,6 +20,25 @@
 #include "mali_memory_types.h"
 #include "mali_memory_os_alloc.h"
 #include "mali_uk_types.h"
+#include "mali_mmu_page_directory.h"
+
+struct mali_pp_job;
+struct mali_vma_chunk;
+
+/* Mali address range _MALI_MEMORY_ALLOCATE_KERNEL_VA allocations are placed in, in page table sized chunks */
+#define MALI_VMA_KERNEL_BASE   0xC0000000
+#define MALI_VMA_KERNEL_SIZE   0x30000000
+#define MALI_VMA_KERNEL_CHUNKS (MALI_VMA_KERNEL_SIZE / MALI_MMU_VIRTUAL_PAGE_SIZE)
+
+/* Power of two size classes of allocations packed into shared chunks, 4 KiB up to 2 MiB */
+#define MALI_VMA_SIZE_CLASSES  10
+
+struct mali_vma_allocator {
+	struct mutex lock;
+	DECLARE_BITMAP(chunks, MALI_VMA_KERNEL_CHUNKS);              /**< Chunks in use */
+	struct mali_vma_chunk *shared[MALI_VMA_KERNEL_CHUNKS];       /**< Slots of the chunks shared by small allocations */
+	struct list_head partial[MALI_VMA_SIZE_CLASSES];             /**< Shared chunks with free slots, per size class */
+};
 
 struct mali_allocation_manager {
 	rwlock_t vm_lock;
@@ -27,6 +46,7 @@ struct mali_allocation_manager {
 	struct list_head head;
 	struct mutex list_mutex;
 	u32 mali_allocation_num;
+	struct mali_vma_allocator va;      /**< Places _MALI_MEMORY_ALLOCATE_KERNEL_VA allocations */
 };
 
 extern struct idr mali_backend_idr;
@@ -37,7 +57,32 @@ void mali_memory_manager_uninit(struct mali_allocation_manager *mgr);
 
 void  mali_mem_allocation_struct_destory(mali_mem_allocation *alloc);
 _mali_osk_errcode_t mali_mem_add_mem_size(struct mali_session_data *session, u32 mali_addr, u32 add_size);
+/* Returns the backend at mali_address with a reference taken, see mali_mem_backend_get() */
 mali_mem_backend *mali_mem_backend_struct_search(struct mali_session_data *session, u32 mali_address);
+void mali_mem_backend_struct_destory(mali_mem_backend **backend, s32 backend_handle);
+
+/*
+ * Look up the backend of an allocation and take a reference on it, without
+ * taking mali_idr_mutex. Returns NULL if there is no backend for the handle.
+ * The reference is dropped with mali_mem_backend_put().
+ */
+mali_mem_backend *mali_mem_backend_get(s32 backend_handle);
+void mali_mem_backend_put(mali_mem_backend *mem_backend);
+
+/*
+ * Resolve the memory cookies of a PP job once, at job creation, into the
+ * job's swappable and dma-buf backends. The job holds a reference on their
+ * allocations until mali_mem_backend_release_job().
+ */
+_mali_osk_errcode_t mali_mem_backend_resolve_job(struct mali_pp_job *job, const u32 *cookies);
+void mali_mem_backend_release_job(struct mali_pp_job *job);
+
+/*
+ * Time num_threads threads doing lookups_per_thread backend lookups each,
+ * with mali_mem_backend_get() and with idr_find() under mali_idr_mutex.
+ */
+int mali_mem_backend_lookup_benchmark(u32 num_threads, u32 lookups_per_thread, u64 *rcu_ns, u64 *mutex_ns);
+
 _mali_osk_errcode_t _mali_ukk_mem_allocate(_mali_uk_alloc_mem_s *args);
 _mali_osk_errcode_t _mali_ukk_mem_free(_mali_uk_free_mem_s *args);
 _mali_osk_errcode_t _mali_ukk_mem_bind(_mali_uk_bind_mem_s *args);
@@ -46,6 +91,8 @@ _mali_osk_errcode_t _mali_ukk_mem_cow(_mali_uk_cow_mem_s *args);
 _mali_osk_errcode_t _mali_ukk_mem_cow_modify_range(_mali_uk_cow_modify_range_s *args);
 _mali_osk_errcode_t _mali_ukk_mem_usage_get(_mali_uk_profiling_memory_usage_get_s *args);
 _mali_osk_errcode_t _mali_ukk_mem_resize(_mali_uk_mem_resize_s *args);
+_mali_osk_errcode_t _mali_ukk_mem_sparse_bind(_mali_uk_mem_sparse_bind_s *args);
+_mali_osk_errcode_t _mali_ukk_mem_madvise(_mali_uk_mem_madvise_s *args);
 
 #endif
 
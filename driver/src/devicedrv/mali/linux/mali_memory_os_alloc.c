@@ -9,6 +9,7 @@
  */
 
 #include <linux/list.h>
+#include <linux/highmem.h>
 #include <linux/mm.h>
 #include <linux/mm_types.h>
 #include <linux/fs.h>
@@ -16,16 +17,34 @@
 #include <linux/version.h>
 #include <linux/platform_device.h>
 #include <linux/workqueue.h>
+#include <linux/percpu.h>
+#include <linux/math64.h>
 
 #include "mali_osk.h"
 #include "mali_memory.h"
 #include "mali_memory_os_alloc.h"
 #include "mali_kernel_linux.h"
+#include "mali_pm.h"
 
 /* Minimum size of allocator page pool */
 #define MALI_OS_MEMORY_KERNEL_BUFFER_SIZE_IN_PAGES (MALI_OS_MEMORY_KERNEL_BUFFER_SIZE_IN_MB * 256)
 #define MALI_OS_MEMORY_POOL_TRIM_JIFFIES (10 * CONFIG_HZ) /* Default to 10s */
 
+/* Dirty pages zeroed per batch, and how long to let frees batch up or to wait between batches while the GPU is busy */
+#define MALI_OS_MEMORY_ZERO_BATCH 64
+#define MALI_OS_MEMORY_ZERO_RETRY_JIFFIES (CONFIG_HZ / 50) /* 20ms */
+
+/* Pages cached per CPU in front of the global pool, and how many are moved at a time */
+#define MALI_MEM_OS_MAGAZINE_SIZE 64
+#define MALI_MEM_OS_MAGAZINE_BATCH 32
+
+/* Largest chunk order tried for new pages, 4 gives 64KB chunks */
+#define MALI_MEM_OS_ALLOC_MAX_ORDER_DEFAULT 4
+#define MALI_MEM_OS_ALLOC_ORDER_LIMIT (MAX_ORDER - 1)
+
+/* Module parameter, 0 allocates one page at a time */
+unsigned int mali_mem_os_alloc_max_order = MALI_MEM_OS_ALLOC_MAX_ORDER_DEFAULT;
+
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 8, 0)
 static unsigned long dma_attrs_wc = 0;
 #elif LINUX_VERSION_CODE >= KERNEL_VERSION(3, 8, 0)
@@ -48,11 +67,14 @@ static unsigned long mali_mem_os_shrink_count(struct shrinker *shrinker, struct
 #endif
 #endif
 static void mali_mem_os_trim_pool(struct work_struct *work);
+static void mali_mem_os_zero_pages(struct work_struct *work);
 
 struct mali_mem_os_allocator mali_mem_os_allocator = {
 	.pool_lock = __SPIN_LOCK_UNLOCKED(pool_lock),
 	.pool_pages = LIST_HEAD_INIT(mali_mem_os_allocator.pool_pages),
 	.pool_count = 0,
+	.dirty_pages = LIST_HEAD_INIT(mali_mem_os_allocator.dirty_pages),
+	.dirty_count = 0,
 
 	.allocated_pages = ATOMIC_INIT(0),
 	.allocation_limit = 0,
@@ -73,6 +95,243 @@ struct mali_mem_os_allocator mali_mem_os_allocator = {
 #endif
 };
 
+/* Total number of pages on the global pool, zeroed and dirty */
+MALI_STATIC_INLINE size_t mali_mem_os_pool_size(void)
+{
+	return mali_mem_os_allocator.pool_count + mali_mem_os_allocator.dirty_count;
+}
+
+/* Zero a pooled page and clean it from the CPU caches, the GPU reads memory directly. */
+static void mali_mem_os_zero_page(struct page *page)
+{
+	clear_highpage(page);
+	dma_sync_single_for_device(&mali_platform_device->dev, page_private(page),
+				   _MALI_OSK_MALI_PAGE_SIZE, DMA_BIDIRECTIONAL);
+}
+
+/* Take up to nr pages off the global pool to give back to the kernel,
+ * dirty pages first as they have not been zeroed yet.
+ * The pool lock must be held.
+ *
+ * Returns the number of pages moved to pages.
+ */
+static size_t mali_mem_os_pool_take(struct list_head *pages, size_t nr)
+{
+	size_t taken = 0;
+
+	while (taken < nr && 0 < mali_mem_os_allocator.dirty_count) {
+		list_move(mali_mem_os_allocator.dirty_pages.next, pages);
+		mali_mem_os_allocator.dirty_count--;
+		taken++;
+	}
+
+	while (taken < nr && 0 < mali_mem_os_allocator.pool_count) {
+		list_move(mali_mem_os_allocator.pool_pages.next, pages);
+		mali_mem_os_allocator.pool_count--;
+		taken++;
+	}
+
+	return taken;
+}
+
+/* Move a batch of zeroed pages from the global pool to a magazine.
+ * The magazine lock must be held.
+ */
+static void mali_mem_os_magazine_refill(struct mali_mem_os_magazine *magazine)
+{
+	size_t nr;
+
+	spin_lock(&mali_mem_os_allocator.pool_lock);
+	nr = min((size_t)MALI_MEM_OS_MAGAZINE_BATCH, mali_mem_os_allocator.pool_count);
+	mali_mem_os_allocator.pool_count -= nr;
+	magazine->count += nr;
+	while (0 < nr--) {
+		list_move(mali_mem_os_allocator.pool_pages.next, &magazine->pages);
+	}
+	spin_unlock(&mali_mem_os_allocator.pool_lock);
+}
+
+/* Take up to count zeroed pages from the current CPU's magazine.
+ * An empty magazine is refilled from the global pool for small allocations.
+ *
+ * Returns the number of pages moved to list.
+ */
+static size_t mali_mem_os_magazine_get(struct list_head *list, size_t count)
+{
+	struct mali_mem_os_magazine *magazine;
+	size_t taken = 0;
+
+	magazine = get_cpu_ptr(mali_mem_os_allocator.magazines);
+	spin_lock(&magazine->lock);
+
+	if (0 == magazine->count && count < MALI_MEM_OS_MAGAZINE_SIZE) {
+		mali_mem_os_magazine_refill(magazine);
+	}
+
+	while (taken < count && 0 < magazine->count) {
+		list_move_tail(magazine->pages.next, list);
+		magazine->count--;
+		taken++;
+	}
+
+	magazine->hits += taken;
+	magazine->misses += count - taken;
+
+	spin_unlock(&magazine->lock);
+	put_cpu_ptr(mali_mem_os_allocator.magazines);
+
+	return taken;
+}
+
+/* Give count freed pages to the current CPU's magazine.
+ * Large frees, and full magazines, go to the global dirty list in one batch.
+ *
+ * Returns MALI_TRUE if pages were put on the global dirty list.
+ */
+static mali_bool mali_mem_os_magazine_put(struct list_head *pages, size_t count)
+{
+	struct mali_mem_os_magazine *magazine;
+	LIST_HEAD(overflow);
+	size_t nr_overflow = 0;
+
+	if (0 == count) {
+		return MALI_FALSE;
+	}
+
+	if (count < MALI_MEM_OS_MAGAZINE_SIZE) {
+		magazine = get_cpu_ptr(mali_mem_os_allocator.magazines);
+		spin_lock(&magazine->lock);
+
+		list_splice(pages, &magazine->dirty_pages);
+		magazine->dirty_count += count;
+
+		if (MALI_MEM_OS_MAGAZINE_SIZE < magazine->dirty_count) {
+			list_splice_init(&magazine->dirty_pages, &overflow);
+			nr_overflow = magazine->dirty_count;
+			magazine->dirty_count = 0;
+		}
+
+		spin_unlock(&magazine->lock);
+		put_cpu_ptr(mali_mem_os_allocator.magazines);
+	} else {
+		list_splice(pages, &overflow);
+		nr_overflow = count;
+	}
+
+	if (0 == nr_overflow) {
+		return MALI_FALSE;
+	}
+
+	spin_lock(&mali_mem_os_allocator.pool_lock);
+	list_splice(&overflow, &mali_mem_os_allocator.dirty_pages);
+	mali_mem_os_allocator.dirty_count += nr_overflow;
+	spin_unlock(&mali_mem_os_allocator.pool_lock);
+
+	return MALI_TRUE;
+}
+
+/* Move the freed pages of all magazines to the global dirty list */
+static void mali_mem_os_magazines_drain_dirty(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct mali_mem_os_magazine *magazine = per_cpu_ptr(mali_mem_os_allocator.magazines, cpu);
+		LIST_HEAD(pages);
+		size_t count;
+
+		if (0 == magazine->dirty_count) {
+			continue;
+		}
+
+		spin_lock(&magazine->lock);
+		list_splice_init(&magazine->dirty_pages, &pages);
+		count = magazine->dirty_count;
+		magazine->dirty_count = 0;
+		spin_unlock(&magazine->lock);
+
+		if (0 < count) {
+			spin_lock(&mali_mem_os_allocator.pool_lock);
+			list_splice(&pages, &mali_mem_os_allocator.dirty_pages);
+			mali_mem_os_allocator.dirty_count += count;
+			spin_unlock(&mali_mem_os_allocator.pool_lock);
+		}
+	}
+}
+
+/* Move the pages of all magazines to the global pool */
+static void mali_mem_os_magazines_drain(void)
+{
+	int cpu;
+
+	mali_mem_os_magazines_drain_dirty();
+
+	for_each_possible_cpu(cpu) {
+		struct mali_mem_os_magazine *magazine = per_cpu_ptr(mali_mem_os_allocator.magazines, cpu);
+		LIST_HEAD(pages);
+		size_t count;
+
+		spin_lock(&magazine->lock);
+		list_splice_init(&magazine->pages, &pages);
+		count = magazine->count;
+		magazine->count = 0;
+		spin_unlock(&magazine->lock);
+
+		if (0 < count) {
+			spin_lock(&mali_mem_os_allocator.pool_lock);
+			list_splice(&pages, &mali_mem_os_allocator.pool_pages);
+			mali_mem_os_allocator.pool_count += count;
+			spin_unlock(&mali_mem_os_allocator.pool_lock);
+		}
+	}
+}
+
+/* Move the pages of all magazines to the global pool, without waiting.
+ * The pool lock must be held. Magazines in use on another CPU are skipped.
+ */
+static void mali_mem_os_magazines_try_drain_locked(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct mali_mem_os_magazine *magazine = per_cpu_ptr(mali_mem_os_allocator.magazines, cpu);
+
+		if (0 == magazine->count && 0 == magazine->dirty_count) {
+			continue;
+		}
+
+		/* The magazine lock nests outside the pool lock, so it can only be tried here */
+		if (0 == spin_trylock(&magazine->lock)) {
+			continue;
+		}
+
+		list_splice_init(&magazine->dirty_pages, &mali_mem_os_allocator.dirty_pages);
+		mali_mem_os_allocator.dirty_count += magazine->dirty_count;
+		magazine->dirty_count = 0;
+
+		list_splice_init(&magazine->pages, &mali_mem_os_allocator.pool_pages);
+		mali_mem_os_allocator.pool_count += magazine->count;
+		magazine->count = 0;
+
+		spin_unlock(&magazine->lock);
+	}
+}
+
+/* Number of pages cached in the magazines, read without locking */
+static size_t mali_mem_os_magazines_count(void)
+{
+	size_t count = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct mali_mem_os_magazine *magazine = per_cpu_ptr(mali_mem_os_allocator.magazines, cpu);
+
+		count += magazine->count + magazine->dirty_count;
+	}
+
+	return count;
+}
+
 u32 mali_mem_os_free(struct list_head *os_pages, u32 pages_count, mali_bool cow_flag)
 {
 	LIST_HEAD(pages);
@@ -101,19 +360,42 @@ u32 mali_mem_os_free(struct list_head *os_pages, u32 pages_count, mali_bool cow_
 		free_pages_nr = pages_count;
 	}
 
-	/* Put pages on pool. */
-	spin_lock(&mali_mem_os_allocator.pool_lock);
-	list_splice(&pages, &mali_mem_os_allocator.pool_pages);
-	mali_mem_os_allocator.pool_count += free_pages_nr;
-	spin_unlock(&mali_mem_os_allocator.pool_lock);
+	/*
+	 * Put pages on this CPU's magazine, or on the global dirty list. They
+	 * are zeroed in the background, small frees are left to batch up in
+	 * the magazine for a while before the zeroing worker drains them.
+	 */
+	if (MALI_TRUE == mali_mem_os_magazine_put(&pages, free_pages_nr)) {
+		queue_delayed_work(mali_mem_os_allocator.wq, &mali_mem_os_allocator.zero_work, 0);
+	} else if (0 < free_pages_nr) {
+		queue_delayed_work(mali_mem_os_allocator.wq, &mali_mem_os_allocator.zero_work, MALI_OS_MEMORY_ZERO_RETRY_JIFFIES);
+	}
 
-	if (MALI_OS_MEMORY_KERNEL_BUFFER_SIZE_IN_PAGES < mali_mem_os_allocator.pool_count) {
-		MALI_DEBUG_PRINT(5, ("OS Mem: Starting pool trim timer %u\n", mali_mem_os_allocator.pool_count));
+	if (MALI_OS_MEMORY_KERNEL_BUFFER_SIZE_IN_PAGES < mali_mem_os_pool_size()) {
+		MALI_DEBUG_PRINT(5, ("OS Mem: Starting pool trim timer %u\n", mali_mem_os_pool_size()));
 		queue_delayed_work(mali_mem_os_allocator.wq, &mali_mem_os_allocator.timed_shrinker, MALI_OS_MEMORY_POOL_TRIM_JIFFIES);
 	}
 	return free_pages_nr;
 }
 
+/**
+* free pages back to the kernel without putting them into the page pool
+*/
+u32 mali_mem_os_free_to_kernel(struct list_head *os_pages)
+{
+	struct mali_page_node *m_page, *m_tmp;
+	u32 free_pages_nr = 0;
+
+	list_for_each_entry_safe(m_page, m_tmp, os_pages, list) {
+		MALI_DEBUG_ASSERT(1 == _mali_page_node_get_ref_count(m_page));
+		mali_mem_os_free_page_node(m_page);
+		free_pages_nr++;
+	}
+	atomic_sub(free_pages_nr, &mali_mem_os_allocator.allocated_pages);
+
+	return free_pages_nr;
+}
+
 /**
 * put page without put it into page pool
 */
@@ -155,9 +437,134 @@ _mali_osk_errcode_t mali_mem_os_resize_pages(mali_mem_os_mem *mem_from, mali_mem
 }
 
 
+static gfp_t mali_mem_os_gfp_flags(void)
+{
+	gfp_t flags = __GFP_ZERO | __GFP_REPEAT | __GFP_NOWARN | __GFP_COLD;
+
+#if defined(CONFIG_ARM) && !defined(CONFIG_ARM_LPAE)
+	flags |= GFP_HIGHUSER;
+#else
+#ifdef CONFIG_ZONE_DMA32
+	flags |= GFP_DMA32;
+#else
+#ifdef CONFIG_ZONE_DMA
+	flags |= GFP_DMA;
+#else
+	/* arm64 utgard only work on < 4G, but the kernel
+	 * didn't provide method to allocte memory < 4G
+	 */
+	MALI_DEBUG_ASSERT(0);
+#endif
+#endif
+#endif
+
+	return flags;
+}
+
+/* Allocate count new pages from the kernel and add them to list.
+ *
+ * Pages are allocated in physically contiguous chunks of up to 1 << max_order
+ * pages, falling back to smaller chunks when the kernel is out of larger
+ * blocks. Each chunk is flushed from the CPU caches as a whole, and then
+ * split into individual pages which are DMA mapped one by one. The rest of
+ * the driver (page pool, COW, swap, freeing) keeps working on single pages,
+ * and unmaps each of them on its own.
+ *
+ * Returns the number of pages added to list. If less than count, *err is set.
+ */
+static size_t mali_mem_os_alloc_new_pages(struct list_head *list, size_t count, u32 max_order, int *err)
+{
+	gfp_t flags = mali_mem_os_gfp_flags();
+	u32 order = min_t(u32, max_order, MALI_MEM_OS_ALLOC_ORDER_LIMIT);
+	size_t allocated = 0;
+
+	while (allocated < count) {
+		struct page *chunk;
+		struct mali_page_node *m_page;
+		dma_addr_t dma_addr;
+		size_t chunk_size;
+		u32 chunk_pages;
+		u32 i;
+
+		/* Never allocate more than what is left. */
+		while (0 < order && (count - allocated) < (1UL << order)) {
+			order--;
+		}
+
+		if (0 < order) {
+			/* Don't try hard for a large block, smaller ones will do. */
+			chunk = alloc_pages((flags & ~__GFP_REPEAT) | __GFP_NORETRY, order);
+			if (NULL == chunk) {
+				order--;
+				continue;
+			}
+		} else {
+			chunk = alloc_page(flags);
+			if (unlikely(NULL == chunk)) {
+				*err = -ENOMEM;
+				break;
+			}
+		}
+
+		chunk_pages = 1 << order;
+		chunk_size = (size_t)chunk_pages * _MALI_OSK_MALI_PAGE_SIZE;
+
+		/* Ensure chunk is flushed from CPU caches. */
+		dma_addr = dma_map_page(&mali_platform_device->dev, chunk,
+					0, chunk_size, DMA_BIDIRECTIONAL);
+		dma_unmap_page(&mali_platform_device->dev, dma_addr,
+			       chunk_size, DMA_BIDIRECTIONAL);
+
+		if (0 < order) {
+			split_page(chunk, order);
+		}
+
+		/*
+		 * Pages of a chunk are unmapped and freed one by one, so each
+		 * of them gets its own DMA mapping.
+		 */
+		for (i = 0; i < chunk_pages; i++) {
+			struct page *page = chunk + i;
+
+			dma_addr = dma_map_page(&mali_platform_device->dev, page,
+						0, _MALI_OSK_MALI_PAGE_SIZE, DMA_BIDIRECTIONAL);
+			if (unlikely(dma_mapping_error(&mali_platform_device->dev, dma_addr))) {
+				MALI_DEBUG_PRINT_ERROR(("OS Mem: Failed to DMA map page %p\n", page));
+				m_page = NULL;
+			} else {
+				/* Store page phys addr */
+				SetPagePrivate(page);
+				set_page_private(page, dma_addr);
+
+				m_page = _mali_page_node_allocate(MALI_PAGE_NODE_OS);
+				if (unlikely(NULL == m_page)) {
+					MALI_PRINT_ERROR(("OS Mem: Can't allocate mali_page node! \n"));
+					dma_unmap_page(&mali_platform_device->dev, dma_addr,
+						       _MALI_OSK_MALI_PAGE_SIZE, DMA_BIDIRECTIONAL);
+					ClearPagePrivate(page);
+				}
+			}
+
+			if (unlikely(NULL == m_page)) {
+				/* Give back the pages of this chunk not yet on the list. */
+				for (; i < chunk_pages; i++) {
+					__free_page(chunk + i);
+				}
+				*err = -EFAULT;
+				return allocated;
+			}
+			m_page->page = page;
+
+			list_add_tail(&m_page->list, list);
+			allocated++;
+		}
+	}
+
+	return allocated;
+}
+
 int mali_mem_os_alloc_pages(mali_mem_os_mem *os_mem, u32 size)
 {
-	struct page *new_page;
 	LIST_HEAD(pages_list);
 	size_t page_count = PAGE_ALIGN(size) / _MALI_OSK_MALI_PAGE_SIZE;
 	size_t remaining = page_count;
@@ -177,9 +584,13 @@ int mali_mem_os_alloc_pages(mali_mem_os_mem *os_mem, u32 size)
 	INIT_LIST_HEAD(&os_mem->pages);
 	os_mem->count = page_count;
 
-	/* Grab pages from pool. */
-	{
+	/* Grab pages from this CPU's magazine, then from the global pool. */
+	remaining -= mali_mem_os_magazine_get(&pages_list, remaining);
+	if (0 < remaining) {
+		LIST_HEAD(dirty_list);
 		size_t pool_pages;
+		size_t dirty_pages;
+
 		spin_lock(&mali_mem_os_allocator.pool_lock);
 		pool_pages = min(remaining, mali_mem_os_allocator.pool_count);
 		for (i = pool_pages; i > 0; i--) {
@@ -188,7 +599,21 @@ int mali_mem_os_alloc_pages(mali_mem_os_mem *os_mem, u32 size)
 		}
 		mali_mem_os_allocator.pool_count -= pool_pages;
 		remaining -= pool_pages;
+
+		/* Zeroing a dirty page is still cheaper than getting a new one. */
+		dirty_pages = min(remaining, mali_mem_os_allocator.dirty_count);
+		for (i = dirty_pages; i > 0; i--) {
+			BUG_ON(list_empty(&mali_mem_os_allocator.dirty_pages));
+			list_move(mali_mem_os_allocator.dirty_pages.next, &dirty_list);
+		}
+		mali_mem_os_allocator.dirty_count -= dirty_pages;
+		remaining -= dirty_pages;
 		spin_unlock(&mali_mem_os_allocator.pool_lock);
+
+		list_for_each_entry(m_page, &dirty_list, list) {
+			mali_mem_os_zero_page(m_page->page);
+		}
+		list_splice_tail(&dirty_list, &pages_list);
 	}
 
 	/* Process pages from pool. */
@@ -200,82 +625,24 @@ int mali_mem_os_alloc_pages(mali_mem_os_mem *os_mem, u32 size)
 	}
 
 	/* Allocate new pages, if needed. */
-	for (i = 0; i < remaining; i++) {
-		dma_addr_t dma_addr;
-		gfp_t flags = __GFP_ZERO | __GFP_REPEAT | __GFP_NOWARN | __GFP_COLD;
-		int err;
+	if (0 < remaining) {
+		int err = 0;
+		size_t allocated;
 
-#if defined(CONFIG_ARM) && !defined(CONFIG_ARM_LPAE)
-		flags |= GFP_HIGHUSER;
-#else
-#ifdef CONFIG_ZONE_DMA32
-		flags |= GFP_DMA32;
-#else
-#ifdef CONFIG_ZONE_DMA
-		flags |= GFP_DMA;
-#else
-		/* arm64 utgard only work on < 4G, but the kernel
-		 * didn't provide method to allocte memory < 4G
-		 */
-		MALI_DEBUG_ASSERT(0);
-#endif
-#endif
-#endif
-
-		new_page = alloc_page(flags);
-
-		if (unlikely(NULL == new_page)) {
+		allocated = mali_mem_os_alloc_new_pages(&os_mem->pages, remaining, mali_mem_os_alloc_max_order, &err);
+		if (unlikely(allocated < remaining)) {
 			/* Calculate the number of pages actually allocated, and free them. */
-			os_mem->count = (page_count - remaining) + i;
+			os_mem->count = (page_count - remaining) + allocated;
 			atomic_add(os_mem->count, &mali_mem_os_allocator.allocated_pages);
 			mali_mem_os_free(&os_mem->pages, os_mem->count, MALI_FALSE);
-			return -ENOMEM;
-		}
-
-		/* Ensure page is flushed from CPU caches. */
-		dma_addr = dma_map_page(&mali_platform_device->dev, new_page,
-					0, _MALI_OSK_MALI_PAGE_SIZE, DMA_BIDIRECTIONAL);
-		dma_unmap_page(&mali_platform_device->dev, dma_addr,
-			       _MALI_OSK_MALI_PAGE_SIZE, DMA_BIDIRECTIONAL);
-		dma_addr = dma_map_page(&mali_platform_device->dev, new_page,
-					0, _MALI_OSK_MALI_PAGE_SIZE, DMA_BIDIRECTIONAL);
-
-		err = dma_mapping_error(&mali_platform_device->dev, dma_addr);
-		if (unlikely(err)) {
-			MALI_DEBUG_PRINT_ERROR(("OS Mem: Failed to DMA map page %p: %u",
-						new_page, err));
-			__free_page(new_page);
-			os_mem->count = (page_count - remaining) + i;
-			atomic_add(os_mem->count, &mali_mem_os_allocator.allocated_pages);
-			mali_mem_os_free(&os_mem->pages, os_mem->count, MALI_FALSE);
-			return -EFAULT;
+			return err;
 		}
-
-		/* Store page phys addr */
-		SetPagePrivate(new_page);
-		set_page_private(new_page, dma_addr);
-
-		m_page = _mali_page_node_allocate(MALI_PAGE_NODE_OS);
-		if (unlikely(NULL == m_page)) {
-			MALI_PRINT_ERROR(("OS Mem: Can't allocate mali_page node! \n"));
-			dma_unmap_page(&mali_platform_device->dev, page_private(new_page),
-				       _MALI_OSK_MALI_PAGE_SIZE, DMA_BIDIRECTIONAL);
-			ClearPagePrivate(new_page);
-			__free_page(new_page);
-			os_mem->count = (page_count - remaining) + i;
-			atomic_add(os_mem->count, &mali_mem_os_allocator.allocated_pages);
-			mali_mem_os_free(&os_mem->pages, os_mem->count, MALI_FALSE);
-			return -EFAULT;
-		}
-		m_page->page = new_page;
-
-		list_add_tail(&m_page->list, &os_mem->pages);
 	}
 
 	atomic_add(page_count, &mali_mem_os_allocator.allocated_pages);
 
-	if (MALI_OS_MEMORY_KERNEL_BUFFER_SIZE_IN_PAGES > mali_mem_os_allocator.pool_count) {
-		MALI_DEBUG_PRINT(4, ("OS Mem: Stopping pool trim timer, only %u pages on pool\n", mali_mem_os_allocator.pool_count));
+	if (MALI_OS_MEMORY_KERNEL_BUFFER_SIZE_IN_PAGES > mali_mem_os_pool_size()) {
+		MALI_DEBUG_PRINT(4, ("OS Mem: Stopping pool trim timer, only %u pages on pool\n", mali_mem_os_pool_size()));
 		cancel_delayed_work(&mali_mem_os_allocator.timed_shrinker);
 	}
 
@@ -286,9 +653,9 @@ int mali_mem_os_alloc_pages(mali_mem_os_mem *os_mem, u32 size)
 _mali_osk_errcode_t mali_mem_os_mali_map(mali_mem_os_mem *os_mem, struct mali_session_data *session, u32 vaddr, u32 start_page, u32 mapping_pgae_num, u32 props)
 {
 	struct mali_page_directory *pagedir = session->page_directory;
+	struct mali_mmu_pagedir_range range;
 	struct mali_page_node *m_page;
-	u32 virt;
-	u32 prop = props;
+	u32 i;
 
 	MALI_DEBUG_ASSERT_POINTER(session);
 	MALI_DEBUG_ASSERT_POINTER(os_mem);
@@ -296,48 +663,44 @@ _mali_osk_errcode_t mali_mem_os_mali_map(mali_mem_os_mem *os_mem, struct mali_se
 	MALI_DEBUG_ASSERT(start_page <= os_mem->count);
 	MALI_DEBUG_ASSERT((start_page + mapping_pgae_num) <= os_mem->count);
 
-	if ((start_page + mapping_pgae_num) == os_mem->count) {
-
-		virt = vaddr + MALI_MMU_PAGE_SIZE * (start_page + mapping_pgae_num);
+	if (0 == mapping_pgae_num) {
+		return _MALI_OSK_ERR_OK;
+	}
 
+	/* Find the first page to map. */
+	if ((start_page + mapping_pgae_num) == os_mem->count) {
+		/* Mapping the tail of the allocation, e.g. after resize, look from the end. */
+		i = mapping_pgae_num;
 		list_for_each_entry_reverse(m_page, &os_mem->pages, list) {
-
-			virt -= MALI_MMU_PAGE_SIZE;
-			if (mapping_pgae_num > 0) {
-				dma_addr_t phys = page_private(m_page->page);
-#if defined(CONFIG_ARCH_DMA_ADDR_T_64BIT)
-				/* Verify that the "physical" address is 32-bit and
-				* usable for Mali, when on a system with bus addresses
-				* wider than 32-bit. */
-				MALI_DEBUG_ASSERT(0 == (phys >> 32));
-#endif
-				mali_mmu_pagedir_update(pagedir, virt, (mali_dma_addr)phys, MALI_MMU_PAGE_SIZE, prop);
-			} else {
-				break;
-			}
-			mapping_pgae_num--;
+			if (0 == --i) break;
 		}
-
 	} else {
-		u32 i = 0;
-		virt = vaddr;
+		i = 0;
 		list_for_each_entry(m_page, &os_mem->pages, list) {
+			if (start_page == i++) break;
+		}
+	}
 
-			if (i >= start_page) {
-				dma_addr_t phys = page_private(m_page->page);
+	mali_mmu_pagedir_range_begin(&range, pagedir, vaddr + MALI_MMU_PAGE_SIZE * start_page, props);
 
+	i = mapping_pgae_num;
+	list_for_each_entry_from(m_page, &os_mem->pages, list) {
+		dma_addr_t phys;
+
+		if (0 == i--) break;
+
+		phys = page_private(m_page->page);
 #if defined(CONFIG_ARCH_DMA_ADDR_T_64BIT)
-				/* Verify that the "physical" address is 32-bit and
-				* usable for Mali, when on a system with bus addresses
-				* wider than 32-bit. */
-				MALI_DEBUG_ASSERT(0 == (phys >> 32));
+		/* Verify that the "physical" address is 32-bit and
+		* usable for Mali, when on a system with bus addresses
+		* wider than 32-bit. */
+		MALI_DEBUG_ASSERT(0 == (phys >> 32));
 #endif
-				mali_mmu_pagedir_update(pagedir, virt, (mali_dma_addr)phys, MALI_MMU_PAGE_SIZE, prop);
-			}
-			i++;
-			virt += MALI_MMU_PAGE_SIZE;
-		}
+		mali_mmu_pagedir_range_add(&range, (mali_dma_addr)phys);
 	}
+
+	mali_mmu_pagedir_range_end(&range);
+
 	return _MALI_OSK_ERR_OK;
 }
 
@@ -350,8 +713,8 @@ void mali_mem_os_mali_unmap(mali_mem_allocation *alloc)
 	MALI_DEBUG_ASSERT_POINTER(session);
 
 	mali_session_memory_lock(session);
-	mali_mem_mali_map_free(session, alloc->psize, alloc->mali_vma_node.vm_node.start,
-			       alloc->flags);
+	mali_mem_mali_map_free(session, mali_mem_mali_map_size(alloc), alloc->mali_vma_node.vm_node.start,
+			       alloc->flags, NULL);
 	mali_session_memory_unlock(session);
 }
 
@@ -466,8 +829,10 @@ u32 mali_mem_os_release(mali_mem_backend *mem_bkend)
 	session = alloc->session;
 	MALI_DEBUG_ASSERT_POINTER(session);
 
-	/* Unmap the memory from the mali virtual address space. */
-	mali_mem_os_mali_unmap(alloc);
+	/* Unmap the memory from the mali virtual address space, purging did it already. */
+	if (!(MALI_MEM_BACKEND_FLAG_PURGED & mem_bkend->flags)) {
+		mali_mem_os_mali_unmap(alloc);
+	}
 	mutex_lock(&mem_bkend->mutex);
 	/* Free pages */
 	if (MALI_MEM_BACKEND_FLAG_COWED & mem_bkend->flags) {
@@ -640,7 +1005,7 @@ static void mali_mem_os_trim_page_table_page_pool(void)
 	size_t nr_to_keep;
 
 	/* Keep 2 page table pages for each 1024 pages in the page cache. */
-	nr_to_keep = mali_mem_os_allocator.pool_count / 512;
+	nr_to_keep = mali_mem_os_pool_size() / 512;
 	/* And a minimum of eight pages, to accomodate new sessions. */
 	nr_to_keep += 8;
 
@@ -657,7 +1022,7 @@ static void mali_mem_os_trim_page_table_page_pool(void)
 
 static unsigned long mali_mem_os_shrink_count(struct shrinker *shrinker, struct shrink_control *sc)
 {
-	return mali_mem_os_allocator.pool_count;
+	return mali_mem_os_pool_size() + mali_mem_os_magazines_count();
 }
 
 #if LINUX_VERSION_CODE < KERNEL_VERSION(3, 0, 0)
@@ -676,7 +1041,7 @@ static unsigned long mali_mem_os_shrink(struct shrinker *shrinker, struct shrink
 {
 	struct mali_page_node *m_page, *m_tmp;
 	unsigned long flags;
-	struct list_head *le, pages;
+	LIST_HEAD(pages);
 #if LINUX_VERSION_CODE < KERNEL_VERSION(3, 0, 0)
 	int nr = nr_to_scan;
 #else
@@ -692,29 +1057,26 @@ static unsigned long mali_mem_os_shrink(struct shrinker *shrinker, struct shrink
 		return -1;
 	}
 
-	if (0 == mali_mem_os_allocator.pool_count) {
+	/* Make the pages cached per CPU reclaimable too. */
+	mali_mem_os_magazines_try_drain_locked();
+
+	if (0 == mali_mem_os_pool_size()) {
 		/* No pages availble */
 		spin_unlock_irqrestore(&mali_mem_os_allocator.pool_lock, flags);
 		return 0;
 	}
 
 	/* Release from general page pool */
-	nr = min((size_t)nr, mali_mem_os_allocator.pool_count);
-	mali_mem_os_allocator.pool_count -= nr;
-	list_for_each(le, &mali_mem_os_allocator.pool_pages) {
-		--nr;
-		if (0 == nr) break;
-	}
-	list_cut_position(&pages, &mali_mem_os_allocator.pool_pages, le);
+	nr = mali_mem_os_pool_take(&pages, nr);
 	spin_unlock_irqrestore(&mali_mem_os_allocator.pool_lock, flags);
 
 	list_for_each_entry_safe(m_page, m_tmp, &pages, list) {
 		mali_mem_os_free_page_node(m_page);
 	}
 
-	if (MALI_OS_MEMORY_KERNEL_BUFFER_SIZE_IN_PAGES > mali_mem_os_allocator.pool_count) {
+	if (MALI_OS_MEMORY_KERNEL_BUFFER_SIZE_IN_PAGES > mali_mem_os_pool_size()) {
 		/* Pools are empty, stop timer */
-		MALI_DEBUG_PRINT(5, ("Stopping timer, only %u pages on pool\n", mali_mem_os_allocator.pool_count));
+		MALI_DEBUG_PRINT(5, ("Stopping timer, only %u pages on pool\n", mali_mem_os_pool_size()));
 		cancel_delayed_work(&mali_mem_os_allocator.timed_shrinker);
 	}
 
@@ -728,29 +1090,23 @@ static unsigned long mali_mem_os_shrink(struct shrinker *shrinker, struct shrink
 static void mali_mem_os_trim_pool(struct work_struct *data)
 {
 	struct mali_page_node *m_page, *m_tmp;
-	struct list_head *le;
 	LIST_HEAD(pages);
 	size_t nr_to_free;
 
 	MALI_IGNORE(data);
 
-	MALI_DEBUG_PRINT(3, ("OS Mem: Trimming pool %u\n", mali_mem_os_allocator.pool_count));
+	MALI_DEBUG_PRINT(3, ("OS Mem: Trimming pool %u\n", mali_mem_os_pool_size()));
 
 	/* Release from general page pool */
 	spin_lock(&mali_mem_os_allocator.pool_lock);
-	if (MALI_OS_MEMORY_KERNEL_BUFFER_SIZE_IN_PAGES < mali_mem_os_allocator.pool_count) {
-		size_t count = mali_mem_os_allocator.pool_count - MALI_OS_MEMORY_KERNEL_BUFFER_SIZE_IN_PAGES;
+	if (MALI_OS_MEMORY_KERNEL_BUFFER_SIZE_IN_PAGES < mali_mem_os_pool_size()) {
+		size_t count = mali_mem_os_pool_size() - MALI_OS_MEMORY_KERNEL_BUFFER_SIZE_IN_PAGES;
 		const size_t min_to_free = min(64, MALI_OS_MEMORY_KERNEL_BUFFER_SIZE_IN_PAGES);
 
 		/* Free half the pages on the pool above the static limit. Or 64 pages, 256KB. */
 		nr_to_free = max(count / 2, min_to_free);
 
-		mali_mem_os_allocator.pool_count -= nr_to_free;
-		list_for_each(le, &mali_mem_os_allocator.pool_pages) {
-			--nr_to_free;
-			if (0 == nr_to_free) break;
-		}
-		list_cut_position(&pages, &mali_mem_os_allocator.pool_pages, le);
+		mali_mem_os_pool_take(&pages, nr_to_free);
 	}
 	spin_unlock(&mali_mem_os_allocator.pool_lock);
 
@@ -761,16 +1117,85 @@ static void mali_mem_os_trim_pool(struct work_struct *data)
 	/* Release some pages from page table page pool */
 	mali_mem_os_trim_page_table_page_pool();
 
-	if (MALI_OS_MEMORY_KERNEL_BUFFER_SIZE_IN_PAGES < mali_mem_os_allocator.pool_count) {
-		MALI_DEBUG_PRINT(4, ("OS Mem: Starting pool trim timer %u\n", mali_mem_os_allocator.pool_count));
+	if (MALI_OS_MEMORY_KERNEL_BUFFER_SIZE_IN_PAGES < mali_mem_os_pool_size()) {
+		MALI_DEBUG_PRINT(4, ("OS Mem: Starting pool trim timer %u\n", mali_mem_os_pool_size()));
 		queue_delayed_work(mali_mem_os_allocator.wq, &mali_mem_os_allocator.timed_shrinker, MALI_OS_MEMORY_POOL_TRIM_JIFFIES);
 	}
 }
 
+static void mali_mem_os_zero_pages(struct work_struct *data)
+{
+	struct mali_page_node *m_page;
+	mali_bool first_batch = MALI_TRUE;
+
+	MALI_IGNORE(data);
+
+	for (;; first_batch = MALI_FALSE) {
+		LIST_HEAD(pages);
+		size_t nr;
+
+		/*
+		 * GPU is busy, don't compete with it for memory bandwidth. One
+		 * batch is still zeroed per pass so the dirty pages drain even
+		 * when the GPU never goes idle.
+		 */
+		if (MALI_FALSE == first_batch && 0 != mali_pm_get_wanted_mask()) {
+			queue_delayed_work(mali_mem_os_allocator.wq, &mali_mem_os_allocator.zero_work, MALI_OS_MEMORY_ZERO_RETRY_JIFFIES);
+			return;
+		}
+
+		mali_mem_os_magazines_drain_dirty();
+
+		spin_lock(&mali_mem_os_allocator.pool_lock);
+		nr = min((size_t)MALI_OS_MEMORY_ZERO_BATCH, mali_mem_os_allocator.dirty_count);
+		mali_mem_os_allocator.dirty_count -= nr;
+		while (0 < nr--) {
+			list_move(mali_mem_os_allocator.dirty_pages.next, &pages);
+		}
+		spin_unlock(&mali_mem_os_allocator.pool_lock);
+
+		if (list_empty(&pages)) {
+			return;
+		}
+
+		nr = 0;
+		list_for_each_entry(m_page, &pages, list) {
+			mali_mem_os_zero_page(m_page->page);
+			nr++;
+		}
+
+		spin_lock(&mali_mem_os_allocator.pool_lock);
+		list_splice(&pages, &mali_mem_os_allocator.pool_pages);
+		mali_mem_os_allocator.pool_count += nr;
+		spin_unlock(&mali_mem_os_allocator.pool_lock);
+
+		cond_resched();
+	}
+}
+
 _mali_osk_errcode_t mali_mem_os_init(void)
 {
+	int cpu;
+
+	mali_mem_os_allocator.magazines = alloc_percpu(struct mali_mem_os_magazine);
+	if (NULL == mali_mem_os_allocator.magazines) {
+		return _MALI_OSK_ERR_NOMEM;
+	}
+
+	for_each_possible_cpu(cpu) {
+		struct mali_mem_os_magazine *magazine = per_cpu_ptr(mali_mem_os_allocator.magazines, cpu);
+
+		spin_lock_init(&magazine->lock);
+		INIT_LIST_HEAD(&magazine->pages);
+		INIT_LIST_HEAD(&magazine->dirty_pages);
+	}
+
+	INIT_DELAYED_WORK(&mali_mem_os_allocator.zero_work, mali_mem_os_zero_pages);
+
 	mali_mem_os_allocator.wq = alloc_workqueue("mali-mem", WQ_UNBOUND, 1);
 	if (NULL == mali_mem_os_allocator.wq) {
+		free_percpu(mali_mem_os_allocator.magazines);
+		mali_mem_os_allocator.magazines = NULL;
 		return _MALI_OSK_ERR_NOMEM;
 	}
 #if LINUX_VERSION_CODE >=  KERNEL_VERSION(4, 8, 0)
@@ -789,12 +1214,17 @@ void mali_mem_os_term(void)
 	struct mali_page_node *m_page, *m_tmp;
 	unregister_shrinker(&mali_mem_os_allocator.shrinker);
 	cancel_delayed_work_sync(&mali_mem_os_allocator.timed_shrinker);
+	cancel_delayed_work_sync(&mali_mem_os_allocator.zero_work);
 
 	if (NULL != mali_mem_os_allocator.wq) {
 		destroy_workqueue(mali_mem_os_allocator.wq);
 		mali_mem_os_allocator.wq = NULL;
 	}
 
+	mali_mem_os_magazines_drain();
+	free_percpu(mali_mem_os_allocator.magazines);
+	mali_mem_os_allocator.magazines = NULL;
+
 	spin_lock(&mali_mem_os_allocator.pool_lock);
 	list_for_each_entry_safe(m_page, m_tmp, &mali_mem_os_allocator.pool_pages, list) {
 		mali_mem_os_free_page_node(m_page);
@@ -802,6 +1232,12 @@ void mali_mem_os_term(void)
 		--mali_mem_os_allocator.pool_count;
 	}
 	BUG_ON(mali_mem_os_allocator.pool_count);
+	list_for_each_entry_safe(m_page, m_tmp, &mali_mem_os_allocator.dirty_pages, list) {
+		mali_mem_os_free_page_node(m_page);
+
+		--mali_mem_os_allocator.dirty_count;
+	}
+	BUG_ON(mali_mem_os_allocator.dirty_count);
 	spin_unlock(&mali_mem_os_allocator.pool_lock);
 
 	/* Release from page table page pool */
@@ -828,3 +1264,64 @@ u32 mali_mem_os_stat(void)
 {
 	return atomic_read(&mali_mem_os_allocator.allocated_pages) * _MALI_OSK_MALI_PAGE_SIZE;
 }
+
+void mali_mem_os_pool_print_stats(_mali_osk_print_ctx *print_ctx)
+{
+	int cpu;
+
+	_mali_osk_ctxprintf(print_ctx, "\nOS memory page pool: %lu zeroed pages, %lu dirty pages\n",
+			    (unsigned long)mali_mem_os_allocator.pool_count,
+			    (unsigned long)mali_mem_os_allocator.dirty_count);
+	_mali_osk_ctxprintf(print_ctx, "  %-6s %8s %8s %12s %12s %8s\n", "cpu", "cached", "dirty", "hits", "misses", "hit_%");
+
+	for_each_online_cpu(cpu) {
+		struct mali_mem_os_magazine *magazine = per_cpu_ptr(mali_mem_os_allocator.magazines, cpu);
+		size_t count, dirty_count;
+		u64 hits, misses;
+
+		spin_lock(&magazine->lock);
+		count = magazine->count;
+		dirty_count = magazine->dirty_count;
+		hits = magazine->hits;
+		misses = magazine->misses;
+		spin_unlock(&magazine->lock);
+
+		_mali_osk_ctxprintf(print_ctx, "  %-6d %8lu %8lu %12llu %12llu %8llu\n", cpu, (unsigned long)count,
+				    (unsigned long)dirty_count, hits, misses,
+				    (0 == hits + misses) ? 0ULL : div64_u64(hits * 100, hits + misses));
+	}
+}
+
+int mali_mem_os_alloc_benchmark(u32 page_count, u32 max_order, u64 *alloc_ns, u64 *free_ns)
+{
+	struct mali_page_node *m_page, *m_tmp;
+	LIST_HEAD(pages);
+	size_t allocated;
+	int err = 0;
+	u64 start;
+
+	MALI_DEBUG_ASSERT_POINTER(alloc_ns);
+	MALI_DEBUG_ASSERT_POINTER(free_ns);
+
+	if (atomic_read(&mali_mem_os_allocator.allocated_pages) * _MALI_OSK_MALI_PAGE_SIZE +
+	    (size_t)page_count * _MALI_OSK_MALI_PAGE_SIZE > mali_mem_os_allocator.allocation_limit) {
+		return -ENOMEM;
+	}
+
+	/* Bypass the page pool, so that the kernel allocator is what gets measured. */
+	start = _mali_osk_time_get_ns();
+	allocated = mali_mem_os_alloc_new_pages(&pages, page_count, max_order, &err);
+	*alloc_ns = _mali_osk_time_get_ns() - start;
+
+	start = _mali_osk_time_get_ns();
+	list_for_each_entry_safe(m_page, m_tmp, &pages, list) {
+		mali_mem_os_free_page_node(m_page);
+	}
+	*free_ns = _mali_osk_time_get_ns() - start;
+
+	if (allocated < page_count) {
+		return err;
+	}
+
+	return 0;
+}
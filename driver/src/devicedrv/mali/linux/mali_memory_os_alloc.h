@@ -14,6 +14,8 @@
 #include "mali_osk.h"
 #include "mali_memory_types.h"
 
+/* Largest order of contiguous chunks new OS pages are allocated in (module parameter) */
+extern unsigned int mali_mem_os_alloc_max_order;
 
 /** @brief Release Mali OS memory
  *
@@ -39,6 +41,16 @@ int mali_mem_os_alloc_pages(mali_mem_os_mem *os_mem, u32 size);
 
 u32 mali_mem_os_free(struct list_head *os_pages, u32 pages_count, mali_bool cow_flag);
 
+/** @brief Free OS memory pages back to the kernel, bypassing the page pool
+ *
+ * For reclaim, where pages parked in the pool would not relieve memory pressure.
+ * The pages must not be shared with a COW copy.
+ *
+ * @param os_pages List of page nodes to free
+ * @return Number of pages freed
+ */
+u32 mali_mem_os_free_to_kernel(struct list_head *os_pages);
+
 _mali_osk_errcode_t mali_mem_os_put_page(struct page *page);
 
 _mali_osk_errcode_t mali_mem_os_resize_pages(mali_mem_os_mem *mem_from, mali_mem_os_mem *mem_to, u32 start_page, u32 page_count);
@@ -51,4 +63,20 @@ int mali_mem_os_cpu_map(mali_mem_backend *mem_bkend, struct vm_area_struct *vma)
 
 _mali_osk_errcode_t mali_mem_os_resize_cpu_map_locked(mali_mem_backend *mem_bkend, struct vm_area_struct *vma, unsigned long start_vaddr, u32 mappig_size);
 
+/** @brief Print the depth of the OS memory page pool and the per-CPU magazine hit rates
+ *
+ * @param print_ctx Context to print to
+ */
+void mali_mem_os_pool_print_stats(_mali_osk_print_ctx *print_ctx);
+
+/** @brief Time allocating and freeing OS memory, bypassing the page pool
+ *
+ * @param page_count Number of pages to allocate and free
+ * @param max_order Largest chunk order to allocate, 0 for single pages
+ * @param alloc_ns Time spent allocating is returned here
+ * @param free_ns Time spent freeing is returned here
+ * @return 0 on success, negative error code if not all pages could be allocated
+ */
+int mali_mem_os_alloc_benchmark(u32 page_count, u32 max_order, u64 *alloc_ns, u64 *free_ns);
+
 #endif /* __MALI_MEMORY_OS_ALLOC_H__ */
@@ -0,0 +1,276 @@
+/*
+ * Copyright (C) 2017 ARM Limited. All rights reserved.
+ * 
+ * This program is free software and is provided to you under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation, and any use by you of this program is subject to the terms of such GNU licence.
+ * 
+ * A copy of the licence is included with the program, and can also be obtained from Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <linux/list.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
+#include <linux/shrinker.h>
+#include <linux/version.h>
+
+#include "mali_kernel_common.h"
+#include "mali_osk.h"
+#include "mali_session.h"
+#include "mali_memory.h"
+#include "mali_memory_os_alloc.h"
+#include "mali_memory_purgeable.h"
+
+/*
+ * OS memory backends user space marked _MALI_MEM_MADVISE_DONTNEED, and which
+ * still hold their pages, oldest first. The shrinker frees their pages.
+ * Lock order is backend mutex, then list lock. The shrinker only trylocks the
+ * backend mutex and session memory lock while holding the list lock.
+ */
+static struct mali_mem_purgeable_list {
+	struct mutex lock;
+	struct list_head head;
+	unsigned long pages; /* Pages held by backends on the list */
+	u64 purged_pages;
+	struct shrinker shrinker;
+} mali_mem_purgeable;
+
+/*
+ * Allocate and map new pages for a purged backend. The backend mutex must be held.
+ */
+static _mali_osk_errcode_t mali_mem_purgeable_restore(mali_mem_backend *mem_bkend)
+{
+	mali_mem_allocation *alloc = mem_bkend->mali_allocation;
+	struct mali_session_data *session = alloc->session;
+	struct vm_area_struct *vma;
+	_mali_osk_errcode_t ret;
+	int retval;
+
+	retval = mali_mem_os_alloc_pages(&mem_bkend->os_mem, mem_bkend->size);
+	if (retval) {
+		mem_bkend->os_mem.count = 0;
+		return (-ENOMEM == retval) ? _MALI_OSK_ERR_NOMEM : _MALI_OSK_ERR_FAULT;
+	}
+
+	mali_session_memory_lock(session);
+	ret = mali_mem_mali_map_prepare(alloc);
+	if (_MALI_OSK_ERR_OK != ret) {
+		mali_session_memory_unlock(session);
+		mali_mem_os_free(&mem_bkend->os_mem.pages, mem_bkend->os_mem.count, MALI_FALSE);
+		mem_bkend->os_mem.count = 0;
+		return ret;
+	}
+
+	mali_mem_os_mali_map(&mem_bkend->os_mem, session, alloc->mali_vma_node.vm_node.start, 0,
+			     mem_bkend->os_mem.count, alloc->mali_mapping.properties);
+
+	/* The vma can't be closed while the memory lock is held */
+	vma = alloc->cpu_mapping.vma;
+	if (NULL != vma && _MALI_OSK_ERR_OK != mali_mem_os_resize_cpu_map_locked(mem_bkend, vma, vma->vm_start, mem_bkend->size)) {
+		MALI_DEBUG_PRINT(2, ("Mali purgeable memory: failed to map restored pages on CPU\n"));
+	}
+	mali_session_memory_unlock(session);
+
+	mem_bkend->flags &= ~MALI_MEM_BACKEND_FLAG_PURGED;
+
+	atomic_add(mem_bkend->os_mem.count, &session->mali_mem_allocated_pages);
+	if (atomic_read(&session->mali_mem_allocated_pages) * MALI_MMU_PAGE_SIZE > session->max_mali_mem_allocated_size) {
+		session->max_mali_mem_allocated_size = atomic_read(&session->mali_mem_allocated_pages) * MALI_MMU_PAGE_SIZE;
+	}
+
+	return _MALI_OSK_ERR_OK;
+}
+
+/*
+ * Unmap a purgeable backend from Mali and the CPU, and free its pages.
+ * The list lock, the backend mutex and the session memory lock must be held.
+ */
+static u32 mali_mem_purgeable_purge(mali_mem_backend *mem_bkend)
+{
+	mali_mem_allocation *alloc = mem_bkend->mali_allocation;
+	struct mali_session_data *session = alloc->session;
+	u32 count = mem_bkend->os_mem.count;
+
+	list_del_init(&mem_bkend->purge_link);
+	mali_mem_purgeable.pages -= count;
+
+	/* Drops the range from the TLBs of the session's running jobs too */
+	mali_mem_mali_map_free(session, alloc->psize, alloc->mali_vma_node.vm_node.start, alloc->flags, NULL);
+
+	if (NULL != alloc->cpu_mapping.vma) {
+		zap_vma_ptes(alloc->cpu_mapping.vma, alloc->cpu_mapping.vma->vm_start, alloc->psize);
+	}
+
+	/* The shrinker reports these as freed, so they go back to the kernel, not into the page pool */
+	mali_mem_os_free_to_kernel(&mem_bkend->os_mem.pages);
+	mem_bkend->os_mem.count = 0;
+	mem_bkend->flags |= MALI_MEM_BACKEND_FLAG_PURGED;
+
+	atomic_sub(count, &session->mali_mem_allocated_pages);
+	mali_mem_purgeable.purged_pages += count;
+
+	return count;
+}
+
+_mali_osk_errcode_t mali_mem_purgeable_advise(mali_mem_backend *mem_bkend, u32 advice, mali_bool *retained)
+{
+	_mali_osk_errcode_t ret = _MALI_OSK_ERR_OK;
+
+	MALI_DEBUG_ASSERT(MALI_MEM_OS == mem_bkend->type);
+
+	mutex_lock(&mem_bkend->mutex);
+
+	if (_MALI_MEM_MADVISE_DONTNEED == advice) {
+		if (!(mem_bkend->flags & MALI_MEM_BACKEND_FLAG_PURGEABLE)) {
+			mem_bkend->flags |= MALI_MEM_BACKEND_FLAG_PURGEABLE;
+
+			if (!(mem_bkend->flags & MALI_MEM_BACKEND_FLAG_PURGED)) {
+				mutex_lock(&mali_mem_purgeable.lock);
+				list_add_tail(&mem_bkend->purge_link, &mali_mem_purgeable.head);
+				mali_mem_purgeable.pages += mem_bkend->os_mem.count;
+				mutex_unlock(&mali_mem_purgeable.lock);
+			}
+		}
+		*retained = (mem_bkend->flags & MALI_MEM_BACKEND_FLAG_PURGED) ? MALI_FALSE : MALI_TRUE;
+	} else {
+		if (mem_bkend->flags & MALI_MEM_BACKEND_FLAG_PURGEABLE) {
+			mutex_lock(&mali_mem_purgeable.lock);
+			if (!list_empty(&mem_bkend->purge_link)) {
+				list_del_init(&mem_bkend->purge_link);
+				mali_mem_purgeable.pages -= mem_bkend->os_mem.count;
+			}
+			mutex_unlock(&mali_mem_purgeable.lock);
+
+			mem_bkend->flags &= ~MALI_MEM_BACKEND_FLAG_PURGEABLE;
+		}
+
+		if (mem_bkend->flags & MALI_MEM_BACKEND_FLAG_PURGED) {
+			/* The contents are lost, user space must refill the new pages */
+			*retained = MALI_FALSE;
+			ret = mali_mem_purgeable_restore(mem_bkend);
+		} else {
+			*retained = MALI_TRUE;
+		}
+	}
+
+	mutex_unlock(&mem_bkend->mutex);
+
+	return ret;
+}
+
+void mali_mem_purgeable_remove(mali_mem_backend *mem_bkend)
+{
+	mutex_lock(&mali_mem_purgeable.lock);
+	if (!list_empty(&mem_bkend->purge_link)) {
+		list_del_init(&mem_bkend->purge_link);
+		mali_mem_purgeable.pages -= mem_bkend->os_mem.count;
+	}
+	mutex_unlock(&mali_mem_purgeable.lock);
+}
+
+static unsigned long mali_mem_purgeable_shrink_count(struct shrinker *shrinker, struct shrink_control *sc)
+{
+	return mali_mem_purgeable.pages;
+}
+
+/*
+ * Purge the oldest purgeable backends of sessions with no GP or PP jobs.
+ * Backends whose locks are busy are skipped, the reclaim may come from a
+ * thread holding them.
+ */
+#if LINUX_VERSION_CODE < KERNEL_VERSION(3, 12, 0)
+static int mali_mem_purgeable_shrink(struct shrinker *shrinker, struct shrink_control *sc)
+#else
+static unsigned long mali_mem_purgeable_shrink(struct shrinker *shrinker, struct shrink_control *sc)
+#endif
+{
+	mali_mem_backend *mem_bkend, *tmp;
+	unsigned long nr = sc->nr_to_scan;
+	unsigned long freed = 0;
+
+	if (0 == nr) {
+		return mali_mem_purgeable_shrink_count(shrinker, sc);
+	}
+
+	if (0 == mutex_trylock(&mali_mem_purgeable.lock)) {
+		/* Not able to lock. */
+		return -1;
+	}
+
+	list_for_each_entry_safe(mem_bkend, tmp, &mali_mem_purgeable.head, purge_link) {
+		struct mali_session_data *session = mem_bkend->mali_allocation->session;
+
+		if (freed >= nr) {
+			break;
+		}
+
+		if (MALI_FALSE == mali_session_is_idle(session)) {
+			continue;
+		}
+
+		if (0 == mutex_trylock(&mem_bkend->mutex)) {
+			continue;
+		}
+
+		if (MALI_FALSE == _mali_osk_mutex_trywait(session->memory_lock)) {
+			mutex_unlock(&mem_bkend->mutex);
+			continue;
+		}
+
+		/*
+		 * Pages shared with a COW copy are not ours alone to free, and only
+		 * the recorded vma is zapped, another one would keep the pages mapped.
+		 */
+		if (!(mem_bkend->flags & MALI_MEM_BACKEND_FLAG_COWED) &&
+		    MALI_FALSE == mali_mem_cpu_mapping_untracked(mem_bkend->mali_allocation)) {
+			freed += mali_mem_purgeable_purge(mem_bkend);
+		}
+
+		mali_session_memory_unlock(session);
+		mutex_unlock(&mem_bkend->mutex);
+	}
+
+	mutex_unlock(&mali_mem_purgeable.lock);
+
+#if LINUX_VERSION_CODE < KERNEL_VERSION(3, 12, 0)
+	return mali_mem_purgeable_shrink_count(shrinker, sc);
+#else
+	return freed;
+#endif
+}
+
+void mali_mem_purgeable_init(void)
+{
+	mutex_init(&mali_mem_purgeable.lock);
+	INIT_LIST_HEAD(&mali_mem_purgeable.head);
+	mali_mem_purgeable.pages = 0;
+	mali_mem_purgeable.purged_pages = 0;
+
+#if LINUX_VERSION_CODE < KERNEL_VERSION(3, 12, 0)
+	mali_mem_purgeable.shrinker.shrink = mali_mem_purgeable_shrink;
+#else
+	mali_mem_purgeable.shrinker.count_objects = mali_mem_purgeable_shrink_count;
+	mali_mem_purgeable.shrinker.scan_objects = mali_mem_purgeable_shrink;
+#endif
+	mali_mem_purgeable.shrinker.seeks = DEFAULT_SEEKS;
+	register_shrinker(&mali_mem_purgeable.shrinker);
+}
+
+void mali_mem_purgeable_term(void)
+{
+	unregister_shrinker(&mali_mem_purgeable.shrinker);
+	MALI_DEBUG_ASSERT(list_empty(&mali_mem_purgeable.head));
+}
+
+void mali_mem_purgeable_print_stats(_mali_osk_print_ctx *print_ctx)
+{
+	unsigned long pages;
+	u64 purged_pages;
+
+	mutex_lock(&mali_mem_purgeable.lock);
+	pages = mali_mem_purgeable.pages;
+	purged_pages = mali_mem_purgeable.purged_pages;
+	mutex_unlock(&mali_mem_purgeable.lock);
+
+	_mali_osk_ctxprintf(print_ctx, "\nPurgeable memory: %lu pages, %llu pages purged\n", pages, purged_pages);
+}
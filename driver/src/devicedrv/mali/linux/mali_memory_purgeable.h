@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2017 ARM Limited. All rights reserved.
+ * 
+ * This program is free software and is provided to you under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation, and any use by you of this program is subject to the terms of such GNU licence.
+ * 
+ * A copy of the licence is included with the program, and can also be obtained from Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __MALI_MEMORY_PURGEABLE_H__
+#define __MALI_MEMORY_PURGEABLE_H__
+
+#include "mali_osk.h"
+#include "mali_memory_types.h"
+
+void mali_mem_purgeable_init(void);
+void mali_mem_purgeable_term(void);
+
+/* Apply _MALI_MEM_MADVISE_DONTNEED or _MALI_MEM_MADVISE_WILLNEED to an OS memory backend.
+ * retained is set to MALI_FALSE if the pages were purged, WILLNEED then allocates new ones. */
+_mali_osk_errcode_t mali_mem_purgeable_advise(mali_mem_backend *mem_bkend, u32 advice, mali_bool *retained);
+
+/* Take a backend off the purgeable list before it is released */
+void mali_mem_purgeable_remove(mali_mem_backend *mem_bkend);
+
+void mali_mem_purgeable_print_stats(_mali_osk_print_ctx *print_ctx);
+
+#endif /* __MALI_MEMORY_PURGEABLE_H__ */
@@ -98,7 +98,7 @@ void mali_mem_secure_mali_unmap(mali_mem_allocation *alloc)
 
 	mali_session_memory_lock(session);
 	mali_mem_mali_map_free(session, alloc->psize, alloc->mali_vma_node.vm_node.start,
-			       alloc->flags);
+			       alloc->flags, NULL);
 	mali_session_memory_unlock(session);
 }
 
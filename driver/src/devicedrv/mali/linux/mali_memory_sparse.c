@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2017 ARM Limited. All rights reserved.
+ * 
+ * This program is free software and is provided to you under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation, and any use by you of this program is subject to the terms of such GNU licence.
+ * 
+ * A copy of the licence is included with the program, and can also be obtained from Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <linux/list.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
+
+#include "mali_kernel_common.h"
+#include "mali_osk.h"
+#include "mali_executor.h"
+#include "mali_mmu.h"
+#include "mali_memory.h"
+#include "mali_memory_os_alloc.h"
+#include "mali_memory_sparse.h"
+
+/* Unbound pages of all sparse allocations are mapped read only to this zeroed page */
+static mali_mem_os_mem mali_mem_sparse_scratch;
+static mali_dma_addr mali_mem_sparse_scratch_addr;
+
+#define MALI_MEM_SPARSE_SCRATCH_PROPS (MALI_MMU_FLAGS_PRESENT | MALI_MMU_FLAGS_READ_PERMISSION)
+
+_mali_osk_errcode_t mali_mem_sparse_init(void)
+{
+	struct mali_page_node *m_page;
+
+	if (mali_mem_os_alloc_pages(&mali_mem_sparse_scratch, _MALI_OSK_MALI_PAGE_SIZE)) {
+		return _MALI_OSK_ERR_NOMEM;
+	}
+
+	m_page = list_first_entry(&mali_mem_sparse_scratch.pages, struct mali_page_node, list);
+	mali_mem_sparse_scratch_addr = (mali_dma_addr)page_private(m_page->page);
+
+	return _MALI_OSK_ERR_OK;
+}
+
+void mali_mem_sparse_term(void)
+{
+	if (0 < mali_mem_sparse_scratch.count) {
+		mali_mem_os_free(&mali_mem_sparse_scratch.pages, mali_mem_sparse_scratch.count, MALI_FALSE);
+		mali_mem_sparse_scratch.count = 0;
+	}
+}
+
+_mali_osk_errcode_t mali_mem_sparse_alloc(mali_mem_sparse *sparse_mem, u32 size)
+{
+	u32 array_size;
+
+	sparse_mem->num_pages = size / _MALI_OSK_MALI_PAGE_SIZE;
+	sparse_mem->count = 0;
+
+	array_size = sizeof(struct mali_page_node *) * sparse_mem->num_pages;
+	sparse_mem->pages = _mali_osk_valloc(array_size);
+	if (NULL == sparse_mem->pages) {
+		return _MALI_OSK_ERR_NOMEM;
+	}
+	_mali_osk_memset(sparse_mem->pages, 0, array_size);
+
+	return _MALI_OSK_ERR_OK;
+}
+
+void mali_mem_sparse_mali_map(mali_mem_sparse *sparse_mem, struct mali_session_data *session, u32 vaddr,
+			      u32 first_page, u32 num_pages, u32 props)
+{
+	struct mali_mmu_pagedir_range range;
+	u32 i;
+
+	MALI_DEBUG_ASSERT(first_page + num_pages <= sparse_mem->num_pages);
+
+	mali_mmu_pagedir_range_begin(&range, session->page_directory, vaddr + first_page * MALI_MMU_PAGE_SIZE, props);
+
+	for (i = first_page; i < first_page + num_pages; i++) {
+		struct mali_page_node *m_page = sparse_mem->pages[i];
+
+		if (NULL != m_page) {
+			range.permission_bits = props;
+			mali_mmu_pagedir_range_add(&range, (mali_dma_addr)page_private(m_page->page));
+		} else {
+			range.permission_bits = MALI_MEM_SPARSE_SCRATCH_PROPS;
+			mali_mmu_pagedir_range_add(&range, mali_mem_sparse_scratch_addr);
+		}
+	}
+
+	mali_mmu_pagedir_range_end(&range);
+}
+
+void mali_mem_sparse_mali_unmap(mali_mem_allocation *alloc)
+{
+	struct mali_session_data *session;
+	MALI_DEBUG_ASSERT_POINTER(alloc);
+	session = alloc->session;
+	MALI_DEBUG_ASSERT_POINTER(session);
+
+	mali_session_memory_lock(session);
+	mali_mem_mali_map_free(session, mali_mem_mali_map_size(alloc), alloc->mali_vma_node.vm_node.start,
+			       alloc->flags, NULL);
+	mali_session_memory_unlock(session);
+}
+
+/* Rewrite the page table entries of a range and drop them from the TLBs of the running jobs */
+static void mali_mem_sparse_mali_remap(mali_mem_backend *mem_bkend, u32 first_page, u32 num_pages)
+{
+	mali_mem_allocation *alloc = mem_bkend->mali_allocation;
+	struct mali_session_data *session = alloc->session;
+	u32 vaddr = alloc->mali_vma_node.vm_node.start;
+	struct mali_mmu_invalidate_batch batch;
+
+	mali_session_memory_lock(session);
+	mali_mem_sparse_mali_map(&mem_bkend->sparse_mem, session, vaddr, first_page, num_pages,
+				 alloc->mali_mapping.properties);
+
+	mali_mmu_invalidate_batch_init(&batch);
+	mali_mmu_invalidate_batch_add(&batch, vaddr + first_page * MALI_MMU_PAGE_SIZE, num_pages * MALI_MMU_PAGE_SIZE);
+	mali_executor_zap_all_active(session, &batch);
+	mali_session_memory_unlock(session);
+}
+
+_mali_osk_errcode_t mali_mem_sparse_bind(mali_mem_backend *mem_bkend, u32 first_page, u32 num_pages)
+{
+	mali_mem_sparse *sparse_mem = &mem_bkend->sparse_mem;
+	struct mali_session_data *session = mem_bkend->mali_allocation->session;
+	struct mali_page_node *m_page, *m_tmp;
+	mali_mem_os_mem os_mem;
+	u32 num_unbound = 0;
+	u32 i;
+	int retval;
+
+	MALI_DEBUG_ASSERT(MALI_MEM_SPARSE == mem_bkend->type);
+	MALI_DEBUG_ASSERT(first_page + num_pages <= sparse_mem->num_pages);
+
+	mutex_lock(&mem_bkend->mutex);
+
+	for (i = first_page; i < first_page + num_pages; i++) {
+		if (NULL == sparse_mem->pages[i]) {
+			num_unbound++;
+		}
+	}
+
+	if (0 == num_unbound) {
+		mutex_unlock(&mem_bkend->mutex);
+		return _MALI_OSK_ERR_OK;
+	}
+
+	retval = mali_mem_os_alloc_pages(&os_mem, num_unbound * _MALI_OSK_MALI_PAGE_SIZE);
+	if (retval) {
+		mutex_unlock(&mem_bkend->mutex);
+		return (-ENOMEM == retval) ? _MALI_OSK_ERR_NOMEM : _MALI_OSK_ERR_FAULT;
+	}
+
+	/* Pages already bound in the range are kept */
+	i = first_page;
+	list_for_each_entry_safe(m_page, m_tmp, &os_mem.pages, list) {
+		while (NULL != sparse_mem->pages[i]) {
+			i++;
+		}
+		list_del(&m_page->list);
+		sparse_mem->pages[i] = m_page;
+	}
+	sparse_mem->count += num_unbound;
+	mem_bkend->mali_allocation->psize = sparse_mem->count * _MALI_OSK_MALI_PAGE_SIZE;
+
+	mali_mem_sparse_mali_remap(mem_bkend, first_page, num_pages);
+
+	mutex_unlock(&mem_bkend->mutex);
+
+	atomic_add(num_unbound, &session->mali_mem_allocated_pages);
+	if (atomic_read(&session->mali_mem_allocated_pages) * MALI_MMU_PAGE_SIZE > session->max_mali_mem_allocated_size) {
+		session->max_mali_mem_allocated_size = atomic_read(&session->mali_mem_allocated_pages) * MALI_MMU_PAGE_SIZE;
+	}
+
+	return _MALI_OSK_ERR_OK;
+}
+
+_mali_osk_errcode_t mali_mem_sparse_unbind(mali_mem_backend *mem_bkend, u32 first_page, u32 num_pages)
+{
+	mali_mem_sparse *sparse_mem = &mem_bkend->sparse_mem;
+	mali_mem_allocation *alloc = mem_bkend->mali_allocation;
+	struct mali_session_data *session = alloc->session;
+	struct vm_area_struct *vma;
+	u32 num_bound = 0;
+	u32 i;
+	LIST_HEAD(pages);
+
+	MALI_DEBUG_ASSERT(MALI_MEM_SPARSE == mem_bkend->type);
+	MALI_DEBUG_ASSERT(first_page + num_pages <= sparse_mem->num_pages);
+
+	mutex_lock(&mem_bkend->mutex);
+
+	/*
+	 * Only the recorded vma can be zapped, another one would keep access to
+	 * the freed pages. Faults wait for the backend mutex, so nothing maps the
+	 * range again before the pages are gone from the backend.
+	 */
+	mali_session_memory_lock(session);
+	if (MALI_TRUE == mali_mem_cpu_mapping_untracked(alloc)) {
+		MALI_DEBUG_PRINT(2, ("Mali sparse memory: can't unbind pages mapped by an unrecorded vma\n"));
+		mali_session_memory_unlock(session);
+		mutex_unlock(&mem_bkend->mutex);
+		return _MALI_OSK_ERR_BUSY;
+	}
+
+	vma = alloc->cpu_mapping.vma;
+	if (NULL != vma) {
+		zap_vma_ptes(vma, vma->vm_start + first_page * _MALI_OSK_MALI_PAGE_SIZE, num_pages * _MALI_OSK_MALI_PAGE_SIZE);
+	}
+	mali_session_memory_unlock(session);
+
+	for (i = first_page; i < first_page + num_pages; i++) {
+		if (NULL != sparse_mem->pages[i]) {
+			list_add_tail(&sparse_mem->pages[i]->list, &pages);
+			sparse_mem->pages[i] = NULL;
+			num_bound++;
+		}
+	}
+
+	if (0 == num_bound) {
+		mutex_unlock(&mem_bkend->mutex);
+		return _MALI_OSK_ERR_OK;
+	}
+
+	sparse_mem->count -= num_bound;
+	alloc->psize = sparse_mem->count * _MALI_OSK_MALI_PAGE_SIZE;
+
+	/* The GPU must be done with the pages before they are freed */
+	mali_mem_sparse_mali_remap(mem_bkend, first_page, num_pages);
+
+	mutex_unlock(&mem_bkend->mutex);
+
+	mali_mem_os_free(&pages, num_bound, MALI_FALSE);
+	atomic_sub(num_bound, &session->mali_mem_allocated_pages);
+
+	return _MALI_OSK_ERR_OK;
+}
+
+int mali_mem_sparse_cpu_fault(mali_mem_backend *mem_bkend, struct vm_area_struct *vma, unsigned long address)
+{
+	mali_mem_sparse *sparse_mem = &mem_bkend->sparse_mem;
+	u32 index = (address - vma->vm_start) / _MALI_OSK_MALI_PAGE_SIZE;
+	struct mali_page_node *m_page = NULL;
+	int ret = -EFAULT;
+
+	MALI_DEBUG_ASSERT(MALI_MEM_SPARSE == mem_bkend->type);
+
+	mutex_lock(&mem_bkend->mutex);
+	if (index < sparse_mem->num_pages) {
+		m_page = sparse_mem->pages[index];
+	}
+
+	if (NULL != m_page) {
+		ret = vm_insert_pfn(vma, address & PAGE_MASK, page_to_pfn(m_page->page));
+	}
+	mutex_unlock(&mem_bkend->mutex);
+
+	return ret;
+}
+
+u32 mali_mem_sparse_release(mali_mem_backend *mem_bkend)
+{
+	mali_mem_sparse *sparse_mem = &mem_bkend->sparse_mem;
+	u32 free_pages_nr = 0;
+	u32 i;
+	LIST_HEAD(pages);
+
+	MALI_DEBUG_ASSERT(MALI_MEM_SPARSE == mem_bkend->type);
+
+	/* Unmap the memory from the mali virtual address space. */
+	mali_mem_sparse_mali_unmap(mem_bkend->mali_allocation);
+
+	mutex_lock(&mem_bkend->mutex);
+	for (i = 0; i < sparse_mem->num_pages; i++) {
+		if (NULL != sparse_mem->pages[i]) {
+			list_add_tail(&sparse_mem->pages[i]->list, &pages);
+		}
+	}
+	free_pages_nr = mali_mem_os_free(&pages, sparse_mem->count, MALI_FALSE);
+	sparse_mem->count = 0;
+
+	_mali_osk_vfree(sparse_mem->pages);
+	sparse_mem->pages = NULL;
+	mutex_unlock(&mem_bkend->mutex);
+
+	return free_pages_nr;
+}
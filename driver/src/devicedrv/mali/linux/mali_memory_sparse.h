@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2017 ARM Limited. All rights reserved.
+ * 
+ * This program is free software and is provided to you under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation, and any use by you of this program is subject to the terms of such GNU licence.
+ * 
+ * A copy of the licence is included with the program, and can also be obtained from Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __MALI_MEMORY_SPARSE_H__
+#define __MALI_MEMORY_SPARSE_H__
+
+#include "mali_session.h"
+#include "mali_memory.h"
+
+#include "mali_memory_types.h"
+
+_mali_osk_errcode_t mali_mem_sparse_init(void);
+void mali_mem_sparse_term(void);
+
+/* Set up a sparse backend covering size bytes, with no pages bound */
+_mali_osk_errcode_t mali_mem_sparse_alloc(mali_mem_sparse *sparse_mem, u32 size);
+
+/* Write the Mali page table entries of a page range, unbound pages are mapped read only to the scratch page */
+void mali_mem_sparse_mali_map(mali_mem_sparse *sparse_mem, struct mali_session_data *session, u32 vaddr,
+			      u32 first_page, u32 num_pages, u32 props);
+
+void mali_mem_sparse_mali_unmap(mali_mem_allocation *alloc);
+
+/* Bind pages to the unbound pages of a range, or unbind all pages of a range */
+_mali_osk_errcode_t mali_mem_sparse_bind(mali_mem_backend *mem_bkend, u32 first_page, u32 num_pages);
+_mali_osk_errcode_t mali_mem_sparse_unbind(mali_mem_backend *mem_bkend, u32 first_page, u32 num_pages);
+
+/* Map a bound page on CPU fault, fails for unbound pages */
+int mali_mem_sparse_cpu_fault(mali_mem_backend *mem_bkend, struct vm_area_struct *vma, unsigned long address);
+
+u32 mali_mem_sparse_release(mali_mem_backend *mem_bkend);
+
+#endif /* __MALI_MEMORY_SPARSE_H__ */
@@ -23,6 +23,7 @@
 #include <linux/file.h>
 #include <linux/swap.h>
 #include <linux/pagemap.h>
+#include <linux/math64.h>
 #include "mali_osk.h"
 #include "mali_osk_mali.h"
 #include "mali_memory.h"
@@ -32,12 +33,14 @@
 #include "mali_ukk.h"
 #include "mali_kernel_utilization.h"
 #include "mali_memory_swap_alloc.h"
+#include "mali_timeline.h"
 
 
 static struct _mali_osk_bitmap idx_mgr;
 static struct file *global_swap_file;
 static struct address_space *global_swap_space;
 static _mali_osk_wq_work_t *mali_mem_swap_out_workq = NULL;
+static _mali_osk_wq_work_t *mali_mem_swap_background_workq = NULL;
 static u32 mem_backend_swapped_pool_size;
 #ifdef MALI_MEM_SWAP_TRACKING
 static u32 mem_backend_swapped_unlock_size;
@@ -47,27 +50,43 @@ static u32 mem_backend_swapped_unlock_size;
 static struct mutex mem_backend_swapped_pool_lock;
 static struct list_head mem_backend_swapped_pool;
 
+/* Swap in latency histogram, bucket i counts swap ins which took less than 2^i us. */
+#define MALI_MEM_SWAP_IN_HIST_BUCKETS 21
+
+/* PP jobs waiting for the swap in worker, in submission order. The lock also protects the statistics. */
+static _mali_osk_wq_work_t *mali_mem_swap_in_workq = NULL;
+static spinlock_t mali_mem_swap_in_lock;
+static struct list_head mali_mem_swap_in_jobs;
+static u64 mali_mem_swap_in_hist[MALI_MEM_SWAP_IN_HIST_BUCKETS];
+static u64 mali_mem_swap_in_max_us;
+
 extern struct mali_mem_os_allocator mali_mem_os_allocator;
 
 #define MALI_SWAP_LOW_MEM_DEFAULT_VALUE (60*1024*1024)
-#define MALI_SWAP_INVALIDATE_MALI_ADDRESS (0)               /* Used to mark the given memory cookie is invalidate. */
+#define MALI_SWAP_BACKGROUND_MEM_DEFAULT_VALUE (120*1024*1024)
 #define MALI_SWAP_GLOBAL_SWAP_FILE_SIZE (0xFFFFFFFF)
 #define MALI_SWAP_GLOBAL_SWAP_FILE_INDEX ((MALI_SWAP_GLOBAL_SWAP_FILE_SIZE) >> PAGE_SHIFT)
 #define MALI_SWAP_GLOBAL_SWAP_FILE_INDEX_RESERVE (1 << 15) /* Reserved for CoW nonlinear swap backend memory, the space size is 128MB. */
 
 unsigned int mali_mem_swap_out_threshold_value = MALI_SWAP_LOW_MEM_DEFAULT_VALUE;
+unsigned int mali_mem_swap_out_background_value = MALI_SWAP_BACKGROUND_MEM_DEFAULT_VALUE;
 
 /**
  * We have two situations to do shrinking things, one is we met low GPU utilization which shows GPU needn't touch too
  * swappable backends in short time, and the other one is we add new swappable backends, the total pool size exceed
  * the threshold value of the swapped pool size.
+ * Before either happens, backends which no job has used for a while are swapped out in the background as soon as
+ * system free memory drops below the higher background watermark.
  */
 typedef enum {
 	MALI_MEM_SWAP_SHRINK_WITH_LOW_UTILIZATION = 100,
 	MALI_MEM_SWAP_SHRINK_FOR_ADDING_NEW_BACKENDS = 257,
+	MALI_MEM_SWAP_SHRINK_IN_BACKGROUND = 258,
 } _mali_mem_swap_pool_shrink_type_t;
 
 static void mali_mem_swap_swapped_bkend_pool_check_for_low_utilization(void *arg);
+static void mali_mem_swap_swapped_bkend_pool_background_shrink(void *arg);
+static void mali_mem_swap_in_worker(void *arg);
 
 _mali_osk_errcode_t mali_mem_swap_init(void)
 {
@@ -92,6 +111,23 @@ _mali_osk_errcode_t mali_mem_swap_init(void)
 		return _MALI_OSK_ERR_NOMEM;
 	}
 
+	mali_mem_swap_in_workq = _mali_osk_wq_create_work(mali_mem_swap_in_worker, NULL);
+	if (NULL == mali_mem_swap_in_workq) {
+		_mali_osk_wq_delete_work(mali_mem_swap_out_workq);
+		_mali_osk_bitmap_term(&idx_mgr);
+		fput(global_swap_file);
+		return _MALI_OSK_ERR_NOMEM;
+	}
+
+	mali_mem_swap_background_workq = _mali_osk_wq_create_work(mali_mem_swap_swapped_bkend_pool_background_shrink, NULL);
+	if (NULL == mali_mem_swap_background_workq) {
+		_mali_osk_wq_delete_work(mali_mem_swap_in_workq);
+		_mali_osk_wq_delete_work(mali_mem_swap_out_workq);
+		_mali_osk_bitmap_term(&idx_mgr);
+		fput(global_swap_file);
+		return _MALI_OSK_ERR_NOMEM;
+	}
+
 #if defined(CONFIG_ARM) && !defined(CONFIG_ARM_LPAE)
 	flags |= GFP_HIGHUSER;
 #else
@@ -120,6 +156,9 @@ _mali_osk_errcode_t mali_mem_swap_init(void)
 	mutex_init(&mem_backend_swapped_pool_lock);
 	INIT_LIST_HEAD(&mem_backend_swapped_pool);
 
+	spin_lock_init(&mali_mem_swap_in_lock);
+	INIT_LIST_HEAD(&mali_mem_swap_in_jobs);
+
 	MALI_DEBUG_PRINT(2, ("Mali SWAP: Swap out threshold vaule is %uM\n", mali_mem_swap_out_threshold_value >> 20));
 
 	return _MALI_OSK_ERR_OK;
@@ -132,8 +171,11 @@ void mali_mem_swap_term(void)
 	fput(global_swap_file);
 
 	_mali_osk_wq_delete_work(mali_mem_swap_out_workq);
+	_mali_osk_wq_delete_work(mali_mem_swap_in_workq);
+	_mali_osk_wq_delete_work(mali_mem_swap_background_workq);
 
 	MALI_DEBUG_ASSERT(list_empty(&mem_backend_swapped_pool));
+	MALI_DEBUG_ASSERT(list_empty(&mali_mem_swap_in_jobs));
 	MALI_DEBUG_ASSERT(0 == mem_backend_swapped_pool_size);
 
 	return;
@@ -219,11 +261,69 @@ static void mali_mem_swap_unlock_partial_locked_mem_backend(mali_mem_backend *me
 	}
 }
 
-static void mali_mem_swap_swapped_bkend_pool_shrink(_mali_mem_swap_pool_shrink_type_t shrink_type)
+/**
+ * Swap out backends from the swapped pool until it is down to target_size, in CLOCK order.
+ * The pool is ordered by when jobs stopped using each backend. A backend which has been
+ * referenced by a job since the clock hand last passed it gets a second chance at the tail.
+ * Only backends not referenced for a whole pass are swapped out, so the working set of
+ * recent frames stays locked in memory as long as there is anything colder to evict.
+ *
+ * @param target_size Pool size to shrink to.
+ * @param max_passes Number of passes over the pool, 1 only evicts backends which were not
+ * referenced since the previous sweep.
+ */
+static void mali_mem_swap_swapped_bkend_pool_evict(u32 target_size, int max_passes)
 {
 	mali_mem_backend *bkend, *tmp_bkend;
+	LIST_HEAD(referenced_list);
+	int pass;
+
+	MALI_DEBUG_ASSERT(1 == mutex_is_locked(&mem_backend_swapped_pool_lock));
+
+	for (pass = 0; pass < max_passes && mem_backend_swapped_pool_size > target_size; pass++) {
+		list_for_each_entry_safe(bkend, tmp_bkend, &mem_backend_swapped_pool, list) {
+			if (mem_backend_swapped_pool_size <= target_size) {
+				break;
+			}
+
+			mutex_lock(&bkend->mutex);
+
+			/* check if backend is in use. */
+			if (0 < bkend->using_count) {
+				mutex_unlock(&bkend->mutex);
+				continue;
+			}
+
+			if (MALI_TRUE == bkend->swap_referenced) {
+				/* Second chance, it goes back to the tail once this pass is done. */
+				bkend->swap_referenced = MALI_FALSE;
+				list_move_tail(&bkend->list, &referenced_list);
+				mutex_unlock(&bkend->mutex);
+				continue;
+			}
+
+			MALI_DEBUG_PRINT(4, ("Mali SWAP: swapping out backend of %u bytes, last used by job %u\n",
+					     bkend->size, bkend->swap_last_job_id));
+
+			mali_mem_swap_unlock_single_mem_backend(bkend);
+			list_del_init(&bkend->list);
+			mem_backend_swapped_pool_size -= bkend->size;
+#ifdef MALI_MEM_SWAP_TRACKING
+			mem_backend_swapped_unlock_size += bkend->size;
+#endif
+			mutex_unlock(&bkend->mutex);
+		}
+
+		list_splice_tail_init(&referenced_list, &mem_backend_swapped_pool);
+	}
+}
+
+static void mali_mem_swap_swapped_bkend_pool_shrink(_mali_mem_swap_pool_shrink_type_t shrink_type)
+{
 	long system_free_size;
 	u32 last_gpu_utilization, gpu_utilization_threshold_value, temp_swap_out_threshold_value;
+	u32 free_threshold_value = mali_mem_swap_out_threshold_value;
+	int max_passes = 2;
 
 	MALI_DEBUG_ASSERT(1 == mutex_is_locked(&mem_backend_swapped_pool_lock));
 
@@ -235,6 +335,14 @@ static void mali_mem_swap_swapped_bkend_pool_shrink(_mali_mem_swap_pool_shrink_t
 		 */
 		gpu_utilization_threshold_value = MALI_MEM_SWAP_SHRINK_WITH_LOW_UTILIZATION;
 		temp_swap_out_threshold_value = (mali_mem_swap_out_threshold_value >> 2);
+	} else if (MALI_MEM_SWAP_SHRINK_IN_BACKGROUND == shrink_type) {
+		/* Proactive swap out, started at the higher background watermark so that the low memory
+		 * case below is hit less often. GPU utilization isn't considered, but only backends which
+		 * were not referenced since the last sweep are swapped out. */
+		gpu_utilization_threshold_value = MALI_MEM_SWAP_SHRINK_FOR_ADDING_NEW_BACKENDS;
+		temp_swap_out_threshold_value = (mali_mem_swap_out_threshold_value >> 1);
+		free_threshold_value = mali_mem_swap_out_background_value;
+		max_passes = 1;
 	} else {
 		/* When we add swappable memory backends to swapped pool, we need to think that we couldn't
 		* hold too much swappable backends in Mali driver, and also we need considering performance.
@@ -252,29 +360,9 @@ static void mali_mem_swap_swapped_bkend_pool_shrink(_mali_mem_swap_pool_shrink_t
 	last_gpu_utilization = _mali_ukk_utilization_gp_pp();
 
 	if ((last_gpu_utilization < gpu_utilization_threshold_value)
-	    && (system_free_size < mali_mem_swap_out_threshold_value)
+	    && (system_free_size < free_threshold_value)
 	    && (mem_backend_swapped_pool_size > temp_swap_out_threshold_value)) {
-		list_for_each_entry_safe(bkend, tmp_bkend, &mem_backend_swapped_pool, list) {
-			if (mem_backend_swapped_pool_size <= temp_swap_out_threshold_value) {
-				break;
-			}
-
-			mutex_lock(&bkend->mutex);
-
-			/* check if backend is in use. */
-			if (0 < bkend->using_count) {
-				mutex_unlock(&bkend->mutex);
-				continue;
-			}
-
-			mali_mem_swap_unlock_single_mem_backend(bkend);
-			list_del_init(&bkend->list);
-			mem_backend_swapped_pool_size -= bkend->size;
-#ifdef MALI_MEM_SWAP_TRACKING
-			mem_backend_swapped_unlock_size += bkend->size;
-#endif
-			mutex_unlock(&bkend->mutex);
-		}
+		mali_mem_swap_swapped_bkend_pool_evict(temp_swap_out_threshold_value, max_passes);
 	}
 
 	return;
@@ -291,6 +379,17 @@ static void mali_mem_swap_swapped_bkend_pool_check_for_low_utilization(void *arg
 	mutex_unlock(&mem_backend_swapped_pool_lock);
 }
 
+static void mali_mem_swap_swapped_bkend_pool_background_shrink(void *arg)
+{
+	MALI_IGNORE(arg);
+
+	mutex_lock(&mem_backend_swapped_pool_lock);
+
+	mali_mem_swap_swapped_bkend_pool_shrink(MALI_MEM_SWAP_SHRINK_IN_BACKGROUND);
+
+	mutex_unlock(&mem_backend_swapped_pool_lock);
+}
+
 /**
  * After PP job finished, we add all of swappable memory backend used by this PP
  * job to the tail of the global swapped pool, and if the total size of swappable memory is more than threshold
@@ -307,16 +406,20 @@ void mali_memory_swap_list_backend_add(mali_mem_backend *mem_bkend)
 		list_del_init(&mem_bkend->list);
 		list_add_tail(&mem_bkend->list, &mem_backend_swapped_pool);
 		mutex_unlock(&mem_bkend->mutex);
-		mutex_unlock(&mem_backend_swapped_pool_lock);
-		return;
-	}
+	} else {
+		list_add_tail(&mem_bkend->list, &mem_backend_swapped_pool);
 
-	list_add_tail(&mem_bkend->list, &mem_backend_swapped_pool);
+		mutex_unlock(&mem_bkend->mutex);
+		mem_backend_swapped_pool_size += mem_bkend->size;
 
-	mutex_unlock(&mem_bkend->mutex);
-	mem_backend_swapped_pool_size += mem_bkend->size;
+		mali_mem_swap_swapped_bkend_pool_shrink(MALI_MEM_SWAP_SHRINK_FOR_ADDING_NEW_BACKENDS);
+	}
 
-	mali_mem_swap_swapped_bkend_pool_shrink(MALI_MEM_SWAP_SHRINK_FOR_ADDING_NEW_BACKENDS);
+	/* Start swapping out cold backends early, before the low memory threshold is reached. */
+	if ((mem_backend_swapped_pool_size > (mali_mem_swap_out_threshold_value >> 1))
+	    && (global_page_state(NR_FREE_PAGES) * PAGE_SIZE < mali_mem_swap_out_background_value)) {
+		_mali_osk_wq_schedule_work(mali_mem_swap_background_workq);
+	}
 
 	mutex_unlock(&mem_backend_swapped_pool_lock);
 	return;
@@ -598,7 +701,7 @@ void mali_mem_swap_mali_unmap(mali_mem_allocation *alloc)
 
 	mali_session_memory_lock(session);
 	mali_mem_mali_map_free(session, alloc->psize, alloc->mali_vma_node.vm_node.start,
-			       alloc->flags);
+			       alloc->flags, NULL);
 	mali_session_memory_unlock(session);
 }
 
@@ -607,82 +710,57 @@ void mali_mem_swap_mali_unmap(mali_mem_allocation *alloc)
 _mali_osk_errcode_t mali_mem_swap_mali_map(mali_mem_swap *swap_mem, struct mali_session_data *session, u32 vaddr, u32 props)
 {
 	struct mali_page_directory *pagedir = session->page_directory;
+	struct mali_mmu_pagedir_range range;
 	struct mali_page_node *m_page;
 	dma_addr_t phys;
-	u32 virt = vaddr;
-	u32 prop = props;
+
+	mali_mmu_pagedir_range_begin(&range, pagedir, vaddr, props);
 
 	list_for_each_entry(m_page, &swap_mem->pages, list) {
 		MALI_DEBUG_ASSERT(NULL != m_page->swap_it->page);
 		phys = m_page->swap_it->dma_addr;
 
-		mali_mmu_pagedir_update(pagedir, virt, phys, MALI_MMU_PAGE_SIZE, prop);
-		virt += MALI_MMU_PAGE_SIZE;
+		mali_mmu_pagedir_range_add(&range, phys);
 	}
 
+	mali_mmu_pagedir_range_end(&range);
+
 	return _MALI_OSK_ERR_OK;
 }
 
-int mali_mem_swap_in_pages(struct mali_pp_job *job)
+/* Swap in all memory backends used by a PP job, reading from the swap file as needed. */
+static int mali_mem_swap_in_job_pages(struct mali_pp_job *job)
 {
-	u32 num_memory_cookies;
+	u32 num_swap_backends;
 	struct mali_session_data *session;
-	struct mali_vma_node *mali_vma_node = NULL;
 	mali_mem_allocation *mali_alloc = NULL;
 	mali_mem_backend *mem_bkend = NULL;
 	struct mali_page_node *m_page;
 	mali_bool swap_in_success = MALI_TRUE;
-	int i;
+	u32 i;
 
 	MALI_DEBUG_ASSERT_POINTER(job);
 
-	num_memory_cookies = mali_pp_job_num_memory_cookies(job);
+	num_swap_backends = mali_pp_job_num_swap_backends(job);
 	session = mali_pp_job_get_session(job);
 
 	MALI_DEBUG_ASSERT_POINTER(session);
 
-	for (i = 0; i < num_memory_cookies; i++) {
-
-		u32 mali_addr  = mali_pp_job_get_memory_cookie(job, i);
-
-		mali_vma_node = mali_vma_offset_search(&session->allocation_mgr, mali_addr, 0);
-		if (NULL == mali_vma_node) {
-			job->memory_cookies[i] = MALI_SWAP_INVALIDATE_MALI_ADDRESS;
-			swap_in_success = MALI_FALSE;
-			MALI_PRINT_ERROR(("SWAP Mem: failed to find mali_vma_node through Mali address: 0x%08x.\n", mali_addr));
-			continue;
-		}
-
-		mali_alloc = container_of(mali_vma_node, struct mali_mem_allocation, mali_vma_node);
-		MALI_DEBUG_ASSERT(NULL != mali_alloc);
-
-		if (MALI_MEM_SWAP != mali_alloc->type &&
-		    MALI_MEM_COW != mali_alloc->type) {
-			continue;
-		}
-
-		/* Get backend memory & Map on GPU */
-		mutex_lock(&mali_idr_mutex);
-		mem_bkend = idr_find(&mali_backend_idr, mali_alloc->backend_handle);
-		mutex_unlock(&mali_idr_mutex);
-		MALI_DEBUG_ASSERT(NULL != mem_bkend);
+	/* A job with an unknown memory cookie is rejected by its creator, nothing to swap in. */
+	if (MALI_TRUE == mali_pp_job_has_invalid_memory_cookies(job)) {
+		job->swap_status = MALI_SWAP_IN_FAIL;
+		return _MALI_OSK_ERR_OK;
+	}
 
-		/* We neednot hold backend's lock here, race safe.*/
-		if ((MALI_MEM_COW == mem_bkend->type) &&
-		    (!(mem_bkend->flags & MALI_MEM_BACKEND_FLAG_SWAP_COWED))) {
-			continue;
-		}
+	for (i = 0; i < num_swap_backends; i++) {
+		mem_bkend = mali_pp_job_get_swap_backend(job, i);
+		mali_alloc = mem_bkend->mali_allocation;
 
 		mutex_lock(&mem_bkend->mutex);
 
-		/* When swap_in_success is MALI_FALSE, it means this job has memory backend that could not be swapped in,
-		 * and it will be aborted in mali scheduler, so here, we just mark those memory cookies which
-		 * should not be swapped out when delete job to invalide */
-		if (MALI_FALSE == swap_in_success) {
-			job->memory_cookies[i] = MALI_SWAP_INVALIDATE_MALI_ADDRESS;
-			mutex_unlock(&mem_bkend->mutex);
-			continue;
-		}
+		/* Record the use for the swap out clock, see mali_mem_swap_swapped_bkend_pool_evict(). */
+		mem_bkend->swap_referenced = MALI_TRUE;
+		mem_bkend->swap_last_job_id = mali_pp_job_get_id(job);
 
 		/* Before swap in, checking if this memory backend has been swapped in by the latest flushed jobs. */
 		++mem_bkend->using_count;
@@ -709,79 +787,190 @@ int mali_mem_swap_in_pages(struct mali_pp_job *job)
 			}
 		}
 
-		if (swap_in_success) {
-#ifdef MALI_MEM_SWAP_TRACKING
-			mem_backend_swapped_unlock_size -= mem_bkend->size;
-#endif
-			_mali_osk_mutex_wait(session->memory_lock);
-			mali_mem_swap_mali_map(&mem_bkend->swap_mem, session, mali_alloc->mali_mapping.addr, mali_alloc->mali_mapping.properties);
-			_mali_osk_mutex_signal(session->memory_lock);
-
-			/* Remove the unlock flag from mem backend flags, mark this backend has been swapped in. */
-			mem_bkend->flags &= ~(MALI_MEM_BACKEND_FLAG_UNSWAPPED_IN);
-			mutex_unlock(&mem_bkend->mutex);
-		} else {
+		if (MALI_FALSE == swap_in_success) {
 			--mem_bkend->using_count;
-			/* Marking that this backend is not swapped in, need not to be processed anymore. */
-			job->memory_cookies[i] = MALI_SWAP_INVALIDATE_MALI_ADDRESS;
 			mutex_unlock(&mem_bkend->mutex);
+			/* The job will be aborted in mali scheduler, so stop here, only the backends before
+			 * this one have to be released by mali_mem_swap_out_pages() when the job is deleted. */
+			break;
 		}
+
+#ifdef MALI_MEM_SWAP_TRACKING
+		mem_backend_swapped_unlock_size -= mem_bkend->size;
+#endif
+		_mali_osk_mutex_wait(session->memory_lock);
+		mali_mem_swap_mali_map(&mem_bkend->swap_mem, session, mali_alloc->mali_mapping.addr, mali_alloc->mali_mapping.properties);
+		_mali_osk_mutex_signal(session->memory_lock);
+
+		/* Remove the unlock flag from mem backend flags, mark this backend has been swapped in. */
+		mem_bkend->flags &= ~(MALI_MEM_BACKEND_FLAG_UNSWAPPED_IN);
+		mutex_unlock(&mem_bkend->mutex);
 	}
 
+	job->num_swapped_in_backends = i;
 	job->swap_status = swap_in_success ? MALI_SWAP_IN_SUCC : MALI_SWAP_IN_FAIL;
 
 	return _MALI_OSK_ERR_OK;
 }
 
-int mali_mem_swap_out_pages(struct mali_pp_job *job)
+/*
+ * Check if the memory of a PP job can be swapped in without waiting for I/O,
+ * that is, every swappable backend is either locked in memory already or
+ * still has all its pages in the page cache of the swap file.
+ */
+static mali_bool mali_mem_swap_in_job_is_resident(struct mali_pp_job *job)
 {
-	u32 num_memory_cookies;
-	struct mali_session_data *session;
-	struct mali_vma_node *mali_vma_node = NULL;
-	mali_mem_allocation *mali_alloc = NULL;
+	u32 num_swap_backends;
 	mali_mem_backend *mem_bkend = NULL;
-	int i;
+	struct mali_page_node *m_page;
+	mali_bool resident = MALI_TRUE;
+	u32 i;
 
-	MALI_DEBUG_ASSERT_POINTER(job);
+	num_swap_backends = mali_pp_job_num_swap_backends(job);
 
-	num_memory_cookies = mali_pp_job_num_memory_cookies(job);
-	session = mali_pp_job_get_session(job);
+	for (i = 0; i < num_swap_backends && MALI_TRUE == resident; i++) {
+		mem_bkend = mali_pp_job_get_swap_backend(job, i);
 
-	MALI_DEBUG_ASSERT_POINTER(session);
+		mutex_lock(&mem_bkend->mutex);
 
+		if (MALI_MEM_BACKEND_FLAG_UNSWAPPED_IN == (MALI_MEM_BACKEND_FLAG_UNSWAPPED_IN & mem_bkend->flags)) {
+			list_for_each_entry(m_page, &mem_bkend->swap_mem.pages, list) {
+				/* Pages which went out to swap are not found in the page cache. */
+				struct page *page = find_get_page(global_swap_space, m_page->swap_it->idx);
 
-	for (i = 0; i < num_memory_cookies; i++) {
-		u32 mali_addr  = mali_pp_job_get_memory_cookie(job, i);
+				if (NULL == page) {
+					resident = MALI_FALSE;
+					break;
+				}
 
-		if (MALI_SWAP_INVALIDATE_MALI_ADDRESS == mali_addr) {
-			continue;
+				if (!PageUptodate(page)) {
+					resident = MALI_FALSE;
+				}
+				put_page(page);
+
+				if (MALI_FALSE == resident) {
+					break;
+				}
+			}
 		}
 
-		mali_vma_node = mali_vma_offset_search(&session->allocation_mgr, mali_addr, 0);
+		mutex_unlock(&mem_bkend->mutex);
+	}
 
-		if (NULL == mali_vma_node) {
-			MALI_PRINT_ERROR(("SWAP Mem: failed to find mali_vma_node through Mali address: 0x%08x.\n", mali_addr));
-			continue;
-		}
+	return resident;
+}
 
-		mali_alloc = container_of(mali_vma_node, struct mali_mem_allocation, mali_vma_node);
-		MALI_DEBUG_ASSERT(NULL != mali_alloc);
+int mali_mem_swap_in_pages(struct mali_pp_job *job)
+{
+	MALI_DEBUG_ASSERT_POINTER(job);
 
-		if (MALI_MEM_SWAP != mali_alloc->type &&
-		    MALI_MEM_COW != mali_alloc->type) {
-			continue;
-		}
+	if (MALI_TRUE == mali_mem_swap_in_job_is_resident(job)) {
+		return mali_mem_swap_in_job_pages(job);
+	}
 
-		mutex_lock(&mali_idr_mutex);
-		mem_bkend = idr_find(&mali_backend_idr, mali_alloc->backend_handle);
-		mutex_unlock(&mali_idr_mutex);
-		MALI_DEBUG_ASSERT(NULL != mem_bkend);
+	/* Reading from swap would stall the submitter, leave it to the swap in worker. */
+	job->swap_in_pending = MALI_TRUE;
 
-		/* We neednot hold backend's lock here, race safe.*/
-		if ((MALI_MEM_COW == mem_bkend->type) &&
-		    (!(mem_bkend->flags & MALI_MEM_BACKEND_FLAG_SWAP_COWED))) {
-			continue;
+	return _MALI_OSK_ERR_OK;
+}
+
+void mali_mem_swap_in_pages_async(struct mali_pp_job *job)
+{
+	MALI_DEBUG_ASSERT_POINTER(job);
+	MALI_DEBUG_ASSERT(MALI_TRUE == job->swap_in_pending);
+
+	job->swap_in_start = _mali_osk_time_get_ns();
+
+	spin_lock(&mali_mem_swap_in_lock);
+	list_add_tail(&job->swap_in_list, &mali_mem_swap_in_jobs);
+	spin_unlock(&mali_mem_swap_in_lock);
+
+	_mali_osk_wq_schedule_work(mali_mem_swap_in_workq);
+}
+
+static void mali_mem_swap_in_worker(void *arg)
+{
+	struct mali_pp_job *job;
+	u64 latency_us;
+	u32 bucket;
+
+	MALI_IGNORE(arg);
+
+	spin_lock(&mali_mem_swap_in_lock);
+
+	while (!list_empty(&mali_mem_swap_in_jobs)) {
+		job = list_first_entry(&mali_mem_swap_in_jobs, struct mali_pp_job, swap_in_list);
+		list_del_init(&job->swap_in_list);
+
+		spin_unlock(&mali_mem_swap_in_lock);
+
+		/* shmem reads swapped out pages with the kernel's swap readahead. */
+		mali_mem_swap_in_job_pages(job);
+
+		latency_us = div_u64(_mali_osk_time_get_ns() - job->swap_in_start, 1000);
+		bucket = (latency_us >> 32) ? MALI_MEM_SWAP_IN_HIST_BUCKETS - 1 : fls((u32)latency_us);
+		if (MALI_MEM_SWAP_IN_HIST_BUCKETS - 1 < bucket) {
+			bucket = MALI_MEM_SWAP_IN_HIST_BUCKETS - 1;
+		}
+
+		spin_lock(&mali_mem_swap_in_lock);
+		mali_mem_swap_in_hist[bucket]++;
+		if (latency_us > mali_mem_swap_in_max_us) {
+			mali_mem_swap_in_max_us = latency_us;
 		}
+		spin_unlock(&mali_mem_swap_in_lock);
+
+		/* Makes the job runnable, it must not be touched after this. */
+		mali_timeline_swap_in_callback(job);
+
+		spin_lock(&mali_mem_swap_in_lock);
+	}
+
+	spin_unlock(&mali_mem_swap_in_lock);
+}
+
+void mali_mem_swap_in_print_stats(_mali_osk_print_ctx *print_ctx)
+{
+	u64 hist[MALI_MEM_SWAP_IN_HIST_BUCKETS];
+	u64 max_us;
+	u64 total = 0;
+	u32 i;
+
+	spin_lock(&mali_mem_swap_in_lock);
+	memcpy(hist, mali_mem_swap_in_hist, sizeof(hist));
+	max_us = mali_mem_swap_in_max_us;
+	spin_unlock(&mali_mem_swap_in_lock);
+
+	for (i = 0; i < MALI_MEM_SWAP_IN_HIST_BUCKETS; i++) {
+		total += hist[i];
+	}
+
+	_mali_osk_ctxprintf(print_ctx, "Deferred swap ins: %llu, max %llu us\n", total, max_us);
+
+	for (i = 0; i < MALI_MEM_SWAP_IN_HIST_BUCKETS - 1; i++) {
+		_mali_osk_ctxprintf(print_ctx, "  < %8u us: %llu\n", 1U << i, hist[i]);
+	}
+	_mali_osk_ctxprintf(print_ctx, "  >= %7u us: %llu\n", 1U << (MALI_MEM_SWAP_IN_HIST_BUCKETS - 2), hist[i]);
+}
+
+void mali_mem_swap_in_reset_stats(void)
+{
+	spin_lock(&mali_mem_swap_in_lock);
+	memset(mali_mem_swap_in_hist, 0, sizeof(mali_mem_swap_in_hist));
+	mali_mem_swap_in_max_us = 0;
+	spin_unlock(&mali_mem_swap_in_lock);
+}
+
+int mali_mem_swap_out_pages(struct mali_pp_job *job)
+{
+	mali_mem_backend *mem_bkend = NULL;
+	u32 i;
+
+	MALI_DEBUG_ASSERT_POINTER(job);
+
+	/* Only backends which mali_mem_swap_in_job_pages() counted as in use by this job. */
+	for (i = 0; i < job->num_swapped_in_backends; i++) {
+		mem_bkend = mali_pp_job_get_swap_backend(job, i);
 
 		mutex_lock(&mem_bkend->mutex);
 
@@ -800,6 +989,8 @@ int mali_mem_swap_out_pages(struct mali_pp_job *job)
 		mali_memory_swap_list_backend_add(mem_bkend);
 	}
 
+	job->num_swapped_in_backends = 0;
+
 	return _MALI_OSK_ERR_OK;
 }
 
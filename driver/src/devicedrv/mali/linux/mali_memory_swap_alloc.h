@@ -96,9 +96,23 @@ void mali_mem_swap_mali_unmap(mali_mem_allocation *alloc);
 
 /**
  * When pp job created, we need swap in all of memory backend needed by this pp job.
+ * If that needs reading from swap, the job is only marked with swap_in_pending and
+ * the swap in is done by the swap in worker once the job is in the timeline system.
  */
 int mali_mem_swap_in_pages(struct mali_pp_job *job);
 
+/**
+ * Hand a job marked with swap_in_pending to the swap in worker. The worker calls
+ * mali_timeline_swap_in_callback() when the job's memory is swapped in.
+ */
+void mali_mem_swap_in_pages_async(struct mali_pp_job *job);
+
+/**
+ * Print and reset the swap in latency histogram of the swap in worker.
+ */
+void mali_mem_swap_in_print_stats(_mali_osk_print_ctx *print_ctx);
+void mali_mem_swap_in_reset_stats(void);
+
 /**
  * Put all of memory backends used this pp job to the global swap list.
  */
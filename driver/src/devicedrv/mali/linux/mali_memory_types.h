@@ -28,6 +28,7 @@ typedef enum mali_mem_type {
 	MALI_MEM_BLOCK,
 	MALI_MEM_COW,
 	MALI_MEM_SECURE,
+	MALI_MEM_SPARSE,
 	MALI_MEM_TYPE_MAX,
 } mali_mem_type;
 
@@ -108,6 +109,7 @@ typedef struct mali_mem_virt_mali_mapping {
 typedef struct mali_mem_virt_cpu_mapping {
 	void __user *addr;
 	struct vm_area_struct *vma;
+	u32 count;           /* vmas mapping the allocation, split ones included, protected by the session memory lock */
 } mali_mem_virt_cpu_mapping;
 
 #define MALI_MEM_ALLOCATION_VALID_MAGIC 0xdeda110c
@@ -118,6 +120,7 @@ typedef struct mali_mm_node {
 	uint32_t start; /* GPU vaddr */
 	uint32_t size;  /* GPU allocation virtual size */
 	unsigned allocated : 1;
+	unsigned kernel_placed : 1; /* start was chosen by mali_vma_offset_alloc() */
 } mali_mm_node;
 
 typedef struct mali_vma_node {
@@ -145,16 +148,31 @@ typedef struct mali_mem_allocation {
 	_mali_osk_atomic_t mem_alloc_refcount;
 } mali_mem_allocation;
 
+/* Per-CPU front cache of the OS memory page pool */
+struct mali_mem_os_magazine {
+	spinlock_t lock;                   /**< Only contended when the magazines are drained */
+	struct list_head pages;            /**< Zeroed pages, ready to be handed out */
+	size_t count;
+	struct list_head dirty_pages;      /**< Freed pages, drained to the global dirty list to be zeroed */
+	size_t dirty_count;
+	u64 hits;                          /**< Pages served from this magazine */
+	u64 misses;                        /**< Pages which had to come from the global pool or the kernel */
+};
+
 struct mali_mem_os_allocator {
 	spinlock_t pool_lock;
-	struct list_head pool_pages;
+	struct list_head pool_pages;       /**< Zeroed pages, ready to be handed out */
 	size_t pool_count;
+	struct list_head dirty_pages;      /**< Freed pages waiting to be zeroed */
+	size_t dirty_count;
+	struct mali_mem_os_magazine __percpu *magazines;
 
 	atomic_t allocated_pages;
 	size_t allocation_limit;
 
 	struct shrinker shrinker;
 	struct delayed_work timed_shrinker;
+	struct delayed_work zero_work;     /**< Zeroes dirty pages while the GPU is idle */
 	struct workqueue_struct *wq;
 };
 
@@ -180,6 +198,12 @@ typedef struct mali_mem_secure {
 	u32 count;
 } mali_mem_secure;
 
+typedef struct mali_mem_sparse {
+	struct mali_page_node **pages;  /**< One per page of the virtual range, NULL if the page is unbound */
+	u32 num_pages;                  /**< Number of pages in the virtual range */
+	u32 count;                      /**< Number of bound pages */
+} mali_mem_sparse;
+
 #define MALI_MEM_BACKEND_FLAG_COWED                   (0x1)  /* COW has happen on this backend */
 #define MALI_MEM_BACKEND_FLAG_COW_CPU_NO_WRITE        (0x2)  /* This is an COW backend, mapped as not allowed cpu to write */
 #define MALI_MEM_BACKEND_FLAG_SWAP_COWED              (0x4)  /* Mark the given backend is cowed from swappable memory. */
@@ -188,11 +212,15 @@ typedef struct mali_mem_secure {
 #define MALI_MEM_BACKEND_FLAG_UNSWAPPED_IN            (0x8)
 #define MALI_MEM_BACKEND_FLAG_NOT_BINDED              (0x1 << 5) /* this backend it not back with physical memory, used for defer bind */
 #define MALI_MEM_BACKEND_FLAG_BINDED              (0x1 << 6) /* this backend it back with physical memory, used for defer bind */
+#define MALI_MEM_BACKEND_FLAG_PURGEABLE           (0x1 << 7) /* User space marked the contents as not needed, the pages may be purged */
+#define MALI_MEM_BACKEND_FLAG_PURGED              (0x1 << 8) /* The pages were purged, and the memory is unmapped from Mali */
 
 typedef struct mali_mem_backend {
 	mali_mem_type type;                /**< Type of backend memory */
 	u32 flags;                         /**< Flags for this allocation */
 	u32 size;
+	atomic_t ref_count;                /**< One reference held by the allocation, plus one per lookup in progress */
+	struct rcu_head rcu;               /**< Frees the backend once lookups under rcu_read_lock() are done with it */
 	/* Union selected by type. */
 	union {
 		mali_mem_os_mem os_mem;       /**< MALI_MEM_OS */
@@ -203,6 +231,7 @@ typedef struct mali_mem_backend {
 		mali_mem_cow cow_mem;
 		mali_mem_swap swap_mem;
 		mali_mem_secure secure_mem;
+		mali_mem_sparse sparse_mem;   /**< MALI_MEM_SPARSE */
 	};
 	mali_mem_allocation *mali_allocation;
 	struct mutex mutex;
@@ -210,10 +239,15 @@ typedef struct mali_mem_backend {
 
 	struct list_head list;           /**< Used to link swappable memory backend to the global swappable list */
 	int using_count;                 /**< Mark how many PP jobs are using this memory backend */
+	mali_bool swap_referenced;       /**< Used by a PP job since the swap out clock last passed this swappable backend */
+	u32 swap_last_job_id;            /**< ID of the last PP job which used this swappable backend */
 	u32 start_idx;                   /**< If the correspondign vma of this backend is linear, this value will be used to set vma->vm_pgoff */
+	struct list_head purge_link;     /**< On the purgeable list while purgeable and holding pages */
 } mali_mem_backend;
 
 #define MALI_MEM_FLAG_MALI_GUARD_PAGE (_MALI_MAP_EXTERNAL_MAP_GUARD_PAGE)
 #define MALI_MEM_FLAG_DONT_CPU_MAP    (1 << 1)
 #define MALI_MEM_FLAG_CAN_RESIZE  (_MALI_MEMORY_ALLOCATE_RESIZEABLE)
+#define MALI_MEM_FLAG_GROWABLE    (_MALI_MEMORY_ALLOCATE_GROWABLE)
+#define MALI_MEM_FLAG_NO_BIND_GPU (_MALI_MEMORY_ALLOCATE_NO_BIND_GPU)
 #endif /* __MALI_MEMORY_TYPES__ */
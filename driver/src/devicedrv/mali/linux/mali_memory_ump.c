@@ -103,7 +103,7 @@ static void mali_mem_ump_unmap(mali_mem_allocation *alloc)
 	MALI_DEBUG_ASSERT_POINTER(session);
 	mali_session_memory_lock(session);
 	mali_mem_mali_map_free(session, alloc->psize, alloc->mali_vma_node.vm_node.start,
-			       alloc->flags);
+			       alloc->flags, NULL);
 	mali_session_memory_unlock(session);
 }
 
@@ -20,6 +20,8 @@
 #include "mali_osk_mali.h"
 #include "mali_kernel_linux.h"
 #include "mali_scheduler.h"
+#include "mali_executor.h"
+#include "mali_mmu.h"
 
 #include "mali_memory.h"
 #include "mali_memory_os_alloc.h"
@@ -36,6 +38,8 @@
 #include "mali_memory_cow.h"
 #include "mali_memory_block_alloc.h"
 #include "mali_memory_swap_alloc.h"
+#include "mali_memory_sparse.h"
+#include "mali_memory_purgeable.h"
 
 
 
@@ -49,17 +53,16 @@ static u32 _mali_free_allocation_mem(mali_mem_allocation *mali_alloc)
 
 	struct mali_session_data *session = mali_alloc->session;
 	MALI_DEBUG_PRINT(4, (" _mali_free_allocation_mem, psize =0x%x! \n", mali_alloc->psize));
-	if (0 == mali_alloc->psize)
+	if (0 == mali_alloc->psize && MALI_MEM_SPARSE != mali_alloc->type)
 		goto out;
 
 	/* Get backend memory & Map on CPU */
-	mutex_lock(&mali_idr_mutex);
-	mem_bkend = idr_find(&mali_backend_idr, mali_alloc->backend_handle);
-	mutex_unlock(&mali_idr_mutex);
+	mem_bkend = mali_mem_backend_get(mali_alloc->backend_handle);
 	MALI_DEBUG_ASSERT(NULL != mem_bkend);
 
 	switch (mem_bkend->type) {
 	case MALI_MEM_OS:
+		mali_mem_purgeable_remove(mem_bkend);
 		free_pages_nr = mali_mem_os_release(mem_bkend);
 		atomic_sub(free_pages_nr, &session->mali_mem_allocated_pages);
 		break;
@@ -110,6 +113,10 @@ static u32 _mali_free_allocation_mem(mali_mem_allocation *mali_alloc)
 		MALI_DEBUG_PRINT(1, ("DMA not supported for mali secure memory\n"));
 #endif
 		break;
+	case MALI_MEM_SPARSE:
+		free_pages_nr = mali_mem_sparse_release(mem_bkend);
+		atomic_sub(free_pages_nr, &session->mali_mem_allocated_pages);
+		break;
 	default:
 		MALI_DEBUG_PRINT(1, ("mem type %d is not in the mali_mem_type enum.\n", mem_bkend->type));
 		break;
@@ -118,11 +125,10 @@ static u32 _mali_free_allocation_mem(mali_mem_allocation *mali_alloc)
 	if ((NULL != mali_alloc->cpu_mapping.vma) && (mali_alloc == (mali_alloc->cpu_mapping.vma)->vm_private_data))
 		(mali_alloc->cpu_mapping.vma)->vm_private_data = NULL;
 
+	mali_mem_backend_put(mem_bkend);
+
 	/*Remove backend memory idex */
-	mutex_lock(&mali_idr_mutex);
-	idr_remove(&mali_backend_idr, mali_alloc->backend_handle);
-	mutex_unlock(&mali_idr_mutex);
-	kfree(mem_bkend);
+	mali_mem_backend_struct_destory(&mem_bkend, mali_alloc->backend_handle);
 out:
 	/* remove memory allocation  */
 	mali_vma_offset_remove(&session->allocation_mgr, &mali_alloc->mali_vma_node);
@@ -155,6 +161,12 @@ void mali_free_session_allocations(struct mali_session_data *session)
 
 	MALI_DEBUG_PRINT(4, (" mali_free_session_allocations! \n"));
 
+	/*
+	 * No jobs are running for the session any more. Detach it from all
+	 * MMUs once, so the unmaps below find no TLB to invalidate.
+	 */
+	mali_executor_zap_all_active(session, NULL);
+
 	list_for_each_entry_safe(entry, next, &session->allocation_mgr.head, list) {
 		mali_allocation_unref(&entry);
 	}
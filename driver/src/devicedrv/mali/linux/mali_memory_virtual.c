@@ -23,6 +23,8 @@
 #include "mali_memory_os_alloc.h"
 #include "mali_memory_manager.h"
 #include "mali_memory_virtual.h"
+#include <linux/bitmap.h>
+#include <linux/log2.h>
 
 
 /**
@@ -79,25 +81,31 @@ out:
 void mali_vma_offset_remove(struct mali_allocation_manager *mgr,
 			    struct mali_vma_node *node)
 {
+	struct mali_mm_node vm_node = { 0 };
+
 	write_lock(&mgr->vm_lock);
 
 	if (node->vm_node.allocated) {
 		rb_erase(&node->vm_rb, &mgr->allocation_mgr_rb);
+		vm_node = node->vm_node;
 		memset(&node->vm_node, 0, sizeof(node->vm_node));
 	}
 	write_unlock(&mgr->vm_lock);
+
+	if (vm_node.kernel_placed) {
+		mali_vma_offset_free(mgr, vm_node.start, vm_node.size);
+	}
 }
 
 /**
-* mali_vma_offset_search - Search the node in RB tree
+*internal helper to search the node in RB tree, called with vm_lock held
 */
-struct mali_vma_node *mali_vma_offset_search(struct mali_allocation_manager *mgr,
+static struct mali_vma_node *_mali_vma_offset_search(struct mali_allocation_manager *mgr,
 		unsigned long start, unsigned long pages)
 {
 	struct mali_vma_node *node, *best;
 	struct rb_node *iter;
 	unsigned long offset;
-	read_lock(&mgr->vm_lock);
 
 	iter = mgr->allocation_mgr_rb.rb_node;
 	best = NULL;
@@ -120,8 +128,244 @@ struct mali_vma_node *mali_vma_offset_search(struct mali_allocation_manager *mgr
 		if (offset <= start + pages)
 			best = NULL;
 	}
-	read_unlock(&mgr->vm_lock);
 
 	return best;
 }
 
+/**
+* mali_vma_offset_search - Search the node in RB tree
+*/
+struct mali_vma_node *mali_vma_offset_search(struct mali_allocation_manager *mgr,
+		unsigned long start, unsigned long pages)
+{
+	struct mali_vma_node *node;
+
+	read_lock(&mgr->vm_lock);
+	node = _mali_vma_offset_search(mgr, start, pages);
+	read_unlock(&mgr->vm_lock);
+
+	return node;
+}
+
+/**
+* mali_vma_offset_search_ref - Search the allocation in RB tree and take a reference on it
+* An allocation whose last reference is gone stays in the tree until it is freed,
+* is not found. The caller drops the reference with mali_allocation_unref().
+*/
+struct mali_mem_allocation *mali_vma_offset_search_ref(struct mali_allocation_manager *mgr,
+		unsigned long start)
+{
+	struct mali_vma_node *node;
+	struct mali_mem_allocation *alloc = NULL;
+
+	read_lock(&mgr->vm_lock);
+	node = _mali_vma_offset_search(mgr, start, 0);
+	if (NULL != node) {
+		alloc = container_of(node, struct mali_mem_allocation, mali_vma_node);
+		if (MALI_FALSE == _mali_osk_atomic_inc_not_zero(&alloc->mem_alloc_refcount))
+			alloc = NULL;
+	}
+	read_unlock(&mgr->vm_lock);
+
+	return alloc;
+}
+
+/*
+ * A chunk of the kernel placed range shared by allocations of one size class,
+ * each allocation taking a naturally aligned slot of the class size.
+ */
+struct mali_vma_chunk {
+	struct list_head link; /* On the partial list of its size class while it has free slots */
+	u32 index;
+	u32 size_class;
+	u32 used;
+	DECLARE_BITMAP(slots, MALI_MMU_VIRTUAL_PAGE_SIZE / MALI_MMU_PAGE_SIZE);
+};
+
+static inline u32 mali_vma_chunk_start(u32 index)
+{
+	return MALI_VMA_KERNEL_BASE + index * MALI_MMU_VIRTUAL_PAGE_SIZE;
+}
+
+/* MALI_TRUE if no node in the RB tree overlaps the range, user space may have placed one there */
+static mali_bool mali_vma_range_is_free(struct mali_allocation_manager *mgr, u32 start, u32 size)
+{
+	struct mali_vma_node *node, *best = NULL;
+	struct rb_node *iter;
+	mali_bool is_free;
+
+	read_lock(&mgr->vm_lock);
+
+	/* Find the last node starting before the end of the range */
+	iter = mgr->allocation_mgr_rb.rb_node;
+	while (likely(iter)) {
+		node = rb_entry(iter, struct mali_vma_node, vm_rb);
+		if (node->vm_node.start < start + size) {
+			best = node;
+			iter = iter->rb_right;
+		} else {
+			iter = iter->rb_left;
+		}
+	}
+	is_free = (NULL == best || best->vm_node.start + best->vm_node.size <= start) ? MALI_TRUE : MALI_FALSE;
+
+	read_unlock(&mgr->vm_lock);
+
+	return is_free;
+}
+
+/* Reserve nr contiguous chunks, the lock must be held */
+static int mali_vma_chunks_alloc(struct mali_allocation_manager *mgr, u32 nr, u32 *index)
+{
+	struct mali_vma_allocator *va = &mgr->va;
+	unsigned long from = 0;
+	unsigned long i;
+
+	for (;;) {
+		i = bitmap_find_next_zero_area(va->chunks, MALI_VMA_KERNEL_CHUNKS, from, nr, 0);
+		if (i >= MALI_VMA_KERNEL_CHUNKS) {
+			return -ENOMEM;
+		}
+
+		if (mali_vma_range_is_free(mgr, mali_vma_chunk_start(i), nr * MALI_MMU_VIRTUAL_PAGE_SIZE)) {
+			break;
+		}
+		from = i + 1;
+	}
+
+	bitmap_set(va->chunks, i, nr);
+	*index = i;
+
+	return 0;
+}
+
+/* Take a free slot of a shared chunk, the lock must be held */
+static mali_bool mali_vma_chunk_take_slot(struct mali_allocation_manager *mgr, struct mali_vma_chunk *chunk, u32 *start)
+{
+	u32 slot_size = MALI_MMU_PAGE_SIZE << chunk->size_class;
+	u32 nr_slots = MALI_MMU_VIRTUAL_PAGE_SIZE / slot_size;
+	u32 slot;
+
+	for_each_clear_bit(slot, chunk->slots, nr_slots) {
+		u32 addr = mali_vma_chunk_start(chunk->index) + slot * slot_size;
+
+		if (mali_vma_range_is_free(mgr, addr, slot_size)) {
+			set_bit(slot, chunk->slots);
+			if (++chunk->used == nr_slots) {
+				list_del_init(&chunk->link);
+			}
+			*start = addr;
+			return MALI_TRUE;
+		}
+	}
+
+	return MALI_FALSE;
+}
+
+static int mali_vma_shared_alloc(struct mali_allocation_manager *mgr, u32 size_class, u32 *start)
+{
+	struct mali_vma_allocator *va = &mgr->va;
+	struct mali_vma_chunk *chunk;
+	u32 index;
+
+	/* Most recently freed into first, its page table is the most likely to still be there */
+	list_for_each_entry(chunk, &va->partial[size_class], link) {
+		if (mali_vma_chunk_take_slot(mgr, chunk, start)) {
+			return 0;
+		}
+	}
+
+	chunk = kzalloc(sizeof(*chunk), GFP_KERNEL);
+	if (NULL == chunk) {
+		return -ENOMEM;
+	}
+
+	if (mali_vma_chunks_alloc(mgr, 1, &index)) {
+		kfree(chunk);
+		return -ENOMEM;
+	}
+
+	chunk->index = index;
+	chunk->size_class = size_class;
+	va->shared[index] = chunk;
+	list_add(&chunk->link, &va->partial[size_class]);
+
+	/* The whole chunk was free */
+	mali_vma_chunk_take_slot(mgr, chunk, start);
+
+	return 0;
+}
+
+int mali_vma_offset_alloc(struct mali_allocation_manager *mgr, u32 size, u32 *start)
+{
+	struct mali_vma_allocator *va = &mgr->va;
+	u32 index;
+	int ret;
+
+	if (0 == size || size > MALI_VMA_KERNEL_SIZE) {
+		return -EINVAL;
+	}
+
+	mutex_lock(&va->lock);
+	if (size <= MALI_MMU_VIRTUAL_PAGE_SIZE / 2) {
+		ret = mali_vma_shared_alloc(mgr, order_base_2(DIV_ROUND_UP(size, MALI_MMU_PAGE_SIZE)), start);
+	} else {
+		ret = mali_vma_chunks_alloc(mgr, DIV_ROUND_UP(size, MALI_MMU_VIRTUAL_PAGE_SIZE), &index);
+		if (0 == ret) {
+			*start = mali_vma_chunk_start(index);
+		}
+	}
+	mutex_unlock(&va->lock);
+
+	return ret;
+}
+
+void mali_vma_offset_free(struct mali_allocation_manager *mgr, u32 start, u32 size)
+{
+	struct mali_vma_allocator *va = &mgr->va;
+	struct mali_vma_chunk *chunk;
+	u32 index;
+
+	MALI_DEBUG_ASSERT(start >= MALI_VMA_KERNEL_BASE && start - MALI_VMA_KERNEL_BASE < MALI_VMA_KERNEL_SIZE);
+	index = (start - MALI_VMA_KERNEL_BASE) / MALI_MMU_VIRTUAL_PAGE_SIZE;
+
+	mutex_lock(&va->lock);
+	chunk = va->shared[index];
+	if (NULL != chunk) {
+		u32 slot_size = MALI_MMU_PAGE_SIZE << chunk->size_class;
+
+		clear_bit((start - mali_vma_chunk_start(index)) / slot_size, chunk->slots);
+		if (0 == --chunk->used) {
+			list_del(&chunk->link);
+			va->shared[index] = NULL;
+			clear_bit(index, va->chunks);
+			kfree(chunk);
+		} else if (list_empty(&chunk->link)) {
+			list_add(&chunk->link, &va->partial[chunk->size_class]);
+		} else {
+			list_move(&chunk->link, &va->partial[chunk->size_class]);
+		}
+	} else {
+		bitmap_clear(va->chunks, index, DIV_ROUND_UP(size, MALI_MMU_VIRTUAL_PAGE_SIZE));
+	}
+	mutex_unlock(&va->lock);
+}
+
+void mali_vma_allocator_init(struct mali_allocation_manager *mgr)
+{
+	struct mali_vma_allocator *va = &mgr->va;
+	int i;
+
+	mutex_init(&va->lock);
+	bitmap_zero(va->chunks, MALI_VMA_KERNEL_CHUNKS);
+	memset(va->shared, 0, sizeof(va->shared));
+	for (i = 0; i < MALI_VMA_SIZE_CLASSES; i++) {
+		INIT_LIST_HEAD(&va->partial[i]);
+	}
+}
+
+void mali_vma_allocator_term(struct mali_allocation_manager *mgr)
+{
+	/* All allocations are freed by now */
+	MALI_DEBUG_ASSERT(bitmap_empty(mgr->va.chunks, MALI_VMA_KERNEL_CHUNKS));
+}
@@ -32,4 +32,19 @@ void mali_vma_offset_remove(struct mali_allocation_manager *mgr,
 struct mali_vma_node *mali_vma_offset_search(struct mali_allocation_manager *mgr,
 		unsigned long start,    unsigned long pages);
 
+/* Search the allocation at start and take a reference on it, NULL if there is none or it is being freed */
+struct mali_mem_allocation *mali_vma_offset_search_ref(struct mali_allocation_manager *mgr,
+		unsigned long start);
+
+void mali_vma_allocator_init(struct mali_allocation_manager *mgr);
+void mali_vma_allocator_term(struct mali_allocation_manager *mgr);
+
+/* Choose the Mali address of a size bytes allocation. Allocations up to half a
+ * page table share page tables with others of the same size class, larger ones
+ * start on a page table boundary. */
+int mali_vma_offset_alloc(struct mali_allocation_manager *mgr, u32 size, u32 *start);
+
+/* Free an address chosen by mali_vma_offset_alloc(), mali_vma_offset_remove() does it for added nodes */
+void mali_vma_offset_free(struct mali_allocation_manager *mgr, u32 start, u32 size);
+
 #endif
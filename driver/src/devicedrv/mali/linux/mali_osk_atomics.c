@@ -37,6 +37,11 @@ u32 _mali_osk_atomic_inc_return(_mali_osk_atomic_t *atom)
 	return atomic_inc_return((atomic_t *)&atom->u.val);
 }
 
+mali_bool _mali_osk_atomic_inc_not_zero(_mali_osk_atomic_t *atom)
+{
+	return atomic_inc_not_zero((atomic_t *)&atom->u.val) ? MALI_TRUE : MALI_FALSE;
+}
+
 void _mali_osk_atomic_init(_mali_osk_atomic_t *atom, u32 val)
 {
 	MALI_DEBUG_ASSERT_POINTER(atom);
@@ -161,6 +161,21 @@ extern "C" {
 		_mali_osk_locks_debug_add((struct _mali_osk_lock_debug_s *)lock);
 	}
 
+	/** @brief Try to lock spinlock and save the register's state, without spinning
+	 * @return MALI_TRUE if the lock was taken, MALI_FALSE if it is held by someone else */
+	static inline mali_bool _mali_osk_spinlock_irq_trylock(_mali_osk_spinlock_irq_t *lock)
+	{
+		unsigned long tmp_flags;
+
+		BUG_ON(NULL == lock);
+		if (!spin_trylock_irqsave(&lock->spinlock, tmp_flags)) {
+			return MALI_FALSE;
+		}
+		lock->flags = tmp_flags;
+		_mali_osk_locks_debug_add((struct _mali_osk_lock_debug_s *)lock);
+		return MALI_TRUE;
+	}
+
 	/** @brief Unlock spinlock with saved register's state */
 	static inline void _mali_osk_spinlock_irq_unlock(_mali_osk_spinlock_irq_t *lock)
 	{
@@ -301,6 +316,17 @@ extern "C" {
 		_mali_osk_locks_debug_add((struct _mali_osk_lock_debug_s *)lock);
 	}
 
+	/** @brief Lock the lock->mutex with mutex_trylock(), returns MALI_TRUE if the lock was taken. */
+	static inline mali_bool _mali_osk_mutex_trywait(_mali_osk_mutex_t *lock)
+	{
+		BUG_ON(NULL == lock);
+		if (0 == mutex_trylock(&lock->mutex)) {
+			return MALI_FALSE;
+		}
+		_mali_osk_locks_debug_add((struct _mali_osk_lock_debug_s *)lock);
+		return MALI_TRUE;
+	}
+
 	/** @brief Unlock the lock->mutex which is locked with mutex_lock() function. */
 	static inline void _mali_osk_mutex_signal(_mali_osk_mutex_t *lock)
 	{
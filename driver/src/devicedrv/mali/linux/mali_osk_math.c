@@ -15,6 +15,7 @@
 
 #include "mali_osk.h"
 #include <linux/bitops.h>
+#include <linux/math64.h>
 
 u32 _mali_osk_clz(u32 input)
 {
@@ -25,3 +26,8 @@ u32 _mali_osk_fls(u32 input)
 {
 	return fls(input);
 }
+
+u64 _mali_osk_div_u64(u64 dividend, u32 divisor)
+{
+	return div_u64(dividend, divisor);
+}
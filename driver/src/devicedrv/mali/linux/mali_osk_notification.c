@@ -15,7 +15,9 @@
 
 #include "mali_osk.h"
 #include "mali_kernel_common.h"
+#include "mali_uk_types.h"
 
+#include <linux/poll.h>
 #include <linux/sched.h>
 #include <linux/slab.h>
 #include <linux/spinlock.h>
@@ -34,9 +36,38 @@ struct _mali_osk_notification_queue_t_struct {
 
 typedef struct _mali_osk_notification_wrapper_t_struct {
 	struct list_head list;           /**< Internal linked list variable */
+	_mali_osk_object_pool_t *pool;   /**< Pool notification came from, NULL if allocated with kmalloc */
 	_mali_osk_notification_t data;   /**< Notification data */
 } _mali_osk_notification_wrapper_t;
 
+/* Largest result buffer of any notification delivered to user space */
+#define MALI_OSK_NOTIFICATION_POOL_PAYLOAD sizeof(((_mali_uk_wait_for_notification_s *)0)->data)
+#define MALI_OSK_NOTIFICATION_POOL_MAX_CACHED 256
+
+static _mali_osk_object_pool_t *notification_pool = NULL;
+
+_mali_osk_errcode_t _mali_osk_notification_initialize(void)
+{
+	MALI_DEBUG_ASSERT(NULL == notification_pool);
+
+	notification_pool = _mali_osk_object_pool_create("mali_notification",
+			    sizeof(_mali_osk_notification_wrapper_t) + MALI_OSK_NOTIFICATION_POOL_PAYLOAD,
+			    MALI_OSK_NOTIFICATION_POOL_MAX_CACHED);
+	if (NULL == notification_pool) {
+		return _MALI_OSK_ERR_NOMEM;
+	}
+
+	return _MALI_OSK_ERR_OK;
+}
+
+void _mali_osk_notification_terminate(void)
+{
+	if (NULL != notification_pool) {
+		_mali_osk_object_pool_destroy(notification_pool);
+		notification_pool = NULL;
+	}
+}
+
 _mali_osk_notification_queue_t *_mali_osk_notification_queue_init(void)
 {
 	_mali_osk_notification_queue_t         *result;
@@ -53,11 +84,20 @@ _mali_osk_notification_queue_t *_mali_osk_notification_queue_init(void)
 
 _mali_osk_notification_t *_mali_osk_notification_create(u32 type, u32 size)
 {
-	/* OPT Recycling of notification objects */
 	_mali_osk_notification_wrapper_t *notification;
 
-	notification = (_mali_osk_notification_wrapper_t *)kmalloc(sizeof(_mali_osk_notification_wrapper_t) + size,
-			GFP_KERNEL | __GFP_HIGH | __GFP_REPEAT);
+	if (NULL != notification_pool && MALI_OSK_NOTIFICATION_POOL_PAYLOAD >= size) {
+		notification = _mali_osk_object_pool_alloc(notification_pool);
+		if (NULL != notification) {
+			notification->pool = notification_pool;
+		}
+	} else {
+		notification = (_mali_osk_notification_wrapper_t *)kmalloc(sizeof(_mali_osk_notification_wrapper_t) + size,
+				GFP_KERNEL | __GFP_HIGH | __GFP_REPEAT);
+		if (NULL != notification) {
+			notification->pool = NULL;
+		}
+	}
 	if (NULL == notification) {
 		MALI_DEBUG_PRINT(1, ("Failed to create a notification object\n"));
 		return NULL;
@@ -88,7 +128,11 @@ void _mali_osk_notification_delete(_mali_osk_notification_t *object)
 	notification = container_of(object, _mali_osk_notification_wrapper_t, data);
 
 	/* Free the container */
-	kfree(notification);
+	if (NULL != notification->pool) {
+		_mali_osk_object_pool_free(notification->pool, notification);
+	} else {
+		kfree(notification);
+	}
 }
 
 void _mali_osk_notification_queue_term(_mali_osk_notification_queue_t *queue)
@@ -133,6 +177,36 @@ void _mali_osk_notification_queue_send(_mali_osk_notification_queue_t *queue, _m
 	wake_up(&queue->receive_queue);
 }
 
+unsigned int _mali_osk_notification_queue_poll(_mali_osk_notification_queue_t *queue, struct file *filp, poll_table *wait)
+{
+#if defined(MALI_UPPER_HALF_SCHEDULING)
+	unsigned long irq_flags;
+#endif
+	unsigned int mask = 0;
+
+	MALI_DEBUG_ASSERT_POINTER(queue);
+
+	poll_wait(filp, &queue->receive_queue, wait);
+
+#if defined(MALI_UPPER_HALF_SCHEDULING)
+	spin_lock_irqsave(&queue->mutex, irq_flags);
+#else
+	spin_lock(&queue->mutex);
+#endif
+
+	if (!list_empty(&queue->head)) {
+		mask = POLLIN | POLLRDNORM;
+	}
+
+#if defined(MALI_UPPER_HALF_SCHEDULING)
+	spin_unlock_irqrestore(&queue->mutex, irq_flags);
+#else
+	spin_unlock(&queue->mutex);
+#endif
+
+	return mask;
+}
+
 _mali_osk_errcode_t _mali_osk_notification_queue_dequeue(_mali_osk_notification_queue_t *queue, _mali_osk_notification_t **result)
 {
 #if defined(MALI_UPPER_HALF_SCHEDULING)
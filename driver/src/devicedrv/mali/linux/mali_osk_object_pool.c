@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2017 ARM Limited. All rights reserved.
+ * 
+ * This program is free software and is provided to you under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation, and any use by you of this program is subject to the terms of such GNU licence.
+ * 
+ * A copy of the licence is included with the program, and can also be obtained from Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/**
+ * @file mali_osk_object_pool.c
+ * Implementation of the OS abstraction layer for the kernel device driver
+ */
+
+#include <linux/list.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+#include "mali_osk.h"
+#include "mali_kernel_common.h"
+
+/* Freed objects are kept on a singly linked list threaded through the objects themselves */
+struct mali_osk_object_pool_entry {
+	struct mali_osk_object_pool_entry *next;
+};
+
+struct _mali_osk_object_pool_t_struct {
+	struct list_head list;          /**< Link in list of all pools */
+	const char *name;
+	struct kmem_cache *cache;       /**< Backing slab cache */
+	u32 object_size;
+	u32 max_cached;                 /**< Maximum number of objects on free list */
+
+	spinlock_t lock;                /**< Protects free list and statistics */
+	struct mali_osk_object_pool_entry *free_list;
+	u32 num_cached;                 /**< Number of objects on free list */
+	u32 num_in_use;                 /**< Number of objects handed out */
+
+	u64 hits;                       /**< Allocations served from the free list */
+	u64 misses;                     /**< Allocations served from the slab cache */
+	u64 failures;                   /**< Allocations which failed */
+	u32 peak_in_use;
+};
+
+static LIST_HEAD(mali_osk_object_pools);
+static DEFINE_MUTEX(mali_osk_object_pools_lock);
+
+_mali_osk_object_pool_t *_mali_osk_object_pool_create(const char *name, u32 object_size, u32 max_cached)
+{
+	_mali_osk_object_pool_t *pool;
+
+	MALI_DEBUG_ASSERT_POINTER(name);
+	MALI_DEBUG_ASSERT(0 < object_size);
+
+	pool = kzalloc(sizeof(*pool), GFP_KERNEL);
+	if (NULL == pool) return NULL;
+
+	if (object_size < sizeof(struct mali_osk_object_pool_entry)) {
+		object_size = sizeof(struct mali_osk_object_pool_entry);
+	}
+
+	pool->cache = kmem_cache_create(name, object_size, 0, SLAB_HWCACHE_ALIGN, NULL);
+	if (NULL == pool->cache) {
+		kfree(pool);
+		return NULL;
+	}
+
+	pool->name = name;
+	pool->object_size = object_size;
+	pool->max_cached = max_cached;
+	spin_lock_init(&pool->lock);
+
+	mutex_lock(&mali_osk_object_pools_lock);
+	list_add_tail(&pool->list, &mali_osk_object_pools);
+	mutex_unlock(&mali_osk_object_pools_lock);
+
+	return pool;
+}
+
+void _mali_osk_object_pool_destroy(_mali_osk_object_pool_t *pool)
+{
+	struct mali_osk_object_pool_entry *entry;
+
+	MALI_DEBUG_ASSERT_POINTER(pool);
+
+	mutex_lock(&mali_osk_object_pools_lock);
+	list_del(&pool->list);
+	mutex_unlock(&mali_osk_object_pools_lock);
+
+	if (0 != pool->num_in_use) {
+		MALI_PRINT_ERROR(("Mali OSK: %u objects still in use when destroying pool %s\n",
+				  pool->num_in_use, pool->name));
+	}
+
+	while (NULL != pool->free_list) {
+		entry = pool->free_list;
+		pool->free_list = entry->next;
+		kmem_cache_free(pool->cache, entry);
+	}
+
+	kmem_cache_destroy(pool->cache);
+	kfree(pool);
+}
+
+void *_mali_osk_object_pool_alloc(_mali_osk_object_pool_t *pool)
+{
+	struct mali_osk_object_pool_entry *entry;
+	unsigned long flags;
+
+	MALI_DEBUG_ASSERT_POINTER(pool);
+
+	spin_lock_irqsave(&pool->lock, flags);
+	entry = pool->free_list;
+	if (NULL != entry) {
+		pool->free_list = entry->next;
+		pool->num_cached--;
+		pool->hits++;
+		pool->num_in_use++;
+		if (pool->num_in_use > pool->peak_in_use) {
+			pool->peak_in_use = pool->num_in_use;
+		}
+	}
+	spin_unlock_irqrestore(&pool->lock, flags);
+
+	if (NULL != entry) {
+		memset(entry, 0, pool->object_size);
+		return entry;
+	}
+
+	entry = kmem_cache_zalloc(pool->cache, GFP_KERNEL);
+
+	spin_lock_irqsave(&pool->lock, flags);
+	if (NULL != entry) {
+		pool->misses++;
+		pool->num_in_use++;
+		if (pool->num_in_use > pool->peak_in_use) {
+			pool->peak_in_use = pool->num_in_use;
+		}
+	} else {
+		pool->failures++;
+	}
+	spin_unlock_irqrestore(&pool->lock, flags);
+
+	return entry;
+}
+
+void _mali_osk_object_pool_free(_mali_osk_object_pool_t *pool, void *object)
+{
+	struct mali_osk_object_pool_entry *entry = object;
+	unsigned long flags;
+
+	MALI_DEBUG_ASSERT_POINTER(pool);
+
+	if (NULL == object) return;
+
+	spin_lock_irqsave(&pool->lock, flags);
+	MALI_DEBUG_ASSERT(0 < pool->num_in_use);
+	pool->num_in_use--;
+	if (pool->num_cached < pool->max_cached) {
+		entry->next = pool->free_list;
+		pool->free_list = entry;
+		pool->num_cached++;
+		entry = NULL;
+	}
+	spin_unlock_irqrestore(&pool->lock, flags);
+
+	if (NULL != entry) {
+		kmem_cache_free(pool->cache, entry);
+	}
+}
+
+void _mali_osk_object_pool_print_stats(_mali_osk_print_ctx *print_ctx)
+{
+	_mali_osk_object_pool_t *pool;
+
+	_mali_osk_ctxprintf(print_ctx, "%-20s %6s %8s %8s %8s %12s %12s %8s\n",
+			    "pool", "size", "in_use", "peak", "cached", "hits", "misses", "failed");
+
+	mutex_lock(&mali_osk_object_pools_lock);
+	list_for_each_entry(pool, &mali_osk_object_pools, list) {
+		u32 in_use, peak, cached;
+		u64 hits, misses, failures;
+		unsigned long flags;
+
+		spin_lock_irqsave(&pool->lock, flags);
+		in_use = pool->num_in_use;
+		peak = pool->peak_in_use;
+		cached = pool->num_cached;
+		hits = pool->hits;
+		misses = pool->misses;
+		failures = pool->failures;
+		spin_unlock_irqrestore(&pool->lock, flags);
+
+		_mali_osk_ctxprintf(print_ctx, "%-20s %6u %8u %8u %8u %12llu %12llu %8llu\n",
+				    pool->name, pool->object_size, in_use, peak, cached,
+				    hits, misses, failures);
+	}
+	mutex_unlock(&mali_osk_object_pools_lock);
+}
+
+void _mali_osk_object_pool_reset_stats(void)
+{
+	_mali_osk_object_pool_t *pool;
+
+	mutex_lock(&mali_osk_object_pools_lock);
+	list_for_each_entry(pool, &mali_osk_object_pools, list) {
+		unsigned long flags;
+
+		spin_lock_irqsave(&pool->lock, flags);
+		pool->hits = 0;
+		pool->misses = 0;
+		pool->failures = 0;
+		pool->peak_in_use = pool->num_in_use;
+		spin_unlock_irqrestore(&pool->lock, flags);
+	}
+	mutex_unlock(&mali_osk_object_pools_lock);
+}
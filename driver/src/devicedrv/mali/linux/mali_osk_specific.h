@@ -74,4 +74,10 @@ MALI_STATIC_INLINE mali_bool _mali_osk_in_atomic(void)
 
 #define _mali_osk_put_user(x, ptr) put_user(x, ptr)
 
+struct file;
+struct poll_table_struct;
+
+/* poll() support for a notification queue, readable when a notification is pending */
+unsigned int _mali_osk_notification_queue_poll(_mali_osk_notification_queue_t *queue, struct file *filp, struct poll_table_struct *wait);
+
 #endif /* __MALI_OSK_SPECIFIC_H__ */
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2017 ARM Limited. All rights reserved.
+ * 
+ * This program is free software and is provided to you under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation, and any use by you of this program is subject to the terms of such GNU licence.
+ * 
+ * A copy of the licence is included with the program, and can also be obtained from Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+
+#include "mali_timeline_seqno.h"
+#include "mali_kernel_common.h"
+#include "mali_session.h"
+#include "mali_timeline.h"
+
+int mali_timeline_seqno_setup(struct mali_session_data *session, _mali_uk_timeline_seqno_setup_s __user *uargs)
+{
+	_mali_uk_timeline_seqno_setup_s kargs;
+	_mali_uk_timeline_seqno_page_s *seqno_page;
+
+	MALI_DEBUG_ASSERT_POINTER(session);
+
+	BUILD_BUG_ON(PAGE_SIZE < sizeof(_mali_uk_timeline_seqno_page_s));
+
+	if (0 != copy_from_user(&kargs, uargs, sizeof(kargs))) {
+		return -EFAULT;
+	}
+
+	if (NULL != session->timeline_seqno_page) {
+		return -EBUSY;
+	}
+
+	seqno_page = vmalloc_user(PAGE_SIZE);
+	if (NULL == seqno_page) {
+		return -ENOMEM;
+	}
+
+	kargs.mmap_offset = _MALI_UK_TIMELINE_SEQNO_MMAP_OFFSET;
+	kargs.mmap_size = PAGE_SIZE;
+	if (0 != copy_to_user(uargs, &kargs, sizeof(kargs))) {
+		vfree(seqno_page);
+		return -EFAULT;
+	}
+
+	/* Publish page, points are written to it from now on. */
+	if (_MALI_OSK_ERR_OK != mali_timeline_system_set_seqno_page(session->timeline_system, seqno_page)) {
+		vfree(seqno_page);
+		return -EBUSY;
+	}
+
+	session->timeline_seqno_page = seqno_page;
+
+	MALI_DEBUG_PRINT(3, ("Mali timeline seqno page set up for session 0x%08X\n", session));
+
+	return 0;
+}
+
+void mali_timeline_seqno_destroy(_mali_uk_timeline_seqno_page_s *seqno_page)
+{
+	MALI_DEBUG_ASSERT_POINTER(seqno_page);
+
+	vfree(seqno_page);
+}
+
+int mali_timeline_seqno_mmap(struct mali_session_data *session, struct vm_area_struct *vma)
+{
+	_mali_uk_timeline_seqno_page_s *seqno_page;
+
+	MALI_DEBUG_ASSERT_POINTER(session);
+
+	seqno_page = session->timeline_seqno_page;
+	if (NULL == seqno_page) {
+		return -EINVAL;
+	}
+
+	if (vma->vm_end - vma->vm_start > PAGE_SIZE) {
+		return -EINVAL;
+	}
+
+	/* Only the kernel may write points. */
+	if (vma->vm_flags & VM_WRITE) {
+		return -EPERM;
+	}
+
+	vma->vm_flags &= ~VM_MAYWRITE;
+	vma->vm_flags |= VM_DONTCOPY;
+	vma->vm_flags |= VM_DONTEXPAND;
+
+	return remap_vmalloc_range(vma, seqno_page, 0);
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2017 ARM Limited. All rights reserved.
+ * 
+ * This program is free software and is provided to you under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation, and any use by you of this program is subject to the terms of such GNU licence.
+ * 
+ * A copy of the licence is included with the program, and can also be obtained from Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/**
+ * @file mali_timeline_seqno.h
+ *
+ * Per session timeline seqno page, mapped read-only into user space.
+ */
+
+#ifndef __MALI_TIMELINE_SEQNO_H__
+#define __MALI_TIMELINE_SEQNO_H__
+
+#include <linux/fs.h>
+#include <linux/mm.h>
+#include "mali_osk.h"
+#include "mali_uk_types.h"
+
+struct mali_session_data;
+
+/**
+ * Create the timeline seqno page of a session, as requested by user space.
+ *
+ * @param session Session to create seqno page for.
+ * @param uargs Setup arguments in user space.
+ * @return 0 on success, negative error code on failure.
+ */
+int mali_timeline_seqno_setup(struct mali_session_data *session, _mali_uk_timeline_seqno_setup_s __user *uargs);
+
+/**
+ * Destroy a timeline seqno page.
+ *
+ * Must only be called after the timeline system publishing to it has been
+ * destroyed, and after user space has unmapped it.
+ *
+ * @param seqno_page Seqno page to destroy.
+ */
+void mali_timeline_seqno_destroy(_mali_uk_timeline_seqno_page_s *seqno_page);
+
+/**
+ * Map the timeline seqno page of a session into user space, read-only.
+ *
+ * @param session Session owning the seqno page.
+ * @param vma Virtual memory area to map seqno page into.
+ * @return 0 on success, negative error code on failure.
+ */
+int mali_timeline_seqno_mmap(struct mali_session_data *session, struct vm_area_struct *vma);
+
+#endif /* __MALI_TIMELINE_SEQNO_H__ */
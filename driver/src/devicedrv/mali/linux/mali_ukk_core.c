@@ -149,3 +149,20 @@ int pending_submit_wrapper(struct mali_session_data *session_data, _mali_uk_pend
 
 	return 0;
 }
+
+int submit_batch_wrapper(struct mali_session_data *session_data, _mali_uk_submit_batch_s __user *uargs)
+{
+	_mali_osk_errcode_t err;
+
+	/* If all jobs were started successfully, 0 is returned.  If there was an error, but the
+	 * jobs were started, we return -ENOENT.  For anything else returned, num_started tells
+	 * how many of the jobs were started. */
+
+	MALI_CHECK_NON_NULL(uargs, -EINVAL);
+	MALI_CHECK_NON_NULL(session_data, -EINVAL);
+
+	err = _mali_ukk_submit_batch(session_data, uargs);
+	if (_MALI_OSK_ERR_OK != err) return map_errcode(err);
+
+	return 0;
+}
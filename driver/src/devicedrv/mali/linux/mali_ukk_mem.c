@@ -44,6 +44,10 @@ int mem_alloc_wrapper(struct mali_session_data *session_data, _mali_uk_alloc_mem
 		return -EFAULT;
 	}
 
+	if ((kargs.flags & _MALI_MEMORY_ALLOCATE_KERNEL_VA) && 0 != put_user(kargs.gpu_vaddr, &uargs->gpu_vaddr)) {
+		return -EFAULT;
+	}
+
 	return 0;
 }
 
@@ -192,6 +196,55 @@ int mem_resize_mem_wrapper(struct mali_session_data *session_data, _mali_uk_mem_
 	return 0;
 }
 
+int mem_sparse_bind_wrapper(struct mali_session_data *session_data, _mali_uk_mem_sparse_bind_s __user *uargs)
+{
+	_mali_uk_mem_sparse_bind_s kargs;
+	_mali_osk_errcode_t err;
+
+	MALI_CHECK_NON_NULL(uargs, -EINVAL);
+	MALI_CHECK_NON_NULL(session_data, -EINVAL);
+
+	if (0 != copy_from_user(&kargs, uargs, sizeof(_mali_uk_mem_sparse_bind_s))) {
+		return -EFAULT;
+	}
+	kargs.ctx = (uintptr_t)session_data;
+
+	err = _mali_ukk_mem_sparse_bind(&kargs);
+
+	if (_MALI_OSK_ERR_OK != err) {
+		return map_errcode(err);
+	}
+
+	return 0;
+}
+
+int mem_madvise_wrapper(struct mali_session_data *session_data, _mali_uk_mem_madvise_s __user *uargs)
+{
+	_mali_uk_mem_madvise_s kargs;
+	_mali_osk_errcode_t err;
+
+	MALI_CHECK_NON_NULL(uargs, -EINVAL);
+	MALI_CHECK_NON_NULL(session_data, -EINVAL);
+
+	if (0 != copy_from_user(&kargs, uargs, sizeof(_mali_uk_mem_madvise_s))) {
+		return -EFAULT;
+	}
+	kargs.ctx = (uintptr_t)session_data;
+
+	err = _mali_ukk_mem_madvise(&kargs);
+
+	/* Purged pages are reported even if allocating new ones failed */
+	if (0 != put_user(kargs.retained, &uargs->retained)) {
+		return -EFAULT;
+	}
+
+	if (_MALI_OSK_ERR_OK != err) {
+		return map_errcode(err);
+	}
+
+	return 0;
+}
+
 int mem_write_safe_wrapper(struct mali_session_data *session_data, _mali_uk_mem_write_safe_s __user *uargs)
 {
 	_mali_uk_mem_write_safe_s kargs;
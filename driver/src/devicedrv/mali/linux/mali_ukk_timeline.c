@@ -36,7 +36,7 @@ int timeline_get_latest_point_wrapper(struct mali_session_data *session, _mali_u
 
 	if (0 != get_user(val, &uargs->timeline)) return -EFAULT;
 
-	if (MALI_UK_TIMELINE_MAX <= val) {
+	if (MALI_UK_TIMELINE_MAX + MALI_UK_TIMELINE_USER_MAX <= val) {
 		return -EINVAL;
 	}
 
@@ -92,3 +92,20 @@ int timeline_create_sync_fence_wrapper(struct mali_session_data *session, _mali_
 
 	return 0;
 }
+
+int timeline_create_wrapper(struct mali_session_data *session, _mali_uk_timeline_create_s __user *uargs)
+{
+	_mali_osk_errcode_t err;
+	mali_timeline_id timeline;
+
+	MALI_DEBUG_ASSERT_POINTER(session);
+
+	err = mali_timeline_system_create_user_timeline(session->timeline_system, &timeline);
+	if (_MALI_OSK_ERR_OK != err) {
+		return map_errcode(err);
+	}
+
+	if (0 != put_user((u32)timeline, &uargs->timeline)) return -EFAULT;
+
+	return 0;
+}